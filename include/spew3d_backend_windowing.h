@@ -36,6 +36,14 @@ typedef struct s3d_backend_windowing_gputex
 typedef struct s3d_backend_windowing_wininfo
     s3d_backend_windowing_wininfo;
 
+typedef struct s3d_drawpolygon s3d_drawpolygon;
+
+typedef struct s3d_backend_windowing_spritequad {
+    s3d_point corners[4];  // Clockwise, starting at the top left.
+    s3d_point texcoords[4];
+    s3d_color color;
+} s3d_backend_windowing_spritequad;
+
 enum S3dBackendWindowingKind {
     S3D_BACKEND_WINDOWING_INVALID = 0,
     S3D_BACKEND_WINDOWING_SDL = 1
@@ -118,6 +126,13 @@ typedef struct s3d_backend_windowing {
         s3dnum_t transparency, int centered,
         int withalphachannel
     );
+    int (*DrawSpriteQuadsAtPixels)(
+        s3d_backend_windowing *backend, s3d_window *win,
+        s3d_backend_windowing_wininfo *backend_winfo,
+        s3d_backend_windowing_gputex *tex,
+        const s3d_backend_windowing_spritequad *quads,
+        uint32_t quad_count
+    );
     int (*DrawPolygonAtPixels)(
         s3d_backend_windowing *backend, s3d_window *win,
         s3d_backend_windowing_wininfo *backend_winfo,
@@ -125,6 +140,13 @@ typedef struct s3d_backend_windowing {
         s3d_pos *vertices, s3d_point *tex_points,
         s3d_color *colors
     );
+    int (*DrawPolygonsAtPixels)(
+        s3d_backend_windowing *backend, s3d_window *win,
+        s3d_backend_windowing_wininfo *backend_winfo,
+        s3d_backend_windowing_gputex *tex,
+        const s3d_drawpolygon *polygons,
+        uint32_t polygon_count
+    );
 
     void *internal;
 } s3d_backend_windowing;
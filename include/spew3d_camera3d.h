@@ -64,6 +64,26 @@ typedef struct s3d_renderpolygon {
     uint8_t clipped;
 } s3d_renderpolygon;
 
+/** One corner of a s3d_drawpolygon, already in screen space.
+ */
+typedef struct s3d_drawvertex {
+    float x, y;  // Screen position in pixels.
+    float texcoord_x, texcoord_y;
+    uint8_t red, green, blue, alpha;  // Light and tint, 255 is full.
+} s3d_drawvertex;
+
+/** A compact copy of a s3d_renderpolygon, holding only what is
+ *  needed for sorting and drawing. Cameras build these once all
+ *  polygons are transformed and split, so that the sort and draw
+ *  passes don't need to walk the much larger s3d_renderpolygon
+ *  array.
+ */
+typedef struct s3d_drawpolygon {
+    s3d_drawvertex vertex[3];
+    float depth;  // Sort key, larger means further away.
+    s3d_texture_t texture;
+} s3d_drawpolygon;
+
 S3DEXP int spew3d_camera_InternalMainThreadProcessEvent(
     s3d_event *e
 );
@@ -33,7 +33,8 @@ enum DeletionKind {
     DELETION_WINDOW = 1,
     DELETION_OBJ3D,
     DELETION_GEOM,
-    DELETION_LVLBOX
+    DELETION_LVLBOX,
+    DELETION_MEMORY  // A plain malloc()'ed block, only needs free().
 };
 
 typedef struct s3d_deletionqueueitem {
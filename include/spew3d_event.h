@@ -55,6 +55,8 @@ enum S3DEventKind {
     S3DEV_INTERNAL_CMD_TEXTURELOCK_LOCKPIXELSTOFINISH,
     S3DEV_INTERNAL_CMD_SPRITEDRAW,
     S3DEV_INTERNAL_CMD_CAM3D_DRAWTOWINDOW,
+    S3DEV_INTERNAL_CMD_SPRITEBATCHDRAW,
+    S3DEV_INTERNAL_CMD_CMDBUFFER_REPLAY,
 
     S3DEV_DUMMY = 99999
 };
@@ -118,6 +120,15 @@ typedef struct s3d_event {
                 s3dnum_t transparency;
                 int withalphachannel;
             } spritedraw;
+            struct spritebatchdraw {
+                uint32_t win_id;
+                struct s3d_spritebatch_entry *entries;
+                uint32_t count, alloc;
+            } spritebatchdraw;
+            struct cmdbuffer {
+                struct s3d_event *events;
+                uint32_t count;
+            } cmdbuffer;
             struct cam3d {
                 uint32_t win_id;
                 s3d_obj3d *obj_ref;
@@ -144,5 +155,35 @@ S3DEXP void spew3d_event_q_Free(s3d_equeue *ev);
 
 S3DEXP void spew3d_event_UpdateMainThread();
 
+typedef struct s3d_cmdbuffer s3d_cmdbuffer;
+
+/** Create a command buffer, which lets any thread record draw
+ *  commands without contending with other drawing threads.
+ *  Use spew3d_cmdbuffer_BeginRecording() to make the calling
+ *  thread's draw calls, like spew3d_texture_Draw(),
+ *  spew3d_spritebatch_DrawToWindow(), spew3d_window_FillWithColor()
+ *  or spew3d_camera3d_RenderToWindow(), go into the buffer instead
+ *  of to the main thread. Then hand all of them over at once with
+ *  spew3d_cmdbuffer_Submit(), and they will be replayed in order.
+ *  A command buffer must only be used by one thread at a time.
+ */
+S3DEXP s3d_cmdbuffer *spew3d_cmdbuffer_New();
+
+S3DEXP void spew3d_cmdbuffer_BeginRecording(s3d_cmdbuffer *buf);
+
+S3DEXP void spew3d_cmdbuffer_EndRecording();
+
+/** Hand all recorded commands to the main thread, and leave the
+ *  buffer empty for recording the next frame.
+ *  Returns 1 on success, 0 on out of memory.
+ */
+S3DEXP int spew3d_cmdbuffer_Submit(s3d_cmdbuffer *buf);
+
+S3DEXP void spew3d_cmdbuffer_Clear(s3d_cmdbuffer *buf);
+
+S3DEXP void spew3d_cmdbuffer_Destroy(s3d_cmdbuffer *buf);
+
+S3DHID int _spew3d_event_InsertDrawCmd(const s3d_event *ev);
+
 #endif  // SPEW3D_EVENT_H_
 
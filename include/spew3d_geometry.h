@@ -42,6 +42,9 @@ typedef uint32_t s3d_material_t;
 #define SPEW3D_MATERIAL_OBJECTPASSABLE ((uint32_t)1 << 2)
 #define SPEW3D_MATERIAL_BULLETSHOTPASSABLE ((uint32_t)1 << 3)
 #define SPEW3D_MATERIAL_AISIGHTPASSABLE ((uint32_t)1 << 4)
+// Polygons with this material are drawn from both sides, even
+// when back-face culling is on:
+#define SPEW3D_MATERIAL_TWOSIDED ((uint32_t)1 << 5)
 
 typedef struct s3d_geometry {
     int wasdeleted;
@@ -63,6 +66,12 @@ typedef struct s3d_geometry {
 
     int32_t owned_texture_count;
     s3d_texture_t *owned_texture;
+
+    // If set, polygons facing away from the camera are skipped.
+    // Only use this for closed meshes wound like the ones from
+    // spew3d_geometry_AddCube(), where spew3d_math3d_polygon_normal()
+    // points out of each polygon's visible side:
+    int cull_backfaces;
 } s3d_geometry;
 
 S3DEXP s3d_geometry *spew3d_geometry_Create();
@@ -103,6 +112,23 @@ S3DEXP int spew3d_geometry_AddPlaneSimple(
 
 S3DEXP void spew3d_geometry_Destroy(s3d_geometry *geometry);
 
+/** Create a lower detail copy of a geometry with at most
+ *  target_polygon_count polygons, e.g. for far away mesh objects.
+ *  It collapses the edges that change the shape the least, as
+ *  judged by quadric error, and keeps the texture coordinates and
+ *  colors of the polygon corners that remain. Open borders are kept
+ *  in place as much as possible. The result may have more polygons
+ *  than requested if no further edge can be collapsed without
+ *  flipping polygons.
+ *
+ *  The copy uses the same textures but doesn't own them, so the
+ *  original geometry must stay around for as long as the copy does.
+ *  Returns NULL on allocation failure.
+ */
+S3DEXP s3d_geometry *spew3d_geometry_Simplify(
+    s3d_geometry *geometry, int32_t target_polygon_count
+);
+
 enum GeomDynLightRenderDetail {
     DLRD_INVALID = 0,
     DLRD_UNLIT = 1,
@@ -135,5 +161,42 @@ S3DEXP int spew3d_geometry_Transform(
     uint32_t *render_fill, uint32_t *render_alloc
 );
 
+/** One placement of a geometry drawn via
+ *  spew3d_geometry_TransformInstances(), relative to the position
+ *  and rotation given there. The tint is multiplied into the
+ *  polygons' vertex colors.
+ */
+typedef struct s3d_geometryinstance {
+    s3d_pos pos;
+    s3d_rotation rotation;
+    s3d_color tint;
+} s3d_geometryinstance;
+
+/** Like spew3d_geometry_Transform(), but for many instances of the
+ *  same geometry at once. This loads the geometry's vertices just
+ *  once for all of them. Instances whose origin is further than
+ *  cull_radius from the camera's view are skipped, use
+ *  spew3d_geometry_GetRadius() to get a fitting value, or pass a
+ *  negative radius to transform all instances.
+ */
+S3DEXP int spew3d_geometry_TransformInstances(
+    s3d_geometry *geometry,
+    s3d_pos *model_pos,
+    s3d_rotation *model_rotation,
+    const s3d_geometryinstance *instances,
+    uint32_t instance_count, s3dnum_t cull_radius,
+    s3d_transform3d_cam_info *cam_info,
+    s3d_geometryrenderlightinfo *render_light_info,
+    s3d_renderpolygon **render_queue,
+    uint32_t *render_fill, uint32_t *render_alloc
+);
+
+/** Get the distance of the geometry's furthest vertex from its
+ *  origin.
+ */
+S3DEXP s3dnum_t spew3d_geometry_GetRadius(
+    s3d_geometry *geometry
+);
+
 #endif  // SPEW3D_GEOMETRY_H_
 
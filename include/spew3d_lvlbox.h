@@ -49,10 +49,15 @@ typedef struct s3d_lvlbox_customprops {
     char *prop_value;
 } s3d_lvlbox_customprops;
 
+/** A reference into the interned table of texture names used by
+ *  all lvlboxes, with 0 meaning no texture. Each distinct pair of
+ *  texture path and vfs flags is only stored once.
+ */
+typedef uint32_t s3d_lvlbox_texname_t;
+
 typedef struct s3d_lvlbox_texinfo {
-    char *name;
-    int vfs_flags;
     s3d_texture_t id;
+    s3d_lvlbox_texname_t name_ref;
     s3d_material_t material;
     int wrapmode;
     int overfit_multiplier;
@@ -60,10 +65,10 @@ typedef struct s3d_lvlbox_texinfo {
 } s3d_lvlbox_texinfo;
 
 typedef struct s3d_lvlbox_fenceinfo {
-    int is_set, has_alpha, is_passable;
     s3d_lvlbox_texinfo tex;
-    int truncate_set;
     double truncate_height_z;
+    int is_set, has_alpha, is_passable;
+    int truncate_set;
 } s3d_lvlbox_fenceinfo;
 
 typedef struct s3d_lvlbox_wallinfo {
@@ -82,46 +87,58 @@ typedef struct s3d_lvlbox_tilepolygon {
     s3d_texture_t texture;
 } s3d_lvlbox_tilepolygon;
 
+typedef struct s3d_lvlbox_tilecache_normals {
+    s3d_pos floor_flat_corner_normals[4];
+    s3d_pos floor_smooth_corner_normals[4];
+    s3d_pos ceiling_flat_corner_normals[4];
+    s3d_pos ceiling_smooth_corner_normals[4];
+} s3d_lvlbox_tilecache_normals;
+
 typedef struct s3d_lvlbox_tilecache {
     uint8_t is_up_to_date, flat_normals_set;
+    uint8_t floor_split_from_front_left;
+    uint8_t ceiling_split_from_front_left;
+    uint8_t atlas_pending;
 
     uint16_t cached_floor_polycount;
     uint16_t cached_floor_maxpolycount;
-    s3d_lvlbox_tilepolygon *cached_floor;
-    s3d_pos floor_flat_corner_normals[4];
-    s3d_pos floor_smooth_corner_normals[4];
-    int floor_split_from_front_left;
-
     uint16_t cached_ceiling_polycount;
     uint16_t cached_ceiling_maxpolycount;
-    s3d_lvlbox_tilepolygon *cached_ceiling;
-    s3d_pos ceiling_flat_corner_normals[4];
-    s3d_pos ceiling_smooth_corner_normals[4];
-    int ceiling_split_from_front_left;
-
     uint16_t cached_wall_polycount;
     uint16_t cached_wall_maxpolycount;
-    s3d_lvlbox_tilepolygon *cached_wall;
-
     uint16_t cached_fence_polycount;
     uint16_t cached_fence_maxpolycount;
+
+    s3d_lvlbox_tilepolygon *cached_floor;
+    s3d_lvlbox_tilepolygon *cached_ceiling;
+    s3d_lvlbox_tilepolygon *cached_wall;
     s3d_lvlbox_tilepolygon *cached_fence;
+
+    // Only needed while rebuilding the cache, so kept out of line:
+    s3d_lvlbox_tilecache_normals *normals;
 } s3d_lvlbox_tilecache;
 
-typedef struct s3d_lvlbox_vertsegment {
+typedef struct s3d_lvlbox_segmenttex {
     s3d_lvlbox_texinfo floor_tex;
-    s3dnum_t floor_z[4];
-
+    s3d_lvlbox_texinfo ceiling_tex;
     s3d_lvlbox_wallinfo wall[4];
+} s3d_lvlbox_segmenttex;
 
-    s3d_lvlbox_texinfo ceiling_tex;
+typedef struct s3d_lvlbox_vertsegment {
+    // Hot data first, so that walking heights and cache state
+    // touches as few cache lines as possible:
+    s3dnum_t floor_z[4];
     s3dnum_t ceiling_z[4];
+    s3d_lvlbox_tilecache cache;
 
     int16_t hori_fence_count;
-    s3d_lvlbox_fenceinfo *hori_fence;
     s3dnum_t *hori_fence_z;
+    s3d_lvlbox_fenceinfo *hori_fence;
 
-    s3d_lvlbox_tilecache cache;
+    // Textures and walls are mostly needed when rebuilding the
+    // cache, editing or saving, so they are kept out of line.
+    // Every segment has this allocated:
+    s3d_lvlbox_segmenttex *texinfo;
 } s3d_lvlbox_vertsegment;
 
 typedef struct s3d_lvlbox_tile {
@@ -134,6 +151,8 @@ typedef struct s3d_lvlbox_tile {
 typedef struct s3d_lvlbox_chunk {
     s3d_lvlbox_tile tile[LVLBOX_CHUNK_SIZE *
         LVLBOX_CHUNK_SIZE];
+
+    uint64_t edit_generation;
 } s3d_lvlbox_chunk;
 
 typedef struct s3d_lvlbox {
@@ -146,6 +165,18 @@ typedef struct s3d_lvlbox {
     void *_internal;
 } s3d_lvlbox;
 
+/** Get the texture path of an interned texture name. The returned
+ *  string is never moved or changed, and stays valid for as long as
+ *  the name is in use by the lvlbox it was taken from.
+ */
+S3DEXP const char *spew3d_lvlbox_TexNameToStr(
+    s3d_lvlbox_texname_t name_ref
+);
+
+S3DEXP int spew3d_lvlbox_TexNameToVFSFlags(
+    s3d_lvlbox_texname_t name_ref
+);
+
 S3DEXP s3d_lvlbox *spew3d_lvlbox_New(
     const char *default_tex, int default_tex_vfs_flags
 );
@@ -238,6 +269,19 @@ S3DEXP s3d_resourceload_job *spew3d_lvlbox_ToMapFile(
     const char *map_file_path, int map_file_vfs_flags
 );
 
+/** Like spew3d_lvlbox_ToMapFile(), but if the lvlbox was last
+ *  saved to or loaded from the same path, only the chunks edited
+ *  since then are appended to a "<map_file_path>.journal" file.
+ *  Loading the map file applies the journal's complete entries.
+ *  A full save that resets the journal is done instead if the
+ *  lvlbox was resized since, or if the journal has grown as large
+ *  as the map file itself.
+ */
+S3DEXP s3d_resourceload_job *spew3d_lvlbox_ToMapFileIncremental(
+    s3d_lvlbox *lvlbox,
+    const char *map_file_path, int map_file_vfs_flags
+);
+
 S3DEXP char *spew3d_lvlbox_ToString(
     s3d_lvlbox *lvlbox, uint32_t *out_slen
 );
@@ -280,5 +324,38 @@ S3DEXP s3d_lvlbox *spew3d_lvlbox_GetByID(uint64_t id);
 
 S3DEXP uint64_t spew3d_lvlbox_GetID(s3d_lvlbox *lvlbox);
 
+/** Get the current edit generation of the lvlbox. Every edit
+ *  that changes tiles increases it, and the chunks touched by
+ *  the edit get the new number as their own edit generation.
+ *  Consumers of derived data (collision, baked meshes, saved
+ *  files, ...) can remember this number and later use
+ *  spew3d_lvlbox_GetChunksEditedSince() to only redo the chunks
+ *  that actually changed.
+ */
+S3DEXP uint64_t spew3d_lvlbox_GetEditGeneration(
+    s3d_lvlbox *lvlbox
+);
+
+/** Get the edit generation of the last change to the given
+ *  chunk, or 0 if the chunk index is invalid. Resizing the
+ *  lvlbox moves chunks around, so it marks all chunks changed.
+ */
+S3DEXP uint64_t spew3d_lvlbox_GetChunkEditGeneration(
+    s3d_lvlbox *lvlbox, uint32_t chunk_index
+);
+
+/** Get a dirty bitmap with one bit per chunk index, with a bit
+ *  being set if that chunk was changed after since_generation.
+ *  The bitmap must be freed by the caller with free().
+ *  Also returns the chunk count the bitmap covers, and the
+ *  current edit generation to pass in the next time around.
+ *  Returns 1 on success, 0 on out of memory.
+ */
+S3DEXP int spew3d_lvlbox_GetChunksEditedSince(
+    s3d_lvlbox *lvlbox, uint64_t since_generation,
+    uint8_t **out_dirty_bitmap, uint32_t *out_chunk_count,
+    uint64_t *out_current_generation
+);
+
 #endif  // SPEW3D_LVLBOX_H_
 
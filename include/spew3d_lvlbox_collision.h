@@ -0,0 +1,103 @@
+/* Copyright (c) 2024, ellie/@ell1e & Spew3D Team (see AUTHORS.md).
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+Alternatively, at your option, this file is offered under the Apache 2
+license, see accompanied LICENSE.md.
+*/
+
+
+#ifndef SPEW3D_LVLBOX_COLLISION_H_
+#define SPEW3D_LVLBOX_COLLISION_H_
+
+#include <stdint.h>
+
+typedef struct s3d_lvlbox s3d_lvlbox;
+
+typedef struct s3d_lvlbox_groundinfo {
+    int32_t chunk_index, tile_index, segment_no;
+    s3dnum_t floor_z, ceiling_z;
+} s3d_lvlbox_groundinfo;
+
+typedef struct s3d_lvlbox_collisionhit {
+    uint8_t hit;
+    s3dnum_t distance;
+    s3d_pos pos, normal;
+    int32_t chunk_index, tile_index, segment_no;
+    int wall_no;
+    uint8_t hit_floor, hit_ceiling, hit_fence;
+} s3d_lvlbox_collisionhit;
+
+/** Look up the floor and ceiling height for each of the given
+ *  positions, under a single lock of the lvlbox. The segment used
+ *  is the one spew3d_lvlbox_WorldPosToTilePos() would pick for the
+ *  same position. Positions outside of the lvlbox or above empty
+ *  tiles get a segment_no of -1. Returns how many positions had
+ *  ground below or around them.
+ */
+S3DEXP uint32_t spew3d_lvlbox_collision_GroundHeights(
+    s3d_lvlbox *lvlbox, const s3d_pos *positions,
+    uint32_t position_count, int ignore_lvlbox_offset,
+    s3d_lvlbox_groundinfo *out_info
+);
+
+/** Cast a ray from ray_origin along ray_dir (which doesn't need
+ *  to be normalized) for up to max_distance units, walking the
+ *  tiles in order. Floors, ceilings, solid fences and the sides
+ *  of tiles that have no free space at the hit height all stop
+ *  the ray. Returns 1 and fills out_hit on a hit, 0 otherwise.
+ */
+S3DEXP int spew3d_lvlbox_collision_RayCast(
+    s3d_lvlbox *lvlbox, s3d_pos ray_origin, s3d_pos ray_dir,
+    s3dnum_t max_distance, int ignore_lvlbox_offset,
+    s3d_lvlbox_collisionhit *out_hit
+);
+
+S3DEXP uint32_t spew3d_lvlbox_collision_RayCastBatch(
+    s3d_lvlbox *lvlbox, const s3d_pos *ray_origins,
+    const s3d_pos *ray_dirs, uint32_t ray_count,
+    s3dnum_t max_distance, int ignore_lvlbox_offset,
+    s3d_lvlbox_collisionhit *out_hits
+);
+
+/** Move a sphere from sweep_start to sweep_end, and find the first
+ *  wall or solid fence it touches. Walls are checked at the height
+ *  of the sphere's center, so for a sphere resting on the floor
+ *  any step lower than the radius doesn't block. On a hit, the
+ *  distance is the fraction of the sweep from 0.0 to 1.0 and pos
+ *  is the sphere's center when touching. Returns 1 on a hit.
+ */
+S3DEXP int spew3d_lvlbox_collision_SphereSweep(
+    s3d_lvlbox *lvlbox, s3d_pos sweep_start, s3d_pos sweep_end,
+    s3dnum_t radius, int ignore_lvlbox_offset,
+    s3d_lvlbox_collisionhit *out_hit
+);
+
+S3DEXP uint32_t spew3d_lvlbox_collision_SphereSweepBatch(
+    s3d_lvlbox *lvlbox, const s3d_pos *sweep_starts,
+    const s3d_pos *sweep_ends, uint32_t sweep_count,
+    s3dnum_t radius, int ignore_lvlbox_offset,
+    s3d_lvlbox_collisionhit *out_hits
+);
+
+#endif  // SPEW3D_LVLBOX_COLLISION_H_
+
@@ -171,6 +171,108 @@ typedef struct s3d_transform3d_cam_info {
 } s3d_transform3d_cam_info;
 
 
+/** A 4x4 matrix for affine 3D transforms, stored row by row.
+ *  It is applied to column vectors, so for a product A * B,
+ *  the transform of B is applied first.
+ */
+typedef struct s3d_matrix4 {
+    s3dnum_t m[4][4];
+} s3d_matrix4;
+
+S3DEXP void spew3d_math3d_matrix_identity(s3d_matrix4 *out);
+
+/** Compute out = a * b. The out matrix may be the same as a or b.
+ */
+S3DEXP void spew3d_math3d_matrix_multiply(
+    const s3d_matrix4 *a, const s3d_matrix4 *b,
+    s3d_matrix4 *out
+);
+
+/** Build the matrix doing the same as spew3d_math3d_rotate()
+ *  with the given rotation.
+ */
+S3DEXP void spew3d_math3d_matrix_fromrotation(
+    const s3d_rotation *r, s3d_matrix4 *out
+);
+
+/** Build the model matrix for an object, which rotates a point
+ *  around the object's origin and then moves it to the object's
+ *  world position.
+ */
+S3DEXP void spew3d_math3d_matrix_model(
+    const s3d_pos *model_world_pos,
+    const s3d_rotation *model_world_rotation,
+    s3d_matrix4 *out
+);
+
+/** Build the view matrix for a camera, which takes world
+ *  coordinates into camera space, with X pointing forward.
+ */
+S3DEXP void spew3d_math3d_matrix_view(
+    const s3d_transform3d_cam_info *cam_info,
+    s3d_matrix4 *out
+);
+
+/** Build the combined model and view matrix. Compute this once
+ *  per object and frame, then use spew3d_math3d_transform3d_matrix()
+ *  for all its vertices instead of spew3d_math3d_transform3d().
+ */
+S3DEXP void spew3d_math3d_matrix_modelview(
+    const s3d_transform3d_cam_info *cam_info,
+    const s3d_pos *model_world_pos,
+    const s3d_rotation *model_world_rotation,
+    s3d_matrix4 *out
+);
+
+static inline void spew3d_math3d_matrix_apply(
+        const s3d_matrix4 *mat, s3d_pos *p
+        ) {
+    s3dnum_t x = p->x;
+    s3dnum_t y = p->y;
+    s3dnum_t z = p->z;
+    p->x = mat->m[0][0] * x + mat->m[0][1] * y +
+        mat->m[0][2] * z + mat->m[0][3];
+    p->y = mat->m[1][0] * x + mat->m[1][1] * y +
+        mat->m[1][2] * z + mat->m[1][3];
+    p->z = mat->m[2][0] * x + mat->m[2][1] * y +
+        mat->m[2][2] * z + mat->m[2][3];
+}
+
+/** Get the camera position in the model space of a modelview
+ *  matrix built by spew3d_math3d_matrix_modelview(). This only
+ *  works for matrices made of just rotations and translations.
+ */
+S3DEXP void spew3d_math3d_matrix_camerapos(
+    const s3d_matrix4 *modelview, s3d_pos *out
+);
+
+/** Check whether a sphere is entirely outside of the camera's view,
+ *  given its center in camera space, e.g. the translation column of
+ *  a modelview matrix for the sphere's object. This is conservative,
+ *  so it may return 0 for spheres just outside of a view corner.
+ */
+S3DEXP int spew3d_math3d_sphere_outsideview(
+    s3d_transform3d_cam_info *cam_info,
+    const s3d_pos *center, s3dnum_t radius
+);
+
+/** Check whether a polygon faces away from a viewer, given a
+ *  normal pointing out of its visible side and any point on it.
+ *  All positions must be in the same space. The normal doesn't
+ *  need to be normalized.
+ */
+static inline int spew3d_math3d_polygon_facesaway(
+        const s3d_pos *normal, const s3d_pos *point_on_polygon,
+        const s3d_pos *viewer_pos
+        ) {
+    s3dnum_t dot = (
+        (viewer_pos->x - point_on_polygon->x) * normal->x +
+        (viewer_pos->y - point_on_polygon->y) * normal->y +
+        (viewer_pos->z - point_on_polygon->z) * normal->z
+    );
+    return (dot <= 0);
+}
+
 S3DEXP void spew3d_math3d_split_fovs_from_fov(
     s3dnum_t input_shared_fov,
     uint32_t pixel_width,
@@ -198,6 +300,53 @@ S3DEXP void spew3d_math3d_transform3d(
     s3d_pos *out_unscaled_pos
 );
 
+S3DEXP void spew3d_math3d_transform3d_matrix(
+    s3d_pos input_pos,
+    s3d_transform3d_cam_info *cam_info,
+    const s3d_matrix4 *modelview,
+    s3d_pos *out_pos,
+    s3d_pos *out_unscaled_pos
+);
+
+/** Transform many vertices at once, like calling
+ *  spew3d_math3d_transform3d_matrix() on each of them, but using
+ *  SIMD instructions where available. The input is given as
+ *  separate arrays for x, y and z. The output arrays get the
+ *  screen space result, and the unscaled output arrays get the
+ *  camera space positions. The unscaled output may be NULL.
+ *  The _f variant works on floats, which fits twice as many
+ *  vertices into each SIMD instruction.
+ */
+S3DEXP void spew3d_math3d_transform_batch_d(
+    const s3d_matrix4 *modelview,
+    s3d_transform3d_cam_info *cam_info,
+    const double *in_x, const double *in_y, const double *in_z,
+    uint32_t count,
+    double *out_x, double *out_y, double *out_z,
+    double *out_unscaled_x, double *out_unscaled_y,
+    double *out_unscaled_z
+);
+
+S3DEXP void spew3d_math3d_transform_batch_f(
+    const s3d_matrix4 *modelview,
+    s3d_transform3d_cam_info *cam_info,
+    const float *in_x, const float *in_y, const float *in_z,
+    uint32_t count,
+    float *out_x, float *out_y, float *out_z,
+    float *out_unscaled_x, float *out_unscaled_y,
+    float *out_unscaled_z
+);
+
+/** Transform many vertices at once, using whichever of
+ *  spew3d_math3d_transform_batch_d() or
+ *  spew3d_math3d_transform_batch_f() matches s3dnum_t.
+ */
+#if defined(SPEW3D_OPTION_FLOAT_MATH)
+#define spew3d_math3d_transform_batch spew3d_math3d_transform_batch_f
+#else
+#define spew3d_math3d_transform_batch spew3d_math3d_transform_batch_d
+#endif
+
 S3DEXP void spew3d_math3d_transform3dscreenspace(
     s3d_pos input_pos,
     s3d_transform3d_cam_info *cam_info,
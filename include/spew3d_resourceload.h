@@ -44,6 +44,10 @@ typedef struct s3d_resourceload_result {
         struct resource_image {
             void *pixels;
             uint64_t w, h;
+
+            // Box filtered half size levels, one after another:
+            void *mip_pixels;
+            uint8_t mip_count;
         } resource_image;
         struct generic {
             void *callback_result;
@@ -68,6 +72,16 @@ S3DEXP void s3d_resourceload_DestroyJob(
 
 S3DEXP int s3d_resourceload_IsDone(s3d_resourceload_job *job);
 
+/** Set a folder where decoded images get cached as raw RGBA
+ *  including their mip chain, so that later loads of the same
+ *  image file skip the slow PNG/JPEG decoding. The cache is keyed
+ *  by the compressed file's contents, so stale entries never get
+ *  used. The folder is created if missing. Pass NULL to turn the
+ *  cache off again, which is the default.
+ *  Returns 1 on success, 0 on failure.
+ */
+S3DEXP int s3d_resourceload_SetImageCacheFolder(const char *path);
+
 S3DEXP int s3d_resourceload_ExtractResult(
     s3d_resourceload_job *job,
     s3d_resourceload_result *out_result,
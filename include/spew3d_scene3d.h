@@ -36,7 +36,8 @@ enum Obj3dKind {
     OBJ3D_MESH,
     OBJ3D_SPRITE3D,
     OBJ3D_CAMERA,
-    OBJ3D_LVLBOX
+    OBJ3D_LVLBOX,
+    OBJ3D_INSTANCEDMESH
 };
 
 typedef struct s3d_scenecolorinfo {
@@ -59,6 +60,50 @@ S3DEXP s3d_obj3d *spew3d_scene3d_AddMeshObj(
     s3d_scene3d *sc, s3d_geometry *geom, int object_owns_mesh
 );
 
+/** Add a lower detail version of a mesh object's mesh, which
+ *  cameras draw instead once they are at least min_distance away
+ *  from the object. The closest level whose min_distance is reached
+ *  wins, and extra meshes are always drawn as they are.
+ *  Levels can be added while cameras are drawing the object, but
+ *  the list they replace is only freed once the main thread next
+ *  processes deletions.
+ *  Returns 1 on success, 0 on failure or if obj isn't a mesh object.
+ */
+S3DEXP int spew3d_obj3d_AddMeshLOD(
+    s3d_obj3d *obj, s3d_geometry *geom,
+    double min_distance, int object_owns_mesh
+);
+
+/** Generate level_count lower detail versions of a mesh object's
+ *  mesh via spew3d_geometry_Simplify() and add them like
+ *  spew3d_obj3d_AddMeshLOD() does. Each level has about half the
+ *  polygons of the previous one and is used from twice its distance,
+ *  starting at first_distance. Fewer levels may be generated if the
+ *  mesh can't be simplified that far. The object owns the generated
+ *  meshes, but they share the original mesh's textures.
+ *  The scene is only locked to add the finished levels, which are
+ *  all published at once, so cameras can keep drawing meanwhile.
+ *  Returns 1 on success, 0 on failure or if obj isn't a mesh object.
+ */
+S3DEXP int spew3d_obj3d_GenerateMeshLODs(
+    s3d_obj3d *obj, int level_count, double first_distance
+);
+
+/** Add an object that draws the same mesh many times, e.g. for
+ *  trees or crates. Each instance is placed relative to the object's
+ *  own position and rotation, and has its own tint. This is much
+ *  cheaper than adding one mesh object per instance, since cameras
+ *  go through all instances in one go and skip the ones out of view.
+ *  The instances are copied, and like an object's mesh they can't be
+ *  changed while the object is in the scene.
+ *  Returns NULL on failure.
+ */
+S3DEXP s3d_obj3d *spew3d_scene3d_AddInstancedMeshObj(
+    s3d_scene3d *sc, s3d_geometry *geom,
+    const s3d_geometryinstance *instances,
+    uint32_t instances_count, int object_owns_mesh
+);
+
 S3DEXP s3d_obj3d *spew3d_scene3d_AddLvlboxObj(
     s3d_scene3d *sc, s3d_lvlbox *lvlbox,
     int object_owns_lvlbox
@@ -106,5 +151,33 @@ S3DEXP int spew3d_obj3d_HasCustomTypeNum(s3d_obj3d *obj, int32_t typeno);
 
 S3DEXP void spew3d_obj3d_Destroy(s3d_obj3d *obj);
 
+/** Publish the current positions and rotations of all objects in
+ *  the scene as a snapshot. Once a scene has a snapshot, cameras
+ *  take object positions and rotations from the latest published one
+ *  instead of locking the scene, so they see a consistent frame and
+ *  don't hold up the simulation while collecting objects.
+ *  Only positions and rotations are copied. Cameras still read each
+ *  object's meshes, detail levels and instances directly, which is
+ *  why those must not change while the object is in the scene.
+ *  Rendering and the final freeing of destroyed objects both stay on
+ *  the main thread. Call this once per simulation tick, from one
+ *  thread at a time. Returns 1 on success, 0 on out of memory.
+ */
+S3DEXP int spew3d_scene3d_PublishSnapshot(s3d_scene3d *sc);
+
+typedef struct s3d_scene3d_snapshotentry {
+    s3d_obj3d *obj;  // NULL if it was destroyed since.
+    int kind;
+    s3d_pos pos;
+    s3d_rotation rot;
+} s3d_scene3d_snapshotentry;
+
+S3DHID int _spew3d_scene3d_AcquireSnapshot(
+    s3d_scene3d *sc, s3d_scene3d_snapshotentry **out_entries,
+    uint32_t *out_count
+);
+
+S3DHID void _spew3d_scene3d_ReleaseSnapshot(s3d_scene3d *sc);
+
 #endif  // SPEW3D_SCENE3D_H_
 
@@ -0,0 +1,103 @@
+/* Copyright (c) 2020-2024, ellie/@ell1e & Spew3D Team (see AUTHORS.md).
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+Alternatively, at your option, this file is offered under the Apache 2
+license, see accompanied LICENSE.md.
+*/
+
+
+#ifndef SPEW3D_SPRITEBATCH_H_
+#define SPEW3D_SPRITEBATCH_H_
+
+#include <stdint.h>
+
+typedef uint64_t s3d_texture_t;
+typedef struct s3d_window s3d_window;
+typedef struct s3d_spritebatch s3d_spritebatch;
+
+typedef struct s3d_spritebatch_entry {
+    s3d_texture_t tid;
+    int32_t pixel_x, pixel_y;
+    s3dnum_t scale, angle;
+    s3dnum_t tint_red, tint_green, tint_blue, transparency;
+    s3dnum_t uv_x, uv_y, uv_w, uv_h;
+    uint8_t centered, withalphachannel;
+} s3d_spritebatch_entry;
+
+/** Create a sprite batch, which collects many sprites to then
+ *  draw them all at once with spew3d_spritebatch_DrawToWindow().
+ *  Consecutive sprites that use the same texture, or small textures
+ *  packed into the same atlas page, are drawn with one call to the
+ *  GPU. Therefore, for best performance add sprites grouped by
+ *  texture where the drawing order allows it.
+ */
+S3DEXP s3d_spritebatch *spew3d_spritebatch_New();
+
+/** Add a sprite to the batch, with the same parameters as for
+ *  spew3d_texture_DrawAtCanvasPixels().
+ */
+S3DEXP int spew3d_spritebatch_Add(
+    s3d_spritebatch *batch,
+    s3d_texture_t tid,
+    int32_t x, int32_t y, int centered,
+    s3dnum_t scale, s3dnum_t angle,
+    s3dnum_t tint_red, s3dnum_t tint_green, s3dnum_t tint_blue,
+    s3dnum_t transparency,
+    int withalphachannel
+);
+
+/** Like spew3d_spritebatch_Add(), but only draw the given region
+ *  of the texture, e.g. for one frame of a sprite sheet. The region
+ *  is specified in texture coordinates from 0.0 to 1.0, and the
+ *  sprite's size is that of the region scaled by the given scale.
+ */
+S3DEXP int spew3d_spritebatch_AddRegion(
+    s3d_spritebatch *batch,
+    s3d_texture_t tid,
+    int32_t x, int32_t y, int centered,
+    s3dnum_t scale, s3dnum_t angle,
+    s3dnum_t tint_red, s3dnum_t tint_green, s3dnum_t tint_blue,
+    s3dnum_t transparency,
+    int withalphachannel,
+    s3dnum_t uv_x, s3dnum_t uv_y, s3dnum_t uv_w, s3dnum_t uv_h
+);
+
+/** Queue all sprites of the batch for drawing to the window, then
+ *  empty the batch so it can be filled anew for the next frame.
+ */
+S3DEXP int spew3d_spritebatch_DrawToWindow(
+    s3d_spritebatch *batch, s3d_window *win
+);
+
+S3DEXP uint32_t spew3d_spritebatch_GetCount(s3d_spritebatch *batch);
+
+S3DEXP void spew3d_spritebatch_Clear(s3d_spritebatch *batch);
+
+S3DEXP void spew3d_spritebatch_Destroy(s3d_spritebatch *batch);
+
+S3DHID void _spew3d_spritebatch_RecycleEntries(
+    s3d_spritebatch_entry *entries, uint32_t alloc
+);
+
+#endif  // SPEW3D_SPRITEBATCH_H_
+
@@ -43,6 +43,7 @@ typedef struct s3d_texture_info {
     int vfsflags;
     uint8_t loaded, loadingfailed;
     uint8_t correspondstofile;
+    uint32_t generation;
 
     void *_internal;
 } s3d_texture_info;
@@ -55,6 +56,13 @@ S3DEXP void spew3d_texinfo(
     s3d_texture_t id, s3d_texture_info *write_to
 );
 
+/** Check whether a texture id still refers to a live texture.
+ *  Since slots of destroyed textures get reused, old ids stop
+ *  being valid once their texture was destroyed, even if a new
+ *  texture was created in the same slot since then.
+ */
+S3DEXP int spew3d_texture_IsValid(s3d_texture_t tid);
+
 S3DEXP s3d_texture_t spew3d_texture_NewWritable(
     const char *name, uint32_t w, uint32_t h
 );
@@ -102,10 +110,76 @@ S3DEXP void spew3d_texture_LockPixelsToFinishEdit(
     s3d_texture_t tid
 );
 
+/** Find where a small texture was packed into a shared atlas
+ *  page, packing it in first if that didn't happen yet. This
+ *  allows drawing many small textures with the same GPU texture.
+ *  Only textures loaded from a file and up to 256x256 pixels are
+ *  packed. The texture coordinates (u, v) of the original map to
+ *  offset + (u, v) * scale on the returned page texture, which
+ *  only works for coordinates in the 0.0 to 1.0 range.
+ *
+ *  Returns 1 on success, 0 if the texture can't be packed, or -1
+ *  if it's still loading and the caller may want to retry later.
+ *  Newly packed textures also return -1 until the next frame, when
+ *  all pages that changed are uploaded again in one go.
+ *  The space is only reused once all textures packed into the same
+ *  page were destroyed.
+ *  Always returns 0 if SPEW3D_OPTION_DISABLE_TEXTURE_ATLAS is set.
+ */
+S3DEXP int spew3d_texture_GetAtlasRegion(
+    s3d_texture_t tid, s3d_texture_t *out_page,
+    s3d_point *out_offset, s3d_point *out_scale
+);
+
+/** Set how many bytes of texture data may stay resident on the GPU
+ *  and in main memory. When a budget is exceeded, the least recently
+ *  used GPU textures are evicted, and the pixel copies of textures
+ *  loaded from a file are dropped. Both get recreated on the next
+ *  use. Pixels obtained via spew3d_texture_GetReadonlyPixels() or
+ *  spew3d_texture_UnlockPixelsToEdit() are never dropped.
+ *  The defaults are 512MiB for the GPU and 1GiB for main memory.
+ */
+S3DEXP void spew3d_texture_SetMemoryBudget(
+    uint64_t gpu_bytes, uint64_t cpu_bytes
+);
+
+/** Get how many bytes of texture data are currently resident on
+ *  the GPU and in main memory. Either pointer may be NULL.
+ */
+S3DEXP void spew3d_texture_GetMemoryUsage(
+    uint64_t *out_gpu_bytes, uint64_t *out_cpu_bytes
+);
+
+/** Set how much texture data may be uploaded to the GPU per frame.
+ *  Textures are uploaded gradually by the main thread, and until
+ *  then drawn with a smaller level or a placeholder, so that scenes
+ *  with many new textures don't make a frame hitch. At least one
+ *  texture is always uploaded per frame, even if over budget.
+ *  The default is 16MiB or 4ms per frame, whichever comes first.
+ */
+S3DEXP void spew3d_texture_SetUploadBudget(
+    uint64_t bytes_per_frame, uint64_t ms_per_frame
+);
+
 S3DEXP int spew3d_texture_InternalMainThreadProcessEvent(
     s3d_event *e
 );
 
+S3DEXP void spew3d_texture_InternalMainThreadUpdate();
+
+// Maximum count of mip levels below the full size texture:
+#define SPEW3D_TEXTURE_MAX_MIPS 15
+
+S3DHID int _internal_spew3d_texture_BuildMipChain(
+    const char *pixels, uint32_t w, uint32_t h,
+    char **out_mip_pixels, uint8_t *out_mip_count
+);
+
+S3DHID uint64_t _internal_spew3d_texture_MipOffset(
+    uint32_t w, uint32_t h, int mip_level,
+    uint32_t *out_w, uint32_t *out_h
+);
+
 S3DHID s3d_texture_info *_internal_spew3d_texinfo_nolock(
     s3d_texture_t id
 );
@@ -84,6 +84,11 @@ S3DEXP void thread_Join(s3d_threadinfo *t);
 
 S3DEXP int thread_InMainThread();
 
+/** Returns the number of CPU cores available to this process,
+ *  or 1 if it can't be determined.
+ */
+S3DEXP int thread_GetCPUCount();
+
 S3DEXP void threadevent_Wait(s3d_tevent *e);
 
 S3DEXP void threadevent_Set(s3d_tevent *e);
@@ -372,6 +372,145 @@ S3DHID int _s3d_sdl_DrawPolygonAtPixels(
     return 1;
 }
 
+// Scratch buffers for sprite quads, only used from the main thread:
+static SDL_Vertex *_s3d_sdl_quad_vertices = NULL;
+static int *_s3d_sdl_quad_indices = NULL;
+static uint32_t _s3d_sdl_quad_alloc = 0;
+
+S3DHID int _s3d_sdl_DrawSpriteQuadsAtPixels(
+        s3d_backend_windowing *backend, s3d_window *win,
+        s3d_backend_windowing_wininfo *_backend_winfo,
+        s3d_backend_windowing_gputex *tex,
+        const s3d_backend_windowing_spritequad *quads,
+        uint32_t quad_count
+        ) {
+    s3d_backend_windowing_wininfo_sdl2 *backend_winfo =
+        (s3d_backend_windowing_wininfo_sdl2 *)_backend_winfo;
+    SDL_Renderer *renderer = backend_winfo->sdl_renderer;
+    assert(backend_winfo != NULL);
+    assert(renderer != NULL);
+    if (quad_count == 0)
+        return 1;
+
+    if (quad_count > _s3d_sdl_quad_alloc) {
+        uint32_t new_alloc = _s3d_sdl_quad_alloc * 2;
+        if (new_alloc < quad_count)
+            new_alloc = quad_count;
+        SDL_Vertex *new_vertices = realloc(
+            _s3d_sdl_quad_vertices,
+            sizeof(*new_vertices) * new_alloc * 4
+        );
+        if (!new_vertices)
+            return 0;
+        _s3d_sdl_quad_vertices = new_vertices;
+        int *new_indices = realloc(
+            _s3d_sdl_quad_indices,
+            sizeof(*new_indices) * new_alloc * 6
+        );
+        if (!new_indices)
+            return 0;
+        _s3d_sdl_quad_indices = new_indices;
+        _s3d_sdl_quad_alloc = new_alloc;
+    }
+    uint32_t i = 0;
+    while (i < quad_count) {
+        const s3d_backend_windowing_spritequad *q = &quads[i];
+        SDL_Color c;
+        c.r = fmax(0, fmin(255, (double)q->color.red * 255.0));
+        c.g = fmax(0, fmin(255, (double)q->color.green * 255.0));
+        c.b = fmax(0, fmin(255, (double)q->color.blue * 255.0));
+        c.a = fmax(0, fmin(255, (double)q->color.alpha * 255.0));
+        SDL_Vertex *v = &_s3d_sdl_quad_vertices[i * 4];
+        int k = 0;
+        while (k < 4) {
+            v[k].position.x = q->corners[k].x;
+            v[k].position.y = q->corners[k].y;
+            v[k].color = c;
+            v[k].tex_coord.x = q->texcoords[k].x;
+            v[k].tex_coord.y = q->texcoords[k].y;
+            k++;
+        }
+        int *idx = &_s3d_sdl_quad_indices[i * 6];
+        idx[0] = i * 4 + 0;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 0;
+        idx[4] = i * 4 + 2;
+        idx[5] = i * 4 + 3;
+        i++;
+    }
+    if (SDL_SetRenderDrawBlendMode(renderer,
+            SDL_BLENDMODE_BLEND) != 0) {
+        return 0;
+    }
+    if (SDL_RenderGeometry(renderer, (SDL_Texture *)tex,
+            _s3d_sdl_quad_vertices, quad_count * 4,
+            _s3d_sdl_quad_indices, quad_count * 6) != 0)
+        return 0;
+    return 1;
+}
+
+// Scratch buffer for polygon batches, only used from the main thread:
+static SDL_Vertex *_s3d_sdl_poly_vertices = NULL;
+static uint32_t _s3d_sdl_poly_alloc = 0;
+
+S3DHID int _s3d_sdl_DrawPolygonsAtPixels(
+        s3d_backend_windowing *backend, s3d_window *win,
+        s3d_backend_windowing_wininfo *_backend_winfo,
+        s3d_backend_windowing_gputex *tex,
+        const s3d_drawpolygon *polygons,
+        uint32_t polygon_count
+        ) {
+    s3d_backend_windowing_wininfo_sdl2 *backend_winfo =
+        (s3d_backend_windowing_wininfo_sdl2 *)_backend_winfo;
+    SDL_Renderer *renderer = backend_winfo->sdl_renderer;
+    assert(backend_winfo != NULL);
+    assert(renderer != NULL);
+    if (polygon_count == 0)
+        return 1;
+
+    if (polygon_count > _s3d_sdl_poly_alloc) {
+        uint32_t new_alloc = _s3d_sdl_poly_alloc * 2;
+        if (new_alloc < polygon_count)
+            new_alloc = polygon_count;
+        SDL_Vertex *new_vertices = realloc(
+            _s3d_sdl_poly_vertices,
+            sizeof(*new_vertices) * new_alloc * 3
+        );
+        if (!new_vertices)
+            return 0;
+        _s3d_sdl_poly_vertices = new_vertices;
+        _s3d_sdl_poly_alloc = new_alloc;
+    }
+    uint32_t i = 0;
+    while (i < polygon_count) {
+        SDL_Vertex *v = &_s3d_sdl_poly_vertices[i * 3];
+        int k = 0;
+        while (k < 3) {
+            const s3d_drawvertex *dv = &polygons[i].vertex[k];
+            v[k].position.x = dv->x;
+            v[k].position.y = dv->y;
+            v[k].color.r = dv->red;
+            v[k].color.g = dv->green;
+            v[k].color.b = dv->blue;
+            v[k].color.a = dv->alpha;
+            v[k].tex_coord.x = dv->texcoord_x;
+            v[k].tex_coord.y = dv->texcoord_y;
+            k++;
+        }
+        i++;
+    }
+    if (SDL_SetRenderDrawBlendMode(renderer,
+            SDL_BLENDMODE_BLEND) != 0) {
+        return 0;
+    }
+    if (SDL_RenderGeometry(renderer, (SDL_Texture *)tex,
+            _s3d_sdl_poly_vertices, polygon_count * 3,
+            NULL, 0) != 0)
+        return 0;
+    return 1;
+}
+
 S3DHID int _s3d_sdl_CreateWinObj(
         s3d_backend_windowing *backend, s3d_window *win,
         s3d_backend_windowing_wininfo *_backend_winfo,
@@ -513,7 +652,9 @@ S3DHID __attribute__((constructor)) static void _init_sdl2_backend() {
         b->CreateGPUTexture = _s3d_sdl_CreateGPUTexture;
         b->DestroyGPUTexture = _s3d_sdl_DestroyGPUTexture;
         b->DrawSpriteAtPixels = _s3d_sdl_DrawSpriteAtPixels;
+        b->DrawSpriteQuadsAtPixels = _s3d_sdl_DrawSpriteQuadsAtPixels;
         b->DrawPolygonAtPixels = _s3d_sdl_DrawPolygonAtPixels;
+        b->DrawPolygonsAtPixels = _s3d_sdl_DrawPolygonsAtPixels;
 
         _singleton_sdl_backend = b;
     }
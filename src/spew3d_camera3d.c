@@ -45,6 +45,10 @@ typedef struct s3d_window s3d_window;
 #define RENDERENTRY_LIGHT 3
 #define RENDERENTRY_LVLBOX 4
 
+// How many instances of an instanced mesh object go into one
+// render queue entry:
+#define SPEW3D_CAMERA3D_INSTANCES_PER_ENTRY 64
+
 typedef struct s3d_queuedrenderentry {
     int kind;
     union {
@@ -55,6 +59,12 @@ typedef struct s3d_queuedrenderentry {
             s3d_rotation world_rotation;
             s3d_pos world_pos;
             double world_max_extent;
+
+            // For instanced mesh objects, the instances to draw the
+            // mesh at, relative to world_pos and world_rotation:
+            const s3d_geometryinstance *instances;
+            uint32_t instances_count;
+            s3dnum_t instance_radius;
         } rendermesh;
         struct rendersprite3d {
             s3d_rotation world_rotation;
@@ -76,13 +86,20 @@ typedef struct s3d_camdata {
     uint32_t _render_queue_buffer_alloc;
     s3d_renderpolygon *_render_polygon_buffer;
     uint32_t _render_polygon_buffer_alloc;
+    s3d_drawpolygon *_render_draw_buffer;
+    uint32_t _render_draw_buffer_alloc;
     s3d_sortstructcache *_render_sort_cache;
 } s3d_camdata;
 
 S3DHID s3d_backend_windowing_gputex *
-    _internal_spew3d_MainThreadOnly_GetGPUTex_nolock(
-        s3d_window *win, s3d_texture_t tex, int withalphachannel
-    );;
+    _internal_spew3d_MainThreadOnly_GetGPUTexMip_nolock(
+        s3d_window *win, s3d_texture_t tex, int withalphachannel,
+        s3dnum_t texcoord_area, s3dnum_t pixel_area
+    );
+S3DHID s3d_backend_windowing_gputex *
+    _internal_spew3d_MainThreadOnly_GetPlaceholderGPUTex_nolock(
+        s3d_window *win
+    );
 S3DHID s3d_scenecolorinfo spew3d_scene3d_GetColorInfo_nolock(
     s3d_scene3d *sc
 );
@@ -100,6 +117,15 @@ S3DHID void _spew3d_scene3d_GetObjMeshes_nolock(
     s3d_geometry ***extra_meshes,
     uint32_t *extra_meshes_count
 );
+S3DHID s3d_geometry *_spew3d_scene3d_GetObjMeshForDistance_nolock(
+    s3d_obj3d *obj, double distance
+);
+S3DHID void _spew3d_scene3d_GetObjInstances_nolock(
+    s3d_obj3d *obj, s3d_geometry **mesh,
+    s3dnum_t *mesh_radius,
+    const s3d_geometryinstance **instances,
+    uint32_t *instances_count
+);
 S3DEXP double spew3d_obj3d_GetOuterMaxExtentRadius_nolock(
     s3d_obj3d *obj
 );
@@ -130,6 +156,12 @@ S3DHID void spew3d_camera_CameraFreeData(
     if (mdata->_render_queue_buffer) {
         free(mdata->_render_queue_buffer);
     }
+    if (mdata->_render_polygon_buffer) {
+        free(mdata->_render_polygon_buffer);
+    }
+    if (mdata->_render_draw_buffer) {
+        free(mdata->_render_draw_buffer);
+    }
     if (mdata->_render_sort_cache) {
         s3d_itemsort_FreeCache(mdata->_render_sort_cache);
     }
@@ -181,15 +213,11 @@ S3DEXP void spew3d_camera3d_RenderToWindow(
         s3d_obj3d *cam, s3d_window *win
         ) {
     assert(_spew3d_scene3d_GetKind_nolock(cam) == OBJ3D_CAMERA);
-    s3d_equeue *eq = _spew3d_event_GetInternalQueue();
-    if (!eq)
-        return;
-
     s3d_event e = {0};
     e.kind = S3DEV_INTERNAL_CMD_CAM3D_DRAWTOWINDOW;
     e.cam3d.obj_ref = cam;
     e.cam3d.win_id = spew3d_window_GetID(win);
-    if (!spew3d_event_q_Insert(eq, &e))
+    if (!_spew3d_event_InsertDrawCmd(&e))
         return;
 }
 
@@ -197,17 +225,13 @@ S3DHID void _spew3d_window_ExtractCanvasSize_nolock(
     s3d_window *win, uint32_t *out_w, uint32_t *out_h
 );
 
-S3DHID static int _depthCompareRenderPolygons(
+S3DHID static int _depthCompareDrawPolygons(
         void *item1, void *item2
         ) {
-    s3d_renderpolygon *entry1 = item1;
-    s3d_renderpolygon *entry2 = item2;
-    /*printf("comparing poly %p <-> %p, "
-        "entry1->vertex_pos[0].x = %f "
-        "entry2->vertex_pos[0].x = %f\n",
-        entry1->vertex_pos_pixels[0].x, entry2->vertex_pos_pixels[0].x);*/
-    double depth1 = (entry1->min_depth + entry1->max_depth) / 2;
-    double depth2 = (entry2->min_depth + entry2->max_depth) / 2;
+    s3d_drawpolygon *entry1 = item1;
+    s3d_drawpolygon *entry2 = item2;
+    float depth1 = entry1->depth;
+    float depth2 = entry2->depth;
     if (depth1 < depth2)
         return 1;
     if (depth1 > depth2)
@@ -277,11 +301,615 @@ S3DHID static int _spew3d_camera3d_CheckClipped(
     return 0;
 }
 
+#define SPEW3D_CAMERA3D_SPLIT_MAX_DEPTH 4
+#define SPEW3D_CAMERA3D_SPLIT_MAX_PIECES 256  // 4 ^ max depth
+#define SPEW3D_CAMERA3D_NEAR_PLANE (0.1 * S3D_METER)
+
+S3DHID static int _spew3d_camera3d_PolygonNeedsSplit(
+        s3d_renderpolygon *p,
+        double pixel_wf, double pixel_hf,
+        double threshold
+        ) {
+    if (_spew3d_camera3d_CheckClipped(p, pixel_wf, pixel_hf))
+        return 0;
+    return (fabs(p->vertex_pos_pixels[0].z -
+            p->vertex_pos_pixels[1].z) > threshold ||
+        fabs(p->vertex_pos_pixels[0].y -
+            p->vertex_pos_pixels[1].y) > threshold ||
+        fabs(p->vertex_pos_pixels[0].x -
+            p->vertex_pos_pixels[1].x) > threshold ||
+        fabs(p->vertex_pos_pixels[0].z -
+            p->vertex_pos_pixels[2].z) > threshold ||
+        fabs(p->vertex_pos_pixels[0].y -
+            p->vertex_pos_pixels[2].y) > threshold ||
+        fabs(p->vertex_pos_pixels[0].x -
+            p->vertex_pos_pixels[2].x) > threshold ||
+        fabs(p->vertex_pos_pixels[1].z -
+            p->vertex_pos_pixels[2].z) > threshold ||
+        fabs(p->vertex_pos_pixels[1].y -
+            p->vertex_pos_pixels[2].y) > threshold ||
+        fabs(p->vertex_pos_pixels[1].x -
+            p->vertex_pos_pixels[2].x) > threshold);
+}
+
+typedef struct s3d_camera3d_splitcorner {
+    s3d_pos pos, pos_pixels, normal;
+    s3d_point texcoord;
+    s3d_color emit;
+} s3d_camera3d_splitcorner;
+
+S3DHID static void _spew3d_camera3d_GetSplitCorner(
+        s3d_renderpolygon *p, int i,
+        s3d_camera3d_splitcorner *out
+        ) {
+    out->pos = p->vertex_pos[i];
+    out->pos_pixels = p->vertex_pos_pixels[i];
+    out->normal = p->vertex_normal[i];
+    out->texcoord = p->vertex_texcoord[i];
+    out->emit = p->vertex_emit[i];
+}
+
+S3DHID static void _spew3d_camera3d_LerpSplitCorner(
+        s3d_transform3d_cam_info *cam_info,
+        s3d_camera3d_splitcorner *c1, s3d_camera3d_splitcorner *c2,
+        double t, s3d_camera3d_splitcorner *out
+        ) {
+    // Positions, texcoords and colors are all linear across the
+    // polygon in camera space, so points along an edge can simply
+    // be interpolated without solving for barycentric coordinates:
+    out->pos.x = c1->pos.x + (c2->pos.x - c1->pos.x) * t;
+    out->pos.y = c1->pos.y + (c2->pos.y - c1->pos.y) * t;
+    out->pos.z = c1->pos.z + (c2->pos.z - c1->pos.z) * t;
+    out->normal.x = c1->normal.x + (c2->normal.x - c1->normal.x) * t;
+    out->normal.y = c1->normal.y + (c2->normal.y - c1->normal.y) * t;
+    out->normal.z = c1->normal.z + (c2->normal.z - c1->normal.z) * t;
+    spew3d_math3d_normalize(&out->normal);
+    out->texcoord.x = c1->texcoord.x +
+        (c2->texcoord.x - c1->texcoord.x) * t;
+    out->texcoord.y = c1->texcoord.y +
+        (c2->texcoord.y - c1->texcoord.y) * t;
+    out->emit.red = c1->emit.red + (c2->emit.red - c1->emit.red) * t;
+    out->emit.green = c1->emit.green +
+        (c2->emit.green - c1->emit.green) * t;
+    out->emit.blue = c1->emit.blue +
+        (c2->emit.blue - c1->emit.blue) * t;
+    out->emit.alpha = c1->emit.alpha +
+        (c2->emit.alpha - c1->emit.alpha) * t;
+
+    // The projection isn't linear, so that one is recomputed:
+    spew3d_math3d_transform3dscreenspace(
+        out->pos, cam_info, &out->pos_pixels, NULL
+    );
+}
+
+S3DHID static void _spew3d_camera3d_SetSplitCorners(
+        s3d_renderpolygon *p,
+        s3d_camera3d_splitcorner *c1, s3d_camera3d_splitcorner *c2,
+        s3d_camera3d_splitcorner *c3
+        ) {
+    s3d_camera3d_splitcorner *c[3];
+    c[0] = c1;
+    c[1] = c2;
+    c[2] = c3;
+    int i = 0;
+    while (i < 3) {
+        p->vertex_pos[i] = c[i]->pos;
+        p->vertex_pos_pixels[i] = c[i]->pos_pixels;
+        p->vertex_normal[i] = c[i]->normal;
+        p->vertex_texcoord[i] = c[i]->texcoord;
+        p->vertex_emit[i] = c[i]->emit;
+        i++;
+    }
+    _internal_spew3d_camera3d_UpdateRenderPolyData(p, 0);
+}
+
+S3DHID static void _spew3d_camera3d_SplitPolygonInFour(
+        s3d_transform3d_cam_info *cam_info,
+        s3d_renderpolygon *p, s3d_renderpolygon *p2,
+        s3d_renderpolygon *p3, s3d_renderpolygon *p4
+        ) {
+    s3d_camera3d_splitcorner v1, v2, v3;
+    _spew3d_camera3d_GetSplitCorner(p, 0, &v1);
+    _spew3d_camera3d_GetSplitCorner(p, 1, &v2);
+    _spew3d_camera3d_GetSplitCorner(p, 2, &v3);
+    s3d_camera3d_splitcorner v1tov2, v2tov3, v3tov1;
+    _spew3d_camera3d_LerpSplitCorner(cam_info, &v1, &v2, 0.5, &v1tov2);
+    _spew3d_camera3d_LerpSplitCorner(cam_info, &v2, &v3, 0.5, &v2tov3);
+    _spew3d_camera3d_LerpSplitCorner(cam_info, &v3, &v1, 0.5, &v3tov1);
+
+    memcpy(p2, p, sizeof(*p2));
+    memcpy(p3, p, sizeof(*p3));
+    memcpy(p4, p, sizeof(*p4));
+    _spew3d_camera3d_SetSplitCorners(p2, &v1tov2, &v2, &v2tov3);
+    _spew3d_camera3d_SetSplitCorners(p3, &v2tov3, &v3, &v3tov1);
+    _spew3d_camera3d_SetSplitCorners(p4, &v2tov3, &v3tov1, &v1tov2);
+    _spew3d_camera3d_SetSplitCorners(p, &v1, &v1tov2, &v3tov1);
+}
+
+S3DHID static int _spew3d_camera3d_ClipPolygonNear(
+        s3d_transform3d_cam_info *cam_info,
+        s3d_renderpolygon *p, s3d_renderpolygon *out_extra
+        ) {
+    // Clip the polygon against the near plane. This leaves either
+    // nothing, one polygon in p, or two polygons in p and out_extra.
+    // Returns how many polygons there are:
+    const double near = SPEW3D_CAMERA3D_NEAR_PLANE;
+    if (p->min_depth >= near)
+        return 1;
+    if (p->max_depth < near)
+        return 0;
+    s3d_camera3d_splitcorner c[3];
+    _spew3d_camera3d_GetSplitCorner(p, 0, &c[0]);
+    _spew3d_camera3d_GetSplitCorner(p, 1, &c[1]);
+    _spew3d_camera3d_GetSplitCorner(p, 2, &c[2]);
+
+    // Walk the edges in order, keeping the corners in front of the
+    // plane and adding one where an edge crosses it. This keeps the
+    // winding intact:
+    s3d_camera3d_splitcorner result[4];
+    int count = 0;
+    int i = 0;
+    while (i < 3) {
+        s3d_camera3d_splitcorner *cur = &c[i];
+        s3d_camera3d_splitcorner *next = &c[(i + 1) % 3];
+        int cur_in = (cur->pos.x >= near);
+        int next_in = (next->pos.x >= near);
+        if (cur_in) {
+            result[count] = *cur;
+            count++;
+        }
+        if (cur_in != next_in) {
+            double t = (near - cur->pos.x) /
+                (next->pos.x - cur->pos.x);
+            _spew3d_camera3d_LerpSplitCorner(
+                cam_info, cur, next, t, &result[count]
+            );
+            count++;
+        }
+        i++;
+    }
+    assert(count == 3 || count == 4);
+    if (count == 4) {
+        memcpy(out_extra, p, sizeof(*out_extra));
+        _spew3d_camera3d_SetSplitCorners(
+            out_extra, &result[0], &result[2], &result[3]
+        );
+    }
+    _spew3d_camera3d_SetSplitCorners(
+        p, &result[0], &result[1], &result[2]
+    );
+    return (count == 4 ? 2 : 1);
+}
+
+S3DHID static uint32_t _spew3d_camera3d_SplitPolygon(
+        s3d_transform3d_cam_info *cam_info,
+        s3d_renderpolygon *pieces,
+        double pixel_wf, double pixel_hf,
+        double threshold
+        ) {
+    // Split the polygon in pieces[0] level by level, appending new
+    // pieces. The pieces array must fit the most pieces possible,
+    // so this never needs to allocate:
+    uint32_t count = 1;
+    int depth = 0;
+    int hadsplit = 1;
+    while (hadsplit && depth < SPEW3D_CAMERA3D_SPLIT_MAX_DEPTH) {
+        depth++;
+        hadsplit = 0;
+        uint32_t origcount = count;
+        uint32_t i = 0;
+        while (i < origcount) {
+            if (_spew3d_camera3d_PolygonNeedsSplit(
+                    &pieces[i], pixel_wf, pixel_hf, threshold)) {
+                hadsplit = 1;
+                assert(count + 3 <= SPEW3D_CAMERA3D_SPLIT_MAX_PIECES);
+                _spew3d_camera3d_SplitPolygonInFour(
+                    cam_info, &pieces[i], &pieces[count],
+                    &pieces[count + 1], &pieces[count + 2]
+                );
+                count += 3;
+            }
+            i++;
+        }
+    }
+    return count;
+}
+
+S3DHID static int _spew3d_camera3d_ReserveSplitOutput(
+        s3d_renderpolygon **out, uint32_t *out_fill,
+        uint32_t *out_alloc, uint32_t amount
+        ) {
+    if (*out_fill + amount <= *out_alloc)
+        return 1;
+    uint32_t newalloc = (*out_fill + amount) * 2;
+    s3d_renderpolygon *newout = realloc(
+        *out, sizeof(*newout) * newalloc
+    );
+    if (!newout)
+        return 0;
+    *out = newout;
+    *out_alloc = newalloc;
+    return 1;
+}
+
+S3DHID static int _spew3d_camera3d_SplitPolygonToOutput(
+        s3d_transform3d_cam_info *cam_info,
+        s3d_renderpolygon *poly,
+        double pixel_wf, double pixel_hf, double threshold,
+        s3d_renderpolygon **scratch,
+        s3d_renderpolygon **out, uint32_t *out_fill,
+        uint32_t *out_alloc
+        ) {
+    // Split the given polygon if needed, with the first piece
+    // replacing it and all others appended to the output:
+    if (!_spew3d_camera3d_PolygonNeedsSplit(
+            poly, pixel_wf, pixel_hf, threshold))
+        return 1;
+    if (*scratch == NULL) {
+        *scratch = malloc(
+            sizeof(**scratch) * SPEW3D_CAMERA3D_SPLIT_MAX_PIECES
+        );
+        if (!*scratch)
+            return 0;
+    }
+    // Reserve space for the most pieces we could get, so that
+    // we grow the output at most once per split polygon:
+    if (!_spew3d_camera3d_ReserveSplitOutput(
+            out, out_fill, out_alloc,
+            SPEW3D_CAMERA3D_SPLIT_MAX_PIECES - 1
+            ))
+        return 0;
+    memcpy(&(*scratch)[0], poly, sizeof(*poly));
+    uint32_t count = _spew3d_camera3d_SplitPolygon(
+        cam_info, *scratch, pixel_wf, pixel_hf, threshold
+    );
+    assert(count >= 4);
+    memcpy(poly, &(*scratch)[0], sizeof(*poly));
+    memcpy(&(*out)[*out_fill], &(*scratch)[1],
+        sizeof(**out) * (count - 1));
+    *out_fill += count - 1;
+    return 1;
+}
+
+S3DHID static int _spew3d_camera3d_SplitPolygonRange(
+        s3d_transform3d_cam_info *cam_info,
+        s3d_renderpolygon *polys,
+        uint32_t range_start, uint32_t range_end,
+        double pixel_wf, double pixel_hf,
+        s3d_renderpolygon **scratch,
+        s3d_renderpolygon **out, uint32_t *out_fill,
+        uint32_t *out_alloc
+        ) {
+    double threshold = (pixel_wf + pixel_hf) / 2.0 / 3.0;
+    uint32_t i = range_start;
+    while (i < range_end) {
+        // Clip against the near plane first, so that splitting only
+        // needs to deal with the affine texture distortion:
+        if (polys[i].min_depth < SPEW3D_CAMERA3D_NEAR_PLANE) {
+            s3d_renderpolygon extra;
+            int clip_count = _spew3d_camera3d_ClipPolygonNear(
+                cam_info, &polys[i], &extra
+            );
+            if (clip_count == 0) {
+                // Nothing left, this gets dropped when drawing.
+                polys[i].clipped = 1;
+                i++;
+                continue;
+            }
+            if (clip_count == 2) {
+                if (!_spew3d_camera3d_SplitPolygonToOutput(
+                        cam_info, &extra, pixel_wf, pixel_hf,
+                        threshold, scratch, out, out_fill, out_alloc
+                        ) ||
+                        !_spew3d_camera3d_ReserveSplitOutput(
+                        out, out_fill, out_alloc, 1
+                        ))
+                    return 0;
+                memcpy(&(*out)[*out_fill], &extra, sizeof(extra));
+                *out_fill += 1;
+            }
+        }
+        if (!_spew3d_camera3d_SplitPolygonToOutput(
+                cam_info, &polys[i], pixel_wf, pixel_hf,
+                threshold, scratch, out, out_fill, out_alloc
+                ))
+            return 0;
+        i++;
+    }
+    return 1;
+}
+
+S3DHID static void _spew3d_camera3d_TransformQueueRange(
+        s3d_queuedrenderentry *queue,
+        uint32_t range_start, uint32_t range_end,
+        int kind,
+        s3d_transform3d_cam_info *cinfo,
+        s3d_geometryrenderlightinfo *rinfo,
+        s3d_renderpolygon **polybuf,
+        uint32_t *polybuf_fill, uint32_t *polybuf_alloc
+        ) {
+    uint32_t i = range_start;
+    while (i < range_end) {
+        if (queue[i].kind != kind) {
+            i++;
+            continue;
+        }
+        if (kind == RENDERENTRY_MESH &&
+                queue[i].rendermesh.instances != NULL) {
+            rinfo->dynlight_mode = DLRD_LIT_FLAT;
+            spew3d_geometry_TransformInstances(
+                queue[i].rendermesh.geom,
+                &queue[i].rendermesh.world_pos,
+                &queue[i].rendermesh.world_rotation,
+                queue[i].rendermesh.instances,
+                queue[i].rendermesh.instances_count,
+                queue[i].rendermesh.instance_radius,
+                cinfo, rinfo, polybuf, polybuf_fill, polybuf_alloc
+            );
+        } else if (kind == RENDERENTRY_MESH) {
+            rinfo->dynlight_mode = DLRD_LIT_FLAT;
+            spew3d_geometry_Transform(
+                queue[i].rendermesh.geom,
+                &queue[i].rendermesh.world_pos,
+                &queue[i].rendermesh.world_rotation,
+                cinfo, rinfo, polybuf, polybuf_fill, polybuf_alloc
+            );
+            // If that failed we ran out of memory, or the mesh
+            // is empty. Not much we can do either way.
+        } else if (kind == RENDERENTRY_LVLBOX) {
+            rinfo->dynlight_mode = DLRD_LIT_FLAT;
+            spew3d_lvlbox_Transform(
+                queue[i].renderlvlbox.lvlbox,
+                &queue[i].renderlvlbox.world_pos,
+                &queue[i].renderlvlbox.world_rotation,
+                cinfo, rinfo, polybuf, polybuf_fill, polybuf_alloc
+            );
+        }
+        i++;
+    }
+}
+
+#ifndef SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+
+#define SPEW3D_CAMERA3D_MAX_TRANSFORM_WORKERS 15
+#define SPEW3D_CAMERA3D_MIN_ENTRIES_PER_WORKER 8
+#define SPEW3D_CAMERA3D_MIN_POLYGONS_PER_WORKER 64
+
+#define TRANSFORMJOB_TRANSFORM 1
+#define TRANSFORMJOB_SPLIT 2
+
+typedef struct s3d_camera3d_transformworker {
+    s3d_semaphore *start_job;
+    int job;
+    uint32_t range_start, range_end;
+    s3d_transform3d_cam_info cinfo;
+    s3d_queuedrenderentry *queue;  // For TRANSFORMJOB_TRANSFORM.
+    s3d_geometryrenderlightinfo rinfo;
+    s3d_renderpolygon *split_polys;  // For TRANSFORMJOB_SPLIT.
+    double pixel_wf, pixel_hf;
+    int split_failed;
+
+    // Kept between frames, so we don't reallocate every time:
+    s3d_renderpolygon *polybuf;
+    uint32_t polybuf_fill, polybuf_alloc;
+    s3d_renderpolygon *split_scratch;
+} s3d_camera3d_transformworker;
+
+// These are only ever touched by the main thread, which is the only
+// one processing draw requests, or by a worker while it owns a job:
+static s3d_camera3d_transformworker *_transform_worker = NULL;
+static int _transform_worker_count = 0;
+static int _transform_worker_spawn_failed = 0;
+static s3d_semaphore *_transform_worker_done = NULL;
+
+S3DHID static void _spew3d_camera3d_TransformWorkerThread(
+        void *userdata
+        ) {
+    s3d_camera3d_transformworker *worker = userdata;
+    while (1) {
+        semaphore_Wait(worker->start_job);
+        worker->polybuf_fill = 0;
+        if (worker->job == TRANSFORMJOB_TRANSFORM) {
+            _spew3d_camera3d_TransformQueueRange(
+                worker->queue, worker->range_start,
+                worker->range_end,
+                RENDERENTRY_MESH, &worker->cinfo, &worker->rinfo,
+                &worker->polybuf, &worker->polybuf_fill,
+                &worker->polybuf_alloc
+            );
+        } else {
+            assert(worker->job == TRANSFORMJOB_SPLIT);
+            worker->split_failed = !_spew3d_camera3d_SplitPolygonRange(
+                &worker->cinfo, worker->split_polys,
+                worker->range_start, worker->range_end,
+                worker->pixel_wf, worker->pixel_hf,
+                &worker->split_scratch,
+                &worker->polybuf, &worker->polybuf_fill,
+                &worker->polybuf_alloc
+            );
+        }
+        semaphore_Post(_transform_worker_done);
+    }
+}
+
+S3DHID static int _spew3d_camera3d_EnsureTransformWorkers() {
+    if (_transform_worker != NULL)
+        return 1;
+    if (_transform_worker_spawn_failed)
+        return 0;
+    int count = thread_GetCPUCount() - 1;
+    if (count > SPEW3D_CAMERA3D_MAX_TRANSFORM_WORKERS)
+        count = SPEW3D_CAMERA3D_MAX_TRANSFORM_WORKERS;
+    if (count < 1) {
+        _transform_worker_spawn_failed = 1;
+        return 0;
+    }
+    _transform_worker_done = semaphore_Create(0);
+    if (!_transform_worker_done) {
+        _transform_worker_spawn_failed = 1;
+        return 0;
+    }
+    s3d_camera3d_transformworker *workers = malloc(
+        sizeof(*workers) * count
+    );
+    if (!workers) {
+        semaphore_Destroy(_transform_worker_done);
+        _transform_worker_done = NULL;
+        _transform_worker_spawn_failed = 1;
+        return 0;
+    }
+    memset(workers, 0, sizeof(*workers) * count);
+    int spawned = 0;
+    while (spawned < count) {
+        workers[spawned].start_job = semaphore_Create(0);
+        if (!workers[spawned].start_job)
+            break;
+        s3d_threadinfo *t = thread_Spawn(
+            _spew3d_camera3d_TransformWorkerThread,
+            &workers[spawned]
+        );
+        if (!t) {
+            semaphore_Destroy(workers[spawned].start_job);
+            workers[spawned].start_job = NULL;
+            break;
+        }
+        thread_Detach(t);
+        spawned++;
+    }
+    if (spawned == 0) {
+        free(workers);
+        semaphore_Destroy(_transform_worker_done);
+        _transform_worker_done = NULL;
+        _transform_worker_spawn_failed = 1;
+        return 0;
+    }
+    #if defined(DEBUG_SPEW3D_RENDER3D)
+    printf("spew3d_camera3d.c: debug: "
+        "Spawned %d polygon transform workers.\n", spawned);
+    #endif
+    _transform_worker = workers;
+    _transform_worker_count = spawned;
+    return 1;
+}
+
+S3DHID static int _spew3d_camera3d_MergeWorkerPolygons(
+        int use_workers, s3d_renderpolygon **polybuf,
+        uint32_t *polybuf_fill, uint32_t *polybuf_alloc
+        ) {
+    uint32_t total = *polybuf_fill;
+    int k = 0;
+    while (k < use_workers) {
+        total += _transform_worker[k].polybuf_fill;
+        k++;
+    }
+    if (total > *polybuf_alloc) {
+        s3d_renderpolygon *newbuf = realloc(
+            *polybuf, sizeof(*newbuf) * total
+        );
+        if (!newbuf)
+            return 0;
+        *polybuf = newbuf;
+        *polybuf_alloc = total;
+    }
+    k = 0;
+    while (k < use_workers) {
+        s3d_camera3d_transformworker *w = &_transform_worker[k];
+        if (w->polybuf_fill > 0)
+            memcpy(&(*polybuf)[*polybuf_fill], w->polybuf,
+                sizeof(**polybuf) * w->polybuf_fill);
+        *polybuf_fill += w->polybuf_fill;
+        k++;
+    }
+    return 1;
+}
+
+#endif  // SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+
+S3DHID static int _spew3d_camera3d_TransformQueue(
+        s3d_queuedrenderentry *queue, uint32_t queuefill,
+        s3d_transform3d_cam_info *cinfo,
+        s3d_geometryrenderlightinfo *rinfo,
+        s3d_renderpolygon **polybuf,
+        uint32_t *polybuf_fill, uint32_t *polybuf_alloc
+        ) {
+    assert(thread_InMainThread());
+    #ifndef SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+    // Figure out how many workers are worth waking up:
+    int use_workers = 0;
+    if (queuefill >= SPEW3D_CAMERA3D_MIN_ENTRIES_PER_WORKER * 2 &&
+            _spew3d_camera3d_EnsureTransformWorkers()) {
+        use_workers = (int)(
+            queuefill / SPEW3D_CAMERA3D_MIN_ENTRIES_PER_WORKER
+        ) - 1;
+        if (use_workers > _transform_worker_count)
+            use_workers = _transform_worker_count;
+    }
+    if (use_workers > 0) {
+        // Split the meshes into even ranges. The first range is
+        // ours, the rest go to the workers:
+        uint32_t per_range = queuefill / (use_workers + 1);
+        uint32_t our_end = queuefill - per_range * use_workers;
+        uint32_t range_start = our_end;
+        int k = 0;
+        while (k < use_workers) {
+            s3d_camera3d_transformworker *w = &_transform_worker[k];
+            w->job = TRANSFORMJOB_TRANSFORM;
+            w->queue = queue;
+            w->range_start = range_start;
+            w->range_end = range_start + per_range;
+            memcpy(&w->cinfo, cinfo, sizeof(*cinfo));
+            memcpy(&w->rinfo, rinfo, sizeof(*rinfo));
+            range_start += per_range;
+            semaphore_Post(w->start_job);
+            k++;
+        }
+        assert(range_start == queuefill);
+
+        // Level boxes update their tile caches while transforming,
+        // so they stay on this thread in case one is shared:
+        _spew3d_camera3d_TransformQueueRange(
+            queue, 0, queuefill, RENDERENTRY_LVLBOX, cinfo, rinfo,
+            polybuf, polybuf_fill, polybuf_alloc
+        );
+        _spew3d_camera3d_TransformQueueRange(
+            queue, 0, our_end, RENDERENTRY_MESH, cinfo, rinfo,
+            polybuf, polybuf_fill, polybuf_alloc
+        );
+        k = 0;
+        while (k < use_workers) {
+            semaphore_Wait(_transform_worker_done);
+            k++;
+        }
+
+        // Merge the worker results into our buffer. If we run out
+        // of memory, we'll render what we have at least:
+        return _spew3d_camera3d_MergeWorkerPolygons(
+            use_workers, polybuf, polybuf_fill, polybuf_alloc
+        );
+    }
+    #endif
+    _spew3d_camera3d_TransformQueueRange(
+        queue, 0, queuefill, RENDERENTRY_LVLBOX, cinfo, rinfo,
+        polybuf, polybuf_fill, polybuf_alloc
+    );
+    _spew3d_camera3d_TransformQueueRange(
+        queue, 0, queuefill, RENDERENTRY_MESH, cinfo, rinfo,
+        polybuf, polybuf_fill, polybuf_alloc
+    );
+    return 1;
+}
+
+// Only used by the main thread, for the range it splits itself:
+static s3d_renderpolygon *_split_mainthread_scratch = NULL;
+static s3d_renderpolygon *_split_mainthread_out = NULL;
+static uint32_t _split_mainthread_out_alloc = 0;
+
 S3DHID static int _spew3d_camera3d_SplitPolygonsIfNeeded(
         s3d_obj3d *cam, s3d_transform3d_cam_info *cam_info,
         uint32_t *buf_fill,
         uint32_t pixel_w, uint32_t pixel_h
         ) {
+    assert(thread_InMainThread());
     spew3d_obj3d_LockAccess(cam);
     s3d_camdata *cdata = (s3d_camdata *)(
         _spew3d_scene3d_ObjExtraData_nolock(cam)
@@ -292,206 +920,157 @@ S3DHID static int _spew3d_camera3d_SplitPolygonsIfNeeded(
     spew3d_obj3d_ReleaseAccess(cam);
     double pixel_wf = pixel_w;
     double pixel_hf = pixel_h;
-    double threshold = (pixel_wf + pixel_hf) / 2.0 / 3.0;
-    double threshold_fine = (pixel_wf + pixel_hf) / 2.0 / 8.0;
-
-    uint32_t origfill = fill;
-    int maxiterations = 4;
-    int hadsplit = 1;
-    while (hadsplit && maxiterations > 0) {
-        maxiterations--;
-        hadsplit = 0;
-        origfill = fill;
-        uint32_t i = 0;
-        while (i < origfill) {
-            s3d_renderpolygon *p = &polys[i];
-            double applied_threshold = threshold;
-            if (p->min_depth <= 0)
-                applied_threshold = threshold_fine;
-            if (!_spew3d_camera3d_CheckClipped(p,
-                    pixel_wf, pixel_hf) &&
-                    fabs(p->vertex_pos_pixels[0].z -
-                        p->vertex_pos_pixels[1].z) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[0].y -
-                        p->vertex_pos_pixels[1].y) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[0].x -
-                        p->vertex_pos_pixels[1].x) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[0].z -
-                        p->vertex_pos_pixels[2].z) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[0].y -
-                        p->vertex_pos_pixels[2].y) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[0].x -
-                        p->vertex_pos_pixels[2].x) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[1].z -
-                        p->vertex_pos_pixels[2].z) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[1].y -
-                        p->vertex_pos_pixels[2].y) >
-                        applied_threshold ||
-                    fabs(p->vertex_pos_pixels[1].x -
-                        p->vertex_pos_pixels[2].x) >
-                        applied_threshold) {
-                // We want to split this one up.
-                hadsplit = 1;
-                if (fill + 3 > alloc) {
-                    uint32_t newalloc = (fill + 3 + 32) * 2;
-                    s3d_renderpolygon *newpolys = realloc(
-                        polys, sizeof(*newpolys) * newalloc
-                    );
-                    if (!newpolys) {
-                        spew3d_obj3d_LockAccess(cam);
-                        cdata->_render_polygon_buffer = polys;
-                        cdata->_render_polygon_buffer_alloc = alloc;
-                        *buf_fill = fill;
-                        spew3d_obj3d_ReleaseAccess(cam);
-                        return 0;
-                    }
-                    polys = newpolys;
-                    alloc = newalloc;
-                    p = &polys[i];
-                }
 
-                s3d_pos sample_v1tov2;
-                sample_v1tov2.x = (p->vertex_pos[0].x +
-                    p->vertex_pos[1].x) / 2;
-                sample_v1tov2.y = (p->vertex_pos[0].y +
-                    p->vertex_pos[1].y) / 2;
-                sample_v1tov2.z = (p->vertex_pos[0].z +
-                    p->vertex_pos[1].z) / 2;
-                s3d_point sample_v1tov2_tx;
-                s3d_pos sample_v1tov2_pixels;
-
-                s3d_pos sample_v2tov3;
-                sample_v2tov3.x = (p->vertex_pos[1].x +
-                    p->vertex_pos[2].x) / 2;
-                sample_v2tov3.y = (p->vertex_pos[1].y +
-                    p->vertex_pos[2].y) / 2;
-                sample_v2tov3.z = (p->vertex_pos[1].z +
-                    p->vertex_pos[2].z) / 2;
-                s3d_point sample_v2tov3_tx;
-                s3d_pos sample_v2tov3_pixels;
-
-                s3d_pos sample_v3tov1;
-                sample_v3tov1.x = (p->vertex_pos[2].x +
-                    p->vertex_pos[0].x) / 2;
-                sample_v3tov1.y = (p->vertex_pos[2].y +
-                    p->vertex_pos[0].y) / 2;
-                sample_v3tov1.z = (p->vertex_pos[2].z +
-                    p->vertex_pos[0].z) / 2;
-                s3d_point sample_v3tov1_tx;
-                s3d_pos sample_v3tov1_pixels;
-
-                spew3d_math3d_sample_polygon_texcoord(
-                    cam_info,
-                    &p->vertex_pos[0], &p->vertex_pos[1],
-                    &p->vertex_pos[2],
-                    &p->vertex_texcoord[0], &p->vertex_texcoord[1],
-                    &p->vertex_texcoord[2],
-                    sample_v1tov2,
-                    &sample_v1tov2, &sample_v1tov2_pixels,
-                    &sample_v1tov2_tx
-                );
-                spew3d_math3d_sample_polygon_texcoord(
-                    cam_info,
-                    &p->vertex_pos[0], &p->vertex_pos[1],
-                    &p->vertex_pos[2],
-                    &p->vertex_texcoord[0], &p->vertex_texcoord[1],
-                    &p->vertex_texcoord[2],
-                    sample_v2tov3,
-                    &sample_v2tov3, &sample_v2tov3_pixels,
-                    &sample_v2tov3_tx
-                );
-                spew3d_math3d_sample_polygon_texcoord(
-                    cam_info,
-                    &p->vertex_pos[0], &p->vertex_pos[1],
-                    &p->vertex_pos[2],
-                    &p->vertex_texcoord[0], &p->vertex_texcoord[1],
-                    &p->vertex_texcoord[2],
-                    sample_v3tov1,
-                    &sample_v3tov1, &sample_v3tov1_pixels,
-                    &sample_v3tov1_tx
-                );
+    // Every polygon is split on its own, so ranges of them can be
+    // split in parallel. New pieces go into separate output buffers
+    // first, so nobody grows the buffer the others are reading:
+    int use_workers = 0;
+    #ifndef SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+    if (fill >= SPEW3D_CAMERA3D_MIN_POLYGONS_PER_WORKER * 2 &&
+            _spew3d_camera3d_EnsureTransformWorkers()) {
+        use_workers = (int)(
+            fill / SPEW3D_CAMERA3D_MIN_POLYGONS_PER_WORKER
+        ) - 1;
+        if (use_workers > _transform_worker_count)
+            use_workers = _transform_worker_count;
+    }
+    #endif
+    uint32_t per_range = fill / (use_workers + 1);
+    uint32_t our_end = fill - per_range * use_workers;
+    #ifndef SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+    uint32_t range_start = our_end;
+    int k = 0;
+    while (k < use_workers) {
+        s3d_camera3d_transformworker *w = &_transform_worker[k];
+        w->job = TRANSFORMJOB_SPLIT;
+        w->split_polys = polys;
+        w->range_start = range_start;
+        w->range_end = range_start + per_range;
+        memcpy(&w->cinfo, cam_info, sizeof(*cam_info));
+        w->pixel_wf = pixel_wf;
+        w->pixel_hf = pixel_hf;
+        w->split_failed = 0;
+        range_start += per_range;
+        semaphore_Post(w->start_job);
+        k++;
+    }
+    assert(range_start == fill);
+    #endif
+    uint32_t our_out_fill = 0;
+    int result = _spew3d_camera3d_SplitPolygonRange(
+        cam_info, polys, 0, our_end, pixel_wf, pixel_hf,
+        &_split_mainthread_scratch, &_split_mainthread_out,
+        &our_out_fill, &_split_mainthread_out_alloc
+    );
+    #ifndef SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+    k = 0;
+    while (k < use_workers) {
+        semaphore_Wait(_transform_worker_done);
+        k++;
+    }
+    k = 0;
+    while (k < use_workers) {
+        if (_transform_worker[k].split_failed)
+            result = 0;
+        k++;
+    }
+    #endif
 
-                s3d_renderpolygon *p2 = &polys[fill];
-                s3d_renderpolygon *p3 = &polys[fill + 1];
-                s3d_renderpolygon *p4 = &polys[fill + 2];
-                memcpy(p2, p, sizeof(*p2));
-                memcpy(p3, p, sizeof(*p3));
-                memcpy(p4, p, sizeof(*p4));
-
-                p2->vertex_pos[0] = sample_v1tov2;
-                p2->vertex_pos[1] = p->vertex_pos[1];
-                p2->vertex_pos[2] = sample_v2tov3;
-                p2->vertex_pos_pixels[0] = sample_v1tov2_pixels;
-                p2->vertex_pos_pixels[1] = (
-                    p->vertex_pos_pixels[1]
-                );
-                p2->vertex_pos_pixels[2] = sample_v2tov3_pixels;
-                p2->vertex_texcoord[0] = sample_v1tov2_tx;
-                p2->vertex_texcoord[1] = p->vertex_texcoord[1];
-                p2->vertex_texcoord[2] = sample_v2tov3_tx;
-                _internal_spew3d_camera3d_UpdateRenderPolyData(
-                    polys, fill
-                );
-                fill++;
-                assert(fill <= alloc);
-
-                p3->vertex_pos[0] = sample_v2tov3;
-                p3->vertex_pos[1] = p->vertex_pos[2];
-                p3->vertex_pos[2] = sample_v3tov1;
-                p3->vertex_pos_pixels[0] = sample_v2tov3_pixels;
-                p3->vertex_pos_pixels[1] = (
-                    p->vertex_pos_pixels[2]
-                );
-                p3->vertex_pos_pixels[2] = sample_v3tov1_pixels;
-                p3->vertex_texcoord[0] = sample_v2tov3_tx;
-                p3->vertex_texcoord[1] = p->vertex_texcoord[2];
-                p3->vertex_texcoord[2] = sample_v3tov1_tx;
-                _internal_spew3d_camera3d_UpdateRenderPolyData(
-                    polys, fill
-                );
-                fill++;
-                assert(fill <= alloc);
-
-                p4->vertex_pos[0] = sample_v2tov3;
-                p4->vertex_pos[1] = sample_v3tov1;
-                p4->vertex_pos[2] = sample_v1tov2;
-                p4->vertex_pos_pixels[0] = sample_v2tov3_pixels;
-                p4->vertex_pos_pixels[1] = sample_v3tov1_pixels;
-                p4->vertex_pos_pixels[2] = sample_v1tov2_pixels;
-                p4->vertex_texcoord[0] = sample_v2tov3_tx;
-                p4->vertex_texcoord[1] = sample_v3tov1_tx;
-                p4->vertex_texcoord[2] = sample_v1tov2_tx;
-                _internal_spew3d_camera3d_UpdateRenderPolyData(
-                    polys, fill
-                );
-                fill++;
-                assert(fill <= alloc);
-
-                p->vertex_pos[1] = sample_v1tov2;
-                p->vertex_pos[2] = sample_v3tov1;
-                p->vertex_pos_pixels[1] = sample_v1tov2_pixels;
-                p->vertex_pos_pixels[2] = sample_v3tov1_pixels;
-                p->vertex_texcoord[1] = sample_v1tov2_tx;
-                p->vertex_texcoord[2] = sample_v3tov1_tx;
-                _internal_spew3d_camera3d_UpdateRenderPolyData(
-                    polys, i
-                );
+    // Append all the new pieces with one resize:
+    if (our_out_fill > 0) {
+        if (fill + our_out_fill > alloc) {
+            uint32_t newalloc = fill + our_out_fill;
+            s3d_renderpolygon *newpolys = realloc(
+                polys, sizeof(*newpolys) * newalloc
+            );
+            if (!newpolys) {
+                result = 0;
+                our_out_fill = 0;
+            } else {
+                polys = newpolys;
+                alloc = newalloc;
             }
-            i++;
         }
+        if (our_out_fill > 0)
+            memcpy(&polys[fill], _split_mainthread_out,
+                sizeof(*polys) * our_out_fill);
+        fill += our_out_fill;
     }
+    #ifndef SPEW3D_OPTION_DISABLE_THREADED_TRANSFORM
+    if (use_workers > 0 && !_spew3d_camera3d_MergeWorkerPolygons(
+            use_workers, &polys, &fill, &alloc
+            ))
+        result = 0;
+    #endif
     spew3d_obj3d_LockAccess(cam);
     cdata->_render_polygon_buffer = polys;
     cdata->_render_polygon_buffer_alloc = alloc;
     *buf_fill = fill;
     spew3d_obj3d_ReleaseAccess(cam);
+    return result;
+}
+
+S3DHID static uint8_t _spew3d_camera3d_ColorToByte(s3dnum_t value) {
+    if (!(value > 0))
+        return 0;
+    if (value >= 1)
+        return 255;
+    return (uint8_t)(value * 255.0 + 0.5);
+}
+
+S3DHID static int _spew3d_camera3d_BuildDrawPolygons(
+        s3d_renderpolygon *polys, uint32_t poly_count,
+        s3d_drawpolygon **drawbuf, uint32_t *draw_fill,
+        uint32_t *draw_alloc
+        ) {
+    s3d_drawpolygon *draws = *drawbuf;
+    if (poly_count > *draw_alloc) {
+        uint32_t newalloc = poly_count + 64;
+        s3d_drawpolygon *newdraws = realloc(
+            draws, sizeof(*newdraws) * newalloc
+        );
+        if (!newdraws)
+            return 0;
+        draws = newdraws;
+        *drawbuf = draws;
+        *draw_alloc = newalloc;
+    }
+    uint32_t fill = 0;
+    uint32_t i = 0;
+    while (i < poly_count) {
+        const s3d_renderpolygon *p = &polys[i];
+        // Skip what was entirely clipped away by the near plane:
+        if (p->max_depth < SPEW3D_CAMERA3D_NEAR_PLANE) {
+            i++;
+            continue;
+        }
+        s3d_drawpolygon *d = &draws[fill];
+        int k = 0;
+        while (k < 3) {
+            d->vertex[k].x = p->vertex_pos_pixels[k].y;
+            d->vertex[k].y = p->vertex_pos_pixels[k].z;
+            d->vertex[k].texcoord_x = p->vertex_texcoord[k].x;
+            d->vertex[k].texcoord_y = p->vertex_texcoord[k].y;
+            d->vertex[k].red = _spew3d_camera3d_ColorToByte(
+                p->vertex_emit[k].red
+            );
+            d->vertex[k].green = _spew3d_camera3d_ColorToByte(
+                p->vertex_emit[k].green
+            );
+            d->vertex[k].blue = _spew3d_camera3d_ColorToByte(
+                p->vertex_emit[k].blue
+            );
+            d->vertex[k].alpha = _spew3d_camera3d_ColorToByte(
+                p->vertex_emit[k].alpha
+            );
+            k++;
+        }
+        d->depth = (p->min_depth + p->max_depth) / 2;
+        d->texture = p->polygon_texture;
+        fill++;
+        i++;
+    }
+    *draw_fill = fill;
     return 1;
 }
 
@@ -530,24 +1109,34 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
         );
     #endif
 
-    // First, collect whatever we even want to render:
-    s3d_spatialstore3d *store = (
-        spew3d_scene3d_GetStoreByObj3d(cam)
-    );
-    assert(store != NULL);
-    s3d_obj3d **buf = cdata->_render_collect_objects_buffer;
-    uint32_t alloc = cdata->_render_collect_objects_alloc;
+    // First, collect whatever we even want to render. If the scene
+    // publishes snapshots, use the latest one, so that we don't
+    // need to hold the scene lock against the simulation:
+    s3d_scene3d *snap_sc = spew3d_obj3d_GetScene_nolock(cam);
+    s3d_scene3d_snapshotentry *snap = NULL;
     uint32_t count = 0;
-    int result = store->IterateAll(
-        store, NULL, 0, &buf,
-        &alloc, &count
-    );
-    if (!result) {
-        // We're probably out of memory. Not much we can do.
-        count = 0;
+    s3d_obj3d **buf = cdata->_render_collect_objects_buffer;
+    if (snap_sc != NULL && _spew3d_scene3d_AcquireSnapshot(
+            snap_sc, &snap, &count)) {
+        // Nothing to do here.
+    } else {
+        snap = NULL;
+        s3d_spatialstore3d *store = (
+            spew3d_scene3d_GetStoreByObj3d(cam)
+        );
+        assert(store != NULL);
+        uint32_t alloc = cdata->_render_collect_objects_alloc;
+        int result = store->IterateAll(
+            store, NULL, 0, &buf,
+            &alloc, &count
+        );
+        if (!result) {
+            // We're probably out of memory. Not much we can do.
+            count = 0;
+        }
+        cdata->_render_collect_objects_buffer = buf;
+        cdata->_render_collect_objects_alloc = alloc;
     }
-    cdata->_render_collect_objects_buffer = buf;
-    cdata->_render_collect_objects_alloc = alloc;
     // For performance reasons, make a separate copy to process
     // culling first, so that things like physics and AI can
     // continue without us blocking them.
@@ -558,21 +1147,31 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
     s3d_queuedrenderentry *queue = cdata->_render_queue_buffer;
     uint32_t queue_alloc = cdata->_render_queue_buffer_alloc;
     if (count <= 0) {
+        if (snap != NULL)
+            _spew3d_scene3d_ReleaseSnapshot(snap_sc);
         mutex_Lock(_win_id_mutex);
         return 1;
     }
-    spew3d_obj3d_LockAccess(cam);  // Should also lock scene.
+    if (snap == NULL)
+        spew3d_obj3d_LockAccess(cam);  // Should also lock scene.
     uint32_t queuefill = 0;
     uint32_t i = 0;
     while (i < count) {
-        s3d_obj3d *obj = buf[i];
-        if (_spew3d_obj3d_GetWasDeleted_nolock(obj)) {
+        s3d_obj3d *obj = (snap != NULL ? snap[i].obj : buf[i]);
+        if (obj == NULL || (snap == NULL &&
+                _spew3d_obj3d_GetWasDeleted_nolock(obj))) {
             i++;
             continue;
         }
-        int kind = _spew3d_scene3d_GetKind_nolock(obj);
+        int kind = (snap != NULL ? snap[i].kind :
+            _spew3d_scene3d_GetKind_nolock(obj));
+        if (snap != NULL && obj == cam) {
+            // Use the camera position matching this snapshot:
+            cam_pos = snap[i].pos;
+            cam_rot = snap[i].rot;
+        }
         if (kind != OBJ3D_MESH && kind != OBJ3D_SPRITE3D &&
-                kind != OBJ3D_LVLBOX
+                kind != OBJ3D_LVLBOX && kind != OBJ3D_INSTANCEDMESH
                 ) {
             i++;
             continue;
@@ -584,19 +1183,22 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
             );
             if (!newqueue) {
                 // Out of memory, we can't render like this.
-                cdata->_render_queue_buffer = queue;
-                cdata->_render_queue_buffer_alloc = queue_alloc;
-                spew3d_obj3d_ReleaseAccess(cam);
+                if (snap != NULL)
+                    _spew3d_scene3d_ReleaseSnapshot(snap_sc);
+                else
+                    spew3d_obj3d_ReleaseAccess(cam);
                 mutex_Lock(_win_id_mutex);
                 return 1;
             }
             queue = newqueue;
             queue_alloc = new_alloc;
+            cdata->_render_queue_buffer = queue;
+            cdata->_render_queue_buffer_alloc = queue_alloc;
         }
-        s3d_pos pos = spew3d_obj3d_GetPos_nolock(obj);
-        s3d_rotation rot = (
-            spew3d_obj3d_GetRotation_nolock(obj)
-        );
+        s3d_pos pos = (snap != NULL ? snap[i].pos :
+            spew3d_obj3d_GetPos_nolock(obj));
+        s3d_rotation rot = (snap != NULL ? snap[i].rot :
+            spew3d_obj3d_GetRotation_nolock(obj));
         if (kind == OBJ3D_SPRITE3D) {
             // FIXME. Actually save some info on sprite, somehow.
             memset(&queue[queuefill], 0, sizeof(queue[queuefill]));
@@ -617,6 +1219,64 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
             queuefill++;
             i++;
             continue;
+        } else if (kind == OBJ3D_INSTANCEDMESH) {
+            s3d_geometry *mesh = NULL;
+            s3dnum_t mesh_radius = 0;
+            const s3d_geometryinstance *instances = NULL;
+            uint32_t instances_count = 0;
+            _spew3d_scene3d_GetObjInstances_nolock(
+                obj, &mesh, &mesh_radius, &instances,
+                &instances_count
+            );
+            // Chop the instances into chunks, so that they can be
+            // spread over the transform workers like regular meshes:
+            uint32_t chunks = (
+                (instances_count +
+                SPEW3D_CAMERA3D_INSTANCES_PER_ENTRY - 1) /
+                SPEW3D_CAMERA3D_INSTANCES_PER_ENTRY
+            );
+            if (queuefill + chunks > queue_alloc) {
+                uint32_t new_alloc = (16 + queuefill + chunks) * 2;
+                s3d_queuedrenderentry *newqueue = realloc(
+                    queue, sizeof(*queue) * new_alloc
+                );
+                if (!newqueue) {
+                    // Out of memory, we can't render like this.
+                    if (snap != NULL)
+                        _spew3d_scene3d_ReleaseSnapshot(snap_sc);
+                    else
+                        spew3d_obj3d_ReleaseAccess(cam);
+                    mutex_Lock(_win_id_mutex);
+                    return 1;
+                }
+                queue = newqueue;
+                queue_alloc = new_alloc;
+                cdata->_render_queue_buffer = queue;
+                cdata->_render_queue_buffer_alloc = queue_alloc;
+            }
+            uint32_t j = 0;
+            while (j < instances_count) {
+                uint32_t chunk_count = instances_count - j;
+                if (chunk_count > SPEW3D_CAMERA3D_INSTANCES_PER_ENTRY)
+                    chunk_count = SPEW3D_CAMERA3D_INSTANCES_PER_ENTRY;
+                memset(&queue[queuefill], 0,
+                    sizeof(queue[queuefill]));
+                queue[queuefill].kind = RENDERENTRY_MESH;
+                queue[queuefill].rendermesh.geom = mesh;
+                queue[queuefill].rendermesh.world_pos = pos;
+                queue[queuefill].rendermesh.world_rotation = rot;
+                queue[queuefill].rendermesh.instances = &instances[j];
+                queue[queuefill].rendermesh.instances_count = (
+                    chunk_count
+                );
+                queue[queuefill].rendermesh.instance_radius = (
+                    mesh_radius
+                );
+                queuefill++;
+                j += chunk_count;
+            }
+            i++;
+            continue;
         }
         assert(kind == OBJ3D_MESH);
 
@@ -628,8 +1288,12 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
             obj, &first_mesh, &extra_meshes,
             &extra_meshes_count
         );
+        // Far away objects may use a lower detail mesh:
+        first_mesh = _spew3d_scene3d_GetObjMeshForDistance_nolock(
+            obj, spew3d_math3d_dist(&pos, &cam_pos)
+        );
         if (extra_meshes_count > 0 &&
-                queuefill + extra_meshes_count > queue_alloc) {
+                queuefill + 1 + extra_meshes_count > queue_alloc) {
             uint32_t new_alloc = (
                 16 + queuefill +
                 extra_meshes_count
@@ -639,12 +1303,17 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
             );
             if (!newqueue) {
                 // Out of memory, we can't render like this.
-                spew3d_obj3d_ReleaseAccess(cam);
+                if (snap != NULL)
+                    _spew3d_scene3d_ReleaseSnapshot(snap_sc);
+                else
+                    spew3d_obj3d_ReleaseAccess(cam);
                 mutex_Lock(_win_id_mutex);
                 return 1;
             }
             queue = newqueue;
             queue_alloc = new_alloc;
+            cdata->_render_queue_buffer = queue;
+            cdata->_render_queue_buffer_alloc = queue_alloc;
         }
         memset(&queue[queuefill], 0, sizeof(queue[queuefill]));
         queue[queuefill].kind = RENDERENTRY_MESH;
@@ -660,12 +1329,11 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
             memcpy(&queue[queuefill],
                 &queue[origindex], sizeof(queue[queuefill]));
             queue[queuefill].rendermesh.geom = extra_meshes[j];
+            queuefill++;
             j++;
         }
         i++;
     }
-    cdata->_render_queue_buffer = queue;
-    cdata->_render_queue_buffer_alloc = queue_alloc;
 
     // Prepare the polygon buffer and compute general scene info:
     s3d_geometryrenderlightinfo rinfo = {0};
@@ -693,7 +1361,10 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
     }
     s3d_renderpolygon *polybuf = cdata->_render_polygon_buffer;
     uint32_t polybuf_alloc = cdata->_render_polygon_buffer_alloc;
-    spew3d_obj3d_ReleaseAccess(cam);
+    if (snap != NULL)
+        _spew3d_scene3d_ReleaseSnapshot(snap_sc);
+    else
+        spew3d_obj3d_ReleaseAccess(cam);
 
     // Compute fov (we don't need a scene lock for that):
     s3d_transform3d_cam_info cinfo = {0};
@@ -709,37 +1380,10 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
 
     // Compute actual polygons to sort them later:
     uint32_t polybuf_fill = 0;
-    i = 0;
-    while (i < queuefill) {
-        if (queue[i].kind == RENDERENTRY_MESH) {
-            rinfo.dynlight_mode = DLRD_LIT_FLAT;
-            int try_add = spew3d_geometry_Transform(
-                queue[i].rendermesh.geom,
-                &queue[i].rendermesh.world_pos,
-                &queue[i].rendermesh.world_rotation,
-                &cinfo,
-                &rinfo, &polybuf, &polybuf_fill, &polybuf_alloc
-            );
-            if (!try_add) {
-                // Ran out of memory. Not much we can do.
-                i += 1;
-            }
-        } else if (queue[i].kind == RENDERENTRY_LVLBOX) {
-            rinfo.dynlight_mode = DLRD_LIT_FLAT;
-            int try_add = spew3d_lvlbox_Transform(
-                queue[i].renderlvlbox.lvlbox,
-                &queue[i].renderlvlbox.world_pos,
-                &queue[i].renderlvlbox.world_rotation,
-                &cinfo,
-                &rinfo, &polybuf, &polybuf_fill, &polybuf_alloc
-            );
-            if (!try_add) {
-                // Ran out of memory. Not much we can do.
-                i += 1;
-            }
-        }
-        i++;
-    }
+    _spew3d_camera3d_TransformQueue(
+        queue, queuefill, &cinfo, &rinfo,
+        &polybuf, &polybuf_fill, &polybuf_alloc
+    );
     spew3d_obj3d_LockAccess(cam);
     cdata->_render_polygon_buffer = polybuf;
     cdata->_render_polygon_buffer_alloc = polybuf_alloc;
@@ -758,10 +1402,32 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
     polybuf_alloc = cdata->_render_polygon_buffer_alloc;
     spew3d_obj3d_ReleaseAccess(cam);
 
+    // Copy out what the sort and draw passes need into compact
+    // records, so they touch a lot less memory:
+    s3d_drawpolygon *drawbuf = cdata->_render_draw_buffer;
+    uint32_t drawbuf_alloc = cdata->_render_draw_buffer_alloc;
+    uint32_t drawbuf_fill = 0;
+    int build_result = _spew3d_camera3d_BuildDrawPolygons(
+        polybuf, polybuf_fill,
+        &drawbuf, &drawbuf_fill, &drawbuf_alloc
+    );
+    spew3d_obj3d_LockAccess(cam);
+    cdata->_render_draw_buffer = drawbuf;
+    cdata->_render_draw_buffer_alloc = drawbuf_alloc;
+    spew3d_obj3d_ReleaseAccess(cam);
+    if (!build_result) {
+        #if defined(DEBUG_SPEW3D_RENDER3D)
+        printf("spew3d_camera3d.c: debug: "
+            "Out of memory for draw polygons.\n");
+        #endif
+        mutex_Lock(_win_id_mutex);
+        return 1;
+    }
+
     #if defined(DEBUG_SPEW3D_RENDER3D)
     printf("spew3d_camera3d.c: debug: "
         "Now sorting geometry, "
-        "polygon queue length: %d\n", polybuf_fill);
+        "polygon queue length: %d\n", drawbuf_fill);
     #endif
     if (!cdata->_render_sort_cache) {
         cdata->_render_sort_cache = s3d_itemsort_CreateCache();
@@ -770,9 +1436,9 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
         }
     }
     int sort_result = s3d_itemsort_Do(
-        polybuf, polybuf_fill * sizeof(polybuf[0]),
-        sizeof(polybuf[0]),
-        &_depthCompareRenderPolygons,
+        drawbuf, drawbuf_fill * sizeof(drawbuf[0]),
+        sizeof(drawbuf[0]),
+        &_depthCompareDrawPolygons,
         cdata->_render_sort_cache,
         NULL, NULL
     );
@@ -786,53 +1452,65 @@ S3DHID int _spew3d_camera3d_ProcessDrawToWindowReq(
     #if defined(DEBUG_SPEW3D_RENDER3D)
     printf("spew3d_camera3d.c: debug: "
         "SDL2 render of geometry, "
-        "polygon queue length: %d\n", polybuf_fill);
+        "polygon queue length: %d\n", drawbuf_fill);
     #endif
     s3d_backend_windowing_wininfo *backend_winfo;
     s3d_backend_windowing *backend = spew3d_window_GetBackend(
         win, &backend_winfo
     );
+    // Consecutive polygons with the same texture get drawn as
+    // one batch:
+    s3d_backend_windowing_gputex *batch_tex = NULL;
+    uint32_t batch_start = 0;
     i = 0;
-    while (i < polybuf_fill) {
-        // If the polygon is too far behind the camera, clip it:
-        if (polybuf[i].center.x <= 0) {
-            i++;
-            continue;
-        }
-
-        s3d_renderpolygon *p = &polybuf[i];
-        s3d_color colors[3] = {0};
-        colors[0].red = 1.0;
-        colors[0].green = 1.0;
-        colors[0].blue = 1.0;
-        colors[0].alpha = 1.0;
-        colors[1].red = 1.0;
-        colors[1].green = 1.0;
-        colors[1].blue = 1.0;
-        colors[1].alpha = 1.0;
-        colors[2].red = 1.0;
-        colors[2].green = 1.0;
-        colors[2].blue = 1.0;
-        colors[2].alpha = 1.0;
-
+    while (i < drawbuf_fill) {
+        const s3d_drawpolygon *d = &drawbuf[i];
         s3d_backend_windowing_gputex *tex = NULL;
-        if (p->polygon_texture != 0) {
+        if (d->texture != 0) {
+            // Compare the texture and screen space areas to pick
+            // a suitable mip level:
+            const s3d_drawvertex *v = d->vertex;
+            s3dnum_t pixel_area = fabs(
+                (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                (v[2].x - v[0].x) * (v[1].y - v[0].y)
+            ) * 0.5;
+            s3dnum_t texcoord_area = fabs(
+                (v[1].texcoord_x - v[0].texcoord_x) *
+                (v[2].texcoord_y - v[0].texcoord_y) -
+                (v[2].texcoord_x - v[0].texcoord_x) *
+                (v[1].texcoord_y - v[0].texcoord_y)
+            ) * 0.5;
             mutex_Lock(_texlist_mutex);
-            tex = _internal_spew3d_MainThreadOnly_GetGPUTex_nolock(
-                win, p->polygon_texture, 1
+            tex = _internal_spew3d_MainThreadOnly_GetGPUTexMip_nolock(
+                win, d->texture, 1,
+                texcoord_area, pixel_area
             );
-            mutex_Release(_texlist_mutex);
             if (tex == NULL) {
-                // FIXME: Do we want some placeholder graphics here?
+                // Still loading or uploading, so show something:
+                tex = (
+                    _internal_spew3d_MainThreadOnly_GetPlaceholderGPUTex_nolock(
+                        win
+                    ));
             }
+            mutex_Release(_texlist_mutex);
+        }
+        if (i > batch_start && tex != batch_tex) {
+            backend->DrawPolygonsAtPixels(
+                backend, win, backend_winfo,
+                batch_tex, &drawbuf[batch_start],
+                i - batch_start
+            );
+            batch_start = i;
         }
-        backend->DrawPolygonAtPixels(
+        batch_tex = tex;
+        i++;
+    }
+    if (drawbuf_fill > batch_start) {
+        backend->DrawPolygonsAtPixels(
             backend, win, backend_winfo,
-            tex, &p->vertex_pos_pixels[0],
-            &p->vertex_texcoord[0],
-            (s3d_color *)colors
+            batch_tex, &drawbuf[batch_start],
+            drawbuf_fill - batch_start
         );
-        i++;
     }
     #else
     // FIXME: Eventually implement custom software renderer
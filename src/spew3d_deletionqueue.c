@@ -83,6 +83,8 @@ S3DHID void _spew3d_deletionqueue_ProcessDeletionsOnMainThread() {
             _spew3d_lvlbox_ActuallyDestroy(
                 (s3d_lvlbox *)deletionqueue[i].item
             );
+        } else if (deletionqueue[i].kind == DELETION_MEMORY) {
+            free(deletionqueue[i].item);
         }
         i++;
     }
@@ -94,6 +96,7 @@ const char _delname_unknown[] = "(unknown)";
 const char _delname_window[] = "s3d_window";
 const char _delname_obj3d[] = "s3d_obj3d";
 const char _delname_geom[] = "s3d_geometry";
+const char _delname_memory[] = "memory";
 S3DHID const char *_delkindname(int kind) {
     if (kind == DELETION_WINDOW) {
         return _delname_window;
@@ -101,6 +104,8 @@ S3DHID const char *_delkindname(int kind) {
         return _delname_obj3d;
     } else if (kind == DELETION_GEOM) {
         return _delname_geom;
+    } else if (kind == DELETION_MEMORY) {
+        return _delname_memory;
     } else {
         return _delname_unknown;
     }
@@ -125,6 +125,101 @@ S3DEXP int spew3d_event_q_Insert(s3d_equeue *eq, const s3d_event *ev) {
     return 1;
 }
 
+typedef struct s3d_cmdbuffer {
+    s3d_event *events;
+    uint32_t count, alloc;
+} s3d_cmdbuffer;
+
+// The command buffer the calling thread currently records into:
+static __thread s3d_cmdbuffer *_spew3d_event_recording_cmdbuffer = NULL;
+
+S3DEXP s3d_cmdbuffer *spew3d_cmdbuffer_New() {
+    s3d_cmdbuffer *buf = malloc(sizeof(*buf));
+    if (!buf)
+        return NULL;
+    memset(buf, 0, sizeof(*buf));
+    return buf;
+}
+
+S3DEXP void spew3d_cmdbuffer_BeginRecording(s3d_cmdbuffer *buf) {
+    _spew3d_event_recording_cmdbuffer = buf;
+}
+
+S3DEXP void spew3d_cmdbuffer_EndRecording() {
+    _spew3d_event_recording_cmdbuffer = NULL;
+}
+
+static void _spew3d_cmdbuffer_FreeEvents(
+        s3d_event *events, uint32_t count
+        ) {
+    // Some commands own extra data that the main thread would
+    // otherwise have freed after use:
+    uint32_t i = 0;
+    while (i < count) {
+        if (events[i].kind == S3DEV_INTERNAL_CMD_SPRITEBATCHDRAW)
+            _spew3d_spritebatch_RecycleEntries(
+                events[i].spritebatchdraw.entries,
+                events[i].spritebatchdraw.alloc
+            );
+        i++;
+    }
+    free(events);
+}
+
+S3DEXP int spew3d_cmdbuffer_Submit(s3d_cmdbuffer *buf) {
+    if (buf->count == 0)
+        return 1;
+    s3d_event e = {0};
+    e.kind = S3DEV_INTERNAL_CMD_CMDBUFFER_REPLAY;
+    e.cmdbuffer.events = buf->events;
+    e.cmdbuffer.count = buf->count;
+    if (!spew3d_event_q_Insert(_spew3d_event_GetInternalQueue(), &e))
+        return 0;
+    buf->events = NULL;
+    buf->count = 0;
+    buf->alloc = 0;
+    return 1;
+}
+
+S3DEXP void spew3d_cmdbuffer_Clear(s3d_cmdbuffer *buf) {
+    _spew3d_cmdbuffer_FreeEvents(buf->events, buf->count);
+    buf->events = NULL;
+    buf->count = 0;
+    buf->alloc = 0;
+}
+
+S3DEXP void spew3d_cmdbuffer_Destroy(s3d_cmdbuffer *buf) {
+    if (!buf)
+        return;
+    if (_spew3d_event_recording_cmdbuffer == buf)
+        _spew3d_event_recording_cmdbuffer = NULL;
+    _spew3d_cmdbuffer_FreeEvents(buf->events, buf->count);
+    free(buf);
+}
+
+S3DHID int _spew3d_event_InsertDrawCmd(const s3d_event *ev) {
+    s3d_cmdbuffer *buf = _spew3d_event_recording_cmdbuffer;
+    if (buf == NULL)
+        return spew3d_event_q_Insert(_spew3d_event_GetInternalQueue(), ev);
+
+    // No lock needed, since only this thread uses the buffer:
+    if (buf->count + 1 > buf->alloc) {
+        uint32_t new_alloc = buf->alloc * 2;
+        if (new_alloc < 64)
+            new_alloc = 64;
+        s3d_event *new_events = realloc(
+            buf->events, sizeof(*new_events) * new_alloc
+        );
+        if (!new_events)
+            return 0;
+        buf->events = new_events;
+        buf->alloc = new_alloc;
+    }
+    memcpy(&buf->events[buf->count], ev, sizeof(*ev));
+    buf->count++;
+    return 1;
+}
+
 S3DEXP int spew3d_event_q_IsEmpty(s3d_equeue *eq) {
     int result = 0;
     mutex_Lock(eq->accesslock);
@@ -170,6 +265,14 @@ S3DHID int _spew3d_window_HandleSDLEvent(SDL_Event *e);
 
 S3DHID void spew3d_audio_mixer_UpdateAllOnMainThread();
 
+static void _spew3d_event_ProcessInternal(s3d_event *e) {
+    assert(e->kind != S3DEV_INVALID);
+    if (!spew3d_window_InternalMainThreadProcessEvent(e)) {
+        if (!spew3d_texture_InternalMainThreadProcessEvent(e))
+            spew3d_camera_InternalMainThreadProcessEvent(e);
+    }
+}
+
 S3DEXP void spew3d_event_UpdateMainThread() {
     thread_MarkAsMainThread();
     #ifndef SPEW3D_OPTION_DISABLE_SDL
@@ -181,6 +284,9 @@ S3DEXP void spew3d_event_UpdateMainThread() {
     s3d_equeue *eq = _spew3d_event_GetInternalQueue();
     assert(eq != NULL);
 
+    // Upload some pending textures before anything gets drawn:
+    spew3d_texture_InternalMainThreadUpdate();
+
     while (1) {
         spew3d_audio_mixer_InternalUpdateAllOnMainThread();
         spew3d_audio_sink_InternalMainThreadUpdate();
@@ -191,10 +297,17 @@ S3DEXP void spew3d_event_UpdateMainThread() {
             break;
 
         assert(e.kind != S3DEV_INVALID);
-        if (!spew3d_window_InternalMainThreadProcessEvent(&e)) {
-            if (!spew3d_texture_InternalMainThreadProcessEvent(&e))
-                spew3d_camera_InternalMainThreadProcessEvent(&e);
+        if (e.kind == S3DEV_INTERNAL_CMD_CMDBUFFER_REPLAY) {
+            // Replay a whole recorded command buffer in order:
+            uint32_t i = 0;
+            while (i < e.cmdbuffer.count) {
+                _spew3d_event_ProcessInternal(&e.cmdbuffer.events[i]);
+                i++;
+            }
+            free(e.cmdbuffer.events);
+            continue;
         }
+        _spew3d_event_ProcessInternal(&e);
     }
 }
 
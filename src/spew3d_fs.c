@@ -1901,7 +1901,6 @@ S3DHID int _spew3d_fs_RemoveFileEx(
     *error = FSERR_SUCCESS;
     return 1;
     #else
-    #if defined(_WIN32) || defined(_WIN64)
     int result;
     if (allowdirs) {
         result = remove(path);
@@ -1925,7 +1924,6 @@ S3DHID int _spew3d_fs_RemoveFileEx(
         }
         return 0;
     }
-    #endif
     *error = FSERR_SUCCESS;
     return 1;
     #endif
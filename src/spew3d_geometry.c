@@ -73,6 +73,10 @@ S3DHID int _internal_spew3d_geometry_AddVertexPolyAlloc(
     if (!new_material)
         return 0;
     geometry->polygon_material = new_material;
+    // Since we may not fill this one in, zero it out in advance:
+    memset(&geometry->polygon_material[
+        geometry->polygon_count * 3], 0,
+        sizeof(*new_material) * (add_polygon * 3));
 
     s3d_color *new_polygon_vertexcolors = realloc(
         geometry->polygon_vertexcolors,
@@ -442,20 +446,555 @@ S3DEXP void spew3d_geometry_Destroy(s3d_geometry *geometry) {
     int result = spew3d_Deletion_Queue(DELETION_GEOM, geometry);
 }
 
-S3DEXP int spew3d_geometry_Transform(
-        s3d_geometry *geometry,
-        s3d_pos *model_pos,
-        s3d_rotation *model_rotation,
-        s3d_transform3d_cam_info *cam_info,
+typedef struct s3d_geometry_simplifyedge {
+    uint32_t v1, v2;
+    uint32_t polygon;
+    double cost;
+    s3d_pos target;
+} s3d_geometry_simplifyedge;
+
+S3DHID static int _spew3d_geometry_SimplifyEdgeCmpVertex(
+        const void *a, const void *b
+        ) {
+    const s3d_geometry_simplifyedge *e1 = a;
+    const s3d_geometry_simplifyedge *e2 = b;
+    if (e1->v1 != e2->v1)
+        return (e1->v1 < e2->v1 ? -1 : 1);
+    if (e1->v2 != e2->v2)
+        return (e1->v2 < e2->v2 ? -1 : 1);
+    return 0;
+}
+
+S3DHID static int _spew3d_geometry_SimplifyEdgeCmpCost(
+        const void *a, const void *b
+        ) {
+    const s3d_geometry_simplifyedge *e1 = a;
+    const s3d_geometry_simplifyedge *e2 = b;
+    if (e1->cost != e2->cost)
+        return (e1->cost < e2->cost ? -1 : 1);
+    return _spew3d_geometry_SimplifyEdgeCmpVertex(a, b);
+}
+
+// A quadric is the symmetric 4x4 matrix summing p * p^T for all
+// planes p = (a, b, c, d) near a vertex, stored as its upper half.
+S3DHID static void _spew3d_geometry_QuadricAddPlane(
+        double *q, double a, double b, double c, double d,
+        double weight
+        ) {
+    q[0] += weight * a * a; q[1] += weight * a * b;
+    q[2] += weight * a * c; q[3] += weight * a * d;
+    q[4] += weight * b * b; q[5] += weight * b * c;
+    q[6] += weight * b * d; q[7] += weight * c * c;
+    q[8] += weight * c * d; q[9] += weight * d * d;
+}
+
+S3DHID static double _spew3d_geometry_QuadricError(
+        const double *q1, const double *q2, const s3d_pos *p
+        ) {
+    double q[10];
+    int i = 0;
+    while (i < 10) {
+        q[i] = q1[i] + q2[i];
+        i++;
+    }
+    double x = p->x;
+    double y = p->y;
+    double z = p->z;
+    return (q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z +
+        2 * q[3] * x + q[4] * y * y + 2 * q[5] * y * z +
+        2 * q[6] * y + q[7] * z * z + 2 * q[8] * z + q[9]);
+}
+
+S3DHID static void _spew3d_geometry_SimplifyNormal(
+        const s3d_pos *p1, const s3d_pos *p2, const s3d_pos *p3,
+        double *out_x, double *out_y, double *out_z
+        ) {
+    double ax = p2->x - p1->x;
+    double ay = p2->y - p1->y;
+    double az = p2->z - p1->z;
+    double bx = p3->x - p1->x;
+    double by = p3->y - p1->y;
+    double bz = p3->z - p1->z;
+    *out_x = ay * bz - az * by;
+    *out_y = az * bx - ax * bz;
+    *out_z = ax * by - ay * bx;
+}
+
+// Returns 1 if moving vertex 'moved' to 'newpos' while merging it
+// with 'other' would flip or squash any polygon that survives:
+S3DHID static int _spew3d_geometry_SimplifyFlips(
+        const s3d_pos *pos, const uint32_t *vindex,
+        const uint8_t *polygon_alive,
+        const uint32_t *adj_start, const uint32_t *adj,
+        uint32_t moved, uint32_t other, const s3d_pos *newpos
+        ) {
+    uint32_t i = adj_start[moved];
+    while (i < adj_start[moved + 1]) {
+        uint32_t p = adj[i];
+        i++;
+        if (!polygon_alive[p])
+            continue;
+        const uint32_t *c = &vindex[p * 3];
+        if (c[0] == other || c[1] == other || c[2] == other)
+            continue;  // This one collapses away.
+        s3d_pos corner[3];
+        int k = 0;
+        while (k < 3) {
+            corner[k] = (c[k] == moved ? *newpos : pos[c[k]]);
+            k++;
+        }
+        double ox, oy, oz, nx, ny, nz;
+        _spew3d_geometry_SimplifyNormal(
+            &pos[c[0]], &pos[c[1]], &pos[c[2]], &ox, &oy, &oz
+        );
+        _spew3d_geometry_SimplifyNormal(
+            &corner[0], &corner[1], &corner[2], &nx, &ny, &nz
+        );
+        double olen = sqrt(ox * ox + oy * oy + oz * oz);
+        double nlen = sqrt(nx * nx + ny * ny + nz * nz);
+        if (nlen <= olen * 0.001)
+            return 1;
+        if (ox * nx + oy * ny + oz * nz < 0.2 * olen * nlen)
+            return 1;
+    }
+    return 0;
+}
+
+S3DEXP s3d_geometry *spew3d_geometry_Simplify(
+        s3d_geometry *geometry, int32_t target_polygon_count
+        ) {
+    if (!geometry)
+        return NULL;
+    if (target_polygon_count < 1)
+        target_polygon_count = 1;
+    const uint32_t vcount = (
+        geometry->vertex_count > 0 ? geometry->vertex_count : 0
+    );
+    const uint32_t pcount = (
+        geometry->polygon_count > 0 ? geometry->polygon_count : 0
+    );
+    s3d_geometry *result = NULL;
+    s3d_pos *pos = malloc(sizeof(*pos) * (vcount + 1));
+    uint32_t *vindex = malloc(sizeof(*vindex) * (pcount * 3 + 1));
+    uint8_t *polygon_alive = malloc(pcount + 1);
+    double *quadric = malloc(sizeof(*quadric) * 10 * (vcount + 1));
+    uint8_t *locked = malloc(vcount + 1);
+    uint32_t *adj_start = malloc(sizeof(*adj_start) * (vcount + 2));
+    uint32_t *adj = malloc(sizeof(*adj) * (pcount * 3 + 1));
+    uint32_t *remap = malloc(sizeof(*remap) * (vcount + 1));
+    s3d_geometry_simplifyedge *edge = malloc(
+        sizeof(*edge) * (pcount * 3 + 1)
+    );
+    if (!pos || !vindex || !polygon_alive || !quadric ||
+            !locked || !adj_start || !adj || !remap || !edge)
+        goto failure;
+    if (vcount > 0)
+        memcpy(pos, geometry->vertex, sizeof(*pos) * vcount);
+    if (pcount > 0)
+        memcpy(vindex, geometry->polygon_vertexindex,
+            sizeof(*vindex) * pcount * 3);
+    int32_t alive_count = 0;
+    uint32_t i = 0;
+    while (i < pcount) {
+        const uint32_t *c = &vindex[i * 3];
+        polygon_alive[i] = (c[0] < vcount && c[1] < vcount &&
+            c[2] < vcount && c[0] != c[1] && c[1] != c[2] &&
+            c[0] != c[2]);
+        if (polygon_alive[i])
+            alive_count++;
+        i++;
+    }
+
+    // Collapse edges in passes. Every pass ranks all edges by their
+    // quadric error, then collapses the cheapest ones as long as they
+    // don't touch a vertex that an earlier collapse in the same pass
+    // already affected, since its quadric and neighbors are now stale:
+    while (alive_count > target_polygon_count) {
+        uint32_t edge_count = 0;
+        i = 0;
+        while (i < pcount) {
+            if (!polygon_alive[i]) {
+                i++;
+                continue;
+            }
+            int k = 0;
+            while (k < 3) {
+                uint32_t a = vindex[i * 3 + k];
+                uint32_t b = vindex[i * 3 + (k + 1) % 3];
+                edge[edge_count].v1 = (a < b ? a : b);
+                edge[edge_count].v2 = (a < b ? b : a);
+                edge[edge_count].polygon = i;
+                edge_count++;
+                k++;
+            }
+            i++;
+        }
+        qsort(edge, edge_count, sizeof(*edge),
+            _spew3d_geometry_SimplifyEdgeCmpVertex);
+
+        // Each polygon adds its plane to its corners, weighted by area:
+        memset(quadric, 0, sizeof(*quadric) * 10 * vcount);
+        i = 0;
+        while (i < pcount) {
+            if (!polygon_alive[i]) {
+                i++;
+                continue;
+            }
+            const uint32_t *c = &vindex[i * 3];
+            double nx, ny, nz;
+            _spew3d_geometry_SimplifyNormal(
+                &pos[c[0]], &pos[c[1]], &pos[c[2]], &nx, &ny, &nz
+            );
+            double len = sqrt(nx * nx + ny * ny + nz * nz);
+            if (len > 0) {
+                nx /= len; ny /= len; nz /= len;
+                double d = -(nx * pos[c[0]].x + ny * pos[c[0]].y +
+                    nz * pos[c[0]].z);
+                int k = 0;
+                while (k < 3) {
+                    _spew3d_geometry_QuadricAddPlane(
+                        &quadric[c[k] * 10], nx, ny, nz, d, len * 0.5
+                    );
+                    k++;
+                }
+            }
+            i++;
+        }
+
+        // Merge duplicate edges. Edges used by only one polygon are on
+        // an open border, which gets a steep perpendicular plane so
+        // that the mesh outline doesn't shrink away:
+        uint32_t unique_count = 0;
+        i = 0;
+        while (i < edge_count) {
+            uint32_t j = i + 1;
+            while (j < edge_count && edge[j].v1 == edge[i].v1 &&
+                    edge[j].v2 == edge[i].v2)
+                j++;
+            if (j - i == 1) {
+                uint32_t a = edge[i].v1;
+                uint32_t b = edge[i].v2;
+                const uint32_t *c = &vindex[edge[i].polygon * 3];
+                double nx, ny, nz;
+                _spew3d_geometry_SimplifyNormal(
+                    &pos[c[0]], &pos[c[1]], &pos[c[2]], &nx, &ny, &nz
+                );
+                double ex = pos[b].x - pos[a].x;
+                double ey = pos[b].y - pos[a].y;
+                double ez = pos[b].z - pos[a].z;
+                double mx = ey * nz - ez * ny;
+                double my = ez * nx - ex * nz;
+                double mz = ex * ny - ey * nx;
+                double mlen = sqrt(mx * mx + my * my + mz * mz);
+                if (mlen > 0) {
+                    mx /= mlen; my /= mlen; mz /= mlen;
+                    double d = -(mx * pos[a].x + my * pos[a].y +
+                        mz * pos[a].z);
+                    double weight = 1000.0 * (ex * ex + ey * ey + ez * ez);
+                    _spew3d_geometry_QuadricAddPlane(
+                        &quadric[a * 10], mx, my, mz, d, weight
+                    );
+                    _spew3d_geometry_QuadricAddPlane(
+                        &quadric[b * 10], mx, my, mz, d, weight
+                    );
+                }
+            }
+            edge[unique_count] = edge[i];
+            unique_count++;
+            i = j;
+        }
+        i = 0;
+        while (i < unique_count) {
+            s3d_geometry_simplifyedge *e = &edge[i];
+            s3d_pos candidate[3];
+            candidate[0] = pos[e->v1];
+            candidate[1] = pos[e->v2];
+            candidate[2] = spew3d_math3d_average(
+                &pos[e->v1], &pos[e->v2]
+            );
+            int k = 0;
+            while (k < 3) {
+                double cost = _spew3d_geometry_QuadricError(
+                    &quadric[e->v1 * 10], &quadric[e->v2 * 10],
+                    &candidate[k]
+                );
+                if (k == 0 || cost < e->cost) {
+                    e->cost = cost;
+                    e->target = candidate[k];
+                }
+                k++;
+            }
+            i++;
+        }
+        qsort(edge, unique_count, sizeof(*edge),
+            _spew3d_geometry_SimplifyEdgeCmpCost);
+
+        // Build the vertex to polygon lookup for this pass:
+        memset(adj_start, 0, sizeof(*adj_start) * (vcount + 2));
+        i = 0;
+        while (i < pcount) {
+            if (polygon_alive[i]) {
+                adj_start[vindex[i * 3 + 0] + 2]++;
+                adj_start[vindex[i * 3 + 1] + 2]++;
+                adj_start[vindex[i * 3 + 2] + 2]++;
+            }
+            i++;
+        }
+        i = 2;
+        while (i < vcount + 2) {
+            adj_start[i] += adj_start[i - 1];
+            i++;
+        }
+        i = 0;
+        while (i < pcount) {
+            if (polygon_alive[i]) {
+                adj[adj_start[vindex[i * 3 + 0] + 1]++] = i;
+                adj[adj_start[vindex[i * 3 + 1] + 1]++] = i;
+                adj[adj_start[vindex[i * 3 + 2] + 1]++] = i;
+            }
+            i++;
+        }
+
+        memset(locked, 0, vcount);
+        uint32_t collapsed = 0;
+        i = 0;
+        while (i < unique_count &&
+                alive_count > target_polygon_count) {
+            const uint32_t a = edge[i].v1;
+            const uint32_t b = edge[i].v2;
+            const s3d_pos target = edge[i].target;
+            i++;
+            if (locked[a] || locked[b])
+                continue;
+            if (_spew3d_geometry_SimplifyFlips(
+                    pos, vindex, polygon_alive, adj_start, adj,
+                    a, b, &target) ||
+                    _spew3d_geometry_SimplifyFlips(
+                    pos, vindex, polygon_alive, adj_start, adj,
+                    b, a, &target))
+                continue;
+
+            // Merge b into a. Polygons that had both end up with
+            // a duplicate corner and are dropped:
+            pos[a] = target;
+            uint32_t k = adj_start[b];
+            while (k < adj_start[b + 1]) {
+                uint32_t p = adj[k];
+                k++;
+                if (!polygon_alive[p])
+                    continue;
+                uint32_t *c = &vindex[p * 3];
+                if (c[0] == b) c[0] = a;
+                if (c[1] == b) c[1] = a;
+                if (c[2] == b) c[2] = a;
+                if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2]) {
+                    polygon_alive[p] = 0;
+                    alive_count--;
+                }
+            }
+            uint32_t v = a;
+            while (1) {
+                k = adj_start[v];
+                while (k < adj_start[v + 1]) {
+                    const uint32_t *c = &vindex[adj[k] * 3];
+                    locked[c[0]] = 1;
+                    locked[c[1]] = 1;
+                    locked[c[2]] = 1;
+                    k++;
+                }
+                if (v == b)
+                    break;
+                v = b;
+            }
+            locked[a] = 1;
+            locked[b] = 1;
+            collapsed++;
+        }
+        if (collapsed == 0)
+            break;
+    }
+
+    // Copy the surviving polygons and the vertices they use:
+    uint32_t used_vertices = 0;
+    i = 0;
+    while (i < vcount) {
+        remap[i] = UINT32_MAX;
+        i++;
+    }
+    i = 0;
+    while (i < pcount) {
+        if (polygon_alive[i]) {
+            int k = 0;
+            while (k < 3) {
+                if (remap[vindex[i * 3 + k]] == UINT32_MAX) {
+                    remap[vindex[i * 3 + k]] = used_vertices;
+                    used_vertices++;
+                }
+                k++;
+            }
+        }
+        i++;
+    }
+    result = spew3d_geometry_Create();
+    if (!result || !_internal_spew3d_geometry_AddVertexPolyAlloc(
+            result, used_vertices, alive_count))
+        goto failure;
+    result->vertex_count = used_vertices;
+    result->polygon_count = alive_count;
+    result->per_polygon_emit_computed = (
+        geometry->per_polygon_emit_computed
+    );
+    result->per_vertex_normals_computed = (
+        geometry->per_vertex_normals_computed
+    );
+    result->cull_backfaces = geometry->cull_backfaces;
+    i = 0;
+    while (i < vcount) {
+        if (remap[i] != UINT32_MAX)
+            result->vertex[remap[i]] = pos[i];
+        i++;
+    }
+    uint32_t out = 0;
+    i = 0;
+    while (i < pcount) {
+        if (!polygon_alive[i]) {
+            i++;
+            continue;
+        }
+        int k = 0;
+        while (k < 3) {
+            result->polygon_vertexindex[out * 3 + k] = (
+                remap[vindex[i * 3 + k]]
+            );
+            result->polygon_texcoord[out * 3 + k] = (
+                geometry->polygon_texcoord[i * 3 + k]
+            );
+            result->polygon_vertexcolors[out * 3 + k] = (
+                geometry->polygon_vertexcolors[i * 3 + k]
+            );
+            result->polygon_vertexnormals[out * 3 + k] = (
+                geometry->polygon_vertexnormals[i * 3 + k]
+            );
+            k++;
+        }
+        result->polygon_material[out] = geometry->polygon_material[i];
+        result->polygon_texture[out] = geometry->polygon_texture[i];
+        spew3d_math3d_polygon_normal(
+            &result->vertex[result->polygon_vertexindex[out * 3 + 0]],
+            &result->vertex[result->polygon_vertexindex[out * 3 + 1]],
+            &result->vertex[result->polygon_vertexindex[out * 3 + 2]],
+            1, &result->polygon_normal[out]
+        );
+        out++;
+        i++;
+    }
+    #if defined(DEBUG_SPEW3D_GEOMETRY)
+    printf("spew3d_geometry.c: debug: spew3d_geometry_Simplify(): "
+        "%d -> %d polygons, %d -> %d vertices\n",
+        (int)pcount, (int)alive_count, (int)vcount,
+        (int)used_vertices);
+    #endif
+    free(pos);
+    free(vindex);
+    free(polygon_alive);
+    free(quadric);
+    free(locked);
+    free(adj_start);
+    free(adj);
+    free(remap);
+    free(edge);
+    return result;
+
+    failure:
+    if (result)
+        _spew3d_geometry_ActuallyDestroy(result);
+    free(pos);
+    free(vindex);
+    free(polygon_alive);
+    free(quadric);
+    free(locked);
+    free(adj_start);
+    free(adj);
+    free(remap);
+    free(edge);
+    return NULL;
+}
+
+// Scratch space for transforming vertices. Every thread gets its
+// own, since cameras transform meshes on multiple threads at once:
+typedef struct s3d_geometry_transformscratch {
+    uint32_t alloc;
+    s3dnum_t *in_x, *in_y, *in_z;
+    s3dnum_t *out_x, *out_y, *out_z;
+    s3dnum_t *out_ux, *out_uy, *out_uz;
+} s3d_geometry_transformscratch;
+
+static __thread s3d_geometry_transformscratch
+    _spew3d_geometry_transformscratch = {0};
+
+S3DHID static int _spew3d_geometry_LoadVertices(
+        s3d_geometry *geometry
+        ) {
+    s3d_geometry_transformscratch *scratch = (
+        &_spew3d_geometry_transformscratch
+    );
+    uint32_t count = geometry->vertex_count;
+    if (count > scratch->alloc) {
+        uint32_t newalloc = count + 64;
+        s3dnum_t *newbuf = realloc(
+            scratch->in_x, sizeof(*newbuf) * newalloc * 9
+        );
+        if (!newbuf)
+            return 0;
+        scratch->in_x = newbuf;
+        scratch->in_y = newbuf + newalloc;
+        scratch->in_z = newbuf + newalloc * 2;
+        scratch->out_x = newbuf + newalloc * 3;
+        scratch->out_y = newbuf + newalloc * 4;
+        scratch->out_z = newbuf + newalloc * 5;
+        scratch->out_ux = newbuf + newalloc * 6;
+        scratch->out_uy = newbuf + newalloc * 7;
+        scratch->out_uz = newbuf + newalloc * 8;
+        scratch->alloc = newalloc;
+    }
+    uint32_t i = 0;
+    while (i < count) {
+        scratch->in_x[i] = geometry->vertex[i].x;
+        scratch->in_y[i] = geometry->vertex[i].y;
+        scratch->in_z[i] = geometry->vertex[i].z;
+        i++;
+    }
+    return 1;
+}
+
+// Transform the vertices put into the scratch space by
+// _spew3d_geometry_LoadVertices():
+S3DHID static void _spew3d_geometry_TransformLoadedVertices(
+        s3d_geometry *geometry, const s3d_matrix4 *modelview,
+        s3d_transform3d_cam_info *cam_info
+        ) {
+    s3d_geometry_transformscratch *scratch = (
+        &_spew3d_geometry_transformscratch
+    );
+    spew3d_math3d_transform_batch(
+        modelview, cam_info,
+        scratch->in_x, scratch->in_y, scratch->in_z,
+        geometry->vertex_count,
+        scratch->out_x, scratch->out_y, scratch->out_z,
+        scratch->out_ux, scratch->out_uy, scratch->out_uz
+    );
+}
+
+// Assemble the polygons of a geometry from its vertices as already
+// transformed into the scratch space with the given modelview matrix.
+// The tint, if any, is multiplied into the polygons' vertex colors:
+S3DHID static int _spew3d_geometry_AssemblePolygons(
+        s3d_geometry *geometry, const s3d_matrix4 *modelview,
+        const s3d_color *tint,
         s3d_geometryrenderlightinfo *render_light_info,
         s3d_renderpolygon **render_queue,
         uint32_t *render_fill, uint32_t *render_alloc
         ) {
-    assert(render_light_info->dynlight_mode !=
-        DLRD_INVALID);
-    if (geometry->polygon_count == 0)
-        return 0;
-
     s3d_renderpolygon *rqueue = *render_queue;
     uint32_t ralloc = *render_alloc;
     uint32_t rfill = *render_fill;
@@ -495,182 +1034,100 @@ S3DEXP int spew3d_geometry_Transform(
         }
     }
 
-    s3d_pos effective_model_pos = {0};
-    if (model_pos != NULL)
-        memcpy(&effective_model_pos, model_pos,
-            sizeof(*model_pos));
-    s3d_rotation effective_model_rot = {0};
-    if (model_rotation != NULL)
-        memcpy(&effective_model_rot, model_rotation,
-            sizeof(*model_rotation));
+    const s3dnum_t *px = _spew3d_geometry_transformscratch.out_x;
+    const s3dnum_t *py = _spew3d_geometry_transformscratch.out_y;
+    const s3dnum_t *pz = _spew3d_geometry_transformscratch.out_z;
+    const s3dnum_t *ux = _spew3d_geometry_transformscratch.out_ux;
+    const s3dnum_t *uy = _spew3d_geometry_transformscratch.out_uy;
+    const s3dnum_t *uz = _spew3d_geometry_transformscratch.out_uz;
+
+    // For back-face culling, get the camera into model space so
+    // that the polygons can be checked before using them:
+    const int cull_backfaces = geometry->cull_backfaces;
+    s3d_pos model_cam_pos = {0};
+    if (cull_backfaces)
+        spew3d_math3d_matrix_camerapos(modelview, &model_cam_pos);
 
-    uint32_t rfill_old = rfill;
+    // Now assemble the polygons from the transformed vertices:
     uint32_t ioffset = 0;
     uint32_t i = 0;
     while (i < geometry->polygon_count) {
         assert(rfill >= 0 && rfill < ralloc);
         assert(ioffset <= geometry->polygon_count * 3 - 3);
+        if (cull_backfaces && (geometry->polygon_material[i] &
+                SPEW3D_MATERIAL_TWOSIDED) == 0) {
+            s3d_pos *v1 = &geometry->vertex[
+                geometry->polygon_vertexindex[ioffset]];
+            s3d_pos *v2 = &geometry->vertex[
+                geometry->polygon_vertexindex[ioffset + 1]];
+            s3d_pos *v3 = &geometry->vertex[
+                geometry->polygon_vertexindex[ioffset + 2]];
+            s3d_pos facing;
+            spew3d_math3d_polygon_normal(v1, v2, v3, 0, &facing);
+            if (spew3d_math3d_polygon_facesaway(
+                    &facing, v1, &model_cam_pos
+                    )) {
+                ioffset += 3;
+                i++;
+                continue;
+            }
+        }
         rqueue[rfill].polygon_texture = (
             geometry->polygon_texture[i]
         );
         rqueue[rfill].clipped = 0;
-        s3d_pos vertex_positions[3];
-
-        // First vertex:
-        #if defined(DEBUG_SPEW3D_TRANSFORM3D)
-        printf("spew3d_geometry.c: debug: geom %p "
-            "vertex #%d input world x,y,z %f,%f,%f\n",
-            geometry, ioffset,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].x,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].y,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].z);
-        #endif
-        spew3d_math3d_transform3d(
-            geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ],
-            cam_info, effective_model_pos,
-            effective_model_rot,
-            &rqueue[rfill].vertex_pos_pixels[0],
-            &rqueue[rfill].vertex_pos[0]
-        );
-        #if defined(DEBUG_SPEW3D_TRANSFORM3D)
-        printf("spew3d_geometry.c: debug: geom %p "
-            "vertex #%d output world x,y,z %f,%f,%f\n",
-            geometry, ioffset,
-            (double)rqueue[rfill].vertex_pos_pixels[0].x,
-            (double)rqueue[rfill].vertex_pos_pixels[0].y,
-            (double)rqueue[rfill].vertex_pos_pixels[0].z);
-        #endif
-        rqueue[rfill].vertex_texcoord[0] = (
-            geometry->polygon_texcoord[ioffset]
-        );
-        rqueue[rfill].vertex_emit[0] = (
-            geometry->polygon_vertexcolors[ioffset]
-        );
-        rqueue[rfill].vertex_emit[0].red = fmax((
-            rqueue[rfill].vertex_emit[0].red *
-            multiplier_vertex_light), scene_ambient.red
-        );
-        rqueue[rfill].vertex_emit[0].green = fmax((
-            rqueue[rfill].vertex_emit[0].green *
-            multiplier_vertex_light), scene_ambient.green
-        );
-        rqueue[rfill].vertex_emit[0].blue = fmax((
-            rqueue[rfill].vertex_emit[0].blue *
-            multiplier_vertex_light), scene_ambient.blue
-        );
-        ioffset++;
-
-        // Second vertex:
-        #if defined(DEBUG_SPEW3D_TRANSFORM3D)
-        printf("spew3d_geometry.c: debug: geom %p "
-            "vertex #%d input world x,y,z %f,%f,%f\n",
-            geometry, ioffset,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].x,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].y,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].z);
-        #endif
-        spew3d_math3d_transform3d(
-            geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ],
-            cam_info, effective_model_pos,
-            effective_model_rot,
-            &rqueue[rfill].vertex_pos_pixels[1],
-            &rqueue[rfill].vertex_pos[1]
-        );
-        #if defined(DEBUG_SPEW3D_TRANSFORM3D)
-        printf("spew3d_geometry.c: debug: geom %p "
-            "vertex #%d output world x,y,z %f,%f,%f\n",
-            geometry, ioffset,
-            (double)rqueue[rfill].vertex_pos_pixels[1].x,
-            (double)rqueue[rfill].vertex_pos_pixels[1].y,
-            (double)rqueue[rfill].vertex_pos_pixels[1].z);
-        #endif
-        rqueue[rfill].vertex_texcoord[1] = (
-            geometry->polygon_texcoord[ioffset]
-        );
-        rqueue[rfill].vertex_emit[1] = (
-            geometry->polygon_vertexcolors[ioffset]
-        );
-        rqueue[rfill].vertex_emit[1].red = fmax((
-            rqueue[rfill].vertex_emit[1].red *
-            multiplier_vertex_light), scene_ambient.red
-        );
-        rqueue[rfill].vertex_emit[1].green = fmax((
-            rqueue[rfill].vertex_emit[1].green *
-            multiplier_vertex_light), scene_ambient.green
-        );
-        rqueue[rfill].vertex_emit[1].blue = fmax((
-            rqueue[rfill].vertex_emit[1].blue *
-            multiplier_vertex_light), scene_ambient.blue
-        );
-        ioffset++;
-
-        // Third vertex:
-        #if defined(DEBUG_SPEW3D_TRANSFORM3D)
-        printf("spew3d_geometry.c: debug: geom %p "
-            "vertex #%d input world x,y,z %f,%f,%f\n",
-            geometry, ioffset,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].x,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].y,
-            (double)geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ].z);
-        #endif
-        spew3d_math3d_transform3d(
-            geometry->vertex[
-                geometry->polygon_vertexindex[ioffset]
-            ],
-            cam_info, effective_model_pos,
-            effective_model_rot,
-            &rqueue[rfill].vertex_pos_pixels[2],
-            &rqueue[rfill].vertex_pos[2]
-        );
-        #if defined(DEBUG_SPEW3D_TRANSFORM3D)
-        printf("spew3d_geometry.c: debug: geom %p "
-            "vertex #%d output world x,y,z %f,%f,%f\n",
-            geometry, ioffset,
-            (double)rqueue[rfill].vertex_pos_pixels[2].x,
-            (double)rqueue[rfill].vertex_pos_pixels[2].y,
-            (double)rqueue[rfill].vertex_pos_pixels[2].z);
-        #endif
-        rqueue[rfill].vertex_texcoord[2] = (
-            geometry->polygon_texcoord[ioffset]
-        );
-        rqueue[rfill].vertex_emit[2] = (
-            geometry->polygon_vertexcolors[ioffset]
-        );
-        rqueue[rfill].vertex_emit[2].red = fmax((
-            rqueue[rfill].vertex_emit[2].red *
-            multiplier_vertex_light), scene_ambient.red
-        );
-        rqueue[rfill].vertex_emit[2].green = fmax((
-            rqueue[rfill].vertex_emit[2].green *
-            multiplier_vertex_light), scene_ambient.green
-        );
-        rqueue[rfill].vertex_emit[2].blue = fmax((
-            rqueue[rfill].vertex_emit[2].blue *
-            multiplier_vertex_light), scene_ambient.blue
-        );
-        ioffset++;
+        int k = 0;
+        while (k < 3) {
+            uint32_t vidx = geometry->polygon_vertexindex[ioffset];
+            assert(vidx < (uint32_t)geometry->vertex_count);
+            rqueue[rfill].vertex_pos_pixels[k].x = px[vidx];
+            rqueue[rfill].vertex_pos_pixels[k].y = py[vidx];
+            rqueue[rfill].vertex_pos_pixels[k].z = pz[vidx];
+            rqueue[rfill].vertex_pos[k].x = ux[vidx];
+            rqueue[rfill].vertex_pos[k].y = uy[vidx];
+            rqueue[rfill].vertex_pos[k].z = uz[vidx];
+            #if defined(DEBUG_SPEW3D_TRANSFORM3D)
+            printf("spew3d_geometry.c: debug: geom %p "
+                "vertex #%d input world x,y,z %f,%f,%f "
+                "output x,y,z %f,%f,%f\n",
+                geometry, ioffset,
+                (double)geometry->vertex[vidx].x,
+                (double)geometry->vertex[vidx].y,
+                (double)geometry->vertex[vidx].z,
+                (double)rqueue[rfill].vertex_pos_pixels[k].x,
+                (double)rqueue[rfill].vertex_pos_pixels[k].y,
+                (double)rqueue[rfill].vertex_pos_pixels[k].z);
+            #endif
+            rqueue[rfill].vertex_texcoord[k] = (
+                geometry->polygon_texcoord[ioffset]
+            );
+            rqueue[rfill].vertex_emit[k] = (
+                geometry->polygon_vertexcolors[ioffset]
+            );
+            rqueue[rfill].vertex_emit[k].red = fmax((
+                rqueue[rfill].vertex_emit[k].red *
+                multiplier_vertex_light), scene_ambient.red
+            );
+            rqueue[rfill].vertex_emit[k].green = fmax((
+                rqueue[rfill].vertex_emit[k].green *
+                multiplier_vertex_light), scene_ambient.green
+            );
+            rqueue[rfill].vertex_emit[k].blue = fmax((
+                rqueue[rfill].vertex_emit[k].blue *
+                multiplier_vertex_light), scene_ambient.blue
+            );
+            // Transparency comes from the material, so only the
+            // tint can make this less opaque:
+            rqueue[rfill].vertex_emit[k].alpha = 1.0;
+            if (tint != NULL) {
+                rqueue[rfill].vertex_emit[k].red *= tint->red;
+                rqueue[rfill].vertex_emit[k].green *= tint->green;
+                rqueue[rfill].vertex_emit[k].blue *= tint->blue;
+                rqueue[rfill].vertex_emit[k].alpha *= tint->alpha;
+            }
+            ioffset++;
+            k++;
+        }
 
         // Compute center, etc.:
         _internal_spew3d_camera3d_UpdateRenderPolyData(
@@ -688,34 +1145,154 @@ S3DEXP int spew3d_geometry_Transform(
         rqueue[rfill].polygon_material = (
             geometry->polygon_material[i]
         );
-        memset(&rqueue[rfill].vertex_normal[0], 0,
-            sizeof(rqueue[rfill].vertex_normal[0]) * 3);
+        if (render_light_info->dynlight_mode >= DLRD_LIT_FULLY) {
+            // Normals are stored per polygon corner, so there is
+            // nothing shared to save work on here.
+            k = 0;
+            while (k < 3) {
+                rqueue[rfill].vertex_normal[k] = (
+                    have_vertex_normals ?
+                    geometry->polygon_vertexnormals[i * 3 + k] :
+                    geometry->polygon_normal[i]
+                );
+                k++;
+            }
+            // FIXME: also compute the actual light here.
+        } else {
+            memset(&rqueue[rfill].vertex_normal[0], 0,
+                sizeof(rqueue[rfill].vertex_normal[0]) * 3);
+        }
 
         rfill++;
         i++;
     }
-    if (render_light_info->dynlight_mode >= DLRD_LIT_FULLY) {
-        ioffset = 0;
-        i = 0;
-        while (i < geometry->polygon_count) {
-            if (have_vertex_normals) {
-                /// FIXME
-                assert(0);
-            } else {
-                rqueue[rfill_old + i].vertex_normal[0] =
-                    geometry->polygon_normal[i];
-                rqueue[rfill_old + i].vertex_normal[1] =
-                    geometry->polygon_normal[i];
-                rqueue[rfill_old + i].vertex_normal[2] =
-                    geometry->polygon_normal[i];
+    *render_fill = rfill;
+    return 1;
+}
+
+S3DEXP int spew3d_geometry_Transform(
+        s3d_geometry *geometry,
+        s3d_pos *model_pos,
+        s3d_rotation *model_rotation,
+        s3d_transform3d_cam_info *cam_info,
+        s3d_geometryrenderlightinfo *render_light_info,
+        s3d_renderpolygon **render_queue,
+        uint32_t *render_fill, uint32_t *render_alloc
+        ) {
+    assert(render_light_info->dynlight_mode !=
+        DLRD_INVALID);
+    if (geometry->polygon_count == 0)
+        return 0;
+
+    s3d_pos effective_model_pos = {0};
+    if (model_pos != NULL)
+        memcpy(&effective_model_pos, model_pos,
+            sizeof(*model_pos));
+    s3d_rotation effective_model_rot = {0};
+    if (model_rotation != NULL)
+        memcpy(&effective_model_rot, model_rotation,
+            sizeof(*model_rotation));
+    s3d_matrix4 modelview;
+    spew3d_math3d_matrix_modelview(
+        cam_info, &effective_model_pos, &effective_model_rot,
+        &modelview
+    );
+
+    // Transform every vertex just once, since most of them are
+    // shared by multiple polygons:
+    if (!_spew3d_geometry_LoadVertices(geometry))
+        return 0;
+    _spew3d_geometry_TransformLoadedVertices(
+        geometry, &modelview, cam_info
+    );
+    return _spew3d_geometry_AssemblePolygons(
+        geometry, &modelview, NULL, render_light_info,
+        render_queue, render_fill, render_alloc
+    );
+}
+
+S3DEXP int spew3d_geometry_TransformInstances(
+        s3d_geometry *geometry,
+        s3d_pos *model_pos,
+        s3d_rotation *model_rotation,
+        const s3d_geometryinstance *instances,
+        uint32_t instance_count, s3dnum_t cull_radius,
+        s3d_transform3d_cam_info *cam_info,
+        s3d_geometryrenderlightinfo *render_light_info,
+        s3d_renderpolygon **render_queue,
+        uint32_t *render_fill, uint32_t *render_alloc
+        ) {
+    assert(render_light_info->dynlight_mode !=
+        DLRD_INVALID);
+    if (geometry->polygon_count == 0)
+        return 0;
+
+    s3d_pos effective_model_pos = {0};
+    if (model_pos != NULL)
+        memcpy(&effective_model_pos, model_pos,
+            sizeof(*model_pos));
+    s3d_rotation effective_model_rot = {0};
+    if (model_rotation != NULL)
+        memcpy(&effective_model_rot, model_rotation,
+            sizeof(*model_rotation));
+    s3d_matrix4 object_modelview;
+    spew3d_math3d_matrix_modelview(
+        cam_info, &effective_model_pos, &effective_model_rot,
+        &object_modelview
+    );
+
+    // The vertices only need to be loaded once for all instances:
+    if (!_spew3d_geometry_LoadVertices(geometry))
+        return 0;
+    uint32_t i = 0;
+    while (i < instance_count) {
+        s3d_matrix4 modelview;
+        spew3d_math3d_matrix_model(
+            &instances[i].pos, &instances[i].rotation, &modelview
+        );
+        spew3d_math3d_matrix_multiply(
+            &object_modelview, &modelview, &modelview
+        );
+        if (cull_radius >= 0) {
+            // The instance's origin in camera space:
+            s3d_pos center;
+            center.x = modelview.m[0][3];
+            center.y = modelview.m[1][3];
+            center.z = modelview.m[2][3];
+            if (spew3d_math3d_sphere_outsideview(
+                    cam_info, &center, cull_radius
+                    )) {
+                i++;
+                continue;
             }
-            // FIXME: also compute the actual light here.
-            i++;
         }
+        _spew3d_geometry_TransformLoadedVertices(
+            geometry, &modelview, cam_info
+        );
+        if (!_spew3d_geometry_AssemblePolygons(
+                geometry, &modelview, &instances[i].tint,
+                render_light_info, render_queue,
+                render_fill, render_alloc
+                ))
+            return 0;
+        i++;
     }
-    *render_fill = rfill;
     return 1;
 }
 
+S3DEXP s3dnum_t spew3d_geometry_GetRadius(
+        s3d_geometry *geometry
+        ) {
+    s3dnum_t radius = 0;
+    int32_t i = 0;
+    while (i < geometry->vertex_count) {
+        s3dnum_t len = spew3d_math3d_len(geometry->vertex[i]);
+        if (len > radius)
+            radius = len;
+        i++;
+    }
+    return radius;
+}
+
 #endif  // SPEW3D_IMPLEMENTATION
 
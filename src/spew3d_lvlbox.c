@@ -28,7 +28,11 @@ license, see accompanied LICENSE.md.
 #if defined(SPEW3D_IMPLEMENTATION) && \
     SPEW3D_IMPLEMENTATION != 0
 
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
 #include <stdint.h>
+#include <stdio.h>
 
 typedef struct s3d_resourceload_job s3d_resourceload_job;
 
@@ -42,12 +46,36 @@ typedef struct s3d_lvlbox_internal {
     char *last_used_fence;
     int last_used_fence_vfsflags;
     int _edit_dragging_floor;
+
+    uint64_t edit_generation;
+
+    char *journal_base_path;
+    int journal_base_vfsflags;
+    int64_t journal_save_id;
+    uint64_t journal_saved_generation;
+    uint32_t journal_chunk_extent_x, journal_chunk_count;
+    uint64_t journal_base_bytes, journal_bytes;
 } s3d_lvlbox_internal;
 
 static s3d_mutex *_global_lvlbox_list_mutex = NULL;
 static s3d_lvlbox **_global_lvlbox_list = NULL;
 static int _global_lvlbox_list_fill = 0;
 
+typedef struct _s3d_lvlbox_texnameentry {
+    char *name;  // Own allocation, so it never moves with the table.
+    int vfs_flags;
+    uint32_t hash;
+    uint32_t refcount;
+    uint32_t next;  // Next slot + 1 in its bucket or the free list.
+} _s3d_lvlbox_texnameentry;
+
+static s3d_mutex *_global_lvlbox_texname_mutex = NULL;
+static _s3d_lvlbox_texnameentry *_global_lvlbox_texname = NULL;
+static uint32_t _global_lvlbox_texname_fill = 0;
+static uint32_t _global_lvlbox_texname_free = 0;  // Slot + 1.
+static uint32_t *_global_lvlbox_texname_bucket = NULL;  // Slot + 1.
+static uint32_t _global_lvlbox_texname_bucket_count = 0;
+
 S3DHID int spew3d_lvlbox_TryUpdateTileCache_nolock(
     s3d_lvlbox *lvlbox,
     uint32_t chunk_index, uint32_t tile_index
@@ -84,6 +112,12 @@ S3DHID void _spew3d_lvlbox_InvalidateTileWithNeighbors_nolock(
     s3d_lvlbox *lvlbox, uint32_t chunk_index,
     uint32_t tile_index
 );
+S3DHID void _spew3d_lvlbox_MarkChunkEdited_nolock(
+    s3d_lvlbox *lvlbox, uint32_t chunk_index
+);
+S3DHID void _spew3d_lvlbox_MarkAllChunksEdited_nolock(
+    s3d_lvlbox *lvlbox
+);
 S3DHID int _spew3d_lvlbox_GetNeighboringCorner_nolock(
     s3d_lvlbox *lvlbox, uint32_t chunk_index,
     uint32_t tile_index, int corner,
@@ -155,13 +189,210 @@ S3DHID __attribute__((constructor)) static void
     if (_global_lvlbox_list_mutex != NULL)
         return;
     _global_lvlbox_list_mutex = mutex_Create();
-    if (!_global_lvlbox_list_mutex) {
+    _global_lvlbox_texname_mutex = mutex_Create();
+    if (!_global_lvlbox_list_mutex ||
+            !_global_lvlbox_texname_mutex) {
         fprintf(stderr, "spew3d_lvlbox.c: error: FATAL ERROR, "
             "FAILED TO CREATE LVLBOX GLOBAL LIST MUTEX.\n");
         _exit(1);
     }
 }
 
+S3DHID static uint32_t _spew3d_lvlbox_TexNameHash(
+        const char *name, int vfs_flags
+        ) {
+    // FNV-1a, which is plenty for the few hundred textures a map
+    // typically uses:
+    uint32_t hash = 2166136261u;
+    while (*name != '\0') {
+        hash ^= (uint8_t)(*name);
+        hash *= 16777619u;
+        name++;
+    }
+    hash ^= (uint32_t)vfs_flags;
+    hash *= 16777619u;
+    return hash;
+}
+
+S3DHID static int _spew3d_lvlbox_TexNameGrowBuckets_nolock() {
+    uint32_t new_count = (
+        _global_lvlbox_texname_bucket_count > 0 ?
+        _global_lvlbox_texname_bucket_count * 2 : 64
+    );
+    uint32_t *new_bucket = malloc(sizeof(*new_bucket) * new_count);
+    if (!new_bucket)
+        return 0;
+    memset(new_bucket, 0, sizeof(*new_bucket) * new_count);
+    uint32_t i = 0;
+    while (i < _global_lvlbox_texname_fill) {
+        _s3d_lvlbox_texnameentry *entry = &_global_lvlbox_texname[i];
+        if (entry->name != NULL) {
+            uint32_t b = entry->hash & (new_count - 1);
+            entry->next = new_bucket[b];
+            new_bucket[b] = i + 1;
+        }
+        i++;
+    }
+    free(_global_lvlbox_texname_bucket);
+    _global_lvlbox_texname_bucket = new_bucket;
+    _global_lvlbox_texname_bucket_count = new_count;
+    return 1;
+}
+
+S3DHID s3d_lvlbox_texname_t _spew3d_lvlbox_TexNameIntern(
+        const char *name, int vfs_flags
+        ) {
+    if (name == NULL)
+        return 0;
+    uint32_t hash = _spew3d_lvlbox_TexNameHash(name, vfs_flags);
+    mutex_Lock(_global_lvlbox_texname_mutex);
+    if (_global_lvlbox_texname_bucket_count > 0) {
+        uint32_t slot = _global_lvlbox_texname_bucket[
+            hash & (_global_lvlbox_texname_bucket_count - 1)
+        ];
+        while (slot != 0) {
+            _s3d_lvlbox_texnameentry *entry = (
+                &_global_lvlbox_texname[slot - 1]
+            );
+            if (entry->hash == hash &&
+                    entry->vfs_flags == vfs_flags &&
+                    strcmp(entry->name, name) == 0) {
+                entry->refcount++;
+                mutex_Release(_global_lvlbox_texname_mutex);
+                return slot;
+            }
+            slot = entry->next;
+        }
+    }
+    // Keep the chains short by growing with the table:
+    if (_global_lvlbox_texname_fill >=
+            _global_lvlbox_texname_bucket_count &&
+            _global_lvlbox_texname_free == 0 &&
+            !_spew3d_lvlbox_TexNameGrowBuckets_nolock()) {
+        mutex_Release(_global_lvlbox_texname_mutex);
+        return 0;
+    }
+    char *name_copy = strdup(name);
+    if (!name_copy) {
+        mutex_Release(_global_lvlbox_texname_mutex);
+        return 0;
+    }
+    uint32_t free_slot;
+    if (_global_lvlbox_texname_free != 0) {
+        free_slot = _global_lvlbox_texname_free - 1;
+        _global_lvlbox_texname_free = (
+            _global_lvlbox_texname[free_slot].next
+        );
+    } else {
+        _s3d_lvlbox_texnameentry *new_table = realloc(
+            _global_lvlbox_texname, sizeof(*new_table) *
+            (_global_lvlbox_texname_fill + 1)
+        );
+        if (!new_table) {
+            free(name_copy);
+            mutex_Release(_global_lvlbox_texname_mutex);
+            return 0;
+        }
+        _global_lvlbox_texname = new_table;
+        free_slot = _global_lvlbox_texname_fill;
+        _global_lvlbox_texname_fill++;
+    }
+    _s3d_lvlbox_texnameentry *entry = (
+        &_global_lvlbox_texname[free_slot]
+    );
+    entry->name = name_copy;
+    entry->vfs_flags = vfs_flags;
+    entry->hash = hash;
+    entry->refcount = 1;
+    uint32_t b = hash & (_global_lvlbox_texname_bucket_count - 1);
+    entry->next = _global_lvlbox_texname_bucket[b];
+    _global_lvlbox_texname_bucket[b] = free_slot + 1;
+    mutex_Release(_global_lvlbox_texname_mutex);
+    return free_slot + 1;
+}
+
+S3DHID s3d_lvlbox_texname_t _spew3d_lvlbox_TexNameRetain(
+        s3d_lvlbox_texname_t name_ref
+        ) {
+    if (name_ref == 0)
+        return 0;
+    mutex_Lock(_global_lvlbox_texname_mutex);
+    assert(name_ref <= _global_lvlbox_texname_fill);
+    assert(_global_lvlbox_texname[name_ref - 1].refcount > 0);
+    _global_lvlbox_texname[name_ref - 1].refcount++;
+    mutex_Release(_global_lvlbox_texname_mutex);
+    return name_ref;
+}
+
+S3DHID void _spew3d_lvlbox_TexNameRelease(
+        s3d_lvlbox_texname_t name_ref
+        ) {
+    if (name_ref == 0)
+        return;
+    mutex_Lock(_global_lvlbox_texname_mutex);
+    assert(name_ref <= _global_lvlbox_texname_fill);
+    _s3d_lvlbox_texnameentry *entry = (
+        &_global_lvlbox_texname[name_ref - 1]
+    );
+    assert(entry->refcount > 0);
+    entry->refcount--;
+    if (entry->refcount == 0) {
+        // Unlink it from its bucket, then put it on the free list:
+        uint32_t *link = &_global_lvlbox_texname_bucket[
+            entry->hash & (_global_lvlbox_texname_bucket_count - 1)
+        ];
+        while (*link != name_ref) {
+            assert(*link != 0);
+            link = &_global_lvlbox_texname[*link - 1].next;
+        }
+        *link = entry->next;
+        free(entry->name);
+        entry->name = NULL;
+        entry->next = _global_lvlbox_texname_free;
+        _global_lvlbox_texname_free = name_ref;
+    }
+    mutex_Release(_global_lvlbox_texname_mutex);
+}
+
+S3DEXP const char *spew3d_lvlbox_TexNameToStr(
+        s3d_lvlbox_texname_t name_ref
+        ) {
+    if (name_ref == 0)
+        return NULL;
+    // The string has its own allocation, so it stays put when the
+    // table grows, and lives for as long as name_ref is held:
+    mutex_Lock(_global_lvlbox_texname_mutex);
+    assert(name_ref <= _global_lvlbox_texname_fill);
+    const char *name = _global_lvlbox_texname[name_ref - 1].name;
+    mutex_Release(_global_lvlbox_texname_mutex);
+    return name;
+}
+
+S3DEXP int spew3d_lvlbox_TexNameToVFSFlags(
+        s3d_lvlbox_texname_t name_ref
+        ) {
+    if (name_ref == 0)
+        return 0;
+    mutex_Lock(_global_lvlbox_texname_mutex);
+    assert(name_ref <= _global_lvlbox_texname_fill);
+    int vfs_flags = _global_lvlbox_texname[name_ref - 1].vfs_flags;
+    mutex_Release(_global_lvlbox_texname_mutex);
+    return vfs_flags;
+}
+
+S3DHID int _spew3d_lvlbox_SetTexInfoName(
+        s3d_lvlbox_texinfo *tex, const char *name, int vfs_flags
+        ) {
+    s3d_lvlbox_texname_t new_ref = _spew3d_lvlbox_TexNameIntern(
+        name, vfs_flags
+    );
+    if (new_ref == 0 && name != NULL)
+        return 0;
+    _spew3d_lvlbox_TexNameRelease(tex->name_ref);
+    tex->name_ref = new_ref;
+    return 1;
+}
+
 S3DHID static void _spew3d_lvlbox_FreeTileCacheContents(
         s3d_lvlbox_tilecache *cache
         ) {
@@ -192,6 +423,9 @@ S3DHID static void _spew3d_lvlbox_FreeTileCacheContents(
     cache->cached_fence_maxpolycount = 0;
     cache->cached_fence = NULL;
 
+    free(cache->normals);
+    cache->normals = NULL;
+
     cache->is_up_to_date = 0;
     cache->flat_normals_set = 0;
 }
@@ -426,154 +660,57 @@ S3DHID void *_spew3d_lvlbox_CycleTexCb(
         mutex_Release(_lvlbox_Internal(lvlbox)->m);
         return (void*)0;
     }
-    if (req->is_targeting_floor) {
-        if (tile->segment[req->segment_no].floor_tex.name) {
-            free(tile->segment[req->segment_no].floor_tex.name);
-        }
-        tile->segment[req->segment_no].floor_tex.name = new_tex;
-        tile->segment[req->segment_no].floor_tex.id = new_tex_id;
-        tile->segment[req->segment_no].cache.is_up_to_date = 0;
-        tile->segment[req->segment_no].cache.flat_normals_set = 0;
+    s3d_lvlbox_texname_t new_tex_ref = _spew3d_lvlbox_TexNameIntern(
+        new_tex, vfsflags
+    );
+    free(new_tex);
+    new_tex = NULL;
+    if (new_tex_ref == 0) {
         free(req);
         mutex_Release(_lvlbox_Internal(lvlbox)->m);
-        return (void*)1;
+        return (void*)0;
+    }
+    s3d_lvlbox_vertsegment *seg = &tile->segment[req->segment_no];
+    s3d_lvlbox_texinfo *target_tex = NULL;
+    if (req->is_targeting_floor) {
+        target_tex = &seg->texinfo->floor_tex;
     } else if (req->is_targeting_ceiling) {
-        if (tile->segment[req->segment_no].ceiling_tex.name) {
-            free(tile->segment[req->segment_no].ceiling_tex.name);
-        }
-        tile->segment[req->segment_no].ceiling_tex.name = new_tex;
-        tile->segment[req->segment_no].ceiling_tex.id = new_tex_id;
-        tile->segment[req->segment_no].cache.is_up_to_date = 0;
-            tile->segment[req->segment_no].cache.flat_normals_set = 0;
-        free(req);
-        mutex_Release(_lvlbox_Internal(lvlbox)->m);
-        return (void*)1;
+        target_tex = &seg->texinfo->ceiling_tex;
     } else if (req->target_verti_fence_no >= 0) {
-        if (tile->segment[req->segment_no].
-                wall[req->target_verti_fence_no].
-                fence.tex.name) {
-            free(tile->segment[req->segment_no].
-                wall[req->target_verti_fence_no].
-                fence.tex.name);
-        }
-        tile->segment[req->segment_no].
-            wall[req->target_verti_fence_no].
-                fence.tex.name = new_tex;
-        tile->segment[req->segment_no].
-            wall[req->target_verti_fence_no].
-                fence.tex.id = new_tex_id;
-        tile->segment[req->segment_no].
-            wall[req->target_verti_fence_no].
-                fence.tex.vfs_flags = vfsflags;
-        tile->segment[req->segment_no].cache.is_up_to_date = 0;
-        tile->segment[req->segment_no].cache.flat_normals_set = 0;
-        free(req);
-        mutex_Release(_lvlbox_Internal(lvlbox)->m);
-        return (void*)1;
+        target_tex = &seg->texinfo->wall[req->target_verti_fence_no].fence.tex;
     } else if (req->target_hori_fence_no >= 0) {
-        if (tile->segment[req->segment_no].
-                hori_fence[req->target_hori_fence_no].
-                tex.name) {
-            free(tile->segment[req->segment_no].
-                hori_fence[req->target_hori_fence_no].
-                tex.name);
-        }
-        tile->segment[req->segment_no].
-            hori_fence[req->target_hori_fence_no].
-                tex.name = new_tex;
-        tile->segment[req->segment_no].
-            hori_fence[req->target_hori_fence_no].
-                tex.id = new_tex_id;
-        tile->segment[req->segment_no].
-            hori_fence[req->target_hori_fence_no].
-                tex.vfs_flags = vfsflags;
-        tile->segment[req->segment_no].cache.is_up_to_date = 0;
-        tile->segment[req->segment_no].cache.flat_normals_set = 0;
-        free(req);
-        mutex_Release(_lvlbox_Internal(lvlbox)->m);
-        return (void*)1;
+        target_tex = &seg->hori_fence[req->target_hori_fence_no].tex;
     } else {
         assert(req->target_wall_no >= 0);
+        s3d_lvlbox_wallinfo *wall = &seg->texinfo->wall[req->target_wall_no];
         if (!req->is_targeting_top_wall) {
-            int change_top_wall_too = ((
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].tex.name == NULL &&
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.name == NULL) || (
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].tex.name != NULL &&
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.name != NULL &&
-                strcmp(tile->segment[req->segment_no].
-                    wall[req->target_wall_no].tex.name,
-                    tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.name) == 0 &&
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].tex.vfs_flags ==
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.vfs_flags
-            ));
-            char *top_new_tex = NULL;
-            s3d_texture_t top_new_tex_id = 0;
-            if (change_top_wall_too) {
-                top_new_tex = strdup(new_tex);
-                if (top_new_tex != NULL)
-                    top_new_tex_id = spew3d_texture_FromFile(
-                        new_tex, vfsflags
-                    );
-                if (!top_new_tex || top_new_tex_id == 0) {
-                    free(top_new_tex);
-                    free(new_tex);
-                    free(req);
-                    mutex_Release(_lvlbox_Internal(lvlbox)->m);
-                    return (void*)0;
-                }
-            }
-            if (tile->segment[req->segment_no].
-                    wall[req->target_wall_no].tex.name) {
-                free(tile->segment[req->segment_no].
-                    wall[req->target_wall_no].tex.name);
-            }
-            tile->segment[req->segment_no].
-                wall[req->target_wall_no].tex.name = new_tex;
-            tile->segment[req->segment_no].
-                wall[req->target_wall_no].tex.id = new_tex_id;
-            tile->segment[req->segment_no].
-                wall[req->target_wall_no].
-                    tex.vfs_flags = vfsflags;
+            // If the top part looked the same, keep it the same:
+            int change_top_wall_too = (
+                wall->tex.name_ref == wall->toptex.name_ref
+            );
             if (change_top_wall_too) {
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.name =
-                        top_new_tex;
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.id =
-                        top_new_tex_id;
-                tile->segment[req->segment_no].
-                    wall[req->target_wall_no].
-                        toptex.vfs_flags = vfsflags;
+                _spew3d_lvlbox_TexNameRelease(wall->toptex.name_ref);
+                wall->toptex.name_ref = _spew3d_lvlbox_TexNameRetain(
+                    new_tex_ref
+                );
+                wall->toptex.id = new_tex_id;
             }
-            tile->segment[req->segment_no].cache.is_up_to_date = 0;
-            tile->segment[req->segment_no].cache.flat_normals_set = 0;
-            free(req);
-            mutex_Release(_lvlbox_Internal(lvlbox)->m);
-            return (void*)1;
+            target_tex = &wall->tex;
         } else {
-            if (tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.name) {
-                free(tile->segment[req->segment_no].
-                    wall[req->target_wall_no].toptex.name);
-            }
-            tile->segment[req->segment_no].
-                wall[req->target_wall_no].toptex.name = new_tex;
-            tile->segment[req->segment_no].
-                wall[req->target_wall_no].toptex.id = new_tex_id;
-            tile->segment[req->segment_no].cache.is_up_to_date = 0;
-            tile->segment[req->segment_no].cache.flat_normals_set = 0;
-            free(req);
-            mutex_Release(_lvlbox_Internal(lvlbox)->m);
-            return (void*)1;
+            target_tex = &wall->toptex;
         }
     }
+    _spew3d_lvlbox_TexNameRelease(target_tex->name_ref);
+    target_tex->name_ref = new_tex_ref;
+    target_tex->id = new_tex_id;
+    seg->cache.is_up_to_date = 0;
+    seg->cache.flat_normals_set = 0;
+    _spew3d_lvlbox_MarkChunkEdited_nolock(
+        lvlbox, req->chunk_index
+    );
+    free(req);
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return (void*)1;
 }
 
 S3DHID int _spew3d_lvlbox_CycleTextureAtTileIdx_nolock(
@@ -632,34 +769,12 @@ S3DHID int _spew3d_lvlbox_CycleTextureAtTileIdx_nolock(
         free(req);
         return 1;
     }
-    int cyclevfsflags = 0;
-    char *old_tex = NULL;
+    s3d_lvlbox_vertsegment *seg = &tile->segment[segment_no];
+    s3d_lvlbox_texinfo *old_texinfo = NULL;
     if (is_targeting_floor) {
-        if (tile->segment[segment_no].floor_tex.name) {
-            old_tex = strdup(
-                tile->segment[segment_no].floor_tex.name
-            );
-            cyclevfsflags = (
-                tile->segment[segment_no].floor_tex.vfs_flags
-            );
-            if (!old_tex) {
-                free(req);
-                return 0;
-            }
-        }
+        old_texinfo = &seg->texinfo->floor_tex;
     } else if (is_targeting_ceiling) {
-        if (tile->segment[segment_no].ceiling_tex.name) {
-            old_tex = strdup(
-                tile->segment[segment_no].ceiling_tex.name
-            );
-            cyclevfsflags = (
-                tile->segment[segment_no].ceiling_tex.vfs_flags
-            );
-            if (!old_tex) {
-                free(req);
-                return 0;
-            }
-        }
+        old_texinfo = &seg->texinfo->ceiling_tex;
     } else {
         assert(
             target_wall_no >= 0 ||
@@ -668,78 +783,31 @@ S3DHID int _spew3d_lvlbox_CycleTextureAtTileIdx_nolock(
         );
         if (!is_targeting_top_wall) {
             if (target_verti_fence_no >= 0) {
-                if (tile->segment[segment_no].
-                        wall[target_verti_fence_no].fence.tex.name !=
-                        NULL) {
-                    old_tex = strdup(
-                        tile->segment[segment_no].
-                            wall[target_wall_no].fence.tex.name
-                    );
-                    cyclevfsflags = (
-                        tile->segment[segment_no].
-                            wall[target_wall_no].fence.tex.vfs_flags
-                    );
-                    if (!old_tex) {
-                        free(req);
-                        return 0;
-                    }
-                }
+                old_texinfo = &seg->texinfo->wall[
+                    target_verti_fence_no].fence.tex;
             } else if (target_hori_fence_no >= 0) {
-                if (tile->segment[segment_no].
-                        hori_fence[target_hori_fence_no].tex.name !=
-                        NULL) {
-                    old_tex = strdup(
-                        tile->segment[segment_no].
-                            hori_fence[target_hori_fence_no].
-                                tex.name
-                    );
-                    cyclevfsflags = (
-                        tile->segment[segment_no].
-                            hori_fence[target_hori_fence_no].
-                                tex.vfs_flags
-                    );
-                    if (!old_tex) {
-                        free(req);
-                        return 0;
-                    }
-                }
-            } else if (tile->segment[segment_no].
-                    wall[target_wall_no].tex.name != NULL) {
-                old_tex = strdup(
-                    tile->segment[segment_no].
-                        wall[target_wall_no].tex.name
-                );
-                cyclevfsflags = (
-                    tile->segment[segment_no].
-                        wall[target_wall_no].tex.vfs_flags
-                );
-                if (!old_tex) {
-                    free(req);
-                    return 0;
-                }
+                old_texinfo = &seg->hori_fence[target_hori_fence_no].tex;
+            } else {
+                old_texinfo = &seg->texinfo->wall[target_wall_no].tex;
             }
         } else {
-            if (tile->segment[segment_no].
-                    wall[target_wall_no].toptex.name != NULL) {
-                old_tex = strdup(
-                    tile->segment[segment_no].
-                        wall[target_wall_no].toptex.name
-                );
-                cyclevfsflags = (
-                    tile->segment[segment_no].
-                        wall[target_wall_no].toptex.vfs_flags
-                );
-                if (!old_tex) {
-                    free(req);
-                    return 0;
-                }
-            }
+            old_texinfo = &seg->texinfo->wall[target_wall_no].toptex;
         }
     }
-    if (!old_tex) {
+    if (old_texinfo->name_ref == 0) {
         free(req);
         return 1;
     }
+    int cyclevfsflags = spew3d_lvlbox_TexNameToVFSFlags(
+        old_texinfo->name_ref
+    );
+    char *old_tex = strdup(spew3d_lvlbox_TexNameToStr(
+        old_texinfo->name_ref
+    ));
+    if (!old_tex) {
+        free(req);
+        return 0;
+    }
     req->current_tex_path = old_tex;
     req->lvlbox_gid = lvlbox->gid;
     req->chunk_index = chunk_index;
@@ -1080,6 +1148,53 @@ S3DHID int _spew3d_lvlbox_GetNeighborTileVertSegment_nolock(
     return 1;
 }
 
+S3DHID static void _spew3d_lvlbox_FreeFenceInfoContents(
+        s3d_lvlbox_fenceinfo *fence
+        ) {
+    _spew3d_lvlbox_TexNameRelease(fence->tex.name_ref);
+    fence->tex.name_ref = 0;
+}
+
+S3DHID static int _spew3d_lvlbox_AllocSegmentTex(
+        s3d_lvlbox_vertsegment *seg
+        ) {
+    assert(seg->texinfo == NULL);
+    seg->texinfo = malloc(sizeof(*seg->texinfo));
+    if (!seg->texinfo)
+        return 0;
+    memset(seg->texinfo, 0, sizeof(*seg->texinfo));
+    return 1;
+}
+
+S3DHID static void _spew3d_lvlbox_FreeSegmentContents(
+        s3d_lvlbox_vertsegment *seg
+        ) {
+    if (seg->texinfo != NULL) {
+        s3d_lvlbox_segmenttex *texinfo = seg->texinfo;
+        _spew3d_lvlbox_TexNameRelease(texinfo->floor_tex.name_ref);
+        _spew3d_lvlbox_TexNameRelease(texinfo->ceiling_tex.name_ref);
+        int w = 0;
+        while (w < 4) {
+            _spew3d_lvlbox_TexNameRelease(texinfo->wall[w].tex.name_ref);
+            _spew3d_lvlbox_TexNameRelease(
+                texinfo->wall[w].toptex.name_ref
+            );
+            _spew3d_lvlbox_FreeFenceInfoContents(&texinfo->wall[w].fence);
+            w++;
+        }
+        free(texinfo);
+        seg->texinfo = NULL;
+    }
+    int f = 0;
+    while (f < seg->hori_fence_count) {
+        _spew3d_lvlbox_FreeFenceInfoContents(&seg->hori_fence[f]);
+        f++;
+    }
+    free(seg->hori_fence);
+    free(seg->hori_fence_z);
+    _spew3d_lvlbox_FreeTileCacheContents(&seg->cache);
+}
+
 S3DHID static void _spew3d_lvlbox_FreeChunkContents(
         s3d_lvlbox_chunk *chunk
         ) {
@@ -1087,13 +1202,12 @@ S3DHID static void _spew3d_lvlbox_FreeChunkContents(
     while (i < (uint32_t)(LVLBOX_CHUNK_SIZE * LVLBOX_CHUNK_SIZE)) {
         if (!chunk->tile[i].occupied) {
             i++;
+            continue;
         }
         int k = 0;
         while (k < chunk->tile[i].segment_count) {
-            if (chunk->tile[i].segment[k].floor_tex.name != NULL)
-                free(chunk->tile[i].segment[k].floor_tex.name);
-            _spew3d_lvlbox_FreeTileCacheContents(
-                &chunk->tile[i].segment[k].cache
+            _spew3d_lvlbox_FreeSegmentContents(
+                &chunk->tile[i].segment[k]
             );
             k++;
         }
@@ -1119,6 +1233,7 @@ S3DHID static void _spew3d_lvlbox_ActuallyDestroy(
         i++;
     }
     mutex_Release(_global_lvlbox_list_mutex);
+    i = 0;
     while (i < lvlbox->chunk_count) {
         _spew3d_lvlbox_FreeChunkContents(&lvlbox->chunk[i]);
         i++;
@@ -1135,6 +1250,7 @@ S3DHID static void _spew3d_lvlbox_ActuallyDestroy(
             free(_lvlbox_Internal(lvlbox)->last_used_tex);
         if (_lvlbox_Internal(lvlbox)->last_used_fence != NULL)
             free(_lvlbox_Internal(lvlbox)->last_used_fence);
+        free(_lvlbox_Internal(lvlbox)->journal_base_path);
     }
     free(lvlbox->_internal);
     free(lvlbox->chunk);
@@ -1357,7 +1473,8 @@ S3DHID int _spew3d_lvlbox_GetNeighborNormalsAtCorner_nolock(
                 assert(neighbor_tile->segment[i].cache.flat_normals_set);
                 if (out_normal)
                     *out_normal = neighbor_tile->segment[i].cache.
-                        ceiling_flat_corner_normals[neighbor_corner];
+                        normals->ceiling_flat_corner_normals[
+                            neighbor_corner];
                 return 1;
             }
             i++;
@@ -1371,7 +1488,8 @@ S3DHID int _spew3d_lvlbox_GetNeighborNormalsAtCorner_nolock(
                 assert(neighbor_tile->segment[i].cache.flat_normals_set);
                 if (out_normal)
                     *out_normal = neighbor_tile->segment[i].cache.
-                        floor_flat_corner_normals[neighbor_corner];
+                        normals->floor_flat_corner_normals[
+                            neighbor_corner];
                 return 1;
             }
             i++;
@@ -1380,6 +1498,106 @@ S3DHID int _spew3d_lvlbox_GetNeighborNormalsAtCorner_nolock(
     return 0;
 }
 
+S3DHID static s3d_lvlbox_texinfo *_spew3d_lvlbox_SegmentTexInfoById(
+        s3d_lvlbox_vertsegment *seg, s3d_texture_t id
+        ) {
+    if (seg->texinfo->floor_tex.id == id)
+        return &seg->texinfo->floor_tex;
+    if (seg->texinfo->ceiling_tex.id == id)
+        return &seg->texinfo->ceiling_tex;
+    int k = 0;
+    while (k < 4) {
+        if (seg->texinfo->wall[k].tex.id == id)
+            return &seg->texinfo->wall[k].tex;
+        if (seg->texinfo->wall[k].toptex.id == id)
+            return &seg->texinfo->wall[k].toptex;
+        if (seg->texinfo->wall[k].fence.tex.id == id)
+            return &seg->texinfo->wall[k].fence.tex;
+        k++;
+    }
+    k = 0;
+    while (k < seg->hori_fence_count) {
+        if (seg->hori_fence[k].tex.id == id)
+            return &seg->hori_fence[k].tex;
+        k++;
+    }
+    return NULL;
+}
+
+S3DHID static void _spew3d_lvlbox_ApplyAtlasToPolygons_nolock(
+        s3d_lvlbox_vertsegment *seg,
+        s3d_lvlbox_tilepolygon *polys, uint16_t count
+        ) {
+    uint16_t i = 0;
+    while (i < count) {
+        s3d_lvlbox_tilepolygon *poly = &polys[i];
+        i++;
+        if (poly->texture == 0)
+            continue;
+        s3d_lvlbox_texinfo *texinfo = (
+            _spew3d_lvlbox_SegmentTexInfoById(seg, poly->texture)
+        );
+        if (texinfo == NULL)
+            continue;  // Already remapped to an atlas page.
+        // Repeating or scrolling textures can't use an atlas:
+        if ((texinfo->wrapmode != S3D_LVLBOX_TEXWRAP_MODE_DEFAULT &&
+                texinfo->wrapmode !=
+                    S3D_LVLBOX_TEXWRAP_MODE_STRETCHED) ||
+                texinfo->scroll_speed_x != 0 ||
+                texinfo->scroll_speed_y != 0)
+            continue;
+        int k = 0;
+        while (k < 3) {
+            if (poly->texcoord[k].x < 0 || poly->texcoord[k].x > 1 ||
+                    poly->texcoord[k].y < 0 ||
+                    poly->texcoord[k].y > 1)
+                break;
+            k++;
+        }
+        if (k < 3)
+            continue;
+        s3d_texture_t page = 0;
+        s3d_point offset, scale;
+        int result = spew3d_texture_GetAtlasRegion(
+            poly->texture, &page, &offset, &scale
+        );
+        if (result < 0) {
+            seg->cache.atlas_pending = 1;
+            continue;
+        } else if (result == 0) {
+            continue;
+        }
+        k = 0;
+        while (k < 3) {
+            poly->texcoord[k].x = offset.x +
+                poly->texcoord[k].x * scale.x;
+            poly->texcoord[k].y = offset.y +
+                poly->texcoord[k].y * scale.y;
+            k++;
+        }
+        poly->texture = page;
+    }
+}
+
+S3DHID static void _spew3d_lvlbox_ApplyAtlasToTileCache_nolock(
+        s3d_lvlbox_vertsegment *seg
+        ) {
+    s3d_lvlbox_tilecache *cache = &seg->cache;
+    cache->atlas_pending = 0;
+    _spew3d_lvlbox_ApplyAtlasToPolygons_nolock(
+        seg, cache->cached_floor, cache->cached_floor_polycount
+    );
+    _spew3d_lvlbox_ApplyAtlasToPolygons_nolock(
+        seg, cache->cached_ceiling, cache->cached_ceiling_polycount
+    );
+    _spew3d_lvlbox_ApplyAtlasToPolygons_nolock(
+        seg, cache->cached_wall, cache->cached_wall_polycount
+    );
+    _spew3d_lvlbox_ApplyAtlasToPolygons_nolock(
+        seg, cache->cached_fence, cache->cached_fence_polycount
+    );
+}
+
 S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
         s3d_lvlbox *lvlbox,
         uint32_t chunk_index, uint32_t tile_index,
@@ -1398,6 +1616,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
     uint32_t i = 0;
     while (i < tile->segment_count) {
         if (tile->segment[i].cache.is_up_to_date) {
+            if (tile->segment[i].cache.atlas_pending)
+                _spew3d_lvlbox_ApplyAtlasToTileCache_nolock(
+                    &tile->segment[i]
+                );
             i++;
             continue;
         }
@@ -1407,6 +1629,14 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
         const uint32_t segment_no =i;
 
         // Set up polygon list for use:
+        if (cache->normals == NULL) {
+            cache->flat_normals_set = 0;
+            cache->normals = malloc(sizeof(*cache->normals));
+            if (!cache->normals) {
+                return 0;
+            }
+            memset(cache->normals, 0, sizeof(*cache->normals));
+        }
         if (cache->cached_floor_maxpolycount < 2) {
             cache->flat_normals_set = 0;
             s3d_lvlbox_tilepolygon *new_polys = (
@@ -1450,7 +1680,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
         {
             int k = 0;
             while (k < 4) {
-                if (tile->segment[i].wall[k].fence.is_set) {
+                if (tile->segment[i].texinfo->wall[k].fence.is_set) {
                     fence_count++;
                 }
                 k++;
@@ -1513,14 +1743,14 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
 
             if (diagonalfrontrightbackleft >
                     diagonalfrontleftbackright &&
-                    tile->segment[segment_no].floor_tex.id != 0) {
+                    tile->segment[segment_no].texinfo->floor_tex.id != 0) {
                 cache->floor_split_from_front_left = 1;
                 memset(&cache->cached_floor[0], 0,
                     sizeof(cache->cached_floor[0]));
                 cache->cached_floor[0].texture =
-                    tile->segment[segment_no].floor_tex.id;
+                    tile->segment[segment_no].texinfo->floor_tex.id;
                 cache->cached_floor[0].material =
-                    tile->segment[segment_no].floor_tex.material;
+                    tile->segment[segment_no].texinfo->floor_tex.material;
                 cache->cached_floor[0].vertex[0] = front_left;
                 cache->cached_floor[0].vertex[1] = front_right;
                 cache->cached_floor[0].vertex[2] = back_right;
@@ -1544,9 +1774,9 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                 memset(&cache->cached_floor[1], 0,
                     sizeof(cache->cached_floor[1]));
                 cache->cached_floor[1].texture =
-                    tile->segment[segment_no].floor_tex.id;
+                    tile->segment[segment_no].texinfo->floor_tex.id;
                 cache->cached_floor[1].material =
-                    tile->segment[segment_no].floor_tex.material;
+                    tile->segment[segment_no].texinfo->floor_tex.material;
                 cache->cached_floor[1].vertex[0] = back_right;
                 cache->cached_floor[1].vertex[1] = back_left;
                 cache->cached_floor[1].vertex[2] = front_left;
@@ -1567,27 +1797,27 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                         &cache->cached_floor[1].polynormal
                     );
 
-                cache->floor_flat_corner_normals[0] =
+                cache->normals->floor_flat_corner_normals[0] =
                     cache->cached_floor[0].polynormal;
-                cache->floor_flat_corner_normals[2] =
+                cache->normals->floor_flat_corner_normals[2] =
                     cache->cached_floor[1].polynormal;
-                cache->floor_flat_corner_normals[1] = spew3d_math3d_average(
+                cache->normals->floor_flat_corner_normals[1] = spew3d_math3d_average(
                     &cache->cached_floor[0].polynormal,
                     &cache->cached_floor[1].polynormal
                 );
-                cache->floor_flat_corner_normals[3] = spew3d_math3d_average(
+                cache->normals->floor_flat_corner_normals[3] = spew3d_math3d_average(
                     &cache->cached_floor[0].polynormal,
                     &cache->cached_floor[1].polynormal
                 );
                 cache->cached_floor_polycount = 2;
-            } else if (tile->segment[segment_no].floor_tex.id != 0) {
+            } else if (tile->segment[segment_no].texinfo->floor_tex.id != 0) {
                 cache->floor_split_from_front_left = 0;
                 memset(&cache->cached_floor[0], 0,
                     sizeof(cache->cached_floor[0]));
                 cache->cached_floor[0].texture =
-                    tile->segment[segment_no].floor_tex.id;
+                    tile->segment[segment_no].texinfo->floor_tex.id;
                 cache->cached_floor[0].material =
-                    tile->segment[segment_no].floor_tex.material;
+                    tile->segment[segment_no].texinfo->floor_tex.material;
                 cache->cached_floor[0].vertex[0] = front_left;
                 cache->cached_floor[0].vertex[1] = front_right;
                 cache->cached_floor[0].vertex[2] = back_left;
@@ -1611,9 +1841,9 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                 memset(&cache->cached_floor[1], 0,
                     sizeof(cache->cached_floor[1]));
                 cache->cached_floor[1].texture =
-                    tile->segment[segment_no].floor_tex.id;
+                    tile->segment[segment_no].texinfo->floor_tex.id;
                 cache->cached_floor[1].material =
-                    tile->segment[segment_no].floor_tex.material;
+                    tile->segment[segment_no].texinfo->floor_tex.material;
                 cache->cached_floor[1].vertex[0] = back_left;
                 cache->cached_floor[1].vertex[1] = front_right;
                 cache->cached_floor[1].vertex[2] = back_right;
@@ -1634,15 +1864,15 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                         &cache->cached_floor[1].polynormal
                     );
 
-                cache->floor_flat_corner_normals[1] =
+                cache->normals->floor_flat_corner_normals[1] =
                     cache->cached_floor[1].polynormal;
-                cache->floor_flat_corner_normals[3] =
+                cache->normals->floor_flat_corner_normals[3] =
                     cache->cached_floor[0].polynormal;
-                cache->floor_flat_corner_normals[0] = spew3d_math3d_average(
+                cache->normals->floor_flat_corner_normals[0] = spew3d_math3d_average(
                     &cache->cached_floor[0].polynormal,
                     &cache->cached_floor[1].polynormal
                 );
-                cache->floor_flat_corner_normals[2] = spew3d_math3d_average(
+                cache->normals->floor_flat_corner_normals[2] = spew3d_math3d_average(
                     &cache->cached_floor[0].polynormal,
                     &cache->cached_floor[1].polynormal
                 );
@@ -1655,7 +1885,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
             int k = 0;
             while (k < 4) {
                 if (!tile->segment[segment_no].
-                        wall[k].fence.is_set) {
+                        texinfo->wall[k].fence.is_set) {
                     k++;
                     continue;
                 }
@@ -1767,18 +1997,18 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                     }
                     shared_max_z_left = fmin(
                         shared_max_z_left, shared_min_z_left + (
-                            tile->segment[segment_no].wall[k].
+                            tile->segment[segment_no].texinfo->wall[k].
                                 fence.truncate_set ?
-                            tile->segment[segment_no].wall[k].
+                            tile->segment[segment_no].texinfo->wall[k].
                                 fence.truncate_height_z :
                             LVLBOX_FENCE_VERTICAL_MAXHEIGHT
                         )
                     );
                     shared_max_z_right = fmin(
                         shared_max_z_right, shared_min_z_right + (
-                            tile->segment[segment_no].wall[k].
+                            tile->segment[segment_no].texinfo->wall[k].
                                 fence.truncate_set ?
-                            tile->segment[segment_no].wall[k].
+                            tile->segment[segment_no].texinfo->wall[k].
                                 fence.truncate_height_z :
                             LVLBOX_FENCE_VERTICAL_MAXHEIGHT
                         )
@@ -1808,10 +2038,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                         sizeof(cache->cached_fence[z]));
                     cache->cached_fence[z].texture =
                         tile->segment[segment_no].
-                        wall[k].fence.tex.id;
+                        texinfo->wall[k].fence.tex.id;
                     cache->cached_fence[z].material =
                         tile->segment[segment_no].
-                        wall[k].fence.tex.material;
+                        texinfo->wall[k].fence.tex.material;
                     cache->cached_fence[z].vertex[0].x =
                         left_corner_x;
                     cache->cached_fence[z].vertex[0].y =
@@ -1849,10 +2079,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                         sizeof(cache->cached_fence[z]));
                     cache->cached_fence[z].texture =
                         tile->segment[segment_no].
-                        wall[k].fence.tex.id;
+                        texinfo->wall[k].fence.tex.id;
                     cache->cached_fence[z].material =
                         tile->segment[segment_no].
-                        wall[k].fence.tex.material;
+                        texinfo->wall[k].fence.tex.material;
                     cache->cached_fence[z].vertex[0].x =
                         left_corner_x;
                     cache->cached_fence[z].vertex[0].y =
@@ -2021,14 +2251,14 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
 
             if (diagonalfrontrightbackleft >
                     diagonalfrontleftbackright &&
-                    tile->segment[segment_no].ceiling_tex.id != 0) {
+                    tile->segment[segment_no].texinfo->ceiling_tex.id != 0) {
                 cache->ceiling_split_from_front_left = 1;
                 memset(&cache->cached_ceiling[0], 0,
                     sizeof(cache->cached_ceiling[0]));
                 cache->cached_ceiling[0].texture =
-                    tile->segment[segment_no].ceiling_tex.id;
+                    tile->segment[segment_no].texinfo->ceiling_tex.id;
                 cache->cached_ceiling[0].material =
-                    tile->segment[segment_no].ceiling_tex.material;
+                    tile->segment[segment_no].texinfo->ceiling_tex.material;
                 cache->cached_ceiling[0].vertex[0] = front_left;
                 cache->cached_ceiling[0].vertex[1] = front_right;
                 cache->cached_ceiling[0].vertex[2] = back_right;
@@ -2052,9 +2282,9 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                 memset(&cache->cached_ceiling[1], 0,
                     sizeof(cache->cached_ceiling[1]));
                 cache->cached_ceiling[1].texture =
-                    tile->segment[segment_no].ceiling_tex.id;
+                    tile->segment[segment_no].texinfo->ceiling_tex.id;
                 cache->cached_ceiling[1].material =
-                    tile->segment[segment_no].ceiling_tex.material;
+                    tile->segment[segment_no].texinfo->ceiling_tex.material;
                 cache->cached_ceiling[1].vertex[0] = back_right;
                 cache->cached_ceiling[1].vertex[1] = back_left;
                 cache->cached_ceiling[1].vertex[2] = front_left;
@@ -2075,31 +2305,32 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                         &cache->cached_ceiling[1].polynormal
                     );
 
-                cache->ceiling_flat_corner_normals[0] =
+                cache->normals->ceiling_flat_corner_normals[0] =
                     cache->cached_ceiling[0].polynormal;
-                cache->ceiling_flat_corner_normals[2] =
+                cache->normals->ceiling_flat_corner_normals[2] =
                     cache->cached_ceiling[1].polynormal;
-                cache->ceiling_flat_corner_normals[1] = (
+                cache->normals->ceiling_flat_corner_normals[1] = (
                     spew3d_math3d_average(
                         &cache->cached_ceiling[0].polynormal,
                         &cache->cached_ceiling[1].polynormal
                     )
                 );
-                cache->ceiling_flat_corner_normals[3] = (
+                cache->normals->ceiling_flat_corner_normals[3] = (
                     spew3d_math3d_average(
                         &cache->cached_ceiling[0].polynormal,
                         &cache->cached_ceiling[1].polynormal
                     )
                 );
                 cache->cached_ceiling_polycount = 2;
-            } else if (tile->segment[segment_no].ceiling_tex.id != 0) {
+            } else if (tile->segment[segment_no].texinfo->
+                    ceiling_tex.id != 0) {
                 cache->ceiling_split_from_front_left = 0;
                 memset(&cache->cached_ceiling[0], 0,
                     sizeof(cache->cached_ceiling[0]));
                 cache->cached_ceiling[0].texture =
-                    tile->segment[segment_no].ceiling_tex.id;
+                    tile->segment[segment_no].texinfo->ceiling_tex.id;
                 cache->cached_ceiling[0].material =
-                    tile->segment[segment_no].ceiling_tex.material;
+                    tile->segment[segment_no].texinfo->ceiling_tex.material;
                 cache->cached_ceiling[0].vertex[0] = front_left;
                 cache->cached_ceiling[0].vertex[1] = front_right;
                 cache->cached_ceiling[0].vertex[2] = back_left;
@@ -2115,7 +2346,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                     &cache->cached_ceiling[0].vertex[2],
                     1, &cache->cached_ceiling[0].polynormal
                 );
-                if (cache->cached_ceiling[0].polynormal.z < 0)
+                if (cache->cached_ceiling[0].polynormal.z > 0)
                     spew3d_math3d_flip(
                         &cache->cached_ceiling[0].polynormal
                     );
@@ -2123,9 +2354,9 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                 memset(&cache->cached_ceiling[1], 0,
                     sizeof(cache->cached_ceiling[1]));
                 cache->cached_ceiling[1].texture =
-                    tile->segment[segment_no].ceiling_tex.id;
+                    tile->segment[segment_no].texinfo->ceiling_tex.id;
                 cache->cached_ceiling[1].material =
-                    tile->segment[segment_no].ceiling_tex.material;
+                    tile->segment[segment_no].texinfo->ceiling_tex.material;
                 cache->cached_ceiling[1].vertex[0] = back_left;
                 cache->cached_ceiling[1].vertex[1] = front_right;
                 cache->cached_ceiling[1].vertex[2] = back_right;
@@ -2141,22 +2372,22 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                     &cache->cached_ceiling[1].vertex[2],
                     1, &cache->cached_ceiling[1].polynormal
                 );
-                if (cache->cached_ceiling[1].polynormal.z < 0)
+                if (cache->cached_ceiling[1].polynormal.z > 0)
                     spew3d_math3d_flip(
                         &cache->cached_ceiling[1].polynormal
                     );
 
-                cache->ceiling_flat_corner_normals[1] =
+                cache->normals->ceiling_flat_corner_normals[1] =
                     cache->cached_ceiling[1].polynormal;
-                cache->ceiling_flat_corner_normals[3] =
+                cache->normals->ceiling_flat_corner_normals[3] =
                     cache->cached_ceiling[0].polynormal;
-                cache->ceiling_flat_corner_normals[0] = (
+                cache->normals->ceiling_flat_corner_normals[0] = (
                     spew3d_math3d_average(
                         &cache->cached_ceiling[0].polynormal,
                         &cache->cached_ceiling[1].polynormal
                     )
                 );
-                cache->ceiling_flat_corner_normals[2] = (
+                cache->normals->ceiling_flat_corner_normals[2] = (
                     spew3d_math3d_average(
                         &cache->cached_ceiling[0].polynormal,
                         &cache->cached_ceiling[1].polynormal
@@ -2172,7 +2403,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
             while (j < 3) {
                 j++;
                 if (tile->segment[segment_no].
-                        wall[j].tex.id == 0)
+                        texinfo->wall[j].tex.id == 0)
                     continue;
 
                 int32_t shift_x = 0;
@@ -2389,10 +2620,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                                 sizeof(cache->cached_wall[n]));
                             cache->cached_wall[n].texture =
                                 tile->segment[segment_no].
-                                    wall[j].tex.id;
+                                    texinfo->wall[j].tex.id;
                             cache->cached_wall[n].material =
                                 tile->segment[segment_no].
-                                    wall[j].tex.material;
+                                    texinfo->wall[j].tex.material;
                             cache->cached_wall[n].vertex[0].x =
                                 intersect.x * corner_lower_right.x +
                                 (1 - intersect.x) * corner_lower_left.x;
@@ -2430,10 +2661,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                                 sizeof(cache->cached_wall[n]));
                             cache->cached_wall[n].texture =
                                 tile->segment[segment_no].
-                                    wall[j].tex.id;
+                                    texinfo->wall[j].tex.id;
                             cache->cached_wall[n].material =
                                 tile->segment[segment_no].
-                                    wall[j].tex.material;
+                                    texinfo->wall[j].tex.material;
                             cache->cached_wall[n].vertex[0] =
                                 corner_lower_left;
                             cache->cached_wall[n].vertex[1] =
@@ -2474,10 +2705,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                             sizeof(cache->cached_wall[n]));
                         cache->cached_wall[n].texture =
                             tile->segment[segment_no].
-                                wall[j].tex.id;
+                                texinfo->wall[j].tex.id;
                         cache->cached_wall[n].material =
                             tile->segment[segment_no].
-                                wall[j].tex.material;
+                                texinfo->wall[j].tex.material;
                         cache->cached_wall[n].vertex[0] =
                             corner_lower_left;
                         cache->cached_wall[n].vertex[1] =
@@ -2505,10 +2736,10 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                             sizeof(cache->cached_wall[n]));
                         cache->cached_wall[n].texture =
                             tile->segment[segment_no].
-                                wall[j].tex.id;
+                                texinfo->wall[j].tex.id;
                         cache->cached_wall[n].material =
                             tile->segment[segment_no].
-                                wall[j].tex.material;
+                                texinfo->wall[j].tex.material;
                         cache->cached_wall[n].vertex[0] =
                             corner_upper_right;
                         cache->cached_wall[n].vertex[1] =
@@ -2570,7 +2801,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                 break;
 
             final_neighbor_normals[corner] =
-                tile->segment[i].cache.floor_flat_corner_normals[0];
+                tile->segment[i].cache.normals->floor_flat_corner_normals[0];
             int corners_collected = 1;
 
             int32_t x = -2;
@@ -2655,7 +2886,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
             corner++;
         }
         memcpy(
-            &tile->segment[i].cache.floor_smooth_corner_normals,
+            &tile->segment[i].cache.normals->floor_smooth_corner_normals,
             &final_neighbor_normals,
             sizeof(s3d_pos) * 4
         );
@@ -2670,7 +2901,7 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
                 break;
 
             final_neighbor_normals[corner] =
-                tile->segment[i].cache.ceiling_flat_corner_normals[0];
+                tile->segment[i].cache.normals->ceiling_flat_corner_normals[0];
             int corners_collected = 1;
 
             int32_t x = -2;
@@ -2755,11 +2986,12 @@ S3DHID int _spew3d_lvlbox_TryUpdateTileCache_nolock_Ex(
             corner++;
         }
         memcpy(
-            &tile->segment[i].cache.ceiling_smooth_corner_normals,
+            &tile->segment[i].cache.normals->ceiling_smooth_corner_normals,
             &final_neighbor_normals,
             sizeof(s3d_pos) * 4
         );
 
+        _spew3d_lvlbox_ApplyAtlasToTileCache_nolock(&tile->segment[i]);
         tile->segment[i].cache.is_up_to_date = 1;
         i++;
     }
@@ -2880,11 +3112,12 @@ S3DHID int32_t _spew3d_lvlbox_TileVertPosToSegmentNo_nolock(
         if (pos_z <= ceiling_max_z ||
                 i >= tile->segment_count - 1) {
             if (pos_z < floor_min_z && i > 0) {
-                if (tile->segment[i].floor_tex.name == NULL &&
-                        tile->segment[i - 1].floor_tex.name != NULL)
+                if (tile->segment[i].texinfo->floor_tex.name_ref == 0 &&
+                        tile->segment[i - 1].texinfo->floor_tex.name_ref != 0)
                     return i - 1;
-                if (tile->segment[i].floor_tex.name != NULL &&
-                        tile->segment[i - 1].ceiling_tex.name == NULL)
+                if (tile->segment[i].texinfo->floor_tex.name_ref != 0 &&
+                        tile->segment[i - 1].texinfo->
+                            ceiling_tex.name_ref == 0)
                     return i - 1;
                 double floor_below_ceiling_max_z =
                     tile->segment[i - 1].ceiling_z[0];
@@ -3062,9 +3295,7 @@ S3DHID int _spew3d_lvlbox_ShiftChunks_nolock(
             );
             if (x + shift_x < 0 || x + shift_x >= chunk_size_x ||
                     y + shift_y < 0 || y + shift_y >= chunk_size_y) {
-                _spew3d_lvlbox_FreeChunkContents(
-                    &lvlbox->chunk[chunk_offset_old]
-                );
+                // Shifted out, this is freed further below.
                 y++;
                 continue;
             }
@@ -3072,9 +3303,6 @@ S3DHID int _spew3d_lvlbox_ShiftChunks_nolock(
                 (chunk_size_x * (y + shift_y)) +
                 (x + shift_x)
             );
-            _spew3d_lvlbox_FreeChunkContents(
-                &lvlbox->chunk[chunk_offset_new]
-            );
             memcpy(&new_chunk[chunk_offset_new],
                 &lvlbox->chunk[chunk_offset_old],
                 sizeof(*lvlbox->chunk));
@@ -3103,6 +3331,7 @@ S3DHID int _spew3d_lvlbox_ShiftChunks_nolock(
     }
     free(lvlbox->chunk);
     lvlbox->chunk = new_chunk;
+    _spew3d_lvlbox_MarkAllChunksEdited_nolock(lvlbox);
     return 1;
 }
 
@@ -3160,6 +3389,7 @@ S3DHID int _spew3d_lvlbox_ResizeChunksY_nolock(
     free(lvlbox->chunk);
     lvlbox->chunk = new_chunk;
     lvlbox->chunk_count = old_chunk_extent_x * chunk_y;
+    _spew3d_lvlbox_MarkAllChunksEdited_nolock(lvlbox);
     return 1;
 }
 
@@ -3217,6 +3447,7 @@ S3DHID int _spew3d_lvlbox_ResizeChunksX_nolock(
     lvlbox->chunk = new_chunk;
     lvlbox->chunk_extent_x = chunk_x;
     lvlbox->chunk_count = chunk_x * old_chunk_extent_y;
+    _spew3d_lvlbox_MarkAllChunksEdited_nolock(lvlbox);
     return 1;
 }
 
@@ -3308,6 +3539,14 @@ S3DHID int _spew3d_lvlbox_ExpandToPosition_nolock(
     return 1;
 }
 
+S3DHID static char *_spew3d_lvlbox_JournalPath(
+    const char *map_file_path
+);
+S3DHID static int _spew3d_lvlbox_ReplayJournal_nolock(
+    s3d_lvlbox *lvlbox, const char *s, uint32_t slen,
+    int *out_clean
+);
+
 struct lvlbox_load_settings {
     int new_if_missing;
     char *new_default_tex;
@@ -3348,10 +3587,65 @@ S3DHID void *_spew3d_lvlbox_DoMapLoad(
     s3d_lvlbox *lvlbox = spew3d_lvlbox_FromString(
         result, result_len
     );
-    if (!result) {
+    free(result);
+    result = NULL;
+    if (!lvlbox) {
         free(settings);
         return NULL;
     }
+    s3d_lvlbox_internal *internal = _lvlbox_Internal(lvlbox);
+    internal->journal_base_bytes = result_len;
+
+    // Apply the committed entries of an incremental save journal,
+    // if there is one for this exact base file:
+    char *journal_path = _spew3d_lvlbox_JournalPath(map_file_path);
+    int _exists = 0;
+    if (journal_path != NULL && internal->journal_save_id != 0 &&
+            spew3d_vfs_Exists(
+            journal_path, map_file_vfs_flags, &_exists, NULL
+            ) && _exists) {
+        // Compaction keeps a journal below the size of the map, so
+        // a larger one or a read error must not just be skipped, or
+        // we'd silently return the map without its recent edits:
+        if (!spew3d_vfs_FileToBytesWithLimit(
+                journal_path, map_file_vfs_flags,
+                20 * 1024 * 1024,
+                NULL, &result, &result_len
+                )) {
+            #if defined(DEBUG_SPEW3D_LVLBOX)
+            fprintf(stderr, "spew3d_lvlbox.c: debug: "
+                "_spew3d_lvlbox_DoMapLoad: Failed to read "
+                "journal \"%s\".\n", journal_path);
+            #endif
+            free(journal_path);
+            spew3d_lvlbox_Destroy(lvlbox);
+            free(settings);
+            return NULL;
+        }
+        int clean = 0;
+        if (_spew3d_lvlbox_ReplayJournal_nolock(
+                lvlbox, result, result_len, &clean
+                )) {
+            // If replay stopped early, anything appended after the
+            // damage would be lost, so do a full save next time:
+            internal->journal_bytes = (
+                clean ? result_len : internal->journal_base_bytes
+            );
+        }
+        // Otherwise the journal belongs to another save_id, and the
+        // next incremental save starts it over.
+        free(result);
+    }
+    if (journal_path != NULL && internal->journal_save_id != 0) {
+        internal->journal_base_path = strdup(map_file_path);
+        internal->journal_base_vfsflags = map_file_vfs_flags;
+        internal->journal_saved_generation = (
+            internal->edit_generation
+        );
+        internal->journal_chunk_extent_x = lvlbox->chunk_extent_x;
+        internal->journal_chunk_count = lvlbox->chunk_count;
+    }
+    free(journal_path);
 
     // We reached the end, clean up:
     free(settings);
@@ -3409,48 +3703,391 @@ S3DEXP s3d_lvlbox *spew3d_lvlbox_FromMapFileFinalize(
 
 struct lvlbox_save_settings {
     s3d_lvlbox *lvlbox;
+    int incremental;
 };
 
-S3DHID void *_spew3d_lvlbox_DoMapSave(
-        const char *map_file_path, int map_file_vfs_flags,
-        void *extra
-        ) {
-    assert(extra != NULL);
-    struct lvlbox_save_settings *settings = extra;
-
-    uint32_t out_bytes = 0;
-    char *serialized = spew3d_lvlbox_ToString(
-        settings->lvlbox, &out_bytes
-    );
-    if (!serialized || out_bytes <= 0) {
-        free(settings);
-        return NULL;
-    }
+struct lvlbox_strbuf {
+    char *s;
+    uint32_t len, alloc;
+};
 
-    SPEW3DVFS_FILE *f = spew3d_vfs_fopen(
-        map_file_path, "wb", map_file_vfs_flags
-    );
-    if (!f) {
-        free(settings);
-        return NULL;
-    }
-    size_t written = spew3d_vfs_fwrite(
-        serialized, 1, out_bytes, f
-    );
-    spew3d_vfs_fclose(f);
-    if (written < out_bytes) {
-        free(settings);
-        return NULL;
+S3DHID static int _lvlbox_ToStr_AppendBytes(
+        struct lvlbox_strbuf *buf, const char *bytes, uint32_t len
+        ) {
+    if (buf->len + len + 1 > buf->alloc) {
+        uint32_t new_alloc = (buf->len + len + 1) * 2;
+        if (new_alloc < 1024)
+            new_alloc = 1024;
+        char *new_s = realloc(buf->s, new_alloc);
+        if (!new_s)
+            return 0;
+        buf->s = new_s;
+        buf->alloc = new_alloc;
     }
+    memcpy(buf->s + buf->len, bytes, len);
+    buf->len += len;
+    buf->s[buf->len] = '\0';
+    return 1;
+}
 
-    // We reached the end, clean up and return success:
-    free(settings);
-    return (void*)1;
+S3DHID static int _lvlbox_ToStr_Append(
+        struct lvlbox_strbuf *buf, const char *fmt, ...
+        ) {
+    char tmp[256];
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    if (written < 0 || written >= (int)sizeof(tmp))
+        return 0;
+    return _lvlbox_ToStr_AppendBytes(buf, tmp, written);
 }
 
-S3DEXP s3d_resourceload_job *spew3d_lvlbox_ToMapFile(
-        s3d_lvlbox *lvlbox,
-        const char *map_file_path, int map_file_vfs_flags
+S3DHID static int _lvlbox_ToStr_TexInfo(
+        struct lvlbox_strbuf *buf, s3d_lvlbox_texinfo *tex
+        ) {
+    if (tex->name_ref == 0)
+        return _lvlbox_ToStr_Append(buf, " none");
+    const char *name = spew3d_lvlbox_TexNameToStr(tex->name_ref);
+    if (!_lvlbox_ToStr_Append(buf, " tex %d ",
+            (int)strlen(name)))
+        return 0;
+    if (!_lvlbox_ToStr_AppendBytes(buf, name, strlen(name)))
+        return 0;
+    return _lvlbox_ToStr_Append(buf, " %d %d %d %d %.17g %.17g",
+        spew3d_lvlbox_TexNameToVFSFlags(tex->name_ref),
+        (int)tex->material, tex->wrapmode,
+        tex->overfit_multiplier, (double)tex->scroll_speed_x,
+        (double)tex->scroll_speed_y);
+}
+
+S3DHID static int _lvlbox_ToStr_FenceInfo(
+        struct lvlbox_strbuf *buf, s3d_lvlbox_fenceinfo *fence
+        ) {
+    if (!_lvlbox_ToStr_Append(buf, " fence %d %d %d %d %.17g",
+            fence->is_set, fence->has_alpha, fence->is_passable,
+            fence->truncate_set, (double)fence->truncate_height_z))
+        return 0;
+    return _lvlbox_ToStr_TexInfo(buf, &fence->tex);
+}
+
+S3DHID static int _spew3d_lvlbox_ChunkToStr_nolock(
+        s3d_lvlbox *lvlbox, uint32_t chunk_index,
+        struct lvlbox_strbuf *buf
+        ) {
+    assert(chunk_index < lvlbox->chunk_count);
+    s3d_lvlbox_chunk *chunk = &lvlbox->chunk[chunk_index];
+    if (!_lvlbox_ToStr_Append(buf, "chunk %u\n",
+            (unsigned int)chunk_index))
+        return 0;
+    uint32_t i = 0;
+    while (i < (uint32_t)(LVLBOX_CHUNK_SIZE * LVLBOX_CHUNK_SIZE)) {
+        s3d_lvlbox_tile *tile = &chunk->tile[i];
+        if (!tile->occupied) {
+            i++;
+            continue;
+        }
+        if (!_lvlbox_ToStr_Append(buf, "tile %u %d\n",
+                (unsigned int)i, (int)tile->segment_count))
+            return 0;
+        int k = 0;
+        while (k < tile->segment_count) {
+            s3d_lvlbox_vertsegment *seg = &tile->segment[k];
+            if (!_lvlbox_ToStr_Append(buf,
+                    "floor %.17g %.17g %.17g %.17g",
+                    (double)seg->floor_z[0], (double)seg->floor_z[1],
+                    (double)seg->floor_z[2], (double)seg->floor_z[3]) ||
+                    !_lvlbox_ToStr_TexInfo(buf, &seg->texinfo->floor_tex) ||
+                    !_lvlbox_ToStr_Append(buf,
+                    "\nceiling %.17g %.17g %.17g %.17g",
+                    (double)seg->ceiling_z[0],
+                    (double)seg->ceiling_z[1],
+                    (double)seg->ceiling_z[2],
+                    (double)seg->ceiling_z[3]) ||
+                    !_lvlbox_ToStr_TexInfo(buf, &seg->texinfo->ceiling_tex) ||
+                    !_lvlbox_ToStr_Append(buf, "\n"))
+                return 0;
+            int w = 0;
+            while (w < 4) {
+                if (!_lvlbox_ToStr_Append(buf, "wall") ||
+                        !_lvlbox_ToStr_TexInfo(buf,
+                            &seg->texinfo->wall[w].tex) ||
+                        !_lvlbox_ToStr_TexInfo(buf,
+                            &seg->texinfo->wall[w].toptex) ||
+                        !_lvlbox_ToStr_FenceInfo(buf,
+                            &seg->texinfo->wall[w].fence) ||
+                        !_lvlbox_ToStr_Append(buf, "\n"))
+                    return 0;
+                w++;
+            }
+            if (!_lvlbox_ToStr_Append(buf, "hori_fences %d\n",
+                    (int)seg->hori_fence_count))
+                return 0;
+            int f = 0;
+            while (f < seg->hori_fence_count) {
+                if (!_lvlbox_ToStr_Append(buf, "hori_fence %.17g",
+                        (double)seg->hori_fence_z[f]) ||
+                        !_lvlbox_ToStr_FenceInfo(buf,
+                            &seg->hori_fence[f]) ||
+                        !_lvlbox_ToStr_Append(buf, "\n"))
+                    return 0;
+                f++;
+            }
+            k++;
+        }
+        i++;
+    }
+    return _lvlbox_ToStr_Append(buf, "endchunk\n");
+}
+
+S3DHID static int _spew3d_lvlbox_ChunkIsEmpty_nolock(
+        s3d_lvlbox *lvlbox, uint32_t chunk_index
+        ) {
+    uint32_t i = 0;
+    while (i < (uint32_t)(LVLBOX_CHUNK_SIZE * LVLBOX_CHUNK_SIZE)) {
+        if (lvlbox->chunk[chunk_index].tile[i].occupied)
+            return 0;
+        i++;
+    }
+    return 1;
+}
+
+S3DHID static char *_spew3d_lvlbox_ToString_nolock(
+        s3d_lvlbox *lvlbox, int64_t save_id, uint32_t *out_slen
+        ) {
+    struct lvlbox_strbuf buf = {0};
+    if (!_lvlbox_ToStr_Append(&buf, "S3DLVLBOX V1\n"
+            "save_id %" PRId64 "\n"
+            "offset %.17g %.17g %.17g\n"
+            "extent %u %u\n",
+            save_id, (double)lvlbox->offset.x,
+            (double)lvlbox->offset.y, (double)lvlbox->offset.z,
+            (unsigned int)lvlbox->chunk_extent_x,
+            (unsigned int)lvlbox->chunk_count)) {
+        free(buf.s);
+        return NULL;
+    }
+    uint32_t i = 0;
+    while (i < lvlbox->chunk_count) {
+        if (_spew3d_lvlbox_ChunkIsEmpty_nolock(lvlbox, i)) {
+            i++;
+            continue;
+        }
+        if (!_spew3d_lvlbox_ChunkToStr_nolock(lvlbox, i, &buf)) {
+            free(buf.s);
+            return NULL;
+        }
+        i++;
+    }
+    if (!_lvlbox_ToStr_Append(&buf, "end\n")) {
+        free(buf.s);
+        return NULL;
+    }
+    *out_slen = buf.len;
+    return buf.s;
+}
+
+S3DHID static char *_spew3d_lvlbox_JournalPath(
+        const char *map_file_path
+        ) {
+    char *journal_path = malloc(strlen(map_file_path) +
+        strlen(".journal") + 1);
+    if (!journal_path)
+        return NULL;
+    memcpy(journal_path, map_file_path, strlen(map_file_path));
+    memcpy(journal_path + strlen(map_file_path), ".journal",
+        strlen(".journal") + 1);
+    return journal_path;
+}
+
+S3DHID static int _spew3d_lvlbox_WriteBytesToFile(
+        const char *path, int vfsflags, const char *mode,
+        const char *bytes, uint32_t len
+        ) {
+    SPEW3DVFS_FILE *f = spew3d_vfs_fopen(
+        path, mode, vfsflags
+    );
+    if (!f)
+        return 0;
+    size_t written = spew3d_vfs_fwrite(
+        bytes, 1, len, f
+    );
+    spew3d_vfs_fclose(f);
+    return (written >= len);
+}
+
+S3DHID static int _spew3d_lvlbox_DoFullSave(
+        s3d_lvlbox *lvlbox,
+        const char *map_file_path, int map_file_vfs_flags
+        ) {
+    int64_t save_id = spew3d_secrandom_RandIntRange(1, INT64_MAX);
+    char *journal_path = _spew3d_lvlbox_JournalPath(map_file_path);
+    char *base_path = strdup(map_file_path);
+    if (!journal_path || !base_path) {
+        free(journal_path);
+        free(base_path);
+        return 0;
+    }
+
+    // Hold the lock until the old journal is gone, since otherwise
+    // an incremental save could append to it in the meantime and
+    // then have its entry deleted along with it:
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint32_t out_bytes = 0;
+    char *serialized = _spew3d_lvlbox_ToString_nolock(
+        lvlbox, save_id, &out_bytes
+    );
+    if (!serialized || !_spew3d_lvlbox_WriteBytesToFile(
+            map_file_path, map_file_vfs_flags, "wb",
+            serialized, out_bytes
+            )) {
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        free(journal_path);
+        free(base_path);
+        free(serialized);
+        return 0;
+    }
+    free(serialized);
+
+    // The old journal belongs to an older save_id and would be
+    // ignored on load anyway, but don't leave it lying around:
+    if ((map_file_vfs_flags & VFSFLAG_NO_REALDISK_ACCESS) == 0) {
+        int _exists = 0;
+        if (spew3d_fs_TargetExists(journal_path, &_exists) &&
+                _exists) {
+            int _err = 0;
+            spew3d_fs_RemoveFile(journal_path, &_err);
+        }
+    }
+    free(journal_path);
+
+    s3d_lvlbox_internal *internal = _lvlbox_Internal(lvlbox);
+    free(internal->journal_base_path);
+    internal->journal_base_path = base_path;
+    internal->journal_base_vfsflags = map_file_vfs_flags;
+    internal->journal_save_id = save_id;
+    internal->journal_saved_generation = internal->edit_generation;
+    internal->journal_chunk_extent_x = lvlbox->chunk_extent_x;
+    internal->journal_chunk_count = lvlbox->chunk_count;
+    internal->journal_base_bytes = out_bytes;
+    internal->journal_bytes = 0;
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return 1;
+}
+
+S3DHID static int _spew3d_lvlbox_DoJournalSave(
+        s3d_lvlbox *lvlbox,
+        const char *map_file_path, int map_file_vfs_flags
+        ) {
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    s3d_lvlbox_internal *internal = _lvlbox_Internal(lvlbox);
+    int need_full_save = (
+        internal->journal_base_path == NULL ||
+        strcmp(internal->journal_base_path, map_file_path) != 0 ||
+        internal->journal_base_vfsflags != map_file_vfs_flags ||
+        internal->journal_chunk_extent_x != lvlbox->chunk_extent_x ||
+        internal->journal_chunk_count != lvlbox->chunk_count ||
+        internal->journal_bytes >= internal->journal_base_bytes
+    );
+    if (need_full_save) {
+        // Either there is nothing to append to, or the journal
+        // got as big as the map itself, so compact it:
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        return _spew3d_lvlbox_DoFullSave(
+            lvlbox, map_file_path, map_file_vfs_flags
+        );
+    }
+    uint64_t generation = internal->edit_generation;
+    if (generation == internal->journal_saved_generation) {
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        return 1;  // Nothing changed.
+    }
+    struct lvlbox_strbuf buf = {0};
+    if (internal->journal_bytes == 0 &&
+            !_lvlbox_ToStr_Append(&buf,
+                "S3DLVLBOXJOURNAL V1\nsave_id %" PRId64 "\n",
+                internal->journal_save_id)) {
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        free(buf.s);
+        return 0;
+    }
+    if (!_lvlbox_ToStr_Append(&buf, "entry %u %u\n",
+            (unsigned int)lvlbox->chunk_extent_x,
+            (unsigned int)lvlbox->chunk_count)) {
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        free(buf.s);
+        return 0;
+    }
+    uint32_t i = 0;
+    while (i < lvlbox->chunk_count) {
+        if (lvlbox->chunk[i].edit_generation >
+                internal->journal_saved_generation &&
+                !_spew3d_lvlbox_ChunkToStr_nolock(lvlbox, i, &buf)) {
+            mutex_Release(_lvlbox_Internal(lvlbox)->m);
+            free(buf.s);
+            return 0;
+        }
+        i++;
+    }
+    if (!_lvlbox_ToStr_Append(&buf, "commit\n")) {
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        free(buf.s);
+        return 0;
+    }
+
+    // Write while still holding the lock, so that concurrent saves
+    // can't interleave their entries. A fresh journal replaces any
+    // left over from an older save_id instead of appending to it:
+    char *journal_path = _spew3d_lvlbox_JournalPath(map_file_path);
+    if (!journal_path || !_spew3d_lvlbox_WriteBytesToFile(
+            journal_path, map_file_vfs_flags,
+            (internal->journal_bytes == 0 ? "wb" : "ab"),
+            buf.s, buf.len
+            )) {
+        // The journal may now end in a torn entry, and replay would
+        // stop there and ignore anything appended after it. Make the
+        // next save a full one, which starts the journal over:
+        internal->journal_bytes = internal->journal_base_bytes;
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        free(journal_path);
+        free(buf.s);
+        return 0;
+    }
+    free(journal_path);
+    free(buf.s);
+    if (internal->journal_saved_generation < generation)
+        internal->journal_saved_generation = generation;
+    internal->journal_bytes += buf.len;
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return 1;
+}
+
+S3DHID void *_spew3d_lvlbox_DoMapSave(
+        const char *map_file_path, int map_file_vfs_flags,
+        void *extra
+        ) {
+    assert(extra != NULL);
+    struct lvlbox_save_settings *settings = extra;
+
+    int result;
+    if (settings->incremental)
+        result = _spew3d_lvlbox_DoJournalSave(
+            settings->lvlbox, map_file_path, map_file_vfs_flags
+        );
+    else
+        result = _spew3d_lvlbox_DoFullSave(
+            settings->lvlbox, map_file_path, map_file_vfs_flags
+        );
+
+    // We reached the end, clean up and return:
+    free(settings);
+    return (result ? (void*)1 : NULL);
+}
+
+S3DHID static s3d_resourceload_job *_spew3d_lvlbox_ToMapFileEx(
+        s3d_lvlbox *lvlbox,
+        const char *map_file_path, int map_file_vfs_flags,
+        int incremental
         ) {
     struct lvlbox_save_settings *settings = (
         malloc(sizeof(*settings))
@@ -3459,91 +4096,435 @@ S3DEXP s3d_resourceload_job *spew3d_lvlbox_ToMapFile(
         return NULL;
     memset(settings, 0, sizeof(*settings));
     settings->lvlbox = lvlbox;
+    settings->incremental = incremental;
 
     s3d_resourceload_job *job = s3d_resourceload_NewJobWithCallback(
         map_file_path, RLTYPE_LVLBOX_STORE, map_file_vfs_flags,
         _spew3d_lvlbox_DoMapSave, settings
     );
+    if (!job)
+        free(settings);
     return job;
 }
 
-S3DHID static int _lvlbox_FromStr_CheckStr(const char **s,
-        uint32_t *slen,
-        s3d_lvlbox **lvlbox, const char *value) {
+S3DEXP s3d_resourceload_job *spew3d_lvlbox_ToMapFile(
+        s3d_lvlbox *lvlbox,
+        const char *map_file_path, int map_file_vfs_flags
+        ) {
+    return _spew3d_lvlbox_ToMapFileEx(
+        lvlbox, map_file_path, map_file_vfs_flags, 0
+    );
+}
+
+S3DEXP s3d_resourceload_job *spew3d_lvlbox_ToMapFileIncremental(
+        s3d_lvlbox *lvlbox,
+        const char *map_file_path, int map_file_vfs_flags
+        ) {
+    return _spew3d_lvlbox_ToMapFileEx(
+        lvlbox, map_file_path, map_file_vfs_flags, 1
+    );
+}
+
+S3DHID static void _lvlbox_FromStr_SkipSpace(
+        const char **s, uint32_t *slen
+        ) {
+    while (*slen > 0 && (**s == ' ' ||
+            **s == '\t' || **s == '\n' || **s == '\r')) {
+        (*s)++;
+        (*slen)--;
+    }
+}
+
+S3DHID static int _lvlbox_FromStr_CheckStr(
+        const char **s, uint32_t *slen, const char *value
+        ) {
+    _lvlbox_FromStr_SkipSpace(s, slen);
     uint32_t vlen = strlen(value);
-    if (*slen < vlen || memcmp(s, value, vlen) != 0)
+    if (*slen < vlen || memcmp(*s, value, vlen) != 0)
         return 0;
-    *slen += vlen;
+    if (*slen > vlen && (*s)[vlen] != ' ' && (*s)[vlen] != '\t' &&
+            (*s)[vlen] != '\n' && (*s)[vlen] != '\r')
+        return 0;  // This is just a prefix of a longer word.
+    *s += vlen;
+    *slen -= vlen;
     return 1;
 }
 
-S3DHID static int _lvlbox_FromStr_CheckSpace(
+S3DHID static int _lvlbox_FromStr_ReadNumber(
+        const char **s, uint32_t *slen, double *out_value
+        ) {
+    _lvlbox_FromStr_SkipSpace(s, slen);
+    char numbuf[64];
+    uint32_t numlen = 0;
+    while (numlen < *slen && (*s)[numlen] != ' ' &&
+            (*s)[numlen] != '\t' && (*s)[numlen] != '\n' &&
+            (*s)[numlen] != '\r') {
+        if (numlen + 1 >= sizeof(numbuf))
+            return 0;
+        numbuf[numlen] = (*s)[numlen];
+        numlen++;
+    }
+    if (numlen == 0)
+        return 0;
+    numbuf[numlen] = '\0';
+    char *numend = NULL;
+    double value = strtod(numbuf, &numend);
+    if (numend != numbuf + numlen || !isfinite(value))
+        return 0;
+    *s += numlen;
+    *slen -= numlen;
+    *out_value = value;
+    return 1;
+}
+
+S3DHID static int _lvlbox_FromStr_ReadInt(
         const char **s, uint32_t *slen,
-        s3d_lvlbox **lvlbox, int optional) {
-    if (*slen <= 0) {
-        if (optional)
-            return 1;
+        int64_t min_value, int64_t max_value, int64_t *out_value
+        ) {
+    double value = 0;
+    if (!_lvlbox_FromStr_ReadNumber(s, slen, &value))
         return 0;
-    }
-    const char *new_s = *s;
-    uint32_t new_slen = *slen;
-    uint32_t spaces = 0;
-    while (*slen > 0 && (**s == ' ' ||
-            **s == '\t' || **s == '\n')) {
-        spaces++;
-        new_slen--;
-        new_s++;
-    }
-    if (optional || spaces > 0) {
-        *s = new_s;
-        *slen = new_slen;
+    if (value != floor(value) || value < (double)min_value ||
+            value > (double)max_value)
+        return 0;
+    *out_value = (int64_t)value;
+    return 1;
+}
+
+S3DHID static int _lvlbox_FromStr_TexInfo(
+        const char **s, uint32_t *slen, s3d_lvlbox_texinfo *tex
+        ) {
+    memset(tex, 0, sizeof(*tex));
+    if (_lvlbox_FromStr_CheckStr(s, slen, "none"))
         return 1;
+    int64_t namelen = 0;
+    if (!_lvlbox_FromStr_CheckStr(s, slen, "tex") ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 1, 4096, &namelen))
+        return 0;
+    // The name follows after exactly one space, and may itself
+    // contain spaces:
+    if (*slen < (uint32_t)namelen + 1 || **s != ' ')
+        return 0;
+    char *name = malloc(namelen + 1);
+    if (!name)
+        return 0;
+    memcpy(name, *s + 1, namelen);
+    name[namelen] = '\0';
+    *s += namelen + 1;
+    *slen -= namelen + 1;
+    int64_t vfs_flags, material, wrapmode, overfit;
+    double scroll_x, scroll_y;
+    if (!_lvlbox_FromStr_ReadInt(s, slen, 0, INT32_MAX, &vfs_flags) ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, UINT32_MAX,
+                &material) ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, INT32_MAX,
+                &wrapmode) ||
+            !_lvlbox_FromStr_ReadInt(s, slen, INT32_MIN, INT32_MAX,
+                &overfit) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &scroll_x) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &scroll_y) ||
+            !_spew3d_lvlbox_SetTexInfoName(tex, name, vfs_flags)) {
+        free(name);
+        return 0;
     }
-    return 0;
+    tex->material = material;
+    tex->wrapmode = wrapmode;
+    tex->overfit_multiplier = overfit;
+    tex->scroll_speed_x = scroll_x;
+    tex->scroll_speed_y = scroll_y;
+    tex->id = spew3d_texture_FromFile(name, vfs_flags);
+    free(name);
+    return 1;
 }
 
-#define CHECK_STR(x) \
-    if (!_lvlbox_FromStr_CheckStr(&s, &slen, &lvlbox, x)) {\
-        _spew3d_lvlbox_ActuallyDestroy(lvlbox);\
-        return NULL;\
+S3DHID static int _lvlbox_FromStr_FenceInfo(
+        const char **s, uint32_t *slen, s3d_lvlbox_fenceinfo *fence
+        ) {
+    memset(fence, 0, sizeof(*fence));
+    int64_t is_set, has_alpha, is_passable, truncate_set;
+    double truncate_height_z;
+    if (!_lvlbox_FromStr_CheckStr(s, slen, "fence") ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, 1, &is_set) ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, 1, &has_alpha) ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, 1, &is_passable) ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, 1, &truncate_set) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &truncate_height_z))
+        return 0;
+    fence->is_set = is_set;
+    fence->has_alpha = has_alpha;
+    fence->is_passable = is_passable;
+    fence->truncate_set = truncate_set;
+    fence->truncate_height_z = truncate_height_z;
+    return _lvlbox_FromStr_TexInfo(s, slen, &fence->tex);
+}
+
+S3DHID static int _lvlbox_FromStr_Segment(
+        const char **s, uint32_t *slen, s3d_lvlbox_vertsegment *seg
+        ) {
+    if (!_spew3d_lvlbox_AllocSegmentTex(seg))
+        return 0;
+    double z[4];
+    if (!_lvlbox_FromStr_CheckStr(s, slen, "floor") ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[0]) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[1]) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[2]) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[3]) ||
+            !_lvlbox_FromStr_TexInfo(s, slen, &seg->texinfo->floor_tex))
+        return 0;
+    int k = 0;
+    while (k < 4) {
+        seg->floor_z[k] = z[k];
+        k++;
+    }
+    if (!_lvlbox_FromStr_CheckStr(s, slen, "ceiling") ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[0]) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[1]) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[2]) ||
+            !_lvlbox_FromStr_ReadNumber(s, slen, &z[3]) ||
+            !_lvlbox_FromStr_TexInfo(s, slen, &seg->texinfo->ceiling_tex))
+        return 0;
+    k = 0;
+    while (k < 4) {
+        seg->ceiling_z[k] = z[k];
+        k++;
     }
-#define CHECK_SPACE(optional) \
-    if (!_lvlbox_FromStr_CheckSpace(&s, &slen, &lvlbox, optional != 0)) {\
-        _spew3d_lvlbox_ActuallyDestroy(lvlbox);\
-        return NULL;\
+    int w = 0;
+    while (w < 4) {
+        if (!_lvlbox_FromStr_CheckStr(s, slen, "wall") ||
+                !_lvlbox_FromStr_TexInfo(s, slen,
+                    &seg->texinfo->wall[w].tex) ||
+                !_lvlbox_FromStr_TexInfo(s, slen,
+                    &seg->texinfo->wall[w].toptex) ||
+                !_lvlbox_FromStr_FenceInfo(s, slen,
+                    &seg->texinfo->wall[w].fence))
+            return 0;
+        w++;
+    }
+    int64_t hori_fence_count = 0;
+    if (!_lvlbox_FromStr_CheckStr(s, slen, "hori_fences") ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, INT16_MAX,
+                &hori_fence_count))
+        return 0;
+    if (hori_fence_count > 0) {
+        seg->hori_fence = malloc(
+            sizeof(*seg->hori_fence) * hori_fence_count
+        );
+        seg->hori_fence_z = malloc(
+            sizeof(*seg->hori_fence_z) * hori_fence_count
+        );
+        if (!seg->hori_fence || !seg->hori_fence_z)
+            return 0;
+        memset(seg->hori_fence, 0,
+            sizeof(*seg->hori_fence) * hori_fence_count);
     }
-/*#define CHECK_INT(v) \
-    if (!_lvlbox_FromStr_CheckNumber(&s, &slen, &lvlbox, v, 1)) {\
-        _spew3d_lvlbox_ActuallyDestroy(lvlbox);\
-        return NULL;\
-    }*/
+    while (seg->hori_fence_count < hori_fence_count) {
+        double fence_z = 0;
+        if (!_lvlbox_FromStr_CheckStr(s, slen, "hori_fence") ||
+                !_lvlbox_FromStr_ReadNumber(s, slen, &fence_z))
+            return 0;
+        seg->hori_fence_z[seg->hori_fence_count] = fence_z;
+        if (!_lvlbox_FromStr_FenceInfo(s, slen,
+                &seg->hori_fence[seg->hori_fence_count]))
+            return 0;
+        seg->hori_fence_count++;
+    }
+    return 1;
+}
+
+S3DHID static int _lvlbox_FromStr_Chunk(
+        const char **s, uint32_t *slen, uint32_t chunk_count,
+        uint32_t *out_chunk_index, s3d_lvlbox_chunk *out_chunk
+        ) {
+    memset(out_chunk, 0, sizeof(*out_chunk));
+    int64_t chunk_index = 0;
+    if (!_lvlbox_FromStr_CheckStr(s, slen, "chunk") ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0,
+                (int64_t)chunk_count - 1, &chunk_index))
+        return 0;
+    *out_chunk_index = chunk_index;
+    while (!_lvlbox_FromStr_CheckStr(s, slen, "endchunk")) {
+        int64_t tile_index = 0;
+        int64_t segment_count = 0;
+        if (!_lvlbox_FromStr_CheckStr(s, slen, "tile") ||
+                !_lvlbox_FromStr_ReadInt(s, slen, 0,
+                    LVLBOX_CHUNK_SIZE * LVLBOX_CHUNK_SIZE - 1,
+                    &tile_index) ||
+                !_lvlbox_FromStr_ReadInt(s, slen, 1, INT16_MAX,
+                    &segment_count))
+            return 0;
+        s3d_lvlbox_tile *tile = &out_chunk->tile[tile_index];
+        if (tile->occupied)
+            return 0;
+        tile->segment = malloc(sizeof(*tile->segment) * segment_count);
+        if (!tile->segment)
+            return 0;
+        memset(tile->segment, 0,
+            sizeof(*tile->segment) * segment_count);
+        tile->occupied = 1;
+        while (tile->segment_count < segment_count) {
+            // Count it first, so it is freed properly on error:
+            tile->segment_count++;
+            if (!_lvlbox_FromStr_Segment(s, slen,
+                    &tile->segment[tile->segment_count - 1]))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+S3DHID static int _spew3d_lvlbox_FromStr_Header(
+        const char **s, uint32_t *slen, const char *magic,
+        int64_t *out_save_id
+        ) {
+    if (!_lvlbox_FromStr_CheckStr(s, slen, magic) ||
+            !_lvlbox_FromStr_CheckStr(s, slen, "V1") ||
+            !_lvlbox_FromStr_CheckStr(s, slen, "save_id") ||
+            !_lvlbox_FromStr_ReadInt(s, slen, 0, INT64_MAX,
+                out_save_id))
+        return 0;
+    return 1;
+}
 
 S3DEXP s3d_lvlbox *spew3d_lvlbox_FromString(
         const char *s, uint32_t slen
         ) {
+    int64_t save_id = 0;
+    double offset_x, offset_y, offset_z;
+    int64_t extent_x, chunk_count;
+    if (!_spew3d_lvlbox_FromStr_Header(&s, &slen, "S3DLVLBOX",
+                &save_id) ||
+            !_lvlbox_FromStr_CheckStr(&s, &slen, "offset") ||
+            !_lvlbox_FromStr_ReadNumber(&s, &slen, &offset_x) ||
+            !_lvlbox_FromStr_ReadNumber(&s, &slen, &offset_y) ||
+            !_lvlbox_FromStr_ReadNumber(&s, &slen, &offset_z) ||
+            !_lvlbox_FromStr_CheckStr(&s, &slen, "extent") ||
+            !_lvlbox_FromStr_ReadInt(&s, &slen, 1, 65536,
+                &extent_x) ||
+            !_lvlbox_FromStr_ReadInt(&s, &slen, 1, 65536 * 65536LL,
+                &chunk_count) ||
+            chunk_count % extent_x != 0)
+        return NULL;
+
     s3d_lvlbox *lvlbox = spew3d_lvlbox_New(NULL, 0);
     if (!lvlbox)
         return NULL;
-
-    const char *s_start = s;
-
-    CHECK_STR("S3DLVLBOX");
-    CHECK_SPACE(0);
-    CHECK_STR("V");
-
+    s3d_lvlbox_chunk *new_chunk = malloc(
+        sizeof(*new_chunk) * chunk_count
+    );
+    if (!new_chunk) {
+        _spew3d_lvlbox_ActuallyDestroy(lvlbox);
+        return NULL;
+    }
+    memset(new_chunk, 0, sizeof(*new_chunk) * chunk_count);
+    _spew3d_lvlbox_FreeChunkContents(&lvlbox->chunk[0]);
+    free(lvlbox->chunk);
+    lvlbox->chunk = new_chunk;
+    lvlbox->chunk_count = chunk_count;
+    lvlbox->chunk_extent_x = extent_x;
+    lvlbox->offset.x = offset_x;
+    lvlbox->offset.y = offset_y;
+    lvlbox->offset.z = offset_z;
+
+    while (!_lvlbox_FromStr_CheckStr(&s, &slen, "end")) {
+        uint32_t chunk_index = 0;
+        s3d_lvlbox_chunk parsed_chunk;
+        if (!_lvlbox_FromStr_Chunk(&s, &slen, lvlbox->chunk_count,
+                &chunk_index, &parsed_chunk)) {
+            _spew3d_lvlbox_FreeChunkContents(&parsed_chunk);
+            _spew3d_lvlbox_ActuallyDestroy(lvlbox);
+            return NULL;
+        }
+        _spew3d_lvlbox_FreeChunkContents(&lvlbox->chunk[chunk_index]);
+        memcpy(&lvlbox->chunk[chunk_index], &parsed_chunk,
+            sizeof(parsed_chunk));
+    }
+    _spew3d_lvlbox_MarkAllChunksEdited_nolock(lvlbox);
+    _lvlbox_Internal(lvlbox)->journal_save_id = save_id;
     return lvlbox;
 }
 
-#undef CHECK_STR
-#undef CHECK_SPACE
+S3DHID static int _spew3d_lvlbox_ReplayJournal_nolock(
+        s3d_lvlbox *lvlbox, const char *s, uint32_t slen,
+        int *out_clean
+        ) {
+    *out_clean = 0;
+    int64_t save_id = 0;
+    if (!_spew3d_lvlbox_FromStr_Header(&s, &slen, "S3DLVLBOXJOURNAL",
+            &save_id) ||
+            save_id != _lvlbox_Internal(lvlbox)->journal_save_id)
+        return 0;
+    while (1) {
+        int64_t extent_x, chunk_count;
+        if (!_lvlbox_FromStr_CheckStr(&s, &slen, "entry") ||
+                !_lvlbox_FromStr_ReadInt(&s, &slen, 1, 65536,
+                    &extent_x) ||
+                !_lvlbox_FromStr_ReadInt(&s, &slen, 1,
+                    65536 * 65536LL, &chunk_count) ||
+                extent_x != lvlbox->chunk_extent_x ||
+                chunk_count != lvlbox->chunk_count) {
+            // Either the end, or a torn write we can't use:
+            *out_clean = (slen == 0);
+            return 1;
+        }
+
+        // Only apply the entry once we know it's complete:
+        uint32_t entry_chunks = 0;
+        uint32_t *entry_chunk_index = NULL;
+        s3d_lvlbox_chunk *entry_chunk = NULL;
+        int complete = 0;
+        while (1) {
+            if (_lvlbox_FromStr_CheckStr(&s, &slen, "commit")) {
+                complete = 1;
+                break;
+            }
+            uint32_t *new_index = realloc(entry_chunk_index,
+                sizeof(*new_index) * (entry_chunks + 1));
+            if (new_index)
+                entry_chunk_index = new_index;
+            s3d_lvlbox_chunk *new_chunk = realloc(entry_chunk,
+                sizeof(*new_chunk) * (entry_chunks + 1));
+            if (new_chunk)
+                entry_chunk = new_chunk;
+            if (!new_index || !new_chunk)
+                break;
+            int result = _lvlbox_FromStr_Chunk(
+                &s, &slen, lvlbox->chunk_count,
+                &entry_chunk_index[entry_chunks],
+                &entry_chunk[entry_chunks]
+            );
+            entry_chunks++;
+            if (!result)
+                break;
+        }
+        uint32_t i = 0;
+        while (i < entry_chunks) {
+            if (complete) {
+                uint32_t idx = entry_chunk_index[i];
+                _spew3d_lvlbox_FreeChunkContents(&lvlbox->chunk[idx]);
+                memcpy(&lvlbox->chunk[idx], &entry_chunk[i],
+                    sizeof(entry_chunk[i]));
+                _spew3d_lvlbox_MarkChunkEdited_nolock(lvlbox, idx);
+            } else {
+                _spew3d_lvlbox_FreeChunkContents(&entry_chunk[i]);
+            }
+            i++;
+        }
+        free(entry_chunk_index);
+        free(entry_chunk);
+        if (!complete)
+            return 1;
+    }
+}
 
 S3DEXP char *spew3d_lvlbox_ToString(
         s3d_lvlbox *lvlbox, uint32_t *out_slen
         ) {
     mutex_Lock(_lvlbox_Internal(lvlbox)->m);
-
+    char *result = _spew3d_lvlbox_ToString_nolock(
+        lvlbox, 0, out_slen
+    );
     mutex_Release(_lvlbox_Internal(lvlbox)->m);
-    return NULL;
+    return result;
 }
 
 S3DEXP s3d_lvlbox *spew3d_lvlbox_New(
@@ -4006,8 +4987,15 @@ S3DHID int _spew3d_lvlbox_SetFloorOrCeilOrWallTextureAt_nolock(
             free(set_tex_name);
             return 0;
         }
-        tile->occupied = 1;
         memset(tile->segment, 0, sizeof(*tile->segment) * 1);
+        if (!_spew3d_lvlbox_AllocSegmentTex(&tile->segment[0])) {
+            free(tile->segment);
+            tile->segment = NULL;
+            free(last_used_name);
+            free(set_tex_name);
+            return 0;
+        }
+        tile->occupied = 1;
         tile->segment_count = 1;
         apply_to_seg_no = 0;
         reset_height_floor = 1;
@@ -4026,11 +5014,12 @@ S3DHID int _spew3d_lvlbox_SetFloorOrCeilOrWallTextureAt_nolock(
         }
     }
     if ((to_wall_no >= 0 || !to_ceiling) &&
-            tile->segment[apply_to_seg_no].floor_tex.name == NULL) {
+            tile->segment[apply_to_seg_no].texinfo->floor_tex.name_ref == 0) {
         reset_height_floor = 1;
     }
     if ((to_wall_no >= 0 || to_ceiling) &&
-            tile->segment[apply_to_seg_no].ceiling_tex.name == NULL) {
+            tile->segment[apply_to_seg_no].texinfo->
+                ceiling_tex.name_ref == 0) {
         reset_height_ceiling = 1;
     }
 
@@ -4064,7 +5053,7 @@ S3DHID int _spew3d_lvlbox_SetFloorOrCeilOrWallTextureAt_nolock(
                     if (!result)
                         continue;
 
-                    double floor_height = 0;
+                    s3dnum_t floor_height = 0;
                     result = _spew3d_lvlbox_GetNeighborHeightAtCorner_nolock(
                         lvlbox, chunk_index, tile_index, corner, 0,
                         neighbor_chunk_index, neighbor_tile_index,
@@ -4080,7 +5069,7 @@ S3DHID int _spew3d_lvlbox_SetFloorOrCeilOrWallTextureAt_nolock(
                         }
                         neighbor_corners_floor_set = 1;
                     }
-                    double ceiling_height = 0;
+                    s3dnum_t ceiling_height = 0;
                     result = _spew3d_lvlbox_GetNeighborHeightAtCorner_nolock(
                         lvlbox, chunk_index, tile_index, corner, 1,
                         neighbor_chunk_index, neighbor_tile_index,
@@ -4101,12 +5090,12 @@ S3DHID int _spew3d_lvlbox_SetFloorOrCeilOrWallTextureAt_nolock(
             int neighboring_wall_left = corner;
             int neighboring_wall_right = (corner + 1) % 4;
             int neighboring_wall_has_texture = (
-                tile->segment[apply_to_seg_no].wall[
+                tile->segment[apply_to_seg_no].texinfo->wall[
                     neighboring_wall_left
-                ].tex.name != NULL ||
-                tile->segment[apply_to_seg_no].wall[
+                ].tex.name_ref != 0 ||
+                tile->segment[apply_to_seg_no].texinfo->wall[
                     neighboring_wall_right
-                ].tex.name != NULL
+                ].tex.name_ref != 0
             );
             if (neighboring_wall_has_texture) {
                 // Just leave it.
@@ -4181,79 +5170,42 @@ S3DHID int _spew3d_lvlbox_SetFloorOrCeilOrWallTextureAt_nolock(
     }
     segment_no = apply_to_seg_no;
     assert(segment_no >= 0 && segment_no < tile->segment_count);
+    s3d_lvlbox_vertsegment *seg = &tile->segment[segment_no];
+    s3d_lvlbox_texinfo *set_tex = NULL;
+    s3d_lvlbox_texinfo *set_top_tex = NULL;
     if (to_ceiling) {
-        tile->segment[segment_no].ceiling_tex.name = set_tex_name;
-        tile->segment[segment_no].ceiling_tex.vfs_flags = vfsflags;
-        tile->segment[segment_no].ceiling_tex.id = tid;
-        tile->segment[segment_no].ceiling_tex.wrapmode =
-            S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
+        set_tex = &seg->texinfo->ceiling_tex;
     } else if (to_wall_no >= 0) {
         assert(to_wall_no >= 0 && to_wall_no < 4);
-        const int i = to_wall_no;
         if (!to_wall_top_part) {
-            int change_top_wall_too = ((
-                tile->segment[segment_no].
-                    wall[to_wall_no].tex.name == NULL &&
-                tile->segment[segment_no].
-                    wall[to_wall_no].toptex.name == NULL) || (
-                tile->segment[segment_no].
-                    wall[to_wall_no].tex.name != NULL &&
-                tile->segment[segment_no].
-                    wall[to_wall_no].toptex.name != NULL &&
-                strcmp(tile->segment[segment_no].
-                    wall[to_wall_no].tex.name,
-                    tile->segment[segment_no].
-                    wall[to_wall_no].toptex.name) == 0 &&
-                tile->segment[segment_no].
-                    wall[to_wall_no].tex.vfs_flags ==
-                tile->segment[segment_no].
-                    wall[to_wall_no].toptex.vfs_flags
-            ));
-            char *top_new_tex = NULL;
-            s3d_texture_t top_new_tex_id = 0;
-            if (change_top_wall_too) {
-                top_new_tex = strdup(set_tex_name);
-                if (top_new_tex != NULL)
-                    top_new_tex_id = spew3d_texture_FromFile(
-                        set_tex_name, vfsflags
-                    );
-                if (!top_new_tex || top_new_tex_id == 0) {
-                    free(top_new_tex);
-                    free(set_tex_name);
-                    free(last_used_name);
-                    return 0;
-                }
-            }
-            tile->segment[segment_no].wall[i].tex.name = set_tex_name;
-            tile->segment[segment_no].wall[i].tex.vfs_flags = vfsflags;
-            tile->segment[segment_no].wall[i].tex.id = tid;
-            tile->segment[segment_no].wall[i].tex.wrapmode =
-                S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
-            if (change_top_wall_too) {
-                tile->segment[segment_no].wall[i].toptex.name =
-                    top_new_tex;
-                tile->segment[segment_no].wall[i].toptex.vfs_flags =
-                    vfsflags;
-                tile->segment[segment_no].wall[i].toptex.id =
-                    top_new_tex_id;
-                tile->segment[segment_no].wall[i].toptex.wrapmode =
-                    S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
-            }
+            set_tex = &seg->texinfo->wall[to_wall_no].tex;
+            // Interned names are unique per path and VFS flags,
+            // so a plain ref comparison tells if both parts match:
+            if (seg->texinfo->wall[to_wall_no].tex.name_ref ==
+                    seg->texinfo->wall[to_wall_no].toptex.name_ref)
+                set_top_tex = &seg->texinfo->wall[to_wall_no].toptex;
         } else {
-            tile->segment[segment_no].wall[i].toptex.name =
-                set_tex_name;
-            tile->segment[segment_no].wall[i].toptex.vfs_flags =
-                vfsflags;
-            tile->segment[segment_no].wall[i].toptex.id = tid;
-            tile->segment[segment_no].wall[i].toptex.wrapmode =
-                S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
+            set_tex = &seg->texinfo->wall[to_wall_no].toptex;
         }
     } else {
-        tile->segment[segment_no].floor_tex.name = set_tex_name;
-        tile->segment[segment_no].floor_tex.vfs_flags = vfsflags;
-        tile->segment[segment_no].floor_tex.id = tid;
-        tile->segment[segment_no].floor_tex.wrapmode =
-            S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
+        set_tex = &seg->texinfo->floor_tex;
+    }
+    if (!_spew3d_lvlbox_SetTexInfoName(set_tex, set_tex_name,
+            vfsflags) ||
+            (set_top_tex != NULL &&
+            !_spew3d_lvlbox_SetTexInfoName(set_top_tex, set_tex_name,
+                vfsflags))) {
+        free(set_tex_name);
+        free(last_used_name);
+        return 0;
+    }
+    free(set_tex_name);
+    set_tex_name = NULL;
+    set_tex->id = tid;
+    set_tex->wrapmode = S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
+    if (set_top_tex != NULL) {
+        set_top_tex->id = tid;
+        set_top_tex->wrapmode = S3D_LVLBOX_TEXWRAP_MODE_DEFAULT;
     }
     if (_lvlbox_Internal(lvlbox)->last_used_tex) {
         free(_lvlbox_Internal(lvlbox)->last_used_tex);
@@ -4271,8 +5223,8 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         s3d_lvlbox *lvlbox,
         s3d_lvlbox_tile *tile, int segment_no,
         s3d_lvlbox_tilepolygon *polygon,
-        s3d_pos model_pos,
-        s3d_rotation model_rot,
+        const s3d_matrix4 *modelview,
+        const s3d_pos *model_cam_pos,
         s3d_transform3d_cam_info *cam_info,
         s3d_geometryrenderlightinfo *render_light_info,
         s3d_color scene_ambient,
@@ -4283,6 +5235,16 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         return 0;
     }
 
+    // Floors, ceilings and walls are only seen from inside their
+    // tile, which is where their normal points. So skip them early
+    // when facing away:
+    if ((polygon->material & SPEW3D_MATERIAL_TWOSIDED) == 0 &&
+            spew3d_math3d_polygon_facesaway(
+                &polygon->polynormal, &polygon->vertex[0],
+                model_cam_pos
+            ))
+        return 1;
+
     double multiplier_vertex_light = 1.0;
     s3d_pos vertex_positions[3];
     s3d_renderpolygon *rqueue = *render_queue;
@@ -4302,9 +5264,9 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         (int)polygon->texture
     );
     #endif
-    spew3d_math3d_transform3d(
+    spew3d_math3d_transform3d_matrix(
         polygon->vertex[0],
-        cam_info, model_pos, model_rot,
+        cam_info, modelview,
         &rqueue[rfill].vertex_pos_pixels[0],
         &rqueue[rfill].vertex_pos[0]
     );
@@ -4335,6 +5297,7 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         rqueue[rfill].vertex_emit[0].blue *
         multiplier_vertex_light), scene_ambient.blue
     );
+    rqueue[rfill].vertex_emit[0].alpha = 1.0;
 
     // Second vertex:
     #if defined(DEBUG_SPEW3D_TRANSFORM3D)
@@ -4346,9 +5309,9 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         (double)polygon->vertex[1].y,
         (double)polygon->vertex[1].z);
     #endif
-    spew3d_math3d_transform3d(
+    spew3d_math3d_transform3d_matrix(
         polygon->vertex[1],
-        cam_info, model_pos, model_rot,
+        cam_info, modelview,
         &rqueue[rfill].vertex_pos_pixels[1],
         &rqueue[rfill].vertex_pos[1]
     );
@@ -4379,6 +5342,7 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         rqueue[rfill].vertex_emit[1].blue *
         multiplier_vertex_light), scene_ambient.blue
     );
+    rqueue[rfill].vertex_emit[1].alpha = 1.0;
 
     // Third vertex:
     #if defined(DEBUG_SPEW3D_TRANSFORM3D)
@@ -4390,9 +5354,9 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         (double)polygon->vertex[2].y,
         (double)polygon->vertex[2].z);
     #endif
-    spew3d_math3d_transform3d(
+    spew3d_math3d_transform3d_matrix(
         polygon->vertex[2],
-        cam_info, model_pos, model_rot,
+        cam_info, modelview,
         &rqueue[rfill].vertex_pos_pixels[2],
         &rqueue[rfill].vertex_pos[2]
     );
@@ -4423,6 +5387,7 @@ S3DHID static inline int spew3d_lvlbox_TransformTilePolygon(
         rqueue[rfill].vertex_emit[2].blue *
         multiplier_vertex_light), scene_ambient.blue
     );
+    rqueue[rfill].vertex_emit[2].alpha = 1.0;
 
     // Set texture and material:
     rqueue[rfill].polygon_texture = (
@@ -4491,6 +5456,13 @@ S3DEXP int spew3d_lvlbox_Transform(
     if (model_rotation != NULL)
         memcpy(&effective_model_rot, model_rotation,
             sizeof(*model_rotation));
+    s3d_matrix4 modelview;
+    spew3d_math3d_matrix_modelview(
+        cam_info, &effective_model_pos, &effective_model_rot,
+        &modelview
+    );
+    s3d_pos model_cam_pos;
+    spew3d_math3d_matrix_camerapos(&modelview, &model_cam_pos);
 
     s3d_renderpolygon *rqueue = *render_queue;
     uint32_t ralloc = *render_alloc;
@@ -4545,7 +5517,7 @@ S3DEXP int spew3d_lvlbox_Transform(
                     int result = spew3d_lvlbox_TransformTilePolygon(
                         lvlbox, tile, i2,
                         &tile->segment[i2].cache.cached_floor[i3],
-                        effective_model_pos, effective_model_rot,
+                        &modelview, &model_cam_pos,
                         cam_info, render_light_info, scene_ambient,
                         render_queue, render_fill, render_alloc
                     );
@@ -4568,7 +5540,7 @@ S3DEXP int spew3d_lvlbox_Transform(
                     int result = spew3d_lvlbox_TransformTilePolygon(
                         lvlbox, tile, i2,
                         &tile->segment[i2].cache.cached_ceiling[i3],
-                        effective_model_pos, effective_model_rot,
+                        &modelview, &model_cam_pos,
                         cam_info, render_light_info, scene_ambient,
                         render_queue, render_fill, render_alloc
                     );
@@ -4591,7 +5563,7 @@ S3DEXP int spew3d_lvlbox_Transform(
                     int result = spew3d_lvlbox_TransformTilePolygon(
                         lvlbox, tile, i2,
                         &tile->segment[i2].cache.cached_wall[i3],
-                        effective_model_pos, effective_model_rot,
+                        &modelview, &model_cam_pos,
                         cam_info, render_light_info, scene_ambient,
                         render_queue, render_fill, render_alloc
                     );
@@ -4619,10 +5591,84 @@ S3DEXP int spew3d_lvlbox_Transform(
 
 #undef LVLBOX_TRANSFORM_QUEUEGROW
 
+S3DHID void _spew3d_lvlbox_MarkChunkEdited_nolock(
+        s3d_lvlbox *lvlbox, uint32_t chunk_index
+        ) {
+    if (chunk_index >= lvlbox->chunk_count)
+        return;
+    _lvlbox_Internal(lvlbox)->edit_generation++;
+    lvlbox->chunk[chunk_index].edit_generation = (
+        _lvlbox_Internal(lvlbox)->edit_generation
+    );
+}
+
+S3DHID void _spew3d_lvlbox_MarkAllChunksEdited_nolock(
+        s3d_lvlbox *lvlbox
+        ) {
+    _lvlbox_Internal(lvlbox)->edit_generation++;
+    uint32_t i = 0;
+    while (i < lvlbox->chunk_count) {
+        lvlbox->chunk[i].edit_generation = (
+            _lvlbox_Internal(lvlbox)->edit_generation
+        );
+        i++;
+    }
+}
+
+S3DEXP uint64_t spew3d_lvlbox_GetEditGeneration(
+        s3d_lvlbox *lvlbox
+        ) {
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint64_t result = _lvlbox_Internal(lvlbox)->edit_generation;
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return result;
+}
+
+S3DEXP uint64_t spew3d_lvlbox_GetChunkEditGeneration(
+        s3d_lvlbox *lvlbox, uint32_t chunk_index
+        ) {
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint64_t result = 0;
+    if (chunk_index < lvlbox->chunk_count)
+        result = lvlbox->chunk[chunk_index].edit_generation;
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return result;
+}
+
+S3DEXP int spew3d_lvlbox_GetChunksEditedSince(
+        s3d_lvlbox *lvlbox, uint64_t since_generation,
+        uint8_t **out_dirty_bitmap, uint32_t *out_chunk_count,
+        uint64_t *out_current_generation
+        ) {
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint32_t bitmap_bytes = (lvlbox->chunk_count + 7) / 8;
+    uint8_t *bitmap = malloc(bitmap_bytes > 0 ? bitmap_bytes : 1);
+    if (!bitmap) {
+        mutex_Release(_lvlbox_Internal(lvlbox)->m);
+        return 0;
+    }
+    memset(bitmap, 0, bitmap_bytes > 0 ? bitmap_bytes : 1);
+    uint32_t i = 0;
+    while (i < lvlbox->chunk_count) {
+        if (lvlbox->chunk[i].edit_generation > since_generation)
+            bitmap[i / 8] |= (uint8_t)(1 << (i % 8));
+        i++;
+    }
+    *out_dirty_bitmap = bitmap;
+    *out_chunk_count = lvlbox->chunk_count;
+    if (out_current_generation != NULL)
+        *out_current_generation = (
+            _lvlbox_Internal(lvlbox)->edit_generation
+        );
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return 1;
+}
+
 S3DHID void _spew3d_lvlbox_InvalidateTileWithNeighbors_nolock(
         s3d_lvlbox *lvlbox, uint32_t chunk_index,
         uint32_t tile_index
         ) {
+    _spew3d_lvlbox_MarkChunkEdited_nolock(lvlbox, chunk_index);
     int32_t shift_x = -2;
     int32_t shift_y;
     while (shift_x < 1) {
@@ -4644,6 +5690,12 @@ S3DHID void _spew3d_lvlbox_InvalidateTileWithNeighbors_nolock(
                 if (!lvlbox->chunk[neighbor_chunk_index].
                         tile[neighbor_tile_index].occupied)
                     continue;
+                // Neighbor geometry depends on ours (e.g. smooth
+                // normals), so its chunk counts as changed too:
+                if (neighbor_chunk_index != chunk_index)
+                    _spew3d_lvlbox_MarkChunkEdited_nolock(
+                        lvlbox, neighbor_chunk_index
+                    );
                 int i = 0;
                 while (i < lvlbox->chunk[neighbor_chunk_index].
                         tile[neighbor_tile_index].segment_count) {
@@ -5153,7 +6205,7 @@ S3DHID int _spew3d_lvlbox_InteractPosDirToTileCornerOrWall_nolock(
         if (neighbor_tile != NULL && out_verti_fence_no != NULL) {
             int our_side_has_fence = (
                 tile->segment[_segment_no].
-                    wall[_wall_no].fence.is_set
+                    texinfo->wall[_wall_no].fence.is_set
             );
             s3dnum_t ourseg_min_z = (
                 tile->segment[_segment_no].floor_z[0]
@@ -5176,7 +6228,7 @@ S3DHID int _spew3d_lvlbox_InteractPosDirToTileCornerOrWall_nolock(
             while (i < neighbor_tile->segment_count) {
                 if (!our_side_has_fence &&
                         !neighbor_tile->segment[i].
-                        wall[opposite_wall].fence.is_set) {
+                        texinfo->wall[opposite_wall].fence.is_set) {
                     i++;
                     continue;
                 }
@@ -0,0 +1,762 @@
+/* Copyright (c) 2024, ellie/@ell1e & Spew3D Team (see AUTHORS.md).
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+Alternatively, at your option, this file is offered under the Apache 2
+license, see accompanied LICENSE.md.
+*/
+
+
+#if defined(SPEW3D_IMPLEMENTATION) && \
+    SPEW3D_IMPLEMENTATION != 0
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct s3d_lvlbox s3d_lvlbox;
+
+#define LVLBOX_COLLISION_EPSILON 0.0001
+
+S3DHID static int _lvlbox_collision_TileAt(
+        s3d_lvlbox *lvlbox, int64_t grid_x, int64_t grid_y,
+        uint32_t *out_chunk_index, uint32_t *out_tile_index
+        ) {
+    if (grid_x < 0 || grid_y < 0)
+        return 0;
+    int64_t chunk_x = grid_x / (int64_t)LVLBOX_CHUNK_SIZE;
+    int64_t chunk_y = grid_y / (int64_t)LVLBOX_CHUNK_SIZE;
+    if (chunk_x >= (int64_t)lvlbox->chunk_extent_x)
+        return 0;
+    int64_t chunk_index = chunk_y * (int64_t)lvlbox->chunk_extent_x +
+        chunk_x;
+    if (chunk_index >= (int64_t)lvlbox->chunk_count)
+        return 0;
+    *out_chunk_index = chunk_index;
+    *out_tile_index = (
+        (grid_y % (int64_t)LVLBOX_CHUNK_SIZE) *
+        (int64_t)LVLBOX_CHUNK_SIZE +
+        (grid_x % (int64_t)LVLBOX_CHUNK_SIZE)
+    );
+    return 1;
+}
+
+S3DHID static void _lvlbox_collision_SurfaceCoeffs(
+        const s3dnum_t corner_z[4],
+        double *out_a, double *out_b, double *out_c, double *out_d
+        ) {
+    // The surface is z = a + b * u + c * v + d * u * v, with u and v
+    // going from 0 to 1 along x and y. This is the same bilinear
+    // interpolation as _spew3d_lvlbox_TileFloorHeightAtInSegment_nolock.
+    *out_a = corner_z[2];  // back-left
+    *out_b = corner_z[3] - corner_z[2];  // front-left
+    *out_c = corner_z[1] - corner_z[2];  // back-right
+    *out_d = corner_z[0] - corner_z[1] - corner_z[3] + corner_z[2];
+}
+
+S3DHID static double _lvlbox_collision_SurfaceZAt(
+        const s3dnum_t corner_z[4], double u, double v
+        ) {
+    double a, b, c, d;
+    _lvlbox_collision_SurfaceCoeffs(corner_z, &a, &b, &c, &d);
+    u = fmax(0, fmin(1, u));
+    v = fmax(0, fmin(1, v));
+    return a + b * u + c * v + d * u * v;
+}
+
+S3DHID static int32_t _lvlbox_collision_FreeSegmentAt(
+        s3d_lvlbox_tile *tile, double u, double v, double z
+        ) {
+    if (!tile->occupied)
+        return -1;
+    int32_t i = 0;
+    while (i < tile->segment_count) {
+        if (z >= _lvlbox_collision_SurfaceZAt(
+                    tile->segment[i].floor_z, u, v
+                ) - LVLBOX_COLLISION_EPSILON &&
+                z <= _lvlbox_collision_SurfaceZAt(
+                    tile->segment[i].ceiling_z, u, v
+                ) + LVLBOX_COLLISION_EPSILON)
+            return i;
+        i++;
+    }
+    return -1;
+}
+
+S3DHID static int _lvlbox_collision_FirstExit(
+        double c0, double c1, double c2,
+        double t_start, double t_end, double *out_t
+        ) {
+    // Find the first t in [t_start, t_end] where the inside
+    // distance c0 + c1 * t + c2 * t * t drops below zero.
+    double value_start = c0 + c1 * t_start + c2 * t_start * t_start;
+    double slope_start = c1 + 2 * c2 * t_start;
+    if (value_start <= 0 && slope_start < 0) {
+        *out_t = t_start;
+        return 1;
+    }
+    double root[2];
+    int root_count = 0;
+    if (fabs(c2) < 1e-12) {
+        if (fabs(c1) < 1e-12)
+            return 0;
+        root[0] = -c0 / c1;
+        root_count = 1;
+    } else {
+        double disc = c1 * c1 - 4 * c2 * c0;
+        if (disc < 0)
+            return 0;
+        double disc_sqrt = sqrt(disc);
+        root[0] = (-c1 - disc_sqrt) / (2 * c2);
+        root[1] = (-c1 + disc_sqrt) / (2 * c2);
+        if (root[0] > root[1]) {
+            double swap = root[0];
+            root[0] = root[1];
+            root[1] = swap;
+        }
+        root_count = 2;
+    }
+    int i = 0;
+    while (i < root_count) {
+        if (root[i] > t_start && root[i] <= t_end &&
+                c1 + 2 * c2 * root[i] <= 0) {
+            *out_t = root[i];
+            return 1;
+        }
+        i++;
+    }
+    return 0;
+}
+
+S3DHID static int _lvlbox_collision_FenceBlocks(
+        s3d_lvlbox_fenceinfo *fence, double fence_floor_z,
+        double z
+        ) {
+    if (!fence->is_set || fence->is_passable)
+        return 0;
+    double fence_height = (fence->truncate_set ?
+        fence->truncate_height_z : LVLBOX_FENCE_VERTICAL_MAXHEIGHT);
+    return (z >= fence_floor_z - LVLBOX_COLLISION_EPSILON &&
+        z <= fence_floor_z + fence_height);
+}
+
+S3DHID static void _lvlbox_collision_WallNoToDir(
+        int wall_no, int32_t *out_x, int32_t *out_y
+        ) {
+    *out_x = 0;
+    *out_y = 0;
+    if (wall_no == 0) {
+        *out_x = 1;
+    } else if (wall_no == 1) {
+        *out_y = 1;
+    } else if (wall_no == 2) {
+        *out_x = -1;
+    } else {
+        assert(wall_no == 3);
+        *out_y = -1;
+    }
+}
+
+S3DHID static int _lvlbox_collision_EdgeBlocks(
+        s3d_lvlbox *lvlbox, int64_t grid_x, int64_t grid_y,
+        int wall_no, double edge_x, double edge_y, double z,
+        uint32_t *out_chunk_index, uint32_t *out_tile_index,
+        int32_t *out_segment_no, uint8_t *out_is_fence
+        ) {
+    // Check whether moving from the given tile across its side
+    // wall_no at the given point and height is blocked.
+    uint32_t chunk_index, tile_index;
+    if (!_lvlbox_collision_TileAt(lvlbox, grid_x, grid_y,
+            &chunk_index, &tile_index))
+        return 0;
+    s3d_lvlbox_tile *tile = &lvlbox->chunk[chunk_index].tile[tile_index];
+    double u = (edge_x - (double)grid_x *
+        (double)LVLBOX_TILE_SIZE) / (double)LVLBOX_TILE_SIZE;
+    double v = (edge_y - (double)grid_y *
+        (double)LVLBOX_TILE_SIZE) / (double)LVLBOX_TILE_SIZE;
+    int32_t segment_no = _lvlbox_collision_FreeSegmentAt(
+        tile, u, v, z
+    );
+    if (segment_no < 0)
+        return 0;  // We aren't in free space on this side.
+    *out_chunk_index = chunk_index;
+    *out_tile_index = tile_index;
+    *out_segment_no = segment_no;
+    *out_is_fence = 0;
+
+    int32_t shift_x, shift_y;
+    _lvlbox_collision_WallNoToDir(wall_no, &shift_x, &shift_y);
+    uint32_t neighbor_chunk_index, neighbor_tile_index;
+    if (!_lvlbox_collision_TileAt(lvlbox,
+            grid_x + shift_x, grid_y + shift_y,
+            &neighbor_chunk_index, &neighbor_tile_index))
+        return 1;  // Edge of the lvlbox.
+    s3d_lvlbox_tile *neighbor_tile = &lvlbox->chunk[
+        neighbor_chunk_index].tile[neighbor_tile_index];
+    double neighbor_u = u - (double)shift_x;
+    double neighbor_v = v - (double)shift_y;
+    int32_t neighbor_segment_no = _lvlbox_collision_FreeSegmentAt(
+        neighbor_tile, neighbor_u, neighbor_v, z
+    );
+    if (neighbor_segment_no < 0)
+        return 1;
+
+    double fence_floor_z = fmax(
+        _lvlbox_collision_SurfaceZAt(
+            tile->segment[segment_no].floor_z, u, v
+        ),
+        _lvlbox_collision_SurfaceZAt(
+            neighbor_tile->segment[neighbor_segment_no].floor_z,
+            neighbor_u, neighbor_v
+        )
+    );
+    if (_lvlbox_collision_FenceBlocks(
+            &tile->segment[segment_no].texinfo->wall[wall_no].fence,
+            fence_floor_z, z) ||
+            _lvlbox_collision_FenceBlocks(
+            &neighbor_tile->segment[neighbor_segment_no].
+                texinfo->wall[(wall_no + 2) % 4].fence,
+            fence_floor_z, z)) {
+        *out_is_fence = 1;
+        return 1;
+    }
+    return 0;
+}
+
+S3DHID static void _lvlbox_collision_ClearHit(
+        s3d_lvlbox_collisionhit *hit
+        ) {
+    memset(hit, 0, sizeof(*hit));
+    hit->chunk_index = -1;
+    hit->tile_index = -1;
+    hit->segment_no = -1;
+    hit->wall_no = -1;
+}
+
+S3DHID static int _spew3d_lvlbox_collision_GroundHeight_nolock(
+        s3d_lvlbox *lvlbox, s3d_pos pos, int ignore_lvlbox_offset,
+        s3d_lvlbox_groundinfo *out_info
+        ) {
+    memset(out_info, 0, sizeof(*out_info));
+    out_info->chunk_index = -1;
+    out_info->tile_index = -1;
+    out_info->segment_no = -1;
+    uint32_t chunk_index, tile_index;
+    s3d_pos tile_pos_offset;
+    int32_t segment_no = -1;
+    if (!_spew3d_lvlbox_WorldPosToTilePos_nolock(
+            lvlbox, pos, ignore_lvlbox_offset,
+            &chunk_index, &tile_index, NULL,
+            &tile_pos_offset, &segment_no
+            ) || segment_no < 0)
+        return 0;
+    s3d_lvlbox_vertsegment *seg = &(lvlbox->chunk[chunk_index].
+        tile[tile_index].segment[segment_no]);
+    double u = tile_pos_offset.x / (double)LVLBOX_TILE_SIZE;
+    double v = tile_pos_offset.y / (double)LVLBOX_TILE_SIZE;
+    double z_offset = (ignore_lvlbox_offset ? 0 : lvlbox->offset.z);
+    out_info->chunk_index = chunk_index;
+    out_info->tile_index = tile_index;
+    out_info->segment_no = segment_no;
+    out_info->floor_z = _lvlbox_collision_SurfaceZAt(
+        seg->floor_z, u, v) + z_offset;
+    out_info->ceiling_z = _lvlbox_collision_SurfaceZAt(
+        seg->ceiling_z, u, v) + z_offset;
+    return 1;
+}
+
+S3DEXP uint32_t spew3d_lvlbox_collision_GroundHeights(
+        s3d_lvlbox *lvlbox, const s3d_pos *positions,
+        uint32_t position_count, int ignore_lvlbox_offset,
+        s3d_lvlbox_groundinfo *out_info
+        ) {
+    uint32_t found = 0;
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint32_t i = 0;
+    while (i < position_count) {
+        if (_spew3d_lvlbox_collision_GroundHeight_nolock(
+                lvlbox, positions[i], ignore_lvlbox_offset,
+                &out_info[i]))
+            found++;
+        i++;
+    }
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return found;
+}
+
+S3DHID static int _spew3d_lvlbox_collision_RayCast_nolock(
+        s3d_lvlbox *lvlbox, s3d_pos ray_origin, s3d_pos ray_dir,
+        s3dnum_t max_distance, int ignore_lvlbox_offset,
+        s3d_lvlbox_collisionhit *out_hit
+        ) {
+    _lvlbox_collision_ClearHit(out_hit);
+    double dir_len = spew3d_math3d_len(ray_dir);
+    if (dir_len <= 0 || max_distance <= 0 ||
+            lvlbox->chunk_count <= 0)
+        return 0;
+    double dx = ray_dir.x / dir_len;
+    double dy = ray_dir.y / dir_len;
+    double dz = ray_dir.z / dir_len;
+    s3d_pos offset = {0};
+    if (!ignore_lvlbox_offset)
+        offset = lvlbox->offset;
+    double ox = ray_origin.x - offset.x;
+    double oy = ray_origin.y - offset.y;
+    double oz = ray_origin.z - offset.z;
+    const double tile_size = (double)LVLBOX_TILE_SIZE;
+    const int64_t tiles_x = (int64_t)lvlbox->chunk_extent_x *
+        (int64_t)LVLBOX_CHUNK_SIZE;
+    const int64_t tiles_y = (int64_t)(lvlbox->chunk_count /
+        lvlbox->chunk_extent_x) * (int64_t)LVLBOX_CHUNK_SIZE;
+
+    // Clip the ray to the area covered by the lvlbox:
+    double t_enter = 0;
+    double t_leave = INFINITY;
+    double t_exit = max_distance;
+    if (fabs(dx) < 1e-12) {
+        if (ox < 0 || ox >= (double)tiles_x * tile_size)
+            return 0;
+    } else {
+        double t1 = (0 - ox) / dx;
+        double t2 = ((double)tiles_x * tile_size - ox) / dx;
+        t_enter = fmax(t_enter, fmin(t1, t2));
+        t_leave = fmin(t_leave, fmax(t1, t2));
+    }
+    if (fabs(dy) < 1e-12) {
+        if (oy < 0 || oy >= (double)tiles_y * tile_size)
+            return 0;
+    } else {
+        double t1 = (0 - oy) / dy;
+        double t2 = ((double)tiles_y * tile_size - oy) / dy;
+        t_enter = fmax(t_enter, fmin(t1, t2));
+        t_leave = fmin(t_leave, fmax(t1, t2));
+    }
+    if (t_enter > t_leave || t_enter > t_exit)
+        return 0;
+
+    // Set up the grid traversal:
+    int64_t grid_x = floor((ox + dx * t_enter) / tile_size);
+    int64_t grid_y = floor((oy + dy * t_enter) / tile_size);
+    grid_x = (grid_x < 0 ? 0 : (grid_x >= tiles_x ?
+        tiles_x - 1 : grid_x));
+    grid_y = (grid_y < 0 ? 0 : (grid_y >= tiles_y ?
+        tiles_y - 1 : grid_y));
+    int step_x = (dx > 0 ? 1 : (dx < 0 ? -1 : 0));
+    int step_y = (dy > 0 ? 1 : (dy < 0 ? -1 : 0));
+    double t_next_x = INFINITY;
+    double t_next_y = INFINITY;
+    double t_delta_x = INFINITY;
+    double t_delta_y = INFINITY;
+    if (step_x != 0) {
+        t_next_x = ((double)(grid_x + (step_x > 0 ? 1 : 0)) *
+            tile_size - ox) / dx;
+        t_delta_x = tile_size / fabs(dx);
+    }
+    if (step_y != 0) {
+        t_next_y = ((double)(grid_y + (step_y > 0 ? 1 : 0)) *
+            tile_size - oy) / dy;
+        t_delta_y = tile_size / fabs(dy);
+    }
+
+    double t_start = t_enter;
+    while (1) {
+        double t_end = fmin(fmin(t_next_x, t_next_y), t_exit);
+        uint32_t chunk_index, tile_index;
+        if (!_lvlbox_collision_TileAt(lvlbox, grid_x, grid_y,
+                &chunk_index, &tile_index))
+            return 0;
+        s3d_lvlbox_tile *tile = (
+            &lvlbox->chunk[chunk_index].tile[tile_index]
+        );
+        double tile_x0 = (double)grid_x * tile_size;
+        double tile_y0 = (double)grid_y * tile_size;
+        double px = ox + dx * t_start;
+        double py = oy + dy * t_start;
+        double pz = oz + dz * t_start;
+
+        int32_t segment_no = _lvlbox_collision_FreeSegmentAt(
+            tile, (px - tile_x0) / tile_size,
+            (py - tile_y0) / tile_size, pz
+        );
+        if (segment_no < 0) {
+            // We started inside solid ground:
+            out_hit->hit = 1;
+            out_hit->distance = t_start;
+            out_hit->pos.x = px + offset.x;
+            out_hit->pos.y = py + offset.y;
+            out_hit->pos.z = pz + offset.z;
+            out_hit->normal.x = -dx;
+            out_hit->normal.y = -dy;
+            out_hit->normal.z = -dz;
+            out_hit->chunk_index = chunk_index;
+            out_hit->tile_index = tile_index;
+            return 1;
+        }
+
+        // Check floor, ceiling and fences inside this tile:
+        s3d_lvlbox_vertsegment *seg = &tile->segment[segment_no];
+        double u0 = (ox - tile_x0) / tile_size;
+        double v0 = (oy - tile_y0) / tile_size;
+        double du = dx / tile_size;
+        double dv = dy / tile_size;
+        double best_t = INFINITY;
+        int best_kind = 0;  // 1 = floor, 2 = ceiling, 3 = fence
+        double a, b, c, d, t;
+        _lvlbox_collision_SurfaceCoeffs(seg->floor_z, &a, &b, &c, &d);
+        if (_lvlbox_collision_FirstExit(
+                oz - (a + b * u0 + c * v0 + d * u0 * v0),
+                dz - (b * du + c * dv + d * (u0 * dv + v0 * du)),
+                -(d * du * dv), t_start, t_end, &t
+                ) && t < best_t) {
+            best_t = t;
+            best_kind = 1;
+        }
+        _lvlbox_collision_SurfaceCoeffs(seg->ceiling_z, &a, &b, &c, &d);
+        if (_lvlbox_collision_FirstExit(
+                (a + b * u0 + c * v0 + d * u0 * v0) - oz,
+                (b * du + c * dv + d * (u0 * dv + v0 * du)) - dz,
+                d * du * dv, t_start, t_end, &t
+                ) && t < best_t) {
+            best_t = t;
+            best_kind = 2;
+        }
+        if (fabs(dz) > 1e-12) {
+            int k = 0;
+            while (k < seg->hori_fence_count) {
+                if (seg->hori_fence[k].is_passable) {
+                    k++;
+                    continue;
+                }
+                t = (seg->hori_fence_z[k] - oz) / dz;
+                if (t >= t_start && t <= t_end && t < best_t) {
+                    best_t = t;
+                    best_kind = 3;
+                }
+                k++;
+            }
+        }
+        if (best_kind != 0) {
+            double hu = u0 + du * best_t;
+            double hv = v0 + dv * best_t;
+            out_hit->hit = 1;
+            out_hit->distance = best_t;
+            out_hit->pos.x = ox + dx * best_t + offset.x;
+            out_hit->pos.y = oy + dy * best_t + offset.y;
+            out_hit->pos.z = oz + dz * best_t + offset.z;
+            if (best_kind == 1) {
+                _lvlbox_collision_SurfaceCoeffs(
+                    seg->floor_z, &a, &b, &c, &d
+                );
+                out_hit->normal.x = -(b + d * hv) / tile_size;
+                out_hit->normal.y = -(c + d * hu) / tile_size;
+                out_hit->normal.z = 1;
+                out_hit->hit_floor = 1;
+            } else if (best_kind == 2) {
+                out_hit->normal.x = (b + d * hv) / tile_size;
+                out_hit->normal.y = (c + d * hu) / tile_size;
+                out_hit->normal.z = -1;
+                out_hit->hit_ceiling = 1;
+            } else {
+                out_hit->normal.z = (dz > 0 ? -1 : 1);
+                out_hit->hit_fence = 1;
+            }
+            spew3d_math3d_normalize(&out_hit->normal);
+            out_hit->chunk_index = chunk_index;
+            out_hit->tile_index = tile_index;
+            out_hit->segment_no = segment_no;
+            return 1;
+        }
+
+        // Advance to the next tile:
+        if (t_end >= t_exit)
+            return 0;
+        int64_t prev_grid_x = grid_x;
+        int64_t prev_grid_y = grid_y;
+        int crossed_wall_no;
+        if (t_next_x < t_next_y) {
+            grid_x += step_x;
+            t_next_x += t_delta_x;
+            crossed_wall_no = (step_x > 0 ? 0 : 2);
+        } else {
+            grid_y += step_y;
+            t_next_y += t_delta_y;
+            crossed_wall_no = (step_y > 0 ? 1 : 3);
+        }
+        t_start = t_end;
+        px = ox + dx * t_start;
+        py = oy + dy * t_start;
+        pz = oz + dz * t_start;
+        uint32_t wall_chunk_index, wall_tile_index;
+        int32_t wall_segment_no;
+        uint8_t is_fence = 0;
+        if (_lvlbox_collision_EdgeBlocks(
+                lvlbox, prev_grid_x, prev_grid_y, crossed_wall_no,
+                px, py, pz, &wall_chunk_index, &wall_tile_index,
+                &wall_segment_no, &is_fence
+                )) {
+            int32_t normal_x, normal_y;
+            _lvlbox_collision_WallNoToDir(
+                crossed_wall_no, &normal_x, &normal_y
+            );
+            out_hit->hit = 1;
+            out_hit->distance = t_start;
+            out_hit->pos.x = px + offset.x;
+            out_hit->pos.y = py + offset.y;
+            out_hit->pos.z = pz + offset.z;
+            out_hit->normal.x = -normal_x;
+            out_hit->normal.y = -normal_y;
+            out_hit->chunk_index = wall_chunk_index;
+            out_hit->tile_index = wall_tile_index;
+            out_hit->segment_no = wall_segment_no;
+            out_hit->wall_no = crossed_wall_no;
+            out_hit->hit_fence = is_fence;
+            return 1;
+        }
+        if (grid_x < 0 || grid_x >= tiles_x ||
+                grid_y < 0 || grid_y >= tiles_y)
+            return 0;
+    }
+}
+
+S3DEXP int spew3d_lvlbox_collision_RayCast(
+        s3d_lvlbox *lvlbox, s3d_pos ray_origin, s3d_pos ray_dir,
+        s3dnum_t max_distance, int ignore_lvlbox_offset,
+        s3d_lvlbox_collisionhit *out_hit
+        ) {
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    int result = _spew3d_lvlbox_collision_RayCast_nolock(
+        lvlbox, ray_origin, ray_dir, max_distance,
+        ignore_lvlbox_offset, out_hit
+    );
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return result;
+}
+
+S3DEXP uint32_t spew3d_lvlbox_collision_RayCastBatch(
+        s3d_lvlbox *lvlbox, const s3d_pos *ray_origins,
+        const s3d_pos *ray_dirs, uint32_t ray_count,
+        s3dnum_t max_distance, int ignore_lvlbox_offset,
+        s3d_lvlbox_collisionhit *out_hits
+        ) {
+    uint32_t hits = 0;
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint32_t i = 0;
+    while (i < ray_count) {
+        if (_spew3d_lvlbox_collision_RayCast_nolock(
+                lvlbox, ray_origins[i], ray_dirs[i], max_distance,
+                ignore_lvlbox_offset, &out_hits[i]))
+            hits++;
+        i++;
+    }
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return hits;
+}
+
+S3DHID static int _lvlbox_collision_SweepCircleVsPoint(
+        double sx, double sy, double mx, double my,
+        double px, double py, double radius, double *out_t
+        ) {
+    // First t in [0, 1] where a circle moving from (sx, sy) by
+    // (mx, my) touches the point (px, py) while moving towards it.
+    double rx = sx - px;
+    double ry = sy - py;
+    double qa = mx * mx + my * my;
+    double qb = 2 * (rx * mx + ry * my);
+    double qc = rx * rx + ry * ry - radius * radius;
+    if (qa < 1e-18 || qb >= 0)
+        return 0;
+    if (qc <= 0) {
+        *out_t = 0;
+        return 1;
+    }
+    double disc = qb * qb - 4 * qa * qc;
+    if (disc < 0)
+        return 0;
+    double t = (-qb - sqrt(disc)) / (2 * qa);
+    if (t < 0 || t > 1)
+        return 0;
+    *out_t = t;
+    return 1;
+}
+
+S3DHID static int _spew3d_lvlbox_collision_SphereSweep_nolock(
+        s3d_lvlbox *lvlbox, s3d_pos sweep_start, s3d_pos sweep_end,
+        s3dnum_t radius, int ignore_lvlbox_offset,
+        s3d_lvlbox_collisionhit *out_hit
+        ) {
+    _lvlbox_collision_ClearHit(out_hit);
+    if (lvlbox->chunk_count <= 0)
+        return 0;
+    s3d_pos offset = {0};
+    if (!ignore_lvlbox_offset)
+        offset = lvlbox->offset;
+    double sx = sweep_start.x - offset.x;
+    double sy = sweep_start.y - offset.y;
+    double sz = sweep_start.z - offset.z;
+    double mx = sweep_end.x - sweep_start.x;
+    double my = sweep_end.y - sweep_start.y;
+    double mz = sweep_end.z - sweep_start.z;
+    if (mx * mx + my * my < 1e-18)
+        return 0;
+    const double tile_size = (double)LVLBOX_TILE_SIZE;
+    const int64_t tiles_x = (int64_t)lvlbox->chunk_extent_x *
+        (int64_t)LVLBOX_CHUNK_SIZE;
+    const int64_t tiles_y = (int64_t)(lvlbox->chunk_count /
+        lvlbox->chunk_extent_x) * (int64_t)LVLBOX_CHUNK_SIZE;
+
+    // Every tile side near the swept area is a candidate:
+    int64_t min_x = floor((fmin(sx, sx + mx) - radius) / tile_size);
+    int64_t max_x = floor((fmax(sx, sx + mx) + radius) / tile_size);
+    int64_t min_y = floor((fmin(sy, sy + my) - radius) / tile_size);
+    int64_t max_y = floor((fmax(sy, sy + my) + radius) / tile_size);
+    if (min_x < 0) min_x = 0;
+    if (min_y < 0) min_y = 0;
+    if (max_x >= tiles_x) max_x = tiles_x - 1;
+    if (max_y >= tiles_y) max_y = tiles_y - 1;
+
+    double best_t = INFINITY;
+    int64_t grid_y = min_y;
+    while (grid_y <= max_y) {
+        int64_t grid_x = min_x;
+        while (grid_x <= max_x) {
+            int wall_no = 0;
+            while (wall_no < 4) {
+                int32_t nx, ny;
+                _lvlbox_collision_WallNoToDir(wall_no, &nx, &ny);
+                // The side runs from (e0x, e0y) to (e1x, e1y):
+                double e0x = (double)(grid_x + (nx > 0 ? 1 : 0)) *
+                    tile_size;
+                double e0y = (double)(grid_y + (ny > 0 ? 1 : 0)) *
+                    tile_size;
+                double e1x = e0x + (nx == 0 ? tile_size : 0);
+                double e1y = e0y + (ny == 0 ? tile_size : 0);
+                double inner_dist = -((sx - e0x) * nx +
+                    (sy - e0y) * ny);
+                double outward_speed = mx * nx + my * ny;
+                if (inner_dist < -LVLBOX_COLLISION_EPSILON ||
+                        outward_speed <= 0) {
+                    wall_no++;
+                    continue;
+                }
+                double t = (inner_dist - radius) / outward_speed;
+                if (t < 0)
+                    t = 0;
+                double cx = sx + mx * t;
+                double cy = sy + my * t;
+                double contact_x = cx + nx * radius;
+                double contact_y = cy + ny * radius;
+                double normal_x = -nx;
+                double normal_y = -ny;
+                int touches = (t <= 1);
+                if (touches && ((nx == 0 && (contact_x < e0x ||
+                        contact_x > e1x)) || (ny == 0 &&
+                        (contact_y < e0y || contact_y > e1y)))) {
+                    // We pass the side's line beyond its end points,
+                    // so we can only touch one of the corners:
+                    double corner_x = (nx == 0 ?
+                        (contact_x < e0x ? e0x : e1x) : e0x);
+                    double corner_y = (ny == 0 ?
+                        (contact_y < e0y ? e0y : e1y) : e0y);
+                    touches = _lvlbox_collision_SweepCircleVsPoint(
+                        sx, sy, mx, my, corner_x, corner_y,
+                        radius, &t
+                    );
+                    if (touches) {
+                        contact_x = corner_x;
+                        contact_y = corner_y;
+                        normal_x = (sx + mx * t) - corner_x;
+                        normal_y = (sy + my * t) - corner_y;
+                    }
+                }
+                uint32_t chunk_index, tile_index;
+                int32_t segment_no;
+                uint8_t is_fence;
+                if (touches && t < best_t &&
+                        _lvlbox_collision_EdgeBlocks(
+                        lvlbox, grid_x, grid_y, wall_no,
+                        contact_x, contact_y, sz + mz * t,
+                        &chunk_index, &tile_index,
+                        &segment_no, &is_fence
+                        )) {
+                    best_t = t;
+                    out_hit->hit = 1;
+                    out_hit->distance = t;
+                    out_hit->pos.x = sx + mx * t + offset.x;
+                    out_hit->pos.y = sy + my * t + offset.y;
+                    out_hit->pos.z = sz + mz * t + offset.z;
+                    out_hit->normal.x = normal_x;
+                    out_hit->normal.y = normal_y;
+                    out_hit->normal.z = 0;
+                    spew3d_math3d_normalize(&out_hit->normal);
+                    out_hit->chunk_index = chunk_index;
+                    out_hit->tile_index = tile_index;
+                    out_hit->segment_no = segment_no;
+                    out_hit->wall_no = wall_no;
+                    out_hit->hit_fence = is_fence;
+                }
+                wall_no++;
+            }
+            grid_x++;
+        }
+        grid_y++;
+    }
+    return out_hit->hit;
+}
+
+S3DEXP int spew3d_lvlbox_collision_SphereSweep(
+        s3d_lvlbox *lvlbox, s3d_pos sweep_start, s3d_pos sweep_end,
+        s3dnum_t radius, int ignore_lvlbox_offset,
+        s3d_lvlbox_collisionhit *out_hit
+        ) {
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    int result = _spew3d_lvlbox_collision_SphereSweep_nolock(
+        lvlbox, sweep_start, sweep_end, radius,
+        ignore_lvlbox_offset, out_hit
+    );
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return result;
+}
+
+S3DEXP uint32_t spew3d_lvlbox_collision_SphereSweepBatch(
+        s3d_lvlbox *lvlbox, const s3d_pos *sweep_starts,
+        const s3d_pos *sweep_ends, uint32_t sweep_count,
+        s3dnum_t radius, int ignore_lvlbox_offset,
+        s3d_lvlbox_collisionhit *out_hits
+        ) {
+    uint32_t hits = 0;
+    mutex_Lock(_lvlbox_Internal(lvlbox)->m);
+    uint32_t i = 0;
+    while (i < sweep_count) {
+        if (_spew3d_lvlbox_collision_SphereSweep_nolock(
+                lvlbox, sweep_starts[i], sweep_ends[i], radius,
+                ignore_lvlbox_offset, &out_hits[i]))
+            hits++;
+        i++;
+    }
+    mutex_Release(_lvlbox_Internal(lvlbox)->m);
+    return hits;
+}
+
+#undef LVLBOX_COLLISION_EPSILON
+
+#endif  // SPEW3D_IMPLEMENTATION
+
@@ -172,6 +172,7 @@ S3DEXP int spew3d_lvlbox_edit_DragFocusedTileCorner(
         ] = post_drag_z;
         tile->segment[segment_no].cache.is_up_to_date = 0;
         tile->segment[segment_no].cache.flat_normals_set = 0;
+        _spew3d_lvlbox_MarkChunkEdited_nolock(lvlbox, chunk_index);
         mutex_Release(_lvlbox_Internal(lvlbox)->m);
         return 1;
     }
@@ -510,18 +511,19 @@ S3DEXP int spew3d_lvlbox_edit_PaintLastUsedFenceEx(
                 i++;
                 continue;
             }
-            if (neighbor_tile->segment[i].wall[opposite_wall].
+            if (neighbor_tile->segment[i].texinfo->wall[opposite_wall].
                     fence.is_set) {
-                free(neighbor_tile->segment[i].wall[opposite_wall].
-                    fence.tex.name);
-                neighbor_tile->segment[i].wall[opposite_wall].
-                    fence.tex.name = NULL;
-                neighbor_tile->segment[i].wall[opposite_wall].
-                    fence.tex.id = 0;
+                _spew3d_lvlbox_TexNameRelease(
+                    neighbor_tile->segment[i].texinfo->wall[opposite_wall].
+                        fence.tex.name_ref
+                );
                 memset(&neighbor_tile->segment[i].
-                    wall[opposite_wall].fence, 0,
+                    texinfo->wall[opposite_wall].fence, 0,
                     sizeof(neighbor_tile->segment[i].
-                    wall[opposite_wall].fence));
+                    texinfo->wall[opposite_wall].fence));
+                _spew3d_lvlbox_InvalidateTileWithNeighbors_nolock(
+                    lvlbox, neighbor_chunk_index, neighbor_tile_index
+                );
             }
             i++;
         }
@@ -583,35 +585,27 @@ S3DEXP int spew3d_lvlbox_edit_PaintLastUsedFenceEx(
                 &tile->segment[segment_no].hori_fence[hori_count],
                 0, sizeof(tile->segment[0].hori_fence[0])
             );
-            tile->segment[segment_no].
-                hori_fence[hori_count].tex.name =
-                strdup(paint_name);
-            if (!tile->segment[segment_no].
-                    hori_fence[hori_count].tex.name) {
-                mutex_Release(_lvlbox_Internal(lvlbox)->m);
-                return 0;
-            }
-            tile->segment[segment_no].
-                hori_fence[hori_count].tex.id =
-                spew3d_texture_FromFile(
-                    paint_name, paint_vfsflags
-                );
-            if (!tile->segment[segment_no].
-                    hori_fence[hori_count].tex.id) {
-                free(tile->segment[segment_no].
-                    hori_fence[hori_count].tex.name);
+            s3d_texture_t paint_tid = spew3d_texture_FromFile(
+                paint_name, paint_vfsflags
+            );
+            if (!paint_tid || !_spew3d_lvlbox_SetTexInfoName(
+                    &tile->segment[segment_no].
+                        hori_fence[hori_count].tex,
+                    paint_name, paint_vfsflags)) {
                 mutex_Release(_lvlbox_Internal(lvlbox)->m);
                 return 0;
             }
             tile->segment[segment_no].
-                hori_fence[hori_count].tex.vfs_flags =
-                paint_vfsflags;
+                hori_fence[hori_count].tex.id = paint_tid;
             tile->segment[segment_no].
                 hori_fence[hori_count].is_set = 1;
             tile->segment[segment_no].
                 hori_fence[hori_count].has_alpha = 1;
 
             tile->segment[segment_no].hori_fence_count++;
+            _spew3d_lvlbox_InvalidateTileWithNeighbors_nolock(
+                lvlbox, chunk_index, tile_index
+            );
             mutex_Release(_lvlbox_Internal(lvlbox)->m);
             return 1;
         }
@@ -822,12 +816,83 @@ S3DHID int _spew3d_lvlbox_edit_AddNewLevelOfGround_nolock(
             floor_above_z) {
         return 1;
     }
+    // Get everything that can fail before we touch the tile, so
+    // that a failure leaves it as it was. The segments below and
+    // above the new one are still at insert_seg_no - 1 and
+    // insert_seg_no here:
+    const char *set_floor_tex_name =
+        _lvlbox_Internal(lvlbox)->last_used_tex;
+    int set_floor_tex_vfsflags =
+        _lvlbox_Internal(lvlbox)->last_used_tex_vfsflags;
+    s3d_lvlbox_texname_t set_floor_tex_ref = 0;
+    s3d_lvlbox_texname_t set_ceiling_tex_ref = 0;
+    assert(set_floor_tex_name != NULL);
+    if (insert_seg_no > 0 &&
+            tile->segment[insert_seg_no - 1].
+            texinfo->floor_tex.name_ref != 0) {
+        set_floor_tex_ref = tile->segment[insert_seg_no - 1].
+            texinfo->floor_tex.name_ref;
+    } else if (insert_seg_no < tile->segment_count &&
+            tile->segment[insert_seg_no].
+            texinfo->floor_tex.name_ref != 0) {
+        set_floor_tex_ref = tile->segment[insert_seg_no].
+            texinfo->floor_tex.name_ref;
+    }
+    if (set_floor_tex_ref != 0) {
+        set_floor_tex_name = spew3d_lvlbox_TexNameToStr(
+            set_floor_tex_ref
+        );
+        set_floor_tex_vfsflags = spew3d_lvlbox_TexNameToVFSFlags(
+            set_floor_tex_ref
+        );
+    }
+    if (insert_seg_no > 0 &&
+            tile->segment[insert_seg_no - 1].
+            texinfo->ceiling_tex.name_ref != 0) {
+        set_ceiling_tex_ref = tile->segment[insert_seg_no - 1].
+            texinfo->ceiling_tex.name_ref;
+    }
+    char *new_last_used = strdup(set_floor_tex_name);
+    s3d_lvlbox_texname_t new_assigned_floor_ref = (
+        set_floor_tex_ref != 0 ?
+        _spew3d_lvlbox_TexNameRetain(set_floor_tex_ref) :
+        _spew3d_lvlbox_TexNameIntern(
+            set_floor_tex_name, set_floor_tex_vfsflags
+        )
+    );
+    s3d_lvlbox_texname_t new_assigned_ceiling_ref = (
+        _spew3d_lvlbox_TexNameRetain(set_ceiling_tex_ref)
+    );
+    s3d_texture_t floor_tid = 0;
+    if (new_assigned_floor_ref != 0)
+        floor_tid = spew3d_texture_FromFile(
+            set_floor_tex_name, set_floor_tex_vfsflags
+        );
+    s3d_texture_t ceiling_tid = 0;
+    if (new_assigned_ceiling_ref != 0)
+        ceiling_tid = spew3d_texture_FromFile(
+            spew3d_lvlbox_TexNameToStr(new_assigned_ceiling_ref),
+            spew3d_lvlbox_TexNameToVFSFlags(new_assigned_ceiling_ref)
+        );
+    s3d_lvlbox_segmenttex *new_texinfo = NULL;
+    if (new_last_used == NULL ||
+            new_assigned_floor_ref == 0 ||
+            floor_tid == 0 ||
+            (new_assigned_ceiling_ref != 0 && ceiling_tid == 0)
+            )
+        goto failure;
+    new_texinfo = malloc(sizeof(*new_texinfo));
+    if (!new_texinfo)
+        goto failure;
+    memset(new_texinfo, 0, sizeof(*new_texinfo));
     s3d_lvlbox_vertsegment *new_seg = realloc(
         tile->segment, sizeof(*new_seg) *
         (tile->segment_count + 1)
     );
     if (!new_seg)
-        return 0;
+        goto failure;
+
+    // From here on nothing can fail anymore:
     tile->segment = new_seg;
     if (tile->segment_count > insert_seg_no) {
         // Move up the segments above us:
@@ -839,6 +904,7 @@ S3DHID int _spew3d_lvlbox_edit_AddNewLevelOfGround_nolock(
     }
     memset(&tile->segment[insert_seg_no], 0,
         sizeof(tile->segment[insert_seg_no]));
+    tile->segment[insert_seg_no].texinfo = new_texinfo;
     #if defined(DEBUG_SPEW3D_LVLBOX)
     printf("spew3d_lvlbox.c: "
         "debug: lvlbox %p "
@@ -852,92 +918,18 @@ S3DHID int _spew3d_lvlbox_edit_AddNewLevelOfGround_nolock(
         (double)new_floor_z, (double)ceiling_below
     );
     #endif
-    char *set_floor_tex_name =
-        _lvlbox_Internal(lvlbox)->last_used_tex;
-    int set_floor_tex_vfsflags =
-        _lvlbox_Internal(lvlbox)->last_used_tex_vfsflags;
-    char *set_ceiling_tex_name = NULL;
-    int set_ceiling_tex_vfsflags = 0;
-    assert(set_floor_tex_name != NULL);
-    if (insert_seg_no > 0 &&
-            tile->segment[insert_seg_no - 1].
-            floor_tex.name != NULL) {
-        set_floor_tex_name = (
-            tile->segment[insert_seg_no - 1].
-            floor_tex.name
-        );
-        set_floor_tex_vfsflags = (
-            tile->segment[insert_seg_no - 1].
-            floor_tex.vfs_flags
-        );
-    } else if (insert_seg_no < tile->segment_count &&
-            tile->segment[insert_seg_no + 1].
-            floor_tex.name != NULL) {
-        set_floor_tex_name = (
-            tile->segment[insert_seg_no + 1].
-            floor_tex.name
-        );
-        set_floor_tex_vfsflags = (
-            tile->segment[insert_seg_no + 1].
-            floor_tex.vfs_flags
-        );
-    }
-    if (insert_seg_no > 0 &&
-            tile->segment[insert_seg_no - 1].
-            ceiling_tex.name != NULL) {
-        set_ceiling_tex_name = tile->segment[insert_seg_no - 1].
-            ceiling_tex.name;
-        set_ceiling_tex_vfsflags = (
-            tile->segment[insert_seg_no - 1].
-            ceiling_tex.vfs_flags
-        );
-    }
-    char *new_last_used = strdup(set_floor_tex_name);
-    char *new_assigned_floor_name = strdup(set_floor_tex_name);
-    char *new_assigned_ceiling_name = (
-        set_ceiling_tex_name != NULL ?
-        strdup(set_ceiling_tex_name) : NULL
-    );
-    s3d_texture_t floor_tid = 0;
-    if (new_assigned_floor_name != NULL)
-        floor_tid = spew3d_texture_FromFile(
-            new_assigned_floor_name,
-            set_floor_tex_vfsflags
-        );
-    s3d_texture_t ceiling_tid = 0;
-    if (new_assigned_ceiling_name != NULL)
-        ceiling_tid = spew3d_texture_FromFile(
-            new_assigned_ceiling_name,
-            set_ceiling_tex_vfsflags
-        );
-    if (new_last_used == NULL ||
-            new_assigned_floor_name == NULL ||
-            floor_tid == 0 ||
-            (set_ceiling_tex_name != NULL &&
-            (new_assigned_ceiling_name == NULL ||
-            ceiling_tid == 0))
-            ) {
-        free(new_last_used);
-        free(new_assigned_floor_name);
-        free(new_assigned_ceiling_name);
-        return 0;
-    }
     if (_lvlbox_Internal(lvlbox)->last_used_tex != NULL)
         free(_lvlbox_Internal(lvlbox)->last_used_tex);
     _lvlbox_Internal(lvlbox)->last_used_tex = new_last_used;
     _lvlbox_Internal(lvlbox)->last_used_tex_vfsflags =
         set_floor_tex_vfsflags;
-    tile->segment[insert_seg_no].floor_tex.name =
-        new_assigned_floor_name;
-    tile->segment[insert_seg_no].floor_tex.vfs_flags =
-        set_floor_tex_vfsflags;
-    tile->segment[insert_seg_no].floor_tex.id = floor_tid;
-    if (new_assigned_ceiling_name != NULL) {
-        tile->segment[insert_seg_no].ceiling_tex.name =
-            new_assigned_ceiling_name;
-        tile->segment[insert_seg_no].ceiling_tex.vfs_flags =
-            set_ceiling_tex_vfsflags;
-        tile->segment[insert_seg_no].ceiling_tex.id = ceiling_tid;
+    tile->segment[insert_seg_no].texinfo->floor_tex.name_ref =
+        new_assigned_floor_ref;
+    tile->segment[insert_seg_no].texinfo->floor_tex.id = floor_tid;
+    if (new_assigned_ceiling_ref != 0) {
+        tile->segment[insert_seg_no].texinfo->ceiling_tex.name_ref =
+            new_assigned_ceiling_ref;
+        tile->segment[insert_seg_no].texinfo->ceiling_tex.id = ceiling_tid;
     }
 
     int i = 0;
@@ -997,6 +989,13 @@ S3DHID int _spew3d_lvlbox_edit_AddNewLevelOfGround_nolock(
         lvlbox, chunk_index, tile_index
     );
     return 1;
+
+    failure: ;
+    free(new_texinfo);
+    free(new_last_used);
+    _spew3d_lvlbox_TexNameRelease(new_assigned_floor_ref);
+    _spew3d_lvlbox_TexNameRelease(new_assigned_ceiling_ref);
+    return 0;
 }
 
 S3DEXP int spew3d_lvlbox_edit_AddNewLevelOfGround(
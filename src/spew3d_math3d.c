@@ -33,6 +33,24 @@ license, see accompanied LICENSE.md.
 #include <stdio.h>
 #include <string.h>
 
+#ifndef SPEW3D_OPTION_DISABLE_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPEW3D_MATH3D_SSE2
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+// Compiled for AVX via function attributes, used if the CPU has it:
+#define SPEW3D_MATH3D_AVX
+#include <immintrin.h>
+#endif
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define SPEW3D_MATH3D_NEON
+#include <arm_neon.h>
+#endif
+#endif  // SPEW3D_OPTION_DISABLE_SIMD
+
 S3DEXP void spew3d_math3d_split_fovs_from_fov(
         s3dnum_t input_shared_fov,
         uint32_t pixel_width,
@@ -411,14 +429,9 @@ S3DEXP void spew3d_math3d_transform3d(
     );
 }
 
-S3DEXP void spew3d_math3d_transform3dscreenspace(
-        s3d_pos input_pos,
-        s3d_transform3d_cam_info *cam_info,
-        s3d_pos *out_pos, s3d_pos *out_unscaled_pos
+S3DHID static void spew3d_math3d_transform3dscreenspace_prepare(
+        s3d_transform3d_cam_info *cam_info
         ) {
-    /*printf("INPUT POS AFTER CAM SPACE TRANSFORM: %f,%f,%f\n",
-        (double)input_pos.x, (double)input_pos.y,
-        (double)input_pos.z);*/
     if (S3DUNLIKELY(!cam_info->cache_set)) {
         cam_info->cache_set = 1;
         cam_info->cached_screen_plane_x = 10000;
@@ -466,6 +479,17 @@ S3DEXP void spew3d_math3d_transform3dscreenspace(
             (double)cam_info->cached_screen_plane_pixel_zwidth
         ) / 2.0;
     }
+}
+
+S3DEXP void spew3d_math3d_transform3dscreenspace(
+        s3d_pos input_pos,
+        s3d_transform3d_cam_info *cam_info,
+        s3d_pos *out_pos, s3d_pos *out_unscaled_pos
+        ) {
+    /*printf("INPUT POS AFTER CAM SPACE TRANSFORM: %f,%f,%f\n",
+        (double)input_pos.x, (double)input_pos.y,
+        (double)input_pos.z);*/
+    spew3d_math3d_transform3dscreenspace_prepare(cam_info);
 
     double dist_to_plane_factor = fmin(
         fabs(input_pos.x / cam_info->cached_screen_plane_x),
@@ -509,6 +533,713 @@ S3DEXP void spew3d_math3d_transform3dscreenspace(
         *out_unscaled_pos = input_pos;
 }
 
+S3DEXP void spew3d_math3d_matrix_identity(s3d_matrix4 *out) {
+    memset(out, 0, sizeof(*out));
+    out->m[0][0] = 1;
+    out->m[1][1] = 1;
+    out->m[2][2] = 1;
+    out->m[3][3] = 1;
+}
+
+S3DEXP void spew3d_math3d_matrix_multiply(
+        const s3d_matrix4 *a, const s3d_matrix4 *b,
+        s3d_matrix4 *out
+        ) {
+    s3d_matrix4 result;
+    int row = 0;
+    while (row < 4) {
+        int col = 0;
+        while (col < 4) {
+            result.m[row][col] = (
+                a->m[row][0] * b->m[0][col] +
+                a->m[row][1] * b->m[1][col] +
+                a->m[row][2] * b->m[2][col] +
+                a->m[row][3] * b->m[3][col]
+            );
+            col++;
+        }
+        row++;
+    }
+    *out = result;
+}
+
+S3DEXP void spew3d_math3d_matrix_fromrotation(
+        const s3d_rotation *r, s3d_matrix4 *out
+        ) {
+    // Same order as spew3d_math3d_rotate(): roll first, then the
+    // vertical angle, then the horizontal angle.
+    double roth = (r->hori * M_PI / 180.0);
+    double rotv = (r->verti * M_PI / 180.0);
+    double rotr = (r->roll * M_PI / 180.0);
+    double ch = cos(roth);
+    double sh = sin(roth);
+    double cv = cos(rotv);
+    double sv = sin(rotv);
+    double cr = cos(rotr);
+    double sr = sin(rotr);
+
+    s3d_matrix4 roll;
+    spew3d_math3d_matrix_identity(&roll);
+    roll.m[1][1] = cr;
+    roll.m[1][2] = sr;
+    roll.m[2][1] = -sr;
+    roll.m[2][2] = cr;
+    s3d_matrix4 verti;
+    spew3d_math3d_matrix_identity(&verti);
+    verti.m[0][0] = cv;
+    verti.m[0][2] = -sv;
+    verti.m[2][0] = sv;
+    verti.m[2][2] = cv;
+    s3d_matrix4 hori;
+    spew3d_math3d_matrix_identity(&hori);
+    hori.m[0][0] = ch;
+    hori.m[0][1] = -sh;
+    hori.m[1][0] = sh;
+    hori.m[1][1] = ch;
+
+    spew3d_math3d_matrix_multiply(&verti, &roll, out);
+    spew3d_math3d_matrix_multiply(&hori, out, out);
+}
+
+S3DEXP void spew3d_math3d_matrix_model(
+        const s3d_pos *model_world_pos,
+        const s3d_rotation *model_world_rotation,
+        s3d_matrix4 *out
+        ) {
+    spew3d_math3d_matrix_fromrotation(model_world_rotation, out);
+    out->m[0][3] += model_world_pos->x;
+    out->m[1][3] += model_world_pos->y;
+    out->m[2][3] += model_world_pos->z;
+}
+
+S3DEXP void spew3d_math3d_matrix_view(
+        const s3d_transform3d_cam_info *cam_info,
+        s3d_matrix4 *out
+        ) {
+    // Move the camera to the origin, then undo its horizontal,
+    // vertical and roll angles in that order, like
+    // spew3d_math3d_transform3d() does:
+    spew3d_math3d_matrix_identity(out);
+    out->m[0][3] = -cam_info->cam_pos.x;
+    out->m[1][3] = -cam_info->cam_pos.y;
+    out->m[2][3] = -cam_info->cam_pos.z;
+    s3d_matrix4 step;
+    s3d_rotation reverse = {0};
+    reverse.hori = -cam_info->cam_rotation.hori;
+    spew3d_math3d_matrix_fromrotation(&reverse, &step);
+    spew3d_math3d_matrix_multiply(&step, out, out);
+    reverse.hori = 0;
+    reverse.verti = -cam_info->cam_rotation.verti;
+    spew3d_math3d_matrix_fromrotation(&reverse, &step);
+    spew3d_math3d_matrix_multiply(&step, out, out);
+    reverse.verti = 0;
+    reverse.roll = -cam_info->cam_rotation.roll;
+    spew3d_math3d_matrix_fromrotation(&reverse, &step);
+    spew3d_math3d_matrix_multiply(&step, out, out);
+}
+
+S3DEXP void spew3d_math3d_matrix_modelview(
+        const s3d_transform3d_cam_info *cam_info,
+        const s3d_pos *model_world_pos,
+        const s3d_rotation *model_world_rotation,
+        s3d_matrix4 *out
+        ) {
+    s3d_matrix4 model;
+    spew3d_math3d_matrix_model(
+        model_world_pos, model_world_rotation, &model
+    );
+    spew3d_math3d_matrix_view(cam_info, out);
+    spew3d_math3d_matrix_multiply(out, &model, out);
+}
+
+S3DEXP int spew3d_math3d_sphere_outsideview(
+        s3d_transform3d_cam_info *cam_info,
+        const s3d_pos *center, s3dnum_t radius
+        ) {
+    if (center->x + radius <= 0)
+        return 1;  // Entirely behind the camera.
+    spew3d_math3d_transform3dscreenspace_prepare(cam_info);
+
+    // The side planes go through the camera at the edges of the
+    // field of view, so compare the distance to each of them:
+    double tan_hori = fabs(
+        (double)cam_info->cached_screen_plane_yleftoffset /
+        (double)cam_info->cached_screen_plane_x
+    );
+    double tan_verti = fabs(
+        (double)cam_info->cached_screen_plane_ztopoffset /
+        (double)cam_info->cached_screen_plane_x
+    );
+    double hori_dist = (
+        (fabs(center->y) - center->x * tan_hori) /
+        sqrt(1.0 + tan_hori * tan_hori)
+    );
+    double verti_dist = (
+        (fabs(center->z) - center->x * tan_verti) /
+        sqrt(1.0 + tan_verti * tan_verti)
+    );
+    return (hori_dist > radius || verti_dist > radius);
+}
+
+S3DEXP void spew3d_math3d_matrix_camerapos(
+        const s3d_matrix4 *modelview, s3d_pos *out
+        ) {
+    // The camera sits at the origin of camera space. For a pure
+    // rotation the inverse is the transpose, so undo the
+    // translation and then rotate back:
+    const s3dnum_t tx = modelview->m[0][3];
+    const s3dnum_t ty = modelview->m[1][3];
+    const s3dnum_t tz = modelview->m[2][3];
+    out->x = -(modelview->m[0][0] * tx + modelview->m[1][0] * ty +
+        modelview->m[2][0] * tz);
+    out->y = -(modelview->m[0][1] * tx + modelview->m[1][1] * ty +
+        modelview->m[2][1] * tz);
+    out->z = -(modelview->m[0][2] * tx + modelview->m[1][2] * ty +
+        modelview->m[2][2] * tz);
+}
+
+S3DEXP void spew3d_math3d_transform3d_matrix(
+        s3d_pos input_pos,
+        s3d_transform3d_cam_info *cam_info,
+        const s3d_matrix4 *modelview,
+        s3d_pos *out_pos, s3d_pos *out_unscaled_pos
+        ) {
+    spew3d_math3d_matrix_apply(modelview, &input_pos);
+    spew3d_math3d_transform3dscreenspace(
+        input_pos, cam_info, out_pos, out_unscaled_pos
+    );
+}
+
+typedef struct s3d_math3d_batchinfo {
+    double m[3][4];
+    double plane_x;
+    double pixel_ywidth, pixel_zwidth;
+    double half_w, h, half_h;
+} s3d_math3d_batchinfo;
+
+S3DHID static void _spew3d_math3d_transform_batch_getinfo(
+        const s3d_matrix4 *modelview,
+        s3d_transform3d_cam_info *cam_info,
+        s3d_math3d_batchinfo *out
+        ) {
+    spew3d_math3d_transform3dscreenspace_prepare(cam_info);
+    int row = 0;
+    while (row < 3) {
+        int col = 0;
+        while (col < 4) {
+            out->m[row][col] = modelview->m[row][col];
+            col++;
+        }
+        row++;
+    }
+    out->plane_x = cam_info->cached_screen_plane_x;
+    out->pixel_ywidth = cam_info->cached_screen_plane_pixel_ywidth;
+    out->pixel_zwidth = cam_info->cached_screen_plane_pixel_zwidth;
+    out->half_w = (double)cam_info->viewport_pixel_width / 2.0;
+    out->h = (double)cam_info->viewport_pixel_height;
+    out->half_h = (double)cam_info->viewport_pixel_height / 2.0;
+}
+
+// The scalar versions also handle the leftovers of the SIMD ones.
+// They must compute the same as spew3d_math3d_transform3d_matrix().
+
+S3DHID static void _spew3d_math3d_transform_batch_scalar_d(
+        const s3d_math3d_batchinfo *bi,
+        const double *in_x, const double *in_y, const double *in_z,
+        uint32_t start, uint32_t count,
+        double *out_x, double *out_y, double *out_z,
+        double *out_ux, double *out_uy, double *out_uz
+        ) {
+    uint32_t i = start;
+    while (i < count) {
+        double x = (bi->m[0][0] * in_x[i] + bi->m[0][1] * in_y[i] +
+            bi->m[0][2] * in_z[i] + bi->m[0][3]);
+        double y = (bi->m[1][0] * in_x[i] + bi->m[1][1] * in_y[i] +
+            bi->m[1][2] * in_z[i] + bi->m[1][3]);
+        double z = (bi->m[2][0] * in_x[i] + bi->m[2][1] * in_y[i] +
+            bi->m[2][2] * in_z[i] + bi->m[2][3]);
+        double dist = fmin(fabs(x / bi->plane_x), 9999);
+        out_x[i] = x;
+        out_y[i] = y / (bi->pixel_ywidth * dist) + bi->half_w;
+        out_z[i] = bi->h - (z / (bi->pixel_zwidth * dist) + bi->half_h);
+        if (out_ux != NULL) {
+            out_ux[i] = x;
+            out_uy[i] = y;
+            out_uz[i] = z;
+        }
+        i++;
+    }
+}
+
+S3DHID static void _spew3d_math3d_transform_batch_scalar_f(
+        const s3d_math3d_batchinfo *bi,
+        const float *in_x, const float *in_y, const float *in_z,
+        uint32_t start, uint32_t count,
+        float *out_x, float *out_y, float *out_z,
+        float *out_ux, float *out_uy, float *out_uz
+        ) {
+    uint32_t i = start;
+    while (i < count) {
+        float x = ((float)bi->m[0][0] * in_x[i] +
+            (float)bi->m[0][1] * in_y[i] +
+            (float)bi->m[0][2] * in_z[i] + (float)bi->m[0][3]);
+        float y = ((float)bi->m[1][0] * in_x[i] +
+            (float)bi->m[1][1] * in_y[i] +
+            (float)bi->m[1][2] * in_z[i] + (float)bi->m[1][3]);
+        float z = ((float)bi->m[2][0] * in_x[i] +
+            (float)bi->m[2][1] * in_y[i] +
+            (float)bi->m[2][2] * in_z[i] + (float)bi->m[2][3]);
+        float dist = fminf(fabsf(x / (float)bi->plane_x), 9999);
+        out_x[i] = x;
+        out_y[i] = y / ((float)bi->pixel_ywidth * dist) +
+            (float)bi->half_w;
+        out_z[i] = (float)bi->h - (z / (
+            (float)bi->pixel_zwidth * dist) + (float)bi->half_h);
+        if (out_ux != NULL) {
+            out_ux[i] = x;
+            out_uy[i] = y;
+            out_uz[i] = z;
+        }
+        i++;
+    }
+}
+
+#if defined(SPEW3D_MATH3D_SSE2)
+S3DHID static uint32_t _spew3d_math3d_transform_batch_sse2_d(
+        const s3d_math3d_batchinfo *bi,
+        const double *in_x, const double *in_y, const double *in_z,
+        uint32_t count,
+        double *out_x, double *out_y, double *out_z,
+        double *out_ux, double *out_uy, double *out_uz
+        ) {
+    __m128d m00 = _mm_set1_pd(bi->m[0][0]);
+    __m128d m01 = _mm_set1_pd(bi->m[0][1]);
+    __m128d m02 = _mm_set1_pd(bi->m[0][2]);
+    __m128d m03 = _mm_set1_pd(bi->m[0][3]);
+    __m128d m10 = _mm_set1_pd(bi->m[1][0]);
+    __m128d m11 = _mm_set1_pd(bi->m[1][1]);
+    __m128d m12 = _mm_set1_pd(bi->m[1][2]);
+    __m128d m13 = _mm_set1_pd(bi->m[1][3]);
+    __m128d m20 = _mm_set1_pd(bi->m[2][0]);
+    __m128d m21 = _mm_set1_pd(bi->m[2][1]);
+    __m128d m22 = _mm_set1_pd(bi->m[2][2]);
+    __m128d m23 = _mm_set1_pd(bi->m[2][3]);
+    __m128d plane_x = _mm_set1_pd(bi->plane_x);
+    __m128d max_dist = _mm_set1_pd(9999);
+    __m128d sign = _mm_set1_pd(-0.0);
+    __m128d ywidth = _mm_set1_pd(bi->pixel_ywidth);
+    __m128d zwidth = _mm_set1_pd(bi->pixel_zwidth);
+    __m128d half_w = _mm_set1_pd(bi->half_w);
+    __m128d h = _mm_set1_pd(bi->h);
+    __m128d half_h = _mm_set1_pd(bi->half_h);
+    uint32_t i = 0;
+    while (i + 2 <= count) {
+        __m128d ix = _mm_loadu_pd(&in_x[i]);
+        __m128d iy = _mm_loadu_pd(&in_y[i]);
+        __m128d iz = _mm_loadu_pd(&in_z[i]);
+        __m128d x = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(m00, ix), _mm_mul_pd(m01, iy)),
+            _mm_mul_pd(m02, iz)), m03);
+        __m128d y = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(m10, ix), _mm_mul_pd(m11, iy)),
+            _mm_mul_pd(m12, iz)), m13);
+        __m128d z = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(m20, ix), _mm_mul_pd(m21, iy)),
+            _mm_mul_pd(m22, iz)), m23);
+        // This picks 9999 for NaN like fmin() does:
+        __m128d dist = _mm_min_pd(
+            _mm_andnot_pd(sign, _mm_div_pd(x, plane_x)), max_dist
+        );
+        _mm_storeu_pd(&out_x[i], x);
+        _mm_storeu_pd(&out_y[i], _mm_add_pd(_mm_div_pd(
+            y, _mm_mul_pd(ywidth, dist)), half_w));
+        _mm_storeu_pd(&out_z[i], _mm_sub_pd(h, _mm_add_pd(
+            _mm_div_pd(z, _mm_mul_pd(zwidth, dist)), half_h)));
+        if (out_ux != NULL) {
+            _mm_storeu_pd(&out_ux[i], x);
+            _mm_storeu_pd(&out_uy[i], y);
+            _mm_storeu_pd(&out_uz[i], z);
+        }
+        i += 2;
+    }
+    return i;
+}
+
+S3DHID static uint32_t _spew3d_math3d_transform_batch_sse2_f(
+        const s3d_math3d_batchinfo *bi,
+        const float *in_x, const float *in_y, const float *in_z,
+        uint32_t count,
+        float *out_x, float *out_y, float *out_z,
+        float *out_ux, float *out_uy, float *out_uz
+        ) {
+    __m128 m00 = _mm_set1_ps((float)bi->m[0][0]);
+    __m128 m01 = _mm_set1_ps((float)bi->m[0][1]);
+    __m128 m02 = _mm_set1_ps((float)bi->m[0][2]);
+    __m128 m03 = _mm_set1_ps((float)bi->m[0][3]);
+    __m128 m10 = _mm_set1_ps((float)bi->m[1][0]);
+    __m128 m11 = _mm_set1_ps((float)bi->m[1][1]);
+    __m128 m12 = _mm_set1_ps((float)bi->m[1][2]);
+    __m128 m13 = _mm_set1_ps((float)bi->m[1][3]);
+    __m128 m20 = _mm_set1_ps((float)bi->m[2][0]);
+    __m128 m21 = _mm_set1_ps((float)bi->m[2][1]);
+    __m128 m22 = _mm_set1_ps((float)bi->m[2][2]);
+    __m128 m23 = _mm_set1_ps((float)bi->m[2][3]);
+    __m128 plane_x = _mm_set1_ps((float)bi->plane_x);
+    __m128 max_dist = _mm_set1_ps(9999);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 ywidth = _mm_set1_ps((float)bi->pixel_ywidth);
+    __m128 zwidth = _mm_set1_ps((float)bi->pixel_zwidth);
+    __m128 half_w = _mm_set1_ps((float)bi->half_w);
+    __m128 h = _mm_set1_ps((float)bi->h);
+    __m128 half_h = _mm_set1_ps((float)bi->half_h);
+    uint32_t i = 0;
+    while (i + 4 <= count) {
+        __m128 ix = _mm_loadu_ps(&in_x[i]);
+        __m128 iy = _mm_loadu_ps(&in_y[i]);
+        __m128 iz = _mm_loadu_ps(&in_z[i]);
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(m00, ix), _mm_mul_ps(m01, iy)),
+            _mm_mul_ps(m02, iz)), m03);
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(m10, ix), _mm_mul_ps(m11, iy)),
+            _mm_mul_ps(m12, iz)), m13);
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(m20, ix), _mm_mul_ps(m21, iy)),
+            _mm_mul_ps(m22, iz)), m23);
+        __m128 dist = _mm_min_ps(
+            _mm_andnot_ps(sign, _mm_div_ps(x, plane_x)), max_dist
+        );
+        _mm_storeu_ps(&out_x[i], x);
+        _mm_storeu_ps(&out_y[i], _mm_add_ps(_mm_div_ps(
+            y, _mm_mul_ps(ywidth, dist)), half_w));
+        _mm_storeu_ps(&out_z[i], _mm_sub_ps(h, _mm_add_ps(
+            _mm_div_ps(z, _mm_mul_ps(zwidth, dist)), half_h)));
+        if (out_ux != NULL) {
+            _mm_storeu_ps(&out_ux[i], x);
+            _mm_storeu_ps(&out_uy[i], y);
+            _mm_storeu_ps(&out_uz[i], z);
+        }
+        i += 4;
+    }
+    return i;
+}
+#endif  // SPEW3D_MATH3D_SSE2
+
+#if defined(SPEW3D_MATH3D_AVX)
+__attribute__((target("avx")))
+S3DHID static uint32_t _spew3d_math3d_transform_batch_avx_d(
+        const s3d_math3d_batchinfo *bi,
+        const double *in_x, const double *in_y, const double *in_z,
+        uint32_t count,
+        double *out_x, double *out_y, double *out_z,
+        double *out_ux, double *out_uy, double *out_uz
+        ) {
+    __m256d m00 = _mm256_set1_pd(bi->m[0][0]);
+    __m256d m01 = _mm256_set1_pd(bi->m[0][1]);
+    __m256d m02 = _mm256_set1_pd(bi->m[0][2]);
+    __m256d m03 = _mm256_set1_pd(bi->m[0][3]);
+    __m256d m10 = _mm256_set1_pd(bi->m[1][0]);
+    __m256d m11 = _mm256_set1_pd(bi->m[1][1]);
+    __m256d m12 = _mm256_set1_pd(bi->m[1][2]);
+    __m256d m13 = _mm256_set1_pd(bi->m[1][3]);
+    __m256d m20 = _mm256_set1_pd(bi->m[2][0]);
+    __m256d m21 = _mm256_set1_pd(bi->m[2][1]);
+    __m256d m22 = _mm256_set1_pd(bi->m[2][2]);
+    __m256d m23 = _mm256_set1_pd(bi->m[2][3]);
+    __m256d plane_x = _mm256_set1_pd(bi->plane_x);
+    __m256d max_dist = _mm256_set1_pd(9999);
+    __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d ywidth = _mm256_set1_pd(bi->pixel_ywidth);
+    __m256d zwidth = _mm256_set1_pd(bi->pixel_zwidth);
+    __m256d half_w = _mm256_set1_pd(bi->half_w);
+    __m256d h = _mm256_set1_pd(bi->h);
+    __m256d half_h = _mm256_set1_pd(bi->half_h);
+    uint32_t i = 0;
+    while (i + 4 <= count) {
+        __m256d ix = _mm256_loadu_pd(&in_x[i]);
+        __m256d iy = _mm256_loadu_pd(&in_y[i]);
+        __m256d iz = _mm256_loadu_pd(&in_z[i]);
+        __m256d x = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(m00, ix), _mm256_mul_pd(m01, iy)),
+            _mm256_mul_pd(m02, iz)), m03);
+        __m256d y = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(m10, ix), _mm256_mul_pd(m11, iy)),
+            _mm256_mul_pd(m12, iz)), m13);
+        __m256d z = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+            _mm256_mul_pd(m20, ix), _mm256_mul_pd(m21, iy)),
+            _mm256_mul_pd(m22, iz)), m23);
+        __m256d dist = _mm256_min_pd(_mm256_andnot_pd(
+            sign, _mm256_div_pd(x, plane_x)), max_dist
+        );
+        _mm256_storeu_pd(&out_x[i], x);
+        _mm256_storeu_pd(&out_y[i], _mm256_add_pd(_mm256_div_pd(
+            y, _mm256_mul_pd(ywidth, dist)), half_w));
+        _mm256_storeu_pd(&out_z[i], _mm256_sub_pd(h, _mm256_add_pd(
+            _mm256_div_pd(z, _mm256_mul_pd(zwidth, dist)), half_h)));
+        if (out_ux != NULL) {
+            _mm256_storeu_pd(&out_ux[i], x);
+            _mm256_storeu_pd(&out_uy[i], y);
+            _mm256_storeu_pd(&out_uz[i], z);
+        }
+        i += 4;
+    }
+    return i;
+}
+
+__attribute__((target("avx")))
+S3DHID static uint32_t _spew3d_math3d_transform_batch_avx_f(
+        const s3d_math3d_batchinfo *bi,
+        const float *in_x, const float *in_y, const float *in_z,
+        uint32_t count,
+        float *out_x, float *out_y, float *out_z,
+        float *out_ux, float *out_uy, float *out_uz
+        ) {
+    __m256 m00 = _mm256_set1_ps((float)bi->m[0][0]);
+    __m256 m01 = _mm256_set1_ps((float)bi->m[0][1]);
+    __m256 m02 = _mm256_set1_ps((float)bi->m[0][2]);
+    __m256 m03 = _mm256_set1_ps((float)bi->m[0][3]);
+    __m256 m10 = _mm256_set1_ps((float)bi->m[1][0]);
+    __m256 m11 = _mm256_set1_ps((float)bi->m[1][1]);
+    __m256 m12 = _mm256_set1_ps((float)bi->m[1][2]);
+    __m256 m13 = _mm256_set1_ps((float)bi->m[1][3]);
+    __m256 m20 = _mm256_set1_ps((float)bi->m[2][0]);
+    __m256 m21 = _mm256_set1_ps((float)bi->m[2][1]);
+    __m256 m22 = _mm256_set1_ps((float)bi->m[2][2]);
+    __m256 m23 = _mm256_set1_ps((float)bi->m[2][3]);
+    __m256 plane_x = _mm256_set1_ps((float)bi->plane_x);
+    __m256 max_dist = _mm256_set1_ps(9999);
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 ywidth = _mm256_set1_ps((float)bi->pixel_ywidth);
+    __m256 zwidth = _mm256_set1_ps((float)bi->pixel_zwidth);
+    __m256 half_w = _mm256_set1_ps((float)bi->half_w);
+    __m256 h = _mm256_set1_ps((float)bi->h);
+    __m256 half_h = _mm256_set1_ps((float)bi->half_h);
+    uint32_t i = 0;
+    while (i + 8 <= count) {
+        __m256 ix = _mm256_loadu_ps(&in_x[i]);
+        __m256 iy = _mm256_loadu_ps(&in_y[i]);
+        __m256 iz = _mm256_loadu_ps(&in_z[i]);
+        __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(m00, ix), _mm256_mul_ps(m01, iy)),
+            _mm256_mul_ps(m02, iz)), m03);
+        __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(m10, ix), _mm256_mul_ps(m11, iy)),
+            _mm256_mul_ps(m12, iz)), m13);
+        __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(m20, ix), _mm256_mul_ps(m21, iy)),
+            _mm256_mul_ps(m22, iz)), m23);
+        __m256 dist = _mm256_min_ps(_mm256_andnot_ps(
+            sign, _mm256_div_ps(x, plane_x)), max_dist
+        );
+        _mm256_storeu_ps(&out_x[i], x);
+        _mm256_storeu_ps(&out_y[i], _mm256_add_ps(_mm256_div_ps(
+            y, _mm256_mul_ps(ywidth, dist)), half_w));
+        _mm256_storeu_ps(&out_z[i], _mm256_sub_ps(h, _mm256_add_ps(
+            _mm256_div_ps(z, _mm256_mul_ps(zwidth, dist)), half_h)));
+        if (out_ux != NULL) {
+            _mm256_storeu_ps(&out_ux[i], x);
+            _mm256_storeu_ps(&out_uy[i], y);
+            _mm256_storeu_ps(&out_uz[i], z);
+        }
+        i += 8;
+    }
+    return i;
+}
+#endif  // SPEW3D_MATH3D_AVX
+
+#if defined(SPEW3D_MATH3D_NEON)
+S3DHID static uint32_t _spew3d_math3d_transform_batch_neon_d(
+        const s3d_math3d_batchinfo *bi,
+        const double *in_x, const double *in_y, const double *in_z,
+        uint32_t count,
+        double *out_x, double *out_y, double *out_z,
+        double *out_ux, double *out_uy, double *out_uz
+        ) {
+    float64x2_t max_dist = vdupq_n_f64(9999);
+    float64x2_t plane_x = vdupq_n_f64(bi->plane_x);
+    float64x2_t ywidth = vdupq_n_f64(bi->pixel_ywidth);
+    float64x2_t zwidth = vdupq_n_f64(bi->pixel_zwidth);
+    float64x2_t half_w = vdupq_n_f64(bi->half_w);
+    float64x2_t h = vdupq_n_f64(bi->h);
+    float64x2_t half_h = vdupq_n_f64(bi->half_h);
+    uint32_t i = 0;
+    while (i + 2 <= count) {
+        float64x2_t ix = vld1q_f64(&in_x[i]);
+        float64x2_t iy = vld1q_f64(&in_y[i]);
+        float64x2_t iz = vld1q_f64(&in_z[i]);
+        float64x2_t x = vaddq_f64(vaddq_f64(vaddq_f64(
+            vmulq_n_f64(ix, bi->m[0][0]), vmulq_n_f64(iy, bi->m[0][1])),
+            vmulq_n_f64(iz, bi->m[0][2])), vdupq_n_f64(bi->m[0][3]));
+        float64x2_t y = vaddq_f64(vaddq_f64(vaddq_f64(
+            vmulq_n_f64(ix, bi->m[1][0]), vmulq_n_f64(iy, bi->m[1][1])),
+            vmulq_n_f64(iz, bi->m[1][2])), vdupq_n_f64(bi->m[1][3]));
+        float64x2_t z = vaddq_f64(vaddq_f64(vaddq_f64(
+            vmulq_n_f64(ix, bi->m[2][0]), vmulq_n_f64(iy, bi->m[2][1])),
+            vmulq_n_f64(iz, bi->m[2][2])), vdupq_n_f64(bi->m[2][3]));
+        // vminnm picks the number over NaN, like fmin() does:
+        float64x2_t dist = vminnmq_f64(
+            vabsq_f64(vdivq_f64(x, plane_x)), max_dist
+        );
+        vst1q_f64(&out_x[i], x);
+        vst1q_f64(&out_y[i], vaddq_f64(vdivq_f64(
+            y, vmulq_f64(ywidth, dist)), half_w));
+        vst1q_f64(&out_z[i], vsubq_f64(h, vaddq_f64(
+            vdivq_f64(z, vmulq_f64(zwidth, dist)), half_h)));
+        if (out_ux != NULL) {
+            vst1q_f64(&out_ux[i], x);
+            vst1q_f64(&out_uy[i], y);
+            vst1q_f64(&out_uz[i], z);
+        }
+        i += 2;
+    }
+    return i;
+}
+
+S3DHID static uint32_t _spew3d_math3d_transform_batch_neon_f(
+        const s3d_math3d_batchinfo *bi,
+        const float *in_x, const float *in_y, const float *in_z,
+        uint32_t count,
+        float *out_x, float *out_y, float *out_z,
+        float *out_ux, float *out_uy, float *out_uz
+        ) {
+    float32x4_t max_dist = vdupq_n_f32(9999);
+    float32x4_t plane_x = vdupq_n_f32((float)bi->plane_x);
+    float32x4_t ywidth = vdupq_n_f32((float)bi->pixel_ywidth);
+    float32x4_t zwidth = vdupq_n_f32((float)bi->pixel_zwidth);
+    float32x4_t half_w = vdupq_n_f32((float)bi->half_w);
+    float32x4_t h = vdupq_n_f32((float)bi->h);
+    float32x4_t half_h = vdupq_n_f32((float)bi->half_h);
+    uint32_t i = 0;
+    while (i + 4 <= count) {
+        float32x4_t ix = vld1q_f32(&in_x[i]);
+        float32x4_t iy = vld1q_f32(&in_y[i]);
+        float32x4_t iz = vld1q_f32(&in_z[i]);
+        float32x4_t x = vaddq_f32(vaddq_f32(vaddq_f32(
+            vmulq_n_f32(ix, (float)bi->m[0][0]),
+            vmulq_n_f32(iy, (float)bi->m[0][1])),
+            vmulq_n_f32(iz, (float)bi->m[0][2])),
+            vdupq_n_f32((float)bi->m[0][3]));
+        float32x4_t y = vaddq_f32(vaddq_f32(vaddq_f32(
+            vmulq_n_f32(ix, (float)bi->m[1][0]),
+            vmulq_n_f32(iy, (float)bi->m[1][1])),
+            vmulq_n_f32(iz, (float)bi->m[1][2])),
+            vdupq_n_f32((float)bi->m[1][3]));
+        float32x4_t z = vaddq_f32(vaddq_f32(vaddq_f32(
+            vmulq_n_f32(ix, (float)bi->m[2][0]),
+            vmulq_n_f32(iy, (float)bi->m[2][1])),
+            vmulq_n_f32(iz, (float)bi->m[2][2])),
+            vdupq_n_f32((float)bi->m[2][3]));
+        float32x4_t dist = vminnmq_f32(
+            vabsq_f32(vdivq_f32(x, plane_x)), max_dist
+        );
+        vst1q_f32(&out_x[i], x);
+        vst1q_f32(&out_y[i], vaddq_f32(vdivq_f32(
+            y, vmulq_f32(ywidth, dist)), half_w));
+        vst1q_f32(&out_z[i], vsubq_f32(h, vaddq_f32(
+            vdivq_f32(z, vmulq_f32(zwidth, dist)), half_h)));
+        if (out_ux != NULL) {
+            vst1q_f32(&out_ux[i], x);
+            vst1q_f32(&out_uy[i], y);
+            vst1q_f32(&out_uz[i], z);
+        }
+        i += 4;
+    }
+    return i;
+}
+#endif  // SPEW3D_MATH3D_NEON
+
+#if defined(SPEW3D_MATH3D_AVX)
+S3DHID static int _spew3d_math3d_cpu_has_avx() {
+    #if defined(__AVX__)
+    return 1;  // We were compiled for it anyway.
+    #else
+    return __builtin_cpu_supports("avx");
+    #endif
+}
+#endif
+
+S3DEXP void spew3d_math3d_transform_batch_d(
+        const s3d_matrix4 *modelview,
+        s3d_transform3d_cam_info *cam_info,
+        const double *in_x, const double *in_y, const double *in_z,
+        uint32_t count,
+        double *out_x, double *out_y, double *out_z,
+        double *out_unscaled_x, double *out_unscaled_y,
+        double *out_unscaled_z
+        ) {
+    s3d_math3d_batchinfo bi;
+    _spew3d_math3d_transform_batch_getinfo(modelview, cam_info, &bi);
+    uint32_t done = 0;
+    #if defined(SPEW3D_MATH3D_AVX)
+    if (_spew3d_math3d_cpu_has_avx()) {
+        done = _spew3d_math3d_transform_batch_avx_d(
+            &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+            out_unscaled_x, out_unscaled_y, out_unscaled_z
+        );
+    } else {
+        done = _spew3d_math3d_transform_batch_sse2_d(
+            &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+            out_unscaled_x, out_unscaled_y, out_unscaled_z
+        );
+    }
+    #elif defined(SPEW3D_MATH3D_SSE2)
+    done = _spew3d_math3d_transform_batch_sse2_d(
+        &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+        out_unscaled_x, out_unscaled_y, out_unscaled_z
+    );
+    #elif defined(SPEW3D_MATH3D_NEON)
+    done = _spew3d_math3d_transform_batch_neon_d(
+        &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+        out_unscaled_x, out_unscaled_y, out_unscaled_z
+    );
+    #endif
+    _spew3d_math3d_transform_batch_scalar_d(
+        &bi, in_x, in_y, in_z, done, count, out_x, out_y, out_z,
+        out_unscaled_x, out_unscaled_y, out_unscaled_z
+    );
+}
+
+S3DEXP void spew3d_math3d_transform_batch_f(
+        const s3d_matrix4 *modelview,
+        s3d_transform3d_cam_info *cam_info,
+        const float *in_x, const float *in_y, const float *in_z,
+        uint32_t count,
+        float *out_x, float *out_y, float *out_z,
+        float *out_unscaled_x, float *out_unscaled_y,
+        float *out_unscaled_z
+        ) {
+    s3d_math3d_batchinfo bi;
+    _spew3d_math3d_transform_batch_getinfo(modelview, cam_info, &bi);
+    uint32_t done = 0;
+    #if defined(SPEW3D_MATH3D_AVX)
+    if (_spew3d_math3d_cpu_has_avx()) {
+        done = _spew3d_math3d_transform_batch_avx_f(
+            &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+            out_unscaled_x, out_unscaled_y, out_unscaled_z
+        );
+    } else {
+        done = _spew3d_math3d_transform_batch_sse2_f(
+            &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+            out_unscaled_x, out_unscaled_y, out_unscaled_z
+        );
+    }
+    #elif defined(SPEW3D_MATH3D_SSE2)
+    done = _spew3d_math3d_transform_batch_sse2_f(
+        &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+        out_unscaled_x, out_unscaled_y, out_unscaled_z
+    );
+    #elif defined(SPEW3D_MATH3D_NEON)
+    done = _spew3d_math3d_transform_batch_neon_f(
+        &bi, in_x, in_y, in_z, count, out_x, out_y, out_z,
+        out_unscaled_x, out_unscaled_y, out_unscaled_z
+    );
+    #endif
+    _spew3d_math3d_transform_batch_scalar_f(
+        &bi, in_x, in_y, in_z, done, count, out_x, out_y, out_z,
+        out_unscaled_x, out_unscaled_y, out_unscaled_z
+    );
+}
+
 S3DEXP void spew3d_math3d_rotate(
         s3d_pos *p, s3d_rotation *r
         ) {
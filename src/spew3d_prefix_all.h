@@ -102,11 +102,16 @@ license, see accompanied LICENSE.md.
 #endif
 
 // Number types:
+#if defined(SPEW3D_OPTION_FLOAT_MATH)
+typedef float s3dnum_t;
+#else
 typedef double s3dnum_t;
+#endif
+// Works for both float and double, since floats are promoted:
+#define S3D_ABS(x) (fabs(x))
 #ifndef S3D_METER
 #define S3D_METER (1.0)
 #endif
-#define S3D_ABS(x) (fabs(x))
 #ifndef S3D_BIGNUM_MAXFRACTIONDIGITS
 #define S3D_BIGNUM_MAXFRACTIONDIGITS 200
 #endif
@@ -29,7 +29,9 @@ license, see accompanied LICENSE.md.
     SPEW3D_IMPLEMENTATION != 0
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -52,6 +54,22 @@ s3d_resourceload_job **job_queue = NULL;
 uint64_t job_queue_len = 0;
 uint64_t job_queue_alloc = 0;
 s3d_threadinfo *_imgloader_process_thread = NULL;
+char *_spew3d_resourceload_imgcache_folder = NULL;
+
+// Header of a decoded image cache file. The pixels follow right after
+// it, then the mip chain, so the file can also be mapped directly.
+#define SPEW3D_IMGCACHE_MAGIC "S3DIMGC1"
+#define SPEW3D_IMGCACHE_BYTEORDER 0x01020304U
+#define SPEW3D_IMGCACHE_MAX_SIZE 32768
+typedef struct s3d_resourceload_imgcache_header {
+    char magic[8];
+    uint32_t byteorder;  // To reject caches copied between machines.
+    uint32_t w, h;
+    uint32_t mip_count;
+    uint64_t source_len;
+    uint64_t source_hash;
+    uint8_t _padding[24];  // Keeps the pixels 64 byte aligned.
+} s3d_resourceload_imgcache_header;
 
 S3DHID __attribute__((constructor)) static void _createMutex() {
     _spew3d_resourceload_mutex = mutex_Create();
@@ -68,12 +86,175 @@ S3DHID static void _s3d_resourceload_FreeJob(
         return;
     if (job->rltype == RLTYPE_IMAGE) {
         free(job->result.resource_image.pixels);
+        free(job->result.resource_image.mip_pixels);
     }
     if (job->path)
         free(job->path);
     free(job);
 }
 
+S3DEXP int s3d_resourceload_SetImageCacheFolder(
+        const char *path
+        ) {
+    char *pathdup = NULL;
+    if (path != NULL) {
+        int exists = 0;
+        if (!spew3d_fs_TargetExists(path, &exists))
+            return 0;
+        if (!exists && !spew3d_fs_CreateDirectory(path))
+            return 0;
+        pathdup = strdup(path);
+        if (!pathdup)
+            return 0;
+    }
+    mutex_Lock(_spew3d_resourceload_mutex);
+    free(_spew3d_resourceload_imgcache_folder);
+    _spew3d_resourceload_imgcache_folder = pathdup;
+    mutex_Release(_spew3d_resourceload_mutex);
+    return 1;
+}
+
+S3DHID static char *_s3d_resourceload_ImgCachePath(
+        const char *compressed, uint64_t compressedlen,
+        uint64_t *out_hash
+        ) {
+    mutex_Lock(_spew3d_resourceload_mutex);
+    if (_spew3d_resourceload_imgcache_folder == NULL) {
+        mutex_Release(_spew3d_resourceload_mutex);
+        return NULL;
+    }
+    char *folder = strdup(_spew3d_resourceload_imgcache_folder);
+    mutex_Release(_spew3d_resourceload_mutex);
+    if (!folder)
+        return NULL;
+
+    // Key by file contents, since archives carry no usable
+    // modification times and the same image may sit at many paths:
+    const uint8_t key[16] = {0};
+    uint8_t hashbytes[8];
+    siphash((const uint8_t *)compressed, compressedlen,
+        key, hashbytes, sizeof(hashbytes));
+    uint64_t hash;
+    memcpy(&hash, hashbytes, sizeof(hash));
+    char name[64];
+    snprintf(name, sizeof(name), "%016" PRIx64 "_%" PRIu64 ".s3dimg",
+        hash, compressedlen);
+    char *result = spew3d_fs_Join(folder, name);
+    free(folder);
+    *out_hash = hash;
+    return result;
+}
+
+S3DHID static int _s3d_resourceload_ImgCacheRead(
+        const char *cachepath, uint64_t source_len,
+        uint64_t source_hash, unsigned char **out_pixels,
+        int *out_w, int *out_h,
+        char **out_mip_pixels, uint8_t *out_mip_count
+        ) {
+    int err = 0;
+    FILE *f = spew3d_fs_OpenFromPath(cachepath, "rb", &err);
+    if (!f)
+        return 0;
+    s3d_resourceload_imgcache_header header;
+    if (fread(&header, 1, sizeof(header), f) != sizeof(header) ||
+            memcmp(header.magic, SPEW3D_IMGCACHE_MAGIC, 8) != 0 ||
+            header.byteorder != SPEW3D_IMGCACHE_BYTEORDER ||
+            header.w == 0 || header.h == 0 ||
+            header.w > SPEW3D_IMGCACHE_MAX_SIZE ||
+            header.h > SPEW3D_IMGCACHE_MAX_SIZE ||
+            header.mip_count > SPEW3D_TEXTURE_MAX_MIPS ||
+            header.source_len != source_len ||
+            header.source_hash != source_hash) {
+        fclose(f);
+        return 0;
+    }
+    uint64_t pixelbytes = (uint64_t)header.w * (uint64_t)header.h * 4;
+    uint64_t mipbytes = 0;
+    if (header.mip_count > 0)
+        mipbytes = _internal_spew3d_texture_MipOffset(
+            header.w, header.h, header.mip_count + 1, NULL, NULL
+        );
+    unsigned char *pixels = malloc(pixelbytes);
+    char *mip_pixels = (mipbytes > 0 ? malloc(mipbytes) : NULL);
+    if (!pixels || (mipbytes > 0 && !mip_pixels) ||
+            fread(pixels, 1, pixelbytes, f) != pixelbytes ||
+            (mipbytes > 0 && fread(mip_pixels, 1, mipbytes, f) !=
+                mipbytes)) {
+        free(pixels);
+        free(mip_pixels);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+    *out_pixels = pixels;
+    *out_w = header.w;
+    *out_h = header.h;
+    *out_mip_pixels = mip_pixels;
+    *out_mip_count = header.mip_count;
+    return 1;
+}
+
+S3DHID static void _s3d_resourceload_ImgCacheWrite(
+        const char *cachepath, uint64_t source_len,
+        uint64_t source_hash, const unsigned char *pixels,
+        int w, int h, const char *mip_pixels, uint8_t mip_count
+        ) {
+    if (w <= 0 || h <= 0 || w > SPEW3D_IMGCACHE_MAX_SIZE ||
+            h > SPEW3D_IMGCACHE_MAX_SIZE)
+        return;
+
+    // Write to a temporary name first, so that other processes
+    // never see a half written cache file:
+    uint64_t suffix = 0;
+    spew3d_secrandom_GetBytes((char *)&suffix, sizeof(suffix));
+    uint64_t tmppathlen = strlen(cachepath) + 32;
+    char *tmppath = malloc(tmppathlen);
+    if (!tmppath)
+        return;
+    snprintf(tmppath, tmppathlen, "%s.%016" PRIx64 ".tmp",
+        cachepath, suffix);
+    int err = 0;
+    FILE *f = spew3d_fs_OpenFromPath(tmppath, "wb", &err);
+    if (!f) {
+        free(tmppath);
+        return;
+    }
+    s3d_resourceload_imgcache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SPEW3D_IMGCACHE_MAGIC, 8);
+    header.byteorder = SPEW3D_IMGCACHE_BYTEORDER;
+    header.w = w;
+    header.h = h;
+    header.mip_count = mip_count;
+    header.source_len = source_len;
+    header.source_hash = source_hash;
+    uint64_t pixelbytes = (uint64_t)w * (uint64_t)h * 4;
+    uint64_t mipbytes = 0;
+    if (mip_count > 0)
+        mipbytes = _internal_spew3d_texture_MipOffset(
+            w, h, mip_count + 1, NULL, NULL
+        );
+    int success = (
+        fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+        fwrite(pixels, 1, pixelbytes, f) == pixelbytes &&
+        (mipbytes == 0 ||
+            fwrite(mip_pixels, 1, mipbytes, f) == mipbytes)
+    );
+    if (fclose(f) != 0)
+        success = 0;
+    if (!success || rename(tmppath, cachepath) != 0) {
+        #if defined(DEBUG_SPEW3D_RESOURCELOAD)
+        fprintf(stderr,
+            "spew3d_resourceload.c: debug: "
+            "_s3d_resourceload_ImgCacheWrite(): "
+            "failed to write cache file: \"%s\"\n",
+            cachepath);
+        #endif
+        spew3d_fs_RemoveFile(tmppath, &err);
+    }
+    free(tmppath);
+}
+
 S3DHID static int s3d_resourceload_ProcessJob() {
     mutex_Lock(_spew3d_resourceload_mutex);
     if (job_queue_len == 0) {
@@ -143,13 +324,47 @@ S3DHID static int s3d_resourceload_ProcessJob() {
         int w = 0;
         int h = 0;
         int n = 0;
-        unsigned char *data32 = stbi_load_from_memory(
-            (unsigned char *)imgcompressed,
-            imgcompressedlen, &w, &h, &n, 4
+        unsigned char *data32 = NULL;
+        char *mip_pixels = NULL;
+        uint8_t mip_count = 0;
+        uint64_t cachehash = 0;
+        char *cachepath = _s3d_resourceload_ImgCachePath(
+            imgcompressed, imgcompressedlen, &cachehash
         );
-        free(imgcompressed);
+        if (cachepath != NULL && _s3d_resourceload_ImgCacheRead(
+                cachepath, imgcompressedlen, cachehash,
+                &data32, &w, &h, &mip_pixels, &mip_count)) {
+            #if defined(DEBUG_SPEW3D_RESOURCELOAD)
+            fprintf(stderr,
+                "spew3d_resourceload.c: debug: "
+                "s3d_resourceload_ProcessJob(): "
+                "using decoded cache for texture: %s [job %p]\n",
+                job->path, job);
+            #endif
+            free(imgcompressed);
+        } else {
+            data32 = stbi_load_from_memory(
+                (unsigned char *)imgcompressed,
+                imgcompressedlen, &w, &h, &n, 4
+            );
+            free(imgcompressed);
+            if (data32 != NULL &&
+                    !_internal_spew3d_texture_BuildMipChain(
+                    (char *)data32, w, h, &mip_pixels, &mip_count)) {
+                // Out of memory, so just go without the smaller levels.
+                mip_pixels = NULL;
+                mip_count = 0;
+            }
+            if (data32 != NULL && cachepath != NULL)
+                _s3d_resourceload_ImgCacheWrite(
+                    cachepath, imgcompressedlen, cachehash,
+                    data32, w, h, mip_pixels, mip_count
+                );
+        }
+        free(cachepath);
         mutex_Lock(_spew3d_resourceload_mutex);
         if (job->markeddeleted) {
+            free(mip_pixels);
             if (data32) free(data32);
             _s3d_resourceload_FreeJob(job);
             mutex_Release(_spew3d_resourceload_mutex);
@@ -176,6 +391,8 @@ S3DHID static int s3d_resourceload_ProcessJob() {
         job->result.resource_image.h = h;
         job->fserror = FSERR_SUCCESS;
         job->result.resource_image.pixels = data32;
+        job->result.resource_image.mip_pixels = mip_pixels;
+        job->result.resource_image.mip_count = mip_count;
         job->hasfinished = 1;
         #if defined(DEBUG_SPEW3D_RESOURCELOAD)
         fprintf(stderr,
@@ -45,10 +45,24 @@ license, see accompanied LICENSE.md.
 
 typedef struct s3d_spatialstore3d s3d_spatialstore3d;
 
+typedef struct s3d_scene3d_snapshot {
+    s3d_scene3d_snapshotentry *entries;
+    uint32_t count, alloc;
+} s3d_scene3d_snapshot;
+
 typedef struct s3d_scene3d {
     s3d_mutex *m;
     s3d_spatialstore3d *store;
     s3d_scenecolorinfo coloring;
+
+    // Triple buffered snapshots: the latest published one, the one
+    // being rendered, and a third one to write the next into.
+    s3d_mutex *snapshot_m;
+    s3d_scene3d_snapshot snapshot[3];
+    int snapshot_latest, snapshot_reading;
+    int snapshot_readers;
+    s3d_obj3d **snapshot_collect_buf;
+    uint32_t snapshot_collect_alloc;
 } s3d_scene3d;
 
 typedef struct s3d_obj3d {
@@ -104,8 +118,11 @@ S3DEXP s3d_scene3d *spew3d_scene3d_New(
     sc->coloring.ambient_emit.red = 1.0;
     sc->coloring.ambient_emit.blue = 1.0;
     sc->coloring.ambient_emit.green = 1.0;
+    sc->snapshot_latest = -1;
+    sc->snapshot_reading = -1;
     sc->m = mutex_Create();
-    if (!sc->m) {
+    sc->snapshot_m = mutex_Create();
+    if (!sc->m || !sc->snapshot_m) {
         spew3d_scene3d_Destroy(sc);
         return NULL;
     }
@@ -229,9 +246,118 @@ S3DEXP void spew3d_scene3d_Destroy(s3d_scene3d *sc) {
         sc->store->Destroy(sc->store);
     if (sc->m)
         mutex_Destroy(sc->m);
+    if (sc->snapshot_m)
+        mutex_Destroy(sc->snapshot_m);
+    int k = 0;
+    while (k < 3) {
+        free(sc->snapshot[k].entries);
+        k++;
+    }
+    free(sc->snapshot_collect_buf);
     free(sc);
 }
 
+static void _spew3d_scene3d_ForgetObjInSnapshots_nolock(
+        s3d_scene3d *sc, s3d_obj3d *obj
+        ) {
+    // Snapshots are only ever written with the scene locked, which
+    // the caller holds, so this can't race a publish. The renderer
+    // runs on the main thread just like the actual deletion.
+    mutex_Lock(sc->snapshot_m);
+    int k = 0;
+    while (k < 3) {
+        uint32_t i = 0;
+        while (i < sc->snapshot[k].count) {
+            if (sc->snapshot[k].entries[i].obj == obj)
+                sc->snapshot[k].entries[i].obj = NULL;
+            i++;
+        }
+        k++;
+    }
+    mutex_Release(sc->snapshot_m);
+}
+
+S3DEXP int spew3d_scene3d_PublishSnapshot(s3d_scene3d *sc) {
+    // Pick a buffer that is neither the latest nor being rendered:
+    mutex_Lock(sc->snapshot_m);
+    int target = 0;
+    while (target == sc->snapshot_latest ||
+            (sc->snapshot_readers > 0 &&
+            target == sc->snapshot_reading))
+        target++;
+    assert(target < 3);
+    mutex_Release(sc->snapshot_m);
+
+    // Hold the scene lock while collecting, since objects may
+    // otherwise get freed before we copy them below:
+    mutex_Lock(sc->m);
+    uint32_t count = 0;
+    if (!sc->store->IterateAll(
+            sc->store, NULL, 0, &sc->snapshot_collect_buf,
+            &sc->snapshot_collect_alloc, &count
+            )) {
+        mutex_Release(sc->m);
+        return 0;
+    }
+    s3d_scene3d_snapshot *snap = &sc->snapshot[target];
+    if (count > snap->alloc) {
+        s3d_scene3d_snapshotentry *new_entries = realloc(
+            snap->entries, sizeof(*new_entries) * count
+        );
+        if (!new_entries) {
+            mutex_Release(sc->m);
+            return 0;
+        }
+        snap->entries = new_entries;
+        snap->alloc = count;
+    }
+    snap->count = 0;
+    uint32_t i = 0;
+    while (i < count) {
+        s3d_obj3d *obj = sc->snapshot_collect_buf[i];
+        i++;
+        if (obj->wasdeleted)
+            continue;
+        s3d_scene3d_snapshotentry *entry = &snap->entries[snap->count];
+        entry->obj = obj;
+        entry->kind = obj->kind;
+        entry->pos = obj->pos;
+        entry->rot = obj->rot;
+        snap->count++;
+    }
+    mutex_Release(sc->m);
+
+    mutex_Lock(sc->snapshot_m);
+    sc->snapshot_latest = target;
+    mutex_Release(sc->snapshot_m);
+    return 1;
+}
+
+S3DHID int _spew3d_scene3d_AcquireSnapshot(
+        s3d_scene3d *sc, s3d_scene3d_snapshotentry **out_entries,
+        uint32_t *out_count
+        ) {
+    mutex_Lock(sc->snapshot_m);
+    if (sc->snapshot_latest < 0) {
+        mutex_Release(sc->snapshot_m);
+        return 0;
+    }
+    if (sc->snapshot_readers == 0)
+        sc->snapshot_reading = sc->snapshot_latest;
+    sc->snapshot_readers++;
+    *out_entries = sc->snapshot[sc->snapshot_reading].entries;
+    *out_count = sc->snapshot[sc->snapshot_reading].count;
+    mutex_Release(sc->snapshot_m);
+    return 1;
+}
+
+S3DHID void _spew3d_scene3d_ReleaseSnapshot(s3d_scene3d *sc) {
+    mutex_Lock(sc->snapshot_m);
+    assert(sc->snapshot_readers > 0);
+    sc->snapshot_readers--;
+    mutex_Release(sc->snapshot_m);
+}
+
 S3DEXP void spew3d_obj3d_Destroy(s3d_obj3d *obj) {
     if (!obj)
         return;
@@ -256,6 +382,7 @@ S3DEXP void _spew3d_obj3d_DestroyActually(s3d_obj3d *obj) {
         s = obj->owner;
         mutex_Lock(s->m);
         s->store->Remove(s->store, obj);
+        _spew3d_scene3d_ForgetObjInSnapshots_nolock(s, obj);
     }
     if (obj->extra) {
         if (obj->extra_destroy_cb) {
@@ -44,11 +44,23 @@ S3DHID int _spew3d_scene3d_GetKind_nolock(s3d_obj3d *obj);
 S3DHID void _spew3d_scene3d_SetKind_nolock();
 S3DHID s3d_window *_spew3d_window_GetByIDLocked(uint32_t id);
 
+typedef struct spew3d_meshobjlod {
+    s3d_geometry *geom;
+    double min_distance;
+    int owned;
+} spew3d_meshobjlod;
+
 typedef struct spew3d_meshobjdata {
     int owning_meshes;
     s3d_geometry *first_geom;
     s3d_geometry **extra_geoms;
     uint32_t extra_geoms_count;
+
+    // Lower detail versions of first_geom, sorted by min_distance
+    // and ended by an entry with geom set to NULL. Cameras drawing
+    // from a snapshot read this without the lock, so it's never
+    // changed in place, only replaced as a whole:
+    spew3d_meshobjlod *lods;
 } spew3d_meshobjdata;
 
 S3DHID void spew3d_scene3d_MeshObjFreeData(
@@ -65,6 +77,13 @@ S3DHID void spew3d_scene3d_MeshObjFreeData(
             i++;
         }
     }
+    uint32_t i = 0;
+    while (mdata->lods != NULL && mdata->lods[i].geom != NULL) {
+        if (mdata->lods[i].owned)
+            spew3d_geometry_Destroy(mdata->lods[i].geom);
+        i++;
+    }
+    free(mdata->lods);
     free(mdata);
 }
 
@@ -81,6 +100,154 @@ S3DHID void _spew3d_scene3d_GetObjMeshes_nolock(
     *extra_meshes_count = mdata->extra_geoms_count;
 }
 
+S3DHID s3d_geometry *_spew3d_scene3d_GetObjMeshForDistance_nolock(
+        s3d_obj3d *obj, double distance
+        ) {
+    spew3d_meshobjdata *mdata = (
+        (spew3d_meshobjdata *)obj->extra
+    );
+    s3d_geometry *result = mdata->first_geom;
+    spew3d_meshobjlod *lods = __atomic_load_n(
+        &mdata->lods, __ATOMIC_ACQUIRE
+    );
+    if (lods == NULL)
+        return result;
+    uint32_t i = 0;
+    while (lods[i].geom != NULL &&
+            lods[i].min_distance <= distance) {
+        result = lods[i].geom;
+        i++;
+    }
+    return result;
+}
+
+S3DHID int _spew3d_obj3d_AddMeshLODs_nolock(
+        s3d_obj3d *obj, const spew3d_meshobjlod *add,
+        uint32_t add_count
+        ) {
+    if (_spew3d_scene3d_GetKind_nolock(obj) != OBJ3D_MESH)
+        return 0;
+    if (add_count == 0)
+        return 1;
+    spew3d_meshobjdata *mdata = (
+        (spew3d_meshobjdata *)obj->extra
+    );
+    uint32_t old_count = 0;
+    while (mdata->lods != NULL && mdata->lods[old_count].geom != NULL)
+        old_count++;
+
+    // Build the new list on the side, so cameras never see it
+    // half done:
+    spew3d_meshobjlod *newlods = malloc(
+        sizeof(*newlods) * (old_count + add_count + 1)
+    );
+    if (!newlods)
+        return 0;
+    if (old_count > 0)
+        memcpy(newlods, mdata->lods, sizeof(*newlods) * old_count);
+    uint32_t count = old_count;
+    uint32_t k = 0;
+    while (k < add_count) {
+        uint32_t insert_at = count;
+        while (insert_at > 0 && newlods[insert_at - 1].min_distance >
+                add[k].min_distance) {
+            newlods[insert_at] = newlods[insert_at - 1];
+            insert_at--;
+        }
+        newlods[insert_at] = add[k];
+        count++;
+        k++;
+    }
+    memset(&newlods[count], 0, sizeof(*newlods));
+
+    // A camera may still be going through the old list, but that
+    // only happens on the main thread, so free it from there:
+    spew3d_meshobjlod *oldlods = mdata->lods;
+    __atomic_store_n(&mdata->lods, newlods, __ATOMIC_RELEASE);
+    if (oldlods != NULL)
+        spew3d_Deletion_Queue(DELETION_MEMORY, oldlods);
+    return 1;
+}
+
+S3DEXP int spew3d_obj3d_AddMeshLOD(
+        s3d_obj3d *obj, s3d_geometry *geom,
+        double min_distance, int object_owns_mesh
+        ) {
+    assert(obj != NULL && geom != NULL);
+    spew3d_obj3d_LockAccess(obj);
+    spew3d_meshobjlod lod = {0};
+    lod.geom = geom;
+    lod.min_distance = min_distance;
+    lod.owned = (object_owns_mesh != 0);
+    int result = _spew3d_obj3d_AddMeshLODs_nolock(obj, &lod, 1);
+    spew3d_obj3d_ReleaseAccess(obj);
+    return result;
+}
+
+S3DEXP int spew3d_obj3d_GenerateMeshLODs(
+        s3d_obj3d *obj, int level_count, double first_distance
+        ) {
+    assert(obj != NULL);
+    spew3d_obj3d_LockAccess(obj);
+    if (_spew3d_scene3d_GetKind_nolock(obj) != OBJ3D_MESH) {
+        spew3d_obj3d_ReleaseAccess(obj);
+        return 0;
+    }
+    s3d_geometry *source = (
+        ((spew3d_meshobjdata *)obj->extra)->first_geom
+    );
+    spew3d_obj3d_ReleaseAccess(obj);
+    if (level_count <= 0)
+        return 1;
+
+    // Simplifying is slow, so do it without holding the scene lock:
+    spew3d_meshobjlod *lods = malloc(sizeof(*lods) * level_count);
+    if (!lods)
+        return 0;
+    int lods_count = 0;
+    double distance = first_distance;
+    while (lods_count < level_count && source != NULL &&
+            source->polygon_count > 2) {
+        // Every level simplifies the previous one, which is a lot
+        // quicker than always starting from the full mesh:
+        s3d_geometry *lod = spew3d_geometry_Simplify(
+            source, source->polygon_count / 2
+        );
+        if (!lod)
+            goto failure;
+        if (lod->polygon_count >= source->polygon_count) {
+            // Nothing left that can be removed.
+            spew3d_geometry_Destroy(lod);
+            break;
+        }
+        lods[lods_count].geom = lod;
+        lods[lods_count].min_distance = distance;
+        lods[lods_count].owned = 1;
+        lods_count++;
+        distance *= 2.0;
+        source = lod;
+    }
+
+    // Add all levels at once, so cameras see either none or all:
+    spew3d_obj3d_LockAccess(obj);
+    if (!_spew3d_obj3d_AddMeshLODs_nolock(obj, lods, lods_count)) {
+        spew3d_obj3d_ReleaseAccess(obj);
+        goto failure;
+    }
+    spew3d_obj3d_ReleaseAccess(obj);
+    free(lods);
+    return 1;
+
+    failure: ;
+    int k = 0;
+    while (k < lods_count) {
+        spew3d_geometry_Destroy(lods[k].geom);
+        k++;
+    }
+    free(lods);
+    return 0;
+}
+
 S3DEXP s3d_obj3d *spew3d_scene3d_AddMeshObj(
         s3d_scene3d *sc, s3d_geometry *geom,
         int object_owns_meshes
@@ -0,0 +1,220 @@
+/* Copyright (c) 2020-2024, ellie/@ell1e & Spew3D Team (see AUTHORS.md).
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+Alternatively, at your option, this file is offered under the Apache 2
+license, see accompanied LICENSE.md.
+*/
+
+
+#if defined(SPEW3D_IMPLEMENTATION) && \
+    SPEW3D_IMPLEMENTATION != 0
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct s3d_spritebatch {
+    s3d_spritebatch_entry *entries;
+    uint32_t count, alloc;
+} s3d_spritebatch;
+
+// Entry buffers the main thread is done drawing, which the next
+// batch to be drawn continues with instead of allocating anew:
+#define SPEW3D_SPRITEBATCH_MAX_RECYCLED 4
+typedef struct s3d_spritebatch_recycled {
+    s3d_spritebatch_entry *entries;
+    uint32_t alloc;
+} s3d_spritebatch_recycled;
+static s3d_spritebatch_recycled _spew3d_spritebatch_recycled[
+    SPEW3D_SPRITEBATCH_MAX_RECYCLED
+];
+static uint32_t _spew3d_spritebatch_recycled_count = 0;
+static s3d_mutex *_spew3d_spritebatch_recycle_mutex = NULL;
+
+S3DHID __attribute__((constructor)) static void
+        _spew3d_spritebatch_mutex_init() {
+    _spew3d_spritebatch_recycle_mutex = mutex_Create();
+    if (!_spew3d_spritebatch_recycle_mutex) {
+        fprintf(stderr, "spew3d_spritebatch.c: error: FATAL, "
+            "failed to create _spew3d_spritebatch_recycle_mutex\n");
+        _exit(1);
+    }
+}
+
+S3DHID void _spew3d_spritebatch_RecycleEntries(
+        s3d_spritebatch_entry *entries, uint32_t alloc
+        ) {
+    if (!entries)
+        return;
+    mutex_Lock(_spew3d_spritebatch_recycle_mutex);
+    if (_spew3d_spritebatch_recycled_count <
+            SPEW3D_SPRITEBATCH_MAX_RECYCLED) {
+        s3d_spritebatch_recycled *slot = &_spew3d_spritebatch_recycled[
+            _spew3d_spritebatch_recycled_count
+        ];
+        slot->entries = entries;
+        slot->alloc = alloc;
+        _spew3d_spritebatch_recycled_count++;
+        entries = NULL;
+    }
+    mutex_Release(_spew3d_spritebatch_recycle_mutex);
+    free(entries);
+}
+
+S3DEXP s3d_spritebatch *spew3d_spritebatch_New() {
+    s3d_spritebatch *batch = malloc(sizeof(*batch));
+    if (!batch)
+        return NULL;
+    memset(batch, 0, sizeof(*batch));
+    return batch;
+}
+
+S3DEXP int spew3d_spritebatch_AddRegion(
+        s3d_spritebatch *batch,
+        s3d_texture_t tid,
+        int32_t x, int32_t y, int centered,
+        s3dnum_t scale, s3dnum_t angle,
+        s3dnum_t tint_red, s3dnum_t tint_green, s3dnum_t tint_blue,
+        s3dnum_t transparency,
+        int withalphachannel,
+        s3dnum_t uv_x, s3dnum_t uv_y, s3dnum_t uv_w, s3dnum_t uv_h
+        ) {
+    if (tid == 0 || transparency < (1.0 / 256.0) * 0.5)
+        return 1;
+    if (batch->count + 1 > batch->alloc) {
+        uint32_t new_alloc = batch->alloc * 2;
+        if (new_alloc < 64)
+            new_alloc = 64;
+        s3d_spritebatch_entry *new_entries = realloc(
+            batch->entries, sizeof(*new_entries) * new_alloc
+        );
+        if (!new_entries)
+            return 0;
+        batch->entries = new_entries;
+        batch->alloc = new_alloc;
+    }
+    s3d_spritebatch_entry *entry = &batch->entries[batch->count];
+    batch->count++;
+    entry->tid = tid;
+    entry->pixel_x = x;
+    entry->pixel_y = y;
+    entry->centered = (centered != 0);
+    entry->scale = scale;
+    entry->angle = angle;
+    entry->tint_red = tint_red;
+    entry->tint_green = tint_green;
+    entry->tint_blue = tint_blue;
+    entry->transparency = transparency;
+    entry->withalphachannel = (withalphachannel != 0);
+    entry->uv_x = uv_x;
+    entry->uv_y = uv_y;
+    entry->uv_w = uv_w;
+    entry->uv_h = uv_h;
+    return 1;
+}
+
+S3DEXP int spew3d_spritebatch_Add(
+        s3d_spritebatch *batch,
+        s3d_texture_t tid,
+        int32_t x, int32_t y, int centered,
+        s3dnum_t scale, s3dnum_t angle,
+        s3dnum_t tint_red, s3dnum_t tint_green, s3dnum_t tint_blue,
+        s3dnum_t transparency,
+        int withalphachannel
+        ) {
+    return spew3d_spritebatch_AddRegion(
+        batch, tid, x, y, centered, scale, angle,
+        tint_red, tint_green, tint_blue, transparency,
+        withalphachannel, 0, 0, 1, 1
+    );
+}
+
+S3DEXP int spew3d_spritebatch_DrawToWindow(
+        s3d_spritebatch *batch, s3d_window *win
+        ) {
+    if (batch->count == 0)
+        return 1;
+
+    // Get small textures packed into atlas pages early, so that
+    // sprites using different ones can share one draw call:
+    s3d_texture_t last_tid = 0;
+    uint32_t i = 0;
+    while (i < batch->count) {
+        if (batch->entries[i].tid != last_tid) {
+            last_tid = batch->entries[i].tid;
+            s3d_texture_t page;
+            s3d_point offset, scale;
+            spew3d_texture_GetAtlasRegion(
+                last_tid, &page, &offset, &scale
+            );
+        }
+        i++;
+    }
+
+    // The event takes over the entries, and recycles them when done:
+    s3d_event e = {0};
+    e.kind = S3DEV_INTERNAL_CMD_SPRITEBATCHDRAW;
+    e.spritebatchdraw.win_id = spew3d_window_GetID(win);
+    e.spritebatchdraw.entries = batch->entries;
+    e.spritebatchdraw.count = batch->count;
+    e.spritebatchdraw.alloc = batch->alloc;
+    if (!_spew3d_event_InsertDrawCmd(&e))
+        return 0;
+    batch->entries = NULL;
+    batch->count = 0;
+    batch->alloc = 0;
+
+    // Continue with the buffer of an earlier frame, if one is done:
+    mutex_Lock(_spew3d_spritebatch_recycle_mutex);
+    if (_spew3d_spritebatch_recycled_count > 0) {
+        _spew3d_spritebatch_recycled_count--;
+        s3d_spritebatch_recycled *slot = &_spew3d_spritebatch_recycled[
+            _spew3d_spritebatch_recycled_count
+        ];
+        batch->entries = slot->entries;
+        batch->alloc = slot->alloc;
+    }
+    mutex_Release(_spew3d_spritebatch_recycle_mutex);
+    return 1;
+}
+
+S3DEXP uint32_t spew3d_spritebatch_GetCount(s3d_spritebatch *batch) {
+    return batch->count;
+}
+
+S3DEXP void spew3d_spritebatch_Clear(s3d_spritebatch *batch) {
+    batch->count = 0;
+}
+
+S3DEXP void spew3d_spritebatch_Destroy(s3d_spritebatch *batch) {
+    if (!batch)
+        return;
+    free(batch->entries);
+    free(batch);
+}
+
+#endif  // SPEW3D_IMPLEMENTATION
+
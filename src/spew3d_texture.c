@@ -33,62 +33,168 @@ license, see accompanied LICENSE.md.
 #include <string.h>
 #include <unistd.h>
 
-static inline uint16_t spew3d_simplehash(const char *k);
-
 // Some global variables:
 uint64_t _internal_spew3d_texlist_count;
 s3d_texture_info *_internal_spew3d_texlist;
 s3d_mutex *_texlist_mutex = NULL;
 
-// Global hash map:
-#define SPEW3D_TEXLIST_IDHASHMAP_SIZE 2048
-typedef struct spew3d_texlist_idhashmap_bucket
-    spew3d_texlist_idhashmap_bucket;
-typedef struct spew3d_texlist_idhashmap_bucket {
-    uint64_t texlist_slot_idx;
-    spew3d_texlist_idhashmap_bucket *next;
-} spew3d_texlist_idhashmap_bucket;
-spew3d_texlist_idhashmap_bucket
-    **_internal_spew3d_texlist_hashmap = NULL;
+// Texture ids hold the 1-based slot in the lower 32 bits, and the
+// generation of that slot in the upper 32 bits. Since the generation
+// changes whenever a slot is reused, stale ids can be detected:
+#define SPEW3D_TEXID_SLOT(id) ((uint32_t)((id) & 0xFFFFFFFFULL))
+#define SPEW3D_TEXID_GENERATION(id) ((uint32_t)((id) >> 32))
+#define SPEW3D_TEXID_MAKE(slot, generation) (\
+    (((uint64_t)(generation)) << 32) | ((uint64_t)(slot)))
+
+// Slots of destroyed textures, waiting to be reused:
+static uint32_t *_internal_spew3d_texlist_freeslots = NULL;
+static uint32_t _internal_spew3d_texlist_freeslots_count = 0;
+static uint32_t _internal_spew3d_texlist_freeslots_alloc = 0;
+
+// Global hash map, using open addressing with linear probing:
+#define SPEW3D_TEXLIST_IDHASHMAP_MINSIZE 64
+#define SPEW3D_TEXLIST_IDHASHMAP_TOMBSTONE UINT32_MAX
+typedef struct spew3d_texlist_idhashmap_entry {
+    uint64_t hash;
+    uint32_t texlist_slot;  // 1-based, 0 means empty.
+} spew3d_texlist_idhashmap_entry;
+static spew3d_texlist_idhashmap_entry
+    *_internal_spew3d_texlist_hashmap = NULL;
+static uint64_t _internal_spew3d_texlist_hashmap_size = 0;
+static uint64_t _internal_spew3d_texlist_hashmap_used = 0;
+static uint8_t _internal_spew3d_texlist_hashkey[16] = {0};
+
+// Texture atlas settings, for packing small textures together:
+#define SPEW3D_TEXATLAS_PAGE_SIZE 1024
+#define SPEW3D_TEXATLAS_MAX_ITEM_SIZE 256
+#define SPEW3D_TEXATLAS_PADDING 2
+
+// Default memory budgets for texture residency:
+#define SPEW3D_TEXTURE_DEFAULT_GPU_BUDGET (512ULL * 1024ULL * 1024ULL)
+#define SPEW3D_TEXTURE_DEFAULT_CPU_BUDGET (1024ULL * 1024ULL * 1024ULL)
+
+// Default per frame budget for draining the GPU upload queue:
+#define SPEW3D_TEXTURE_DEFAULT_UPLOAD_BYTES (16ULL * 1024ULL * 1024ULL)
+#define SPEW3D_TEXTURE_DEFAULT_UPLOAD_MS 4
 
 // Extra info struct:
 typedef struct spew3d_texture_extrainfo {
     s3d_resourceload_job *loadingjob;
-    s3d_texture_info *parent;
     uint8_t editlocked;
     uint64_t editlocked_id;
 
     char *pixels;
     uint32_t width, height;
     int forcenogpu;
-    uint64_t last_use_ts;
+    uint32_t slot;  // Texture list slot + 1, for the budget eviction.
+    // Use order for the budgets, most recently used first:
+    uint8_t lru_linked;
+    struct spew3d_texture_extrainfo *lru_prev, *lru_next;
+    uint8_t pixels_handed_out;
+    uint64_t gpu_bytes;
+    uint32_t upload_queued_alpha, upload_queued_noalpha;  // Per level.
 
     s3d_backend_windowing_gputex *gputexture_alpha,
         *gputexture_noalpha;
+    uint8_t gputexture_outdated;
+
+    // Smaller versions for far away use, level 1 and up. The count
+    // stays set when the pixels are dropped:
+    char *mip_pixels;
+    uint8_t mip_count;
+    s3d_backend_windowing_gputex
+        *gputexture_mip_alpha[SPEW3D_TEXTURE_MAX_MIPS],
+        *gputexture_mip_noalpha[SPEW3D_TEXTURE_MAX_MIPS];
     s3d_backend_windowing *gpubackend;
     s3d_window *gpubackend_window;
     s3d_backend_windowing_wininfo *gpubackend_backend_winfo;
+
+    uint8_t atlas_state;
+    uint8_t is_atlas_page;
+    s3d_texture_t atlas_page;
+    uint32_t atlas_x, atlas_y;
 } spew3d_texture_extrainfo;
 
-static char *_internal_tex_get_buf = NULL;
-static uint32_t _internal_tex_get_buf_size = 0;
+enum {
+    TEXATLAS_STATE_UNTRIED = 0,
+    TEXATLAS_STATE_PACKED = 1,
+    TEXATLAS_STATE_UNSUITABLE = 2,
+    TEXATLAS_STATE_PENDING = 3  // Packed, but page not re-uploaded yet.
+};
+
+// Atlas pages use simple shelf packing, one shelf after another.
+// Space is only reclaimed once all items of a page are gone:
+typedef struct spew3d_texatlas_page {
+    s3d_texture_t tid;
+    uint32_t shelf_x, shelf_y, shelf_h;
+    uint32_t item_count;
+    uint8_t needs_upload;
+} spew3d_texatlas_page;
+static spew3d_texatlas_page *_internal_spew3d_texatlas_page = NULL;
+static uint32_t _internal_spew3d_texatlas_page_count = 0;
+// Items packed since the last frame, which become usable once their
+// pages were marked for re-upload all at once:
+static s3d_texture_t *_internal_spew3d_texatlas_pending = NULL;
+static uint32_t _internal_spew3d_texatlas_pending_count = 0;
+static uint32_t _internal_spew3d_texatlas_pending_alloc = 0;
+static s3d_mutex *_texatlas_mutex = NULL;
+
+// Pending GPU uploads, drained on the main thread a bit per frame:
+typedef struct spew3d_texture_uploadreq {
+    s3d_texture_t tid;
+    uint32_t win_id;
+    uint8_t alpha, mip_level;
+} spew3d_texture_uploadreq;
+static spew3d_texture_uploadreq *_internal_spew3d_texture_uploadq = NULL;
+static uint32_t _internal_spew3d_texture_uploadq_count = 0;
+static uint32_t _internal_spew3d_texture_uploadq_alloc = 0;
+static uint64_t _internal_spew3d_texture_upload_bytes = (
+    SPEW3D_TEXTURE_DEFAULT_UPLOAD_BYTES
+);
+static uint64_t _internal_spew3d_texture_upload_ms = (
+    SPEW3D_TEXTURE_DEFAULT_UPLOAD_MS
+);
+static s3d_texture_t _internal_spew3d_texture_placeholder = 0;
+
+// Residency tracking, to stay within the memory budgets:
+static spew3d_texture_extrainfo *_internal_spew3d_texture_lru_head = NULL;
+static spew3d_texture_extrainfo *_internal_spew3d_texture_lru_tail = NULL;
+static uint64_t _internal_spew3d_texture_gpu_bytes = 0;
+static uint64_t _internal_spew3d_texture_cpu_bytes = 0;
+static uint64_t _internal_spew3d_texture_gpu_budget = (
+    SPEW3D_TEXTURE_DEFAULT_GPU_BUDGET
+);
+static uint64_t _internal_spew3d_texture_cpu_budget = (
+    SPEW3D_TEXTURE_DEFAULT_CPU_BUDGET
+);
+
+static void _internal_spew3d_TextureLRUUnlink_nolock(
+        spew3d_texture_extrainfo *extrainfo
+        ) {
+    if (!extrainfo->lru_linked)
+        return;
+    if (extrainfo->lru_prev != NULL)
+        extrainfo->lru_prev->lru_next = extrainfo->lru_next;
+    else
+        _internal_spew3d_texture_lru_head = extrainfo->lru_next;
+    if (extrainfo->lru_next != NULL)
+        extrainfo->lru_next->lru_prev = extrainfo->lru_prev;
+    else
+        _internal_spew3d_texture_lru_tail = extrainfo->lru_prev;
+    extrainfo->lru_prev = NULL;
+    extrainfo->lru_next = NULL;
+    extrainfo->lru_linked = 0;
+}
 
 static void __attribute__((constructor)) _internal_spew3d_ensure_texhash() {
-    if (_internal_spew3d_texlist_hashmap != NULL)
+    if (_texlist_mutex != NULL)
         return;
 
-    _internal_spew3d_texlist_hashmap = malloc(
-        sizeof(*_internal_spew3d_texlist_hashmap) *
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE
-    );
-    if (!_internal_spew3d_texlist_hashmap) {
-        fprintf(stderr, "spew3d_texture.c: error: "
-            "Failed to allocate _internal_spew3d_texlist_hashmap.\n");
-        _exit(1);
-    }
-    memset(_internal_spew3d_texlist_hashmap, 0,
-        sizeof(*_internal_spew3d_texlist_hashmap) *
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE
+    // A random key makes it hard to craft colliding texture names.
+    // If that fails, the zero key still gives a good distribution.
+    spew3d_secrandom_GetBytes(
+        (char *)_internal_spew3d_texlist_hashkey,
+        sizeof(_internal_spew3d_texlist_hashkey)
     );
 
     _texlist_mutex = mutex_Create();
@@ -97,25 +203,53 @@ static void __attribute__((constructor)) _internal_spew3d_ensure_texhash() {
             "Failed to allocate tex list access mutex.\n");
         _exit(1);
     }
+    _texatlas_mutex = mutex_Create();
+    if (!_texatlas_mutex) {
+        fprintf(stderr, "spew3d_texture.c: error: "
+            "Failed to allocate tex atlas access mutex.\n");
+        _exit(1);
+    }
 }
 
 S3DHID s3d_texture_info *_internal_spew3d_texinfo_nolock(
         s3d_texture_t id
         ) {
-    assert(id > 0 && id <= _internal_spew3d_texlist_count);
-    return &_internal_spew3d_texlist[id - 1];
+    uint32_t slot = SPEW3D_TEXID_SLOT(id);
+    assert(slot > 0 && slot <= _internal_spew3d_texlist_count);
+    assert(_internal_spew3d_texlist[slot - 1].generation ==
+        SPEW3D_TEXID_GENERATION(id));
+    return &_internal_spew3d_texlist[slot - 1];
 }
 
 S3DEXP void spew3d_texinfo(
         s3d_texture_t id, s3d_texture_info *writeto
         ) {
     mutex_Lock(_texlist_mutex);
-    assert(id > 0 && id <= _internal_spew3d_texlist_count);
-    s3d_texture_info *i = &_internal_spew3d_texlist[id - 1];
+    s3d_texture_info *i = _internal_spew3d_texinfo_nolock(id);
     memcpy(i, writeto, sizeof(*writeto));
     mutex_Release(_texlist_mutex);
 }
 
+static int _internal_spew3d_texture_IsValid_nolock(
+        s3d_texture_t tid
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    uint32_t slot = SPEW3D_TEXID_SLOT(tid);
+    return (
+        slot > 0 && slot <= _internal_spew3d_texlist_count &&
+        _internal_spew3d_texlist[slot - 1].generation ==
+            SPEW3D_TEXID_GENERATION(tid) &&
+        _internal_spew3d_texlist[slot - 1].idstring != NULL
+    );
+}
+
+S3DEXP int spew3d_texture_IsValid(s3d_texture_t tid) {
+    mutex_Lock(_texlist_mutex);
+    int result = _internal_spew3d_texture_IsValid_nolock(tid);
+    mutex_Release(_texlist_mutex);
+    return result;
+}
+
 static inline spew3d_texture_extrainfo *spew3d_extrainfo(
         s3d_texture_t tid
         ) {
@@ -125,26 +259,458 @@ static inline spew3d_texture_extrainfo *spew3d_extrainfo(
         tinfo->_internal);
 }
 
-static int _spew3d_check_texidstring_used(
-        const char *id) {
+static uint64_t _internal_spew3d_texlist_Hash(const char *id) {
+    uint8_t out[8];
+    siphash((const uint8_t *)id, strlen(id),
+        _internal_spew3d_texlist_hashkey, out, sizeof(out));
+    uint64_t hash;
+    memcpy(&hash, out, sizeof(hash));
+    return hash;
+}
+
+static int _internal_spew3d_texlist_HashmapMatches_nolock(
+        spew3d_texlist_idhashmap_entry *entry,
+        uint64_t hash, const char *id, int correspondstofile
+        ) {
+    if (entry->hash != hash ||
+            entry->texlist_slot == SPEW3D_TEXLIST_IDHASHMAP_TOMBSTONE)
+        return 0;
+    s3d_texture_info *tinfo = (
+        &_internal_spew3d_texlist[entry->texlist_slot - 1]
+    );
+    return (tinfo->idstring != NULL &&
+        (correspondstofile < 0 ||
+        tinfo->correspondstofile == (correspondstofile != 0)) &&
+        strcmp(tinfo->idstring, id) == 0);
+}
+
+// Returns the 1-based slot, or 0 if not found. Passing -1 for
+// correspondstofile matches both file and writable textures.
+static uint32_t _internal_spew3d_texlist_HashmapFind_nolock(
+        uint64_t hash, const char *id, int correspondstofile
+        ) {
     assert(mutex_IsLocked(_texlist_mutex));
-    uint16_t hash = spew3d_simplehash(id);
-    spew3d_texlist_idhashmap_bucket *bucket =
-        _internal_spew3d_texlist_hashmap[hash %
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE];
-    while (bucket != NULL) {
-        const uint64_t idx = bucket->texlist_slot_idx;
-        assert(id >= 0 && idx < _internal_spew3d_texlist_count);
-        if (_internal_spew3d_texlist[idx].idstring != NULL &&
-                strcmp(_internal_spew3d_texlist[idx].idstring,
-                    id) == 0) {
+    if (_internal_spew3d_texlist_hashmap_size == 0)
+        return 0;
+    const uint64_t mask = _internal_spew3d_texlist_hashmap_size - 1;
+    uint64_t i = hash & mask;
+    while (_internal_spew3d_texlist_hashmap[i].texlist_slot != 0) {
+        if (_internal_spew3d_texlist_HashmapMatches_nolock(
+                &_internal_spew3d_texlist_hashmap[i], hash, id,
+                correspondstofile))
+            return _internal_spew3d_texlist_hashmap[i].texlist_slot;
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+static int _internal_spew3d_texlist_HashmapResize_nolock(
+        uint64_t new_size
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    assert((new_size & (new_size - 1)) == 0);
+    spew3d_texlist_idhashmap_entry *new_map = malloc(
+        sizeof(*new_map) * new_size
+    );
+    if (!new_map)
+        return 0;
+    memset(new_map, 0, sizeof(*new_map) * new_size);
+    uint64_t used = 0;
+    uint64_t k = 0;
+    while (k < _internal_spew3d_texlist_hashmap_size) {
+        spew3d_texlist_idhashmap_entry *entry = (
+            &_internal_spew3d_texlist_hashmap[k]
+        );
+        k++;
+        if (entry->texlist_slot == 0 || entry->texlist_slot ==
+                SPEW3D_TEXLIST_IDHASHMAP_TOMBSTONE)
+            continue;
+        uint64_t i = entry->hash & (new_size - 1);
+        while (new_map[i].texlist_slot != 0)
+            i = (i + 1) & (new_size - 1);
+        new_map[i] = *entry;
+        used++;
+    }
+    free(_internal_spew3d_texlist_hashmap);
+    _internal_spew3d_texlist_hashmap = new_map;
+    _internal_spew3d_texlist_hashmap_size = new_size;
+    _internal_spew3d_texlist_hashmap_used = used;
+    return 1;
+}
+
+static int _internal_spew3d_texlist_HashmapInsert_nolock(
+        uint64_t hash, uint32_t slot
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    // Keep at most half of the table in use, tombstones included,
+    // so probe sequences stay short:
+    if ((_internal_spew3d_texlist_hashmap_used + 1) * 2 >
+            _internal_spew3d_texlist_hashmap_size) {
+        uint64_t new_size = SPEW3D_TEXLIST_IDHASHMAP_MINSIZE;
+        while (new_size < (_internal_spew3d_texlist_hashmap_used + 1) * 4)
+            new_size *= 2;
+        if (!_internal_spew3d_texlist_HashmapResize_nolock(new_size))
+            return 0;
+    }
+    const uint64_t mask = _internal_spew3d_texlist_hashmap_size - 1;
+    uint64_t i = hash & mask;
+    while (_internal_spew3d_texlist_hashmap[i].texlist_slot != 0)
+        i = (i + 1) & mask;
+    _internal_spew3d_texlist_hashmap[i].hash = hash;
+    _internal_spew3d_texlist_hashmap[i].texlist_slot = slot;
+    _internal_spew3d_texlist_hashmap_used++;
+    return 1;
+}
+
+static int _internal_spew3d_texlist_HashmapRemove_nolock(
+        const char *id, int correspondstofile
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    if (_internal_spew3d_texlist_hashmap_size == 0)
+        return 0;
+    uint64_t hash = _internal_spew3d_texlist_Hash(id);
+    const uint64_t mask = _internal_spew3d_texlist_hashmap_size - 1;
+    uint64_t i = hash & mask;
+    while (_internal_spew3d_texlist_hashmap[i].texlist_slot != 0) {
+        if (_internal_spew3d_texlist_HashmapMatches_nolock(
+                &_internal_spew3d_texlist_hashmap[i], hash, id,
+                correspondstofile)) {
+            // Leave a tombstone, so later entries stay reachable:
+            _internal_spew3d_texlist_hashmap[i].texlist_slot =
+                SPEW3D_TEXLIST_IDHASHMAP_TOMBSTONE;
             return 1;
         }
-        bucket = bucket->next;
+        i = (i + 1) & mask;
     }
     return 0;
 }
 
+static void _internal_spew3d_texlist_FreeSlot_nolock(
+        s3d_texture_info *tinfo
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    free(tinfo->idstring);
+    free(tinfo->diskpath);
+    tinfo->idstring = NULL;
+    tinfo->diskpath = NULL;
+    tinfo->_internal = NULL;
+    tinfo->loaded = 0;
+    tinfo->generation++;  // Invalidates all old ids for this slot.
+    if (_internal_spew3d_texlist_freeslots_count + 1 >
+            _internal_spew3d_texlist_freeslots_alloc) {
+        uint32_t new_alloc = (
+            _internal_spew3d_texlist_freeslots_alloc * 2 + 16
+        );
+        uint32_t *new_freeslots = realloc(
+            _internal_spew3d_texlist_freeslots,
+            sizeof(*new_freeslots) * new_alloc
+        );
+        if (!new_freeslots)
+            return;  // Just don't reuse this slot.
+        _internal_spew3d_texlist_freeslots = new_freeslots;
+        _internal_spew3d_texlist_freeslots_alloc = new_alloc;
+    }
+    _internal_spew3d_texlist_freeslots[
+        _internal_spew3d_texlist_freeslots_count
+    ] = (tinfo - _internal_spew3d_texlist) + 1;
+    _internal_spew3d_texlist_freeslots_count++;
+}
+
+static void _internal_spew3d_TextureDropGPU_nolock(
+        spew3d_texture_extrainfo *extrainfo
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    if (extrainfo->gputexture_alpha) {
+        extrainfo->gpubackend->DestroyGPUTexture(
+            extrainfo->gpubackend,
+            extrainfo->gpubackend_window,
+            extrainfo->gpubackend_backend_winfo,
+            extrainfo->gputexture_alpha
+        );
+        extrainfo->gputexture_alpha = NULL;
+    }
+    if (extrainfo->gputexture_noalpha) {
+        extrainfo->gpubackend->DestroyGPUTexture(
+            extrainfo->gpubackend,
+            extrainfo->gpubackend_window,
+            extrainfo->gpubackend_backend_winfo,
+            extrainfo->gputexture_noalpha
+        );
+        extrainfo->gputexture_noalpha = NULL;
+    }
+    int i = 0;
+    while (i < SPEW3D_TEXTURE_MAX_MIPS) {
+        if (extrainfo->gputexture_mip_alpha[i]) {
+            extrainfo->gpubackend->DestroyGPUTexture(
+                extrainfo->gpubackend,
+                extrainfo->gpubackend_window,
+                extrainfo->gpubackend_backend_winfo,
+                extrainfo->gputexture_mip_alpha[i]
+            );
+            extrainfo->gputexture_mip_alpha[i] = NULL;
+        }
+        if (extrainfo->gputexture_mip_noalpha[i]) {
+            extrainfo->gpubackend->DestroyGPUTexture(
+                extrainfo->gpubackend,
+                extrainfo->gpubackend_window,
+                extrainfo->gpubackend_backend_winfo,
+                extrainfo->gputexture_mip_noalpha[i]
+            );
+            extrainfo->gputexture_mip_noalpha[i] = NULL;
+        }
+        i++;
+    }
+    assert(_internal_spew3d_texture_gpu_bytes >= extrainfo->gpu_bytes);
+    _internal_spew3d_texture_gpu_bytes -= extrainfo->gpu_bytes;
+    extrainfo->gpu_bytes = 0;
+}
+
+static void _internal_spew3d_TextureDropPixels_nolock(
+        spew3d_texture_extrainfo *extrainfo
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    if (!extrainfo->pixels)
+        return;
+    uint64_t bytes = (
+        (uint64_t)extrainfo->width * (uint64_t)extrainfo->height * 4
+    );
+    if (extrainfo->mip_count > 0)
+        bytes += _internal_spew3d_texture_MipOffset(
+            extrainfo->width, extrainfo->height,
+            extrainfo->mip_count + 1, NULL, NULL
+        );
+    assert(_internal_spew3d_texture_cpu_bytes >= bytes);
+    _internal_spew3d_texture_cpu_bytes -= bytes;
+    free(extrainfo->pixels);
+    extrainfo->pixels = NULL;
+    free(extrainfo->mip_pixels);
+    extrainfo->mip_pixels = NULL;
+    // Keep mip_count, since the GPU may still hold these levels and
+    // reloading will bring back the same amount of them anyway.
+}
+
+static void _internal_spew3d_TextureMarkUsed_nolock(
+        spew3d_texture_extrainfo *extrainfo
+        ) {
+    if (_internal_spew3d_texture_lru_head == extrainfo)
+        return;
+    _internal_spew3d_TextureLRUUnlink_nolock(extrainfo);
+    extrainfo->lru_next = _internal_spew3d_texture_lru_head;
+    if (_internal_spew3d_texture_lru_head != NULL)
+        _internal_spew3d_texture_lru_head->lru_prev = extrainfo;
+    else
+        _internal_spew3d_texture_lru_tail = extrainfo;
+    _internal_spew3d_texture_lru_head = extrainfo;
+    extrainfo->lru_linked = 1;
+}
+
+static void _internal_spew3d_TextureEnforceGPUBudget_nolock(
+        s3d_texture_t keep_tid
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    // Evict from the least recently used end. Evicting doesn't change
+    // the use order, so the walk continues where it left off:
+    spew3d_texture_extrainfo *candidate = (
+        _internal_spew3d_texture_lru_tail
+    );
+    while (_internal_spew3d_texture_gpu_bytes >
+            _internal_spew3d_texture_gpu_budget) {
+        while (candidate != NULL && (
+                candidate->slot == SPEW3D_TEXID_SLOT(keep_tid) ||
+                candidate->gpu_bytes == 0))
+            candidate = candidate->lru_prev;
+        if (!candidate)
+            return;
+        spew3d_texture_extrainfo *oldest = candidate;
+        candidate = candidate->lru_prev;
+        #if defined(DEBUG_SPEW3D_TEXTURE)
+        s3d_texture_info *oldest_tinfo = (
+            &_internal_spew3d_texlist[oldest->slot - 1]
+        );
+        fprintf(stderr,
+            "spew3d_texture.c: debug: "
+            "_internal_spew3d_TextureEnforceGPUBudget_nolock(): "
+            "evicting GPU copy of \"%s\"\n",
+            oldest_tinfo->idstring);
+        #endif
+        _internal_spew3d_TextureDropGPU_nolock(oldest);
+    }
+}
+
+static void _internal_spew3d_TextureEnforceCPUBudget_nolock(
+        s3d_texture_t keep_tid
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    spew3d_texture_extrainfo *candidate = (
+        _internal_spew3d_texture_lru_tail
+    );
+    while (_internal_spew3d_texture_cpu_bytes >
+            _internal_spew3d_texture_cpu_budget) {
+        // Find the least recently used pixels that can be reloaded
+        // from disk, and that nobody outside got a pointer to:
+        s3d_texture_info *oldest_tinfo = NULL;
+        while (candidate != NULL) {
+            s3d_texture_info *tinfo = (
+                &_internal_spew3d_texlist[candidate->slot - 1]
+            );
+            if (candidate->slot != SPEW3D_TEXID_SLOT(keep_tid) &&
+                    candidate->pixels != NULL &&
+                    tinfo->correspondstofile &&
+                    tinfo->diskpath != NULL &&
+                    !candidate->pixels_handed_out &&
+                    !candidate->editlocked &&
+                    candidate->loadingjob == NULL) {
+                oldest_tinfo = tinfo;
+                break;
+            }
+            candidate = candidate->lru_prev;
+        }
+        if (!candidate)
+            return;
+        spew3d_texture_extrainfo *oldest = candidate;
+        candidate = candidate->lru_prev;
+        #if defined(DEBUG_SPEW3D_TEXTURE)
+        fprintf(stderr,
+            "spew3d_texture.c: debug: "
+            "_internal_spew3d_TextureEnforceCPUBudget_nolock(): "
+            "dropping pixels of \"%s\"\n",
+            oldest_tinfo->idstring);
+        #endif
+        _internal_spew3d_TextureDropPixels_nolock(oldest);
+        oldest_tinfo->loaded = 0;
+    }
+}
+
+S3DEXP void spew3d_texture_SetMemoryBudget(
+        uint64_t gpu_bytes, uint64_t cpu_bytes
+        ) {
+    mutex_Lock(_texlist_mutex);
+    _internal_spew3d_texture_gpu_budget = gpu_bytes;
+    _internal_spew3d_texture_cpu_budget = cpu_bytes;
+    // GPU textures can only be freed from the main thread, so these
+    // get evicted on the next upload instead of here.
+    _internal_spew3d_TextureEnforceCPUBudget_nolock(0);
+    mutex_Release(_texlist_mutex);
+}
+
+S3DEXP void spew3d_texture_GetMemoryUsage(
+        uint64_t *out_gpu_bytes, uint64_t *out_cpu_bytes
+        ) {
+    mutex_Lock(_texlist_mutex);
+    if (out_gpu_bytes)
+        *out_gpu_bytes = _internal_spew3d_texture_gpu_bytes;
+    if (out_cpu_bytes)
+        *out_cpu_bytes = _internal_spew3d_texture_cpu_bytes;
+    mutex_Release(_texlist_mutex);
+}
+
+static inline uint32_t _internal_spew3d_texture_Avg4(
+        uint32_t a, uint32_t b, uint32_t c, uint32_t d
+        ) {
+    // Average all four 8-bit channels at once, with two channels
+    // per 16-bit lane so the sums can't overflow into each other:
+    uint32_t even = (
+        (a & 0x00FF00FFU) + (b & 0x00FF00FFU) +
+        (c & 0x00FF00FFU) + (d & 0x00FF00FFU) + 0x00020002U
+    );
+    uint32_t odd = (
+        ((a >> 8) & 0x00FF00FFU) + ((b >> 8) & 0x00FF00FFU) +
+        ((c >> 8) & 0x00FF00FFU) + ((d >> 8) & 0x00FF00FFU) +
+        0x00020002U
+    );
+    return ((even >> 2) & 0x00FF00FFU) |
+        (((odd >> 2) & 0x00FF00FFU) << 8);
+}
+
+S3DHID uint64_t _internal_spew3d_texture_MipOffset(
+        uint32_t w, uint32_t h, int mip_level,
+        uint32_t *out_w, uint32_t *out_h
+        ) {
+    assert(mip_level >= 1);
+    uint64_t offset = 0;
+    int level = 1;
+    while (1) {
+        w = (w > 1 ? w / 2 : 1);
+        h = (h > 1 ? h / 2 : 1);
+        if (level == mip_level)
+            break;
+        offset += (uint64_t)w * (uint64_t)h * 4;
+        level++;
+    }
+    if (out_w)
+        *out_w = w;
+    if (out_h)
+        *out_h = h;
+    return offset;
+}
+
+S3DHID int _internal_spew3d_texture_BuildMipChain(
+        const char *pixels, uint32_t w, uint32_t h,
+        char **out_mip_pixels, uint8_t *out_mip_count
+        ) {
+    *out_mip_pixels = NULL;
+    *out_mip_count = 0;
+    int count = 0;
+    uint32_t level_w = w;
+    uint32_t level_h = h;
+    while ((level_w > 1 || level_h > 1) &&
+            count < SPEW3D_TEXTURE_MAX_MIPS) {
+        level_w = (level_w > 1 ? level_w / 2 : 1);
+        level_h = (level_h > 1 ? level_h / 2 : 1);
+        count++;
+    }
+    if (count == 0)
+        return 1;
+    uint64_t total = _internal_spew3d_texture_MipOffset(
+        w, h, count + 1, NULL, NULL
+    );
+    char *mips = malloc(total);
+    if (!mips)
+        return 0;
+    const char *src = pixels;
+    uint32_t src_w = w;
+    uint32_t src_h = h;
+    int level = 1;
+    while (level <= count) {
+        uint32_t dst_w, dst_h;
+        uint64_t offset = _internal_spew3d_texture_MipOffset(
+            w, h, level, &dst_w, &dst_h
+        );
+        char *dst = mips + offset;
+        uint32_t y = 0;
+        while (y < dst_h) {
+            uint32_t y1 = y * 2;
+            uint32_t y2 = (y1 + 1 < src_h ? y1 + 1 : y1);
+            const char *row1 = src + (uint64_t)y1 * src_w * 4;
+            const char *row2 = src + (uint64_t)y2 * src_w * 4;
+            char *dst_row = dst + (uint64_t)y * dst_w * 4;
+            uint32_t x = 0;
+            while (x < dst_w) {
+                uint32_t x1 = x * 2;
+                uint32_t x2 = (x1 + 1 < src_w ? x1 + 1 : x1);
+                uint32_t p[4];
+                memcpy(&p[0], row1 + x1 * 4, 4);
+                memcpy(&p[1], row1 + x2 * 4, 4);
+                memcpy(&p[2], row2 + x1 * 4, 4);
+                memcpy(&p[3], row2 + x2 * 4, 4);
+                uint32_t avg = _internal_spew3d_texture_Avg4(
+                    p[0], p[1], p[2], p[3]
+                );
+                memcpy(dst_row + x * 4, &avg, 4);
+                x++;
+            }
+            y++;
+        }
+        src = dst;
+        src_w = dst_w;
+        src_h = dst_h;
+        level++;
+    }
+    *out_mip_pixels = mips;
+    *out_mip_count = count;
+    return 1;
+}
+
 static int _internal_spew3d_ForceLoadTexture(s3d_texture_t tid) {
     assert(mutex_IsLocked(_texlist_mutex));
     s3d_texture_info *tinfo = _internal_spew3d_texinfo_nolock(tid);
@@ -173,7 +739,19 @@ static int _internal_spew3d_ForceLoadTexture(s3d_texture_t tid) {
         extrainfo->pixels = r.resource_image.pixels;
         extrainfo->width = r.resource_image.w;
         extrainfo->height = r.resource_image.h;
+        extrainfo->mip_pixels = r.resource_image.mip_pixels;
+        extrainfo->mip_count = r.resource_image.mip_count;
         assert(extrainfo->pixels != NULL);
+        _internal_spew3d_texture_cpu_bytes += (
+            (uint64_t)extrainfo->width *
+            (uint64_t)extrainfo->height * 4
+        );
+        if (extrainfo->mip_count > 0)
+            _internal_spew3d_texture_cpu_bytes += (
+                _internal_spew3d_texture_MipOffset(
+                    extrainfo->width, extrainfo->height,
+                    extrainfo->mip_count + 1, NULL, NULL
+                ));
         #if defined(DEBUG_SPEW3D_TEXTURE)
         fprintf(stderr,
             "spew3d_texture.c: debug: "
@@ -183,6 +761,8 @@ static int _internal_spew3d_ForceLoadTexture(s3d_texture_t tid) {
         tinfo->loaded = 1;
         s3d_resourceload_DestroyJob(extrainfo->loadingjob);
         extrainfo->loadingjob = NULL;
+        _internal_spew3d_TextureMarkUsed_nolock(extrainfo);
+        _internal_spew3d_TextureEnforceCPUBudget_nolock(tid);
         return 1;
     }
 
@@ -205,12 +785,42 @@ static int _internal_spew3d_ForceLoadTexture(s3d_texture_t tid) {
     return 0;
 }
 
-S3DHID int _internal_spew3d_TextureToGPU(
+static s3d_backend_windowing_gputex **_internal_spew3d_TextureGPUSlot(
+        spew3d_texture_extrainfo *extrainfo, int alpha, int mip_level
+        ) {
+    assert(mip_level >= 0 && mip_level <= extrainfo->mip_count);
+    if (mip_level == 0)
+        return (alpha ? &extrainfo->gputexture_alpha :
+            &extrainfo->gputexture_noalpha);
+    return (alpha ? &extrainfo->gputexture_mip_alpha[mip_level - 1] :
+        &extrainfo->gputexture_mip_noalpha[mip_level - 1]);
+}
+
+S3DHID int _internal_spew3d_TextureToGPUEx(
         s3d_window *win,
-        s3d_texture_t tid, int alpha,
+        s3d_texture_t tid, int alpha, int mip_level,
         s3d_backend_windowing_gputex **out_tex
         ) {
     assert(mutex_IsLocked(_texlist_mutex));
+    spew3d_texture_extrainfo *extrainfo = (
+        spew3d_extrainfo(tid)
+    );
+    _internal_spew3d_TextureMarkUsed_nolock(extrainfo);
+    if (mip_level > extrainfo->mip_count)
+        mip_level = extrainfo->mip_count;
+
+    // If it's still on the GPU, we don't need the pixels:
+    if (!extrainfo->gputexture_outdated) {
+        s3d_backend_windowing_gputex **slot = (
+            _internal_spew3d_TextureGPUSlot(
+                extrainfo, alpha, mip_level
+            ));
+        if (*slot != NULL) {
+            *out_tex = *slot;
+            return 1;
+        }
+    }
+
     if (!_internal_spew3d_ForceLoadTexture(tid))
         return 0;
     s3d_texture_info *tinfo = _internal_spew3d_texinfo_nolock(tid);
@@ -218,12 +828,12 @@ S3DHID int _internal_spew3d_TextureToGPU(
         return 0;
     assert(tinfo != NULL && tinfo->idstring != NULL);
     assert(tinfo->loaded);
-    spew3d_texture_extrainfo *extrainfo = (
-        spew3d_extrainfo(tid)
-    );
     assert(extrainfo != NULL && extrainfo->pixels != NULL);
     if (extrainfo->loadingjob != NULL)
         return 0;
+    // Reloading may have changed how many levels are available:
+    if (mip_level > extrainfo->mip_count)
+        mip_level = extrainfo->mip_count;
 
     s3d_backend_windowing *backend;
     s3d_backend_windowing_wininfo *backend_winfo;
@@ -234,19 +844,27 @@ S3DHID int _internal_spew3d_TextureToGPU(
             )
         return 1;
 
-    if (alpha && extrainfo->gputexture_alpha) {
-        *out_tex = extrainfo->gputexture_alpha;
-        return 1;
-    } else if (!alpha && extrainfo->gputexture_noalpha) {
-        *out_tex = extrainfo->gputexture_noalpha;
-        return 1;
+    if (extrainfo->gputexture_outdated) {
+        // The pixels changed, e.g. since more textures were packed
+        // into this atlas page, so upload it anew:
+        _internal_spew3d_TextureDropGPU_nolock(extrainfo);
+        extrainfo->gputexture_outdated = 0;
     }
 
+    uint32_t level_w = extrainfo->width;
+    uint32_t level_h = extrainfo->height;
+    char *level_pixels = extrainfo->pixels;
+    if (mip_level > 0)
+        level_pixels = extrainfo->mip_pixels + (
+            _internal_spew3d_texture_MipOffset(
+                extrainfo->width, extrainfo->height, mip_level,
+                &level_w, &level_h
+            ));
     s3d_backend_windowing_gputex *tex = (
         backend->CreateGPUTexture(
             backend, win, backend_winfo,
-            extrainfo->pixels, extrainfo->width,
-            extrainfo->height, !alpha
+            level_pixels, level_w,
+            level_h, !alpha
         )
     );
     if (!tex)
@@ -254,16 +872,29 @@ S3DHID int _internal_spew3d_TextureToGPU(
     extrainfo->gpubackend = backend;
     extrainfo->gpubackend_window = win;
     extrainfo->gpubackend_backend_winfo = backend_winfo;
-    if (alpha) {
-        extrainfo->gputexture_alpha = tex;
-        *out_tex = extrainfo->gputexture_alpha;
-        return 1;
-    } else {
-        extrainfo->gputexture_noalpha = tex;
-        *out_tex = extrainfo->gputexture_noalpha;
-        return 1;
-    }
-    return 0;
+    uint64_t bytes = (
+        (uint64_t)level_w * (uint64_t)level_h * 4
+    );
+    extrainfo->gpu_bytes += bytes;
+    _internal_spew3d_texture_gpu_bytes += bytes;
+    s3d_backend_windowing_gputex **slot = (
+        _internal_spew3d_TextureGPUSlot(extrainfo, alpha, mip_level)
+    );
+    assert(*slot == NULL);
+    *slot = tex;
+    *out_tex = tex;
+    _internal_spew3d_TextureEnforceGPUBudget_nolock(tid);
+    return 1;
+}
+
+S3DHID int _internal_spew3d_TextureToGPU(
+        s3d_window *win,
+        s3d_texture_t tid, int alpha,
+        s3d_backend_windowing_gputex **out_tex
+        ) {
+    return _internal_spew3d_TextureToGPUEx(
+        win, tid, alpha, 0, out_tex
+    );
 }
 
 S3DEXP const char *spew3d_texture_GetReadonlyPixels(
@@ -275,7 +906,10 @@ S3DEXP const char *spew3d_texture_GetReadonlyPixels(
         mutex_Release(_texlist_mutex);
         return NULL;
     }
-    const char *pixels = spew3d_extrainfo(tid)->pixels;
+    spew3d_texture_extrainfo *extrainfo = spew3d_extrainfo(tid);
+    _internal_spew3d_TextureMarkUsed_nolock(extrainfo);
+    extrainfo->pixels_handed_out = 1;
+    const char *pixels = extrainfo->pixels;
     mutex_Release(_texlist_mutex);
     return pixels;
 }
@@ -309,6 +943,7 @@ S3DEXP char *spew3d_texture_UnlockPixelsToEdit(
         einfo->editlocked = 1;
         einfo->editlocked_id = lock_req_id;
     }
+    einfo->pixels_handed_out = 1;
     char *pixels = einfo->pixels;
     mutex_Release(_texlist_mutex);
     return pixels;
@@ -337,24 +972,7 @@ S3DHID int _spew3d_window_ProcessTexLockPixelsReq(s3d_event *ev) {
     assert(!einfo->editlocked);
     #endif
     einfo->editlocked = 0;
-    if (einfo->gputexture_alpha) {
-        einfo->gpubackend->DestroyGPUTexture(
-            einfo->gpubackend,
-            einfo->gpubackend_window,
-            einfo->gpubackend_backend_winfo,
-            einfo->gputexture_alpha
-        );
-        einfo->gputexture_alpha = NULL;
-    }
-    if (einfo->gputexture_noalpha) {
-        einfo->gpubackend->DestroyGPUTexture(
-            einfo->gpubackend,
-            einfo->gpubackend_window,
-            einfo->gpubackend_backend_winfo,
-            einfo->gputexture_noalpha
-        );
-        einfo->gputexture_noalpha = NULL;
-    }
+    _internal_spew3d_TextureDropGPU_nolock(einfo);
     return 1;
 }
 
@@ -363,51 +981,324 @@ S3DEXP int spew3d_texture_GetSize(
         int32_t *out_height
         ) {
     mutex_Lock(_texlist_mutex);
-    if (!_internal_spew3d_ForceLoadTexture(tid)) {
-        mutex_Release(_texlist_mutex);
-        return 0;
-    }
     spew3d_texture_extrainfo *extrainfo = (
         spew3d_extrainfo(tid)
     );
+    // If the pixels were dropped to save memory, the size is
+    // still known and there is no need to reload:
+    if ((extrainfo->width == 0 || extrainfo->height == 0) &&
+            !_internal_spew3d_ForceLoadTexture(tid)) {
+        mutex_Release(_texlist_mutex);
+        return 0;
+    }
     *out_width = extrainfo->width;
     *out_height = extrainfo->height;
     mutex_Release(_texlist_mutex);
     return 1;
 }
 
-static int _unregister_texid_from_hashmap(
-        const char *id, int wascorrespondstofile
+#if !defined(SPEW3D_OPTION_DISABLE_TEXTURE_ATLAS)
+S3DHID static int _spew3d_texture_AtlasFindSpot_nolock(
+        uint32_t w, uint32_t h,
+        spew3d_texatlas_page **out_page,
+        uint32_t *out_x, uint32_t *out_y
         ) {
-    assert(mutex_IsLocked(_texlist_mutex));
-    int unregistercount = 0;
-    uint16_t hash = spew3d_simplehash(id);
-    spew3d_texlist_idhashmap_bucket *bucket =
-        _internal_spew3d_texlist_hashmap[hash %
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE];
-    spew3d_texlist_idhashmap_bucket *parentbucket = NULL;
-    while (bucket != NULL) {
-        const uint64_t idx = bucket->texlist_slot_idx;
-        assert(id >= 0 && idx < _internal_spew3d_texlist_count);
-        if (_internal_spew3d_texlist[idx].idstring != NULL &&
-                _internal_spew3d_texlist[idx].correspondstofile ==
-                (wascorrespondstofile != 0) &&
-                strcmp(_internal_spew3d_texlist[idx].idstring,
-                    id) == 0) {
-            unregistercount++;
-            spew3d_texlist_idhashmap_bucket *freebucket = bucket;
-            if (parentbucket)
-                parentbucket->next = bucket->next;
-            else
-                _internal_spew3d_texlist_hashmap[hash %
-                    SPEW3D_TEXLIST_IDHASHMAP_SIZE] = bucket->next;
-            bucket = bucket->next;
+    assert(mutex_IsLocked(_texatlas_mutex));
+    // Earlier pages may have been emptied and reset, so try all:
+    uint32_t i = 0;
+    while (i < _internal_spew3d_texatlas_page_count) {
+        spew3d_texatlas_page *page = &_internal_spew3d_texatlas_page[i];
+        i++;
+        uint32_t x = page->shelf_x;
+        uint32_t y = page->shelf_y;
+        uint32_t shelf_h = page->shelf_h;
+        if (x + w > SPEW3D_TEXATLAS_PAGE_SIZE) {
+            // Start a new shelf below:
+            x = 0;
+            y += shelf_h;
+            shelf_h = 0;
+        }
+        if (y + h > SPEW3D_TEXATLAS_PAGE_SIZE)
             continue;
+        page->shelf_x = x + w;
+        page->shelf_y = y;
+        page->shelf_h = (shelf_h > h ? shelf_h : h);
+        page->item_count++;
+        *out_page = page;
+        *out_x = x;
+        *out_y = y;
+        return 1;
+    }
+    return 0;
+}
+
+S3DHID static void _spew3d_texture_AtlasRemoveItem_nolock(
+        spew3d_texture_extrainfo *extrainfo
+        ) {
+    assert(mutex_IsLocked(_texatlas_mutex));
+    assert(mutex_IsLocked(_texlist_mutex));
+    if (extrainfo->atlas_state != TEXATLAS_STATE_PACKED &&
+            extrainfo->atlas_state != TEXATLAS_STATE_PENDING)
+        return;
+    extrainfo->atlas_state = TEXATLAS_STATE_UNSUITABLE;
+    uint32_t i = 0;
+    while (i < _internal_spew3d_texatlas_page_count) {
+        spew3d_texatlas_page *page = &_internal_spew3d_texatlas_page[i];
+        if (page->tid == extrainfo->atlas_page) {
+            assert(page->item_count > 0);
+            page->item_count--;
+            if (page->item_count == 0) {
+                // Nothing left to keep, so start filling it anew:
+                page->shelf_x = 0;
+                page->shelf_y = 0;
+                page->shelf_h = 0;
+            }
+            return;
+        }
+        i++;
+    }
+}
+
+S3DHID static void _spew3d_texture_AtlasUploadPending() {
+    mutex_Lock(_texatlas_mutex);
+    if (_internal_spew3d_texatlas_pending_count == 0) {
+        mutex_Release(_texatlas_mutex);
+        return;
+    }
+    mutex_Lock(_texlist_mutex);
+    // Every changed page is uploaded once for all its new items:
+    uint32_t i = 0;
+    while (i < _internal_spew3d_texatlas_page_count) {
+        spew3d_texatlas_page *page = &_internal_spew3d_texatlas_page[i];
+        if (page->needs_upload) {
+            spew3d_extrainfo(page->tid)->gputexture_outdated = 1;
+            page->needs_upload = 0;
+        }
+        i++;
+    }
+    i = 0;
+    while (i < _internal_spew3d_texatlas_pending_count) {
+        s3d_texture_t tid = _internal_spew3d_texatlas_pending[i];
+        i++;
+        if (!_internal_spew3d_texture_IsValid_nolock(tid))
+            continue;  // Destroyed in the meantime.
+        spew3d_texture_extrainfo *extrainfo = spew3d_extrainfo(tid);
+        if (extrainfo->atlas_state == TEXATLAS_STATE_PENDING)
+            extrainfo->atlas_state = TEXATLAS_STATE_PACKED;
+    }
+    _internal_spew3d_texatlas_pending_count = 0;
+    mutex_Release(_texlist_mutex);
+    mutex_Release(_texatlas_mutex);
+}
+
+S3DHID static int _spew3d_texture_AtlasAddPage() {
+    assert(mutex_IsLocked(_texatlas_mutex));
+    char name[64];
+    snprintf(name, sizeof(name), "spew3d-internal-texatlas-%d",
+        (int)_internal_spew3d_texatlas_page_count);
+    spew3d_texatlas_page *new_pages = realloc(
+        _internal_spew3d_texatlas_page,
+        sizeof(*new_pages) * (_internal_spew3d_texatlas_page_count + 1)
+    );
+    if (!new_pages)
+        return 0;
+    _internal_spew3d_texatlas_page = new_pages;
+    s3d_texture_t page_tid = spew3d_texture_NewWritable(
+        name, SPEW3D_TEXATLAS_PAGE_SIZE, SPEW3D_TEXATLAS_PAGE_SIZE
+    );
+    if (page_tid == 0)
+        return 0;
+    mutex_Lock(_texlist_mutex);
+    spew3d_extrainfo(page_tid)->is_atlas_page = 1;
+    mutex_Release(_texlist_mutex);
+    spew3d_texatlas_page *page = &_internal_spew3d_texatlas_page[
+        _internal_spew3d_texatlas_page_count
+    ];
+    memset(page, 0, sizeof(*page));
+    page->tid = page_tid;
+    _internal_spew3d_texatlas_page_count++;
+    return 1;
+}
+
+S3DHID static void _spew3d_texture_AtlasCopyPixels_nolock(
+        spew3d_texture_extrainfo *src,
+        spew3d_texture_extrainfo *dst,
+        uint32_t dst_x, uint32_t dst_y
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    const int32_t pad = SPEW3D_TEXATLAS_PADDING;
+    const int32_t w = src->width;
+    const int32_t h = src->height;
+    int32_t y = -pad;
+    while (y < h + pad) {
+        // The padding repeats the edge pixels, so filtering at the
+        // border doesn't bleed in the neighboring atlas items:
+        int32_t src_y = (y < 0 ? 0 : (y >= h ? h - 1 : y));
+        char *dst_row = dst->pixels + (
+            ((uint64_t)(dst_y + pad + y) * dst->width +
+            (dst_x + pad)) * 4
+        );
+        const char *src_row = src->pixels + (
+            (uint64_t)src_y * w * 4
+        );
+        int32_t x = -pad;
+        while (x < 0) {
+            memcpy(dst_row + x * 4, src_row, 4);
+            x++;
+        }
+        memcpy(dst_row, src_row, w * 4);
+        x = w;
+        while (x < w + pad) {
+            memcpy(dst_row + x * 4, src_row + (w - 1) * 4, 4);
+            x++;
+        }
+        y++;
+    }
+}
+#endif
+
+S3DEXP int spew3d_texture_GetAtlasRegion(
+        s3d_texture_t tid, s3d_texture_t *out_page,
+        s3d_point *out_offset, s3d_point *out_scale
+        ) {
+    #if defined(SPEW3D_OPTION_DISABLE_TEXTURE_ATLAS)
+    return 0;
+    #else
+    mutex_Lock(_texatlas_mutex);
+    mutex_Lock(_texlist_mutex);
+    s3d_texture_info *tinfo = _internal_spew3d_texinfo_nolock(tid);
+    spew3d_texture_extrainfo *extrainfo = spew3d_extrainfo(tid);
+    if (extrainfo == NULL ||
+            extrainfo->atlas_state == TEXATLAS_STATE_UNSUITABLE) {
+        mutex_Release(_texlist_mutex);
+        mutex_Release(_texatlas_mutex);
+        return 0;
+    }
+    if (extrainfo->atlas_state == TEXATLAS_STATE_PENDING) {
+        mutex_Release(_texlist_mutex);
+        mutex_Release(_texatlas_mutex);
+        return -1;
+    }
+    if (extrainfo->atlas_state == TEXATLAS_STATE_UNTRIED) {
+        // Writable textures may change at any time, so only
+        // textures from disk are packed:
+        if (!tinfo->correspondstofile || extrainfo->is_atlas_page) {
+            extrainfo->atlas_state = TEXATLAS_STATE_UNSUITABLE;
+            mutex_Release(_texlist_mutex);
+            mutex_Release(_texatlas_mutex);
+            return 0;
+        }
+        if (!_internal_spew3d_ForceLoadTexture(tid)) {
+            int failed = tinfo->loadingfailed;
+            if (failed)
+                extrainfo->atlas_state = TEXATLAS_STATE_UNSUITABLE;
+            mutex_Release(_texlist_mutex);
+            mutex_Release(_texatlas_mutex);
+            return (failed ? 0 : -1);
         }
-        parentbucket = bucket;
-        bucket = bucket->next;
+        if (extrainfo->width == 0 || extrainfo->height == 0 ||
+                extrainfo->width > SPEW3D_TEXATLAS_MAX_ITEM_SIZE ||
+                extrainfo->height > SPEW3D_TEXATLAS_MAX_ITEM_SIZE) {
+            extrainfo->atlas_state = TEXATLAS_STATE_UNSUITABLE;
+            mutex_Release(_texlist_mutex);
+            mutex_Release(_texatlas_mutex);
+            return 0;
+        }
+        uint32_t padded_w = (
+            extrainfo->width + SPEW3D_TEXATLAS_PADDING * 2
+        );
+        uint32_t padded_h = (
+            extrainfo->height + SPEW3D_TEXATLAS_PADDING * 2
+        );
+        if (_internal_spew3d_texatlas_pending_count + 1 >
+                _internal_spew3d_texatlas_pending_alloc) {
+            uint32_t new_alloc = (
+                _internal_spew3d_texatlas_pending_count + 16
+            ) * 2;
+            s3d_texture_t *new_pending = realloc(
+                _internal_spew3d_texatlas_pending,
+                sizeof(*new_pending) * new_alloc
+            );
+            if (!new_pending) {
+                mutex_Release(_texlist_mutex);
+                mutex_Release(_texatlas_mutex);
+                return 0;
+            }
+            _internal_spew3d_texatlas_pending = new_pending;
+            _internal_spew3d_texatlas_pending_alloc = new_alloc;
+        }
+        spew3d_texatlas_page *page = NULL;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        if (!_spew3d_texture_AtlasFindSpot_nolock(
+                padded_w, padded_h, &page, &x, &y)) {
+            mutex_Release(_texlist_mutex);
+            if (!_spew3d_texture_AtlasAddPage()) {
+                mutex_Release(_texatlas_mutex);
+                return 0;
+            }
+            mutex_Lock(_texlist_mutex);
+            // The texture list may have been reallocated:
+            extrainfo = spew3d_extrainfo(tid);
+            int result = _spew3d_texture_AtlasFindSpot_nolock(
+                padded_w, padded_h, &page, &x, &y
+            );
+            assert(result != 0);
+        }
+        spew3d_texture_extrainfo *page_extrainfo = (
+            spew3d_extrainfo(page->tid)
+        );
+        assert(page_extrainfo->pixels != NULL);
+        _spew3d_texture_AtlasCopyPixels_nolock(
+            extrainfo, page_extrainfo, x, y
+        );
+        // Re-uploading the whole page for every new item would be
+        // slow, so it's done once per frame for all of them:
+        page->needs_upload = 1;
+        _internal_spew3d_texatlas_pending[
+            _internal_spew3d_texatlas_pending_count
+        ] = tid;
+        _internal_spew3d_texatlas_pending_count++;
+        extrainfo->atlas_page = page->tid;
+        extrainfo->atlas_x = x;
+        extrainfo->atlas_y = y;
+        extrainfo->atlas_state = TEXATLAS_STATE_PENDING;
+        #if defined(DEBUG_SPEW3D_TEXTURE)
+        fprintf(stderr,
+            "spew3d_texture.c: debug: "
+            "spew3d_texture_GetAtlasRegion(): "
+            "Packed texture %d (%dx%d) into atlas page "
+            "texture %d at %d,%d\n",
+            (int)tid, (int)extrainfo->width,
+            (int)extrainfo->height, (int)page->tid,
+            (int)x, (int)y);
+        #endif
+        mutex_Release(_texlist_mutex);
+        mutex_Release(_texatlas_mutex);
+        return -1;
     }
-    return unregistercount;
+    assert(extrainfo->atlas_state == TEXATLAS_STATE_PACKED);
+    *out_page = extrainfo->atlas_page;
+    out_offset->x = (
+        (s3dnum_t)(extrainfo->atlas_x + SPEW3D_TEXATLAS_PADDING) /
+        (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE
+    );
+    out_offset->y = (
+        (s3dnum_t)(extrainfo->atlas_y + SPEW3D_TEXATLAS_PADDING) /
+        (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE
+    );
+    out_scale->x = (
+        (s3dnum_t)extrainfo->width /
+        (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE
+    );
+    out_scale->y = (
+        (s3dnum_t)extrainfo->height /
+        (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE
+    );
+    mutex_Release(_texlist_mutex);
+    mutex_Release(_texatlas_mutex);
+    return 1;
+    #endif
 }
 
 S3DHID s3d_texture_t _internal_spew3d_texture_NewEx(
@@ -424,7 +1315,7 @@ S3DHID s3d_texture_t _internal_spew3d_texture_NewEx(
     char *normpath = (
         fromfile ? spew3d_vfs_NormalizePath(path) : NULL
     );
-    if (!normpath) {
+    if (fromfile && !normpath) {
         return 0;
     }
     uint32_t idlen = (
@@ -466,166 +1357,137 @@ S3DHID s3d_texture_t _internal_spew3d_texture_NewEx(
         "path:\"%s\", name: \"%s\", vfsflags:%d\n",
         id, path, name, vfsflags);
     #endif
-
-    mutex_Lock(_texlist_mutex);
-
-    if (idlen >= _internal_tex_get_buf_size) {
-        uint32_t newsize = (
-            idlen + 20
-        );
-        char *_internal_tex_get_buf_new = malloc(
-            newsize
-        );
-        if (!_internal_tex_get_buf_new) {
-            free(id);
-            mutex_Release(_texlist_mutex);
-            return 0;
-        }
-        _internal_tex_get_buf =
-            _internal_tex_get_buf_new;
-        _internal_tex_get_buf_size = newsize;
-    }
     assert(idlen >= 2);
     assert(id[idlen] == '\0');
-    memcpy(_internal_tex_get_buf, id, idlen + 1);
-    free(id);
-    id = NULL;
-    if (strlen(_internal_tex_get_buf) == 0) {
-        mutex_Release(_texlist_mutex);
+    if (idlen <= 2) {
+        free(id);
         return 0;
     }
+    // Hash before locking, to keep the locked part short:
+    uint64_t idhash = _internal_spew3d_texlist_Hash(id);
+
+    mutex_Lock(_texlist_mutex);
 
     // Check if this texture is already in the global hashmap:
-    _internal_spew3d_ensure_texhash();
-    assert(_internal_spew3d_texlist_hashmap != NULL);
-    uint16_t idhash = spew3d_simplehash(_internal_tex_get_buf);
-    spew3d_texlist_idhashmap_bucket *bucket =
-        _internal_spew3d_texlist_hashmap[idhash %
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE];
-    while (bucket != NULL) {
-        const uint64_t idx = bucket->texlist_slot_idx;
-        assert(id >= 0 && idx < _internal_spew3d_texlist_count);
-        if (_internal_spew3d_texlist[idx].idstring != NULL &&
-                _internal_spew3d_texlist[idx].correspondstofile ==
-                (fromfile != 0) &&
-                strcmp(_internal_spew3d_texlist[idx].idstring,
-                   _internal_tex_get_buf) == 0) {
-            #if defined(DEBUG_SPEW3D_TEXTURE)
-            fprintf(stderr,
-                "spew3d_texture.c: debug: "
-                "_internal_spew3d_texture_NewEx id:\"%s\" "
-                " -> return pre-existing sdl_texture_t=%d\n",
-                _internal_tex_get_buf,
-                idx + 1);
-            #endif
-            mutex_Release(_texlist_mutex);
-            return idx + 1;
-        }
-        assert(bucket != bucket->next);
-        bucket = bucket->next;
+    uint32_t found_slot = _internal_spew3d_texlist_HashmapFind_nolock(
+        idhash, id, fromfile
+    );
+    if (found_slot != 0) {
+        s3d_texture_t result_id = SPEW3D_TEXID_MAKE(found_slot,
+            _internal_spew3d_texlist[found_slot - 1].generation);
+        #if defined(DEBUG_SPEW3D_TEXTURE)
+        fprintf(stderr,
+            "spew3d_texture.c: debug: "
+            "_internal_spew3d_texture_NewEx id:\"%s\" "
+            " -> return pre-existing sdl_texture_t=%" PRIu64 "\n",
+            id, result_id);
+        #endif
+        mutex_Release(_texlist_mutex);
+        free(id);
+        return result_id;
     }
 
     // If we arrive here, the texture doesn't exist yet.
 
     #ifndef NDEBUG
     // Sanity check:
-    if (_spew3d_check_texidstring_used(_internal_tex_get_buf)) {
+    if (_internal_spew3d_texlist_HashmapFind_nolock(
+            idhash, id, -1) != 0) {
         mutex_Release(_texlist_mutex);
         fprintf(stderr, "spew3d_texture.c: error: critical "
             "programming error by application, name clash "
             "between a writable texture and another different "
             "writable or non-writable texture (which is "
             "not allowed");
-        assert(!_spew3d_check_texidstring_used(_internal_tex_get_buf));
         _exit(1);
     }
     #endif
 
-    // Allocate new slot in hash map:
-    spew3d_texlist_idhashmap_bucket *newbucket = malloc(
-        sizeof(*newbucket));
-    if (!newbucket) {
-        mutex_Release(_texlist_mutex);
-        return 0;
-    }
-    memset(newbucket, 0, sizeof(*newbucket));
-    newbucket->next = (
-        _internal_spew3d_texlist_hashmap[idhash %
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE]
-    );
-    newbucket->texlist_slot_idx = _internal_spew3d_texlist_count;
-    #if defined(DEBUG_SPEW3D_TEXTURE)
-    fprintf(stderr,
-        "spew3d_texture.c: debug: "
-        "_internal_spew3d_texture_NewEx id:\"%s\" "
-        " -> create new sdl_texture_t=%d\n",
-        _internal_tex_get_buf,
-        (int)(newbucket->texlist_slot_idx + 1));
-    #endif
-
-    // Allocate new slot in global list:
-    int64_t newcount = _internal_spew3d_texlist_count + 1;
-    s3d_texture_info *new_texlist = realloc(
-        _internal_spew3d_texlist,
-        sizeof(*new_texlist) * newcount
-    );
-    if (!new_texlist) {
-        free(newbucket);
-        mutex_Release(_texlist_mutex);
-        return 0;
-    }
-    _internal_spew3d_texlist = new_texlist;
-
-    // Allocate actual entry:
-    char *iddup = strdup(_internal_tex_get_buf);
-    if (!iddup) {
-        free(newbucket);
-        mutex_Release(_texlist_mutex);
-        return 0;
-    }
+    // Allocate the actual entry:
     char *pathdup = NULL;
     if (fromfile) {
-        pathdup = strdup(_internal_tex_get_buf);
+        pathdup = strdup(id + 2);
         if (!pathdup) {
-            free(newbucket);
-            free(iddup);
+            free(id);
             mutex_Release(_texlist_mutex);
             return 0;
         }
-        memmove(pathdup, pathdup + 2,
-            strlen(pathdup) + 1 - 2);
     }
     spew3d_texture_extrainfo *extrainfo = malloc(
         sizeof(*extrainfo)
     );
     if (!extrainfo) {
         free(pathdup);
-        free(newbucket);
-        free(iddup);
+        free(id);
         mutex_Release(_texlist_mutex);
         return 0;
     }
     memset(extrainfo, 0, sizeof(*extrainfo));
-    s3d_texture_info *newinfo = &_internal_spew3d_texlist[
-        _internal_spew3d_texlist_count
-    ];
+
+    // Get a slot, either a freed one or a new one at the end:
+    uint32_t slot = 0;
+    if (_internal_spew3d_texlist_freeslots_count > 0) {
+        slot = _internal_spew3d_texlist_freeslots[
+            _internal_spew3d_texlist_freeslots_count - 1
+        ];
+    } else {
+        if (_internal_spew3d_texlist_count >= UINT32_MAX - 1) {
+            free(extrainfo);
+            free(pathdup);
+            free(id);
+            mutex_Release(_texlist_mutex);
+            return 0;
+        }
+        s3d_texture_info *new_texlist = realloc(
+            _internal_spew3d_texlist,
+            sizeof(*new_texlist) * (_internal_spew3d_texlist_count + 1)
+        );
+        if (!new_texlist) {
+            free(extrainfo);
+            free(pathdup);
+            free(id);
+            mutex_Release(_texlist_mutex);
+            return 0;
+        }
+        _internal_spew3d_texlist = new_texlist;
+        memset(&_internal_spew3d_texlist[
+            _internal_spew3d_texlist_count
+        ], 0, sizeof(*new_texlist));
+        slot = _internal_spew3d_texlist_count + 1;
+    }
+    if (!_internal_spew3d_texlist_HashmapInsert_nolock(idhash, slot)) {
+        free(extrainfo);
+        free(pathdup);
+        free(id);
+        mutex_Release(_texlist_mutex);
+        return 0;
+    }
+    if (slot == _internal_spew3d_texlist_count + 1)
+        _internal_spew3d_texlist_count++;
+    else
+        _internal_spew3d_texlist_freeslots_count--;
+
+    s3d_texture_info *newinfo = &_internal_spew3d_texlist[slot - 1];
+    extrainfo->slot = slot;
+    uint32_t generation = newinfo->generation;
     memset(newinfo, 0, sizeof(*newinfo));
-    extrainfo->parent = newinfo;
-    newinfo->idstring = iddup;
+    newinfo->generation = generation;
+    newinfo->idstring = id;
     newinfo->diskpath = pathdup;
     newinfo->correspondstofile = (fromfile != 0);
     newinfo->loaded = 0;
     newinfo->_internal = extrainfo;
     newinfo->vfsflags = vfsflags;
-
-    // Place new entry in hash map and list:
-    _internal_spew3d_texlist_hashmap[idhash %
-        SPEW3D_TEXLIST_IDHASHMAP_SIZE] = (
-            newbucket);
-
-    _internal_spew3d_texlist_count += 1;
-    assert(_spew3d_check_texidstring_used(iddup));
-    uint64_t result_id = _internal_spew3d_texlist_count;
+    s3d_texture_t result_id = SPEW3D_TEXID_MAKE(slot, generation);
+    #if defined(DEBUG_SPEW3D_TEXTURE)
+    fprintf(stderr,
+        "spew3d_texture.c: debug: "
+        "_internal_spew3d_texture_NewEx id:\"%s\" "
+        " -> create new sdl_texture_t=%" PRIu64 "\n",
+        id, result_id);
+    #endif
+    assert(_internal_spew3d_texlist_HashmapFind_nolock(
+        idhash, id, fromfile) == slot);
     mutex_Release(_texlist_mutex);
     return result_id;
 }
@@ -674,43 +1536,236 @@ S3DEXP int spew3d_texture_DrawAtCanvasPixels(
     e.spritedraw.transparency = transparency;
     e.spritedraw.withalphachannel = withalphachannel;
     mutex_Release(_texlist_mutex);
-    return spew3d_event_q_Insert(_spew3d_event_GetInternalQueue(), &e);
+    return _spew3d_event_InsertDrawCmd(&e);
+}
+
+static int _internal_spew3d_TextureQueueUpload_nolock(
+        s3d_window *win, s3d_texture_t tid, int alpha, int mip_level
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    spew3d_texture_extrainfo *extrainfo = spew3d_extrainfo(tid);
+    uint32_t *queued = (alpha ? &extrainfo->upload_queued_alpha :
+        &extrainfo->upload_queued_noalpha);
+    if ((*queued & (1U << mip_level)) != 0)
+        return 1;
+    if (_internal_spew3d_texture_uploadq_count + 1 >
+            _internal_spew3d_texture_uploadq_alloc) {
+        uint32_t new_alloc = (
+            _internal_spew3d_texture_uploadq_alloc * 2 + 16
+        );
+        spew3d_texture_uploadreq *new_queue = realloc(
+            _internal_spew3d_texture_uploadq,
+            sizeof(*new_queue) * new_alloc
+        );
+        if (!new_queue)
+            return 0;
+        _internal_spew3d_texture_uploadq = new_queue;
+        _internal_spew3d_texture_uploadq_alloc = new_alloc;
+    }
+    spew3d_texture_uploadreq *req = &_internal_spew3d_texture_uploadq[
+        _internal_spew3d_texture_uploadq_count
+    ];
+    _internal_spew3d_texture_uploadq_count++;
+    req->tid = tid;
+    req->win_id = spew3d_window_GetID(win);
+    req->alpha = (alpha != 0);
+    req->mip_level = mip_level;
+    *queued |= (1U << mip_level);
+    return 1;
+}
+
+S3DEXP void spew3d_texture_SetUploadBudget(
+        uint64_t bytes_per_frame, uint64_t ms_per_frame
+        ) {
+    mutex_Lock(_texlist_mutex);
+    _internal_spew3d_texture_upload_bytes = bytes_per_frame;
+    _internal_spew3d_texture_upload_ms = ms_per_frame;
+    mutex_Release(_texlist_mutex);
+}
+
+S3DEXP void spew3d_texture_InternalMainThreadUpdate() {
+    #if !defined(SPEW3D_OPTION_DISABLE_TEXTURE_ATLAS)
+    _spew3d_texture_AtlasUploadPending();
+    #endif
+
+    if (_internal_spew3d_texture_placeholder == 0) {
+        // A dim checkerboard, shown while real textures upload:
+        s3d_texture_t tid = spew3d_texture_NewWritable(
+            "spew3d_internal_placeholder_tex", 4, 4
+        );
+        if (tid != 0) {
+            mutex_Lock(_texlist_mutex);
+            spew3d_texture_extrainfo *extrainfo = spew3d_extrainfo(tid);
+            int i = 0;
+            while (i < 16) {
+                uint8_t v = ((((i % 4) + (i / 4)) % 2) == 0 ?
+                    0x60 : 0x80);
+                extrainfo->pixels[i * 4 + 0] = v;
+                extrainfo->pixels[i * 4 + 1] = v;
+                extrainfo->pixels[i * 4 + 2] = v;
+                extrainfo->pixels[i * 4 + 3] = (char)0xFF;
+                i++;
+            }
+            _internal_spew3d_texture_placeholder = tid;
+            mutex_Release(_texlist_mutex);
+        }
+    }
+
+    mutex_Lock(_texlist_mutex);
+    uint64_t start_ts = spew3d_time_Ticks();
+    uint64_t uploaded_bytes = 0;
+    int uploaded_any = 0;
+    uint32_t kept = 0;
+    uint32_t i = 0;
+    while (i < _internal_spew3d_texture_uploadq_count) {
+        spew3d_texture_uploadreq req = (
+            _internal_spew3d_texture_uploadq[i]
+        );
+        i++;
+        // Always do at least one, so that progress is guaranteed:
+        if (uploaded_any && (
+                uploaded_bytes >= _internal_spew3d_texture_upload_bytes ||
+                spew3d_time_Ticks() - start_ts >=
+                    _internal_spew3d_texture_upload_ms)) {
+            _internal_spew3d_texture_uploadq[kept] = req;
+            kept++;
+            continue;
+        }
+        if (!_internal_spew3d_texture_IsValid_nolock(req.tid))
+            continue;  // Destroyed in the meantime.
+        s3d_texture_info *tinfo = _internal_spew3d_texinfo_nolock(
+            req.tid
+        );
+        spew3d_texture_extrainfo *extrainfo = spew3d_extrainfo(req.tid);
+        uint32_t *queued = (req.alpha ?
+            &extrainfo->upload_queued_alpha :
+            &extrainfo->upload_queued_noalpha);
+        s3d_window *win = spew3d_window_GetByID(req.win_id);
+        if (!win) {
+            *queued &= ~(1U << req.mip_level);
+            continue;
+        }
+        uint64_t gpu_bytes_before = _internal_spew3d_texture_gpu_bytes;
+        s3d_backend_windowing_gputex *gputex = NULL;
+        int result = _internal_spew3d_TextureToGPUEx(
+            win, req.tid, req.alpha, req.mip_level, &gputex
+        );
+        if (result == 0 && !tinfo->loaded && !tinfo->loadingfailed) {
+            // The pixels are still being loaded, so try again later:
+            _internal_spew3d_texture_uploadq[kept] = req;
+            kept++;
+            continue;
+        }
+        *queued &= ~(1U << req.mip_level);
+        if (result == 0) {
+            tinfo->loadingfailed = 1;
+            #if defined(DEBUG_SPEW3D_TEXTURE)
+            fprintf(stderr,
+                "spew3d_texture.c: debug: "
+                "spew3d_texture_InternalMainThreadUpdate(): "
+                "failed to access, decode, or "
+                "do GPU upload of texture \"%s\"\n",
+                tinfo->idstring);
+            #endif
+            continue;
+        }
+        uploaded_any = 1;
+        if (_internal_spew3d_texture_gpu_bytes > gpu_bytes_before)
+            uploaded_bytes += (
+                _internal_spew3d_texture_gpu_bytes - gpu_bytes_before
+            );
+    }
+    _internal_spew3d_texture_uploadq_count = kept;
+    mutex_Release(_texlist_mutex);
 }
 
 S3DHID s3d_backend_windowing_gputex *
-        _internal_spew3d_MainThreadOnly_GetGPUTex_nolock(
-        s3d_window *win, s3d_texture_t tex, int withalphachannel
+        _internal_spew3d_MainThreadOnly_GetPlaceholderGPUTex_nolock(
+        s3d_window *win
+        ) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    if (_internal_spew3d_texture_placeholder == 0)
+        return NULL;
+    s3d_backend_windowing_gputex *gputex = NULL;
+    if (!_internal_spew3d_TextureToGPUEx(
+            win, _internal_spew3d_texture_placeholder, 0, 0, &gputex))
+        return NULL;
+    return gputex;
+}
+
+S3DHID s3d_backend_windowing_gputex *
+        _internal_spew3d_MainThreadOnly_GetGPUTexMip_nolock(
+        s3d_window *win, s3d_texture_t tex, int withalphachannel,
+        s3dnum_t texcoord_area, s3dnum_t pixel_area
         ) {
     assert(mutex_IsLocked(_texlist_mutex));
-    s3d_texture_info *tinfo = _internal_spew3d_texinfo_nolock(tex);
     spew3d_texture_extrainfo *extrainfo = (
         spew3d_extrainfo(tex)
     );
-    if (!_internal_spew3d_ForceLoadTexture(tex))
+    if (extrainfo->gpu_bytes == 0 &&
+            !_internal_spew3d_ForceLoadTexture(tex))
         return NULL;
-    s3d_backend_windowing_gputex *gputex = NULL;
-    int gpuupload = _internal_spew3d_TextureToGPU(
-        win, tex, withalphachannel, &gputex
-    );
-    if (gpuupload == 0) {
-        tinfo->loadingfailed = 1;
-        #if defined(DEBUG_SPEW3D_TEXTURE)
-        fprintf(stderr,
-            "spew3d_texture.c: debug: "
-            "spew3d_texture_DrawToCanvas(): "
-            "failed to access, decode, or "
-            "do GPU upload of texture\n");
-        #endif
+
+    // Pick the level where one texel covers about one pixel:
+    int mip_level = 0;
+    if (extrainfo->mip_count > 0 && pixel_area > 0 &&
+            texcoord_area > 0) {
+        s3dnum_t texel_area = texcoord_area * (
+            (s3dnum_t)extrainfo->width *
+            (s3dnum_t)extrainfo->height
+        );
+        s3dnum_t texels_per_pixel = texel_area / pixel_area;
+        while (texels_per_pixel >= 4.0 &&
+                mip_level < extrainfo->mip_count) {
+            texels_per_pixel /= 4.0;
+            mip_level++;
+        }
+    }
+    _internal_spew3d_TextureMarkUsed_nolock(extrainfo);
+    s3d_backend_windowing_gputex **slot = (
+        _internal_spew3d_TextureGPUSlot(
+            extrainfo, withalphachannel, mip_level
+        ));
+    if (*slot != NULL && !extrainfo->gputexture_outdated)
+        return *slot;
+
+    // Uploading right here would make the first frame that shows
+    // many new textures hitch, so leave it to the upload queue:
+    if (!_internal_spew3d_TextureQueueUpload_nolock(
+            win, tex, withalphachannel, mip_level))
         return NULL;
+    if (*slot != NULL)
+        return *slot;  // Outdated, but better than nothing meanwhile.
+
+    // Until then, use a smaller level if one is on the GPU already:
+    int level = mip_level + 1;
+    while (level <= SPEW3D_TEXTURE_MAX_MIPS) {
+        s3d_backend_windowing_gputex *smaller = (withalphachannel ?
+            extrainfo->gputexture_mip_alpha[level - 1] :
+            extrainfo->gputexture_mip_noalpha[level - 1]);
+        if (smaller != NULL && !extrainfo->gputexture_outdated)
+            return smaller;
+        level++;
     }
-    return gputex;
+    return NULL;
+}
+
+S3DHID s3d_backend_windowing_gputex *
+        _internal_spew3d_MainThreadOnly_GetGPUTex_nolock(
+        s3d_window *win, s3d_texture_t tex, int withalphachannel
+        ) {
+    return _internal_spew3d_MainThreadOnly_GetGPUTexMip_nolock(
+        win, tex, withalphachannel, 0, 0
+    );
 }
 
 S3DHID int _spew3d_texture_ProcessSpriteDrawReq(s3d_event *e) {
     assert(mutex_IsLocked(_texlist_mutex));
 
     s3d_window *win = spew3d_window_GetByID(e->spritedraw.win_id);
-    s3d_texture_t tid = e->spritedraw.win_id;
+    if (!win)
+        return 1;  // Window was closed in the meantime.
+    s3d_texture_t tid = e->spritedraw.tid;
     int32_t x = e->spritedraw.pixel_x;
     int32_t y = e->spritedraw.pixel_y;
     int centered = e->spritedraw.centered;
@@ -730,7 +1785,9 @@ S3DHID int _spew3d_texture_ProcessSpriteDrawReq(s3d_event *e) {
     s3d_backend_windowing *backend = spew3d_window_GetBackend(
         win, &backend_winfo
     );
-    if (!_internal_spew3d_ForceLoadTexture(tid))
+    // If it's still on the GPU, dropped pixels don't need a reload:
+    if (extrainfo->gpu_bytes == 0 &&
+            !_internal_spew3d_ForceLoadTexture(tid))
         return 1;
 
     if (extrainfo->forcenogpu ||
@@ -761,6 +1818,157 @@ S3DHID int _spew3d_texture_ProcessSpriteDrawReq(s3d_event *e) {
     );
 }
 
+// Scratch buffer for sprite batches, only used from the main thread:
+static s3d_backend_windowing_spritequad *_internal_spew3d_spritequads = NULL;
+static uint32_t _internal_spew3d_spritequads_alloc = 0;
+
+static void _internal_spew3d_texture_SpriteQuad(
+        const s3d_spritebatch_entry *entry,
+        s3dnum_t tex_w, s3dnum_t tex_h,
+        s3d_point uv_offset, s3d_point uv_scale,
+        s3d_backend_windowing_spritequad *quad
+        ) {
+    s3dnum_t w = tex_w * entry->uv_w * entry->scale;
+    s3dnum_t h = tex_h * entry->uv_h * entry->scale;
+    s3dnum_t cx = entry->pixel_x + (entry->centered ? 0 : w * 0.5);
+    s3dnum_t cy = entry->pixel_y + (entry->centered ? 0 : h * 0.5);
+
+    // Rotate around the center, same as single sprite draws do:
+    s3dnum_t rad = -entry->angle * M_PI / 180.0;
+    s3dnum_t c = cos(rad);
+    s3dnum_t sn = sin(rad);
+    const s3dnum_t local_x[4] = {-w * 0.5, w * 0.5, w * 0.5, -w * 0.5};
+    const s3dnum_t local_y[4] = {-h * 0.5, -h * 0.5, h * 0.5, h * 0.5};
+    s3dnum_t u0 = uv_offset.x + entry->uv_x * uv_scale.x;
+    s3dnum_t u1 = uv_offset.x + (entry->uv_x + entry->uv_w) * uv_scale.x;
+    s3dnum_t v0 = uv_offset.y + entry->uv_y * uv_scale.y;
+    s3dnum_t v1 = uv_offset.y + (entry->uv_y + entry->uv_h) * uv_scale.y;
+    const s3dnum_t tex_u[4] = {u0, u1, u1, u0};
+    const s3dnum_t tex_v[4] = {v0, v0, v1, v1};
+    int k = 0;
+    while (k < 4) {
+        quad->corners[k].x = cx + local_x[k] * c - local_y[k] * sn;
+        quad->corners[k].y = cy + local_x[k] * sn + local_y[k] * c;
+        quad->texcoords[k].x = tex_u[k];
+        quad->texcoords[k].y = tex_v[k];
+        k++;
+    }
+    quad->color.red = entry->tint_red;
+    quad->color.green = entry->tint_green;
+    quad->color.blue = entry->tint_blue;
+    quad->color.alpha = entry->transparency;
+}
+
+S3DHID int _spew3d_texture_ProcessSpriteBatchDrawReq(s3d_event *e) {
+    assert(mutex_IsLocked(_texlist_mutex));
+    s3d_spritebatch_entry *entries = e->spritebatchdraw.entries;
+    uint32_t count = e->spritebatchdraw.count;
+    uint32_t alloc = e->spritebatchdraw.alloc;
+    s3d_window *win = spew3d_window_GetByID(e->spritebatchdraw.win_id);
+    s3d_backend_windowing_wininfo *backend_winfo = NULL;
+    s3d_backend_windowing *backend = (win != NULL ?
+        spew3d_window_GetBackend(win, &backend_winfo) : NULL);
+    if (!backend || !backend->supports_gpu_textures ||
+            !backend->DrawSpriteQuadsAtPixels) {
+        // FIXME: implement this, the no SDL2 render path.
+        _spew3d_spritebatch_RecycleEntries(entries, alloc);
+        return 1;
+    }
+    if (count > _internal_spew3d_spritequads_alloc) {
+        s3d_backend_windowing_spritequad *new_quads = realloc(
+            _internal_spew3d_spritequads,
+            sizeof(*new_quads) * count
+        );
+        if (!new_quads) {
+            _spew3d_spritebatch_RecycleEntries(entries, alloc);
+            return 0;
+        }
+        _internal_spew3d_spritequads = new_quads;
+        _internal_spew3d_spritequads_alloc = count;
+    }
+
+    // Collect quads until the GPU texture changes, then draw them
+    // all with one call:
+    int result = 1;
+    s3d_backend_windowing_gputex *run_tex = NULL;
+    uint32_t run_len = 0;
+    s3d_texture_t last_tid = 0;
+    int last_alpha = -1;
+    s3d_backend_windowing_gputex *last_gputex = NULL;
+    s3dnum_t last_w = 0;
+    s3dnum_t last_h = 0;
+    s3d_point uv_offset = {0};
+    s3d_point uv_scale = {0};
+    uint32_t i = 0;
+    while (i < count) {
+        s3d_spritebatch_entry *entry = &entries[i];
+        i++;
+        if (entry->tid != last_tid ||
+                entry->withalphachannel != last_alpha) {
+            last_tid = entry->tid;
+            last_alpha = entry->withalphachannel;
+            last_gputex = NULL;
+            if (!_internal_spew3d_texture_IsValid_nolock(entry->tid))
+                continue;
+            spew3d_texture_extrainfo *extrainfo = (
+                spew3d_extrainfo(entry->tid)
+            );
+            // Sprites still on the GPU, directly or via their atlas
+            // page, don't need their dropped pixels reloaded:
+            if (extrainfo->gpu_bytes == 0 &&
+                    extrainfo->atlas_state != TEXATLAS_STATE_PACKED &&
+                    !_internal_spew3d_ForceLoadTexture(entry->tid))
+                continue;
+            last_w = extrainfo->width;
+            last_h = extrainfo->height;
+            s3d_texture_t draw_tid = entry->tid;
+            uv_offset.x = 0;
+            uv_offset.y = 0;
+            uv_scale.x = 1;
+            uv_scale.y = 1;
+            if (extrainfo->atlas_state == TEXATLAS_STATE_PACKED) {
+                draw_tid = extrainfo->atlas_page;
+                uv_offset.x = (
+                    (s3dnum_t)(extrainfo->atlas_x +
+                        SPEW3D_TEXATLAS_PADDING) /
+                    (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE
+                );
+                uv_offset.y = (
+                    (s3dnum_t)(extrainfo->atlas_y +
+                        SPEW3D_TEXATLAS_PADDING) /
+                    (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE
+                );
+                uv_scale.x = last_w / (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE;
+                uv_scale.y = last_h / (s3dnum_t)SPEW3D_TEXATLAS_PAGE_SIZE;
+            }
+            last_gputex = _internal_spew3d_MainThreadOnly_GetGPUTex_nolock(
+                win, draw_tid, entry->withalphachannel
+            );
+        }
+        if (last_gputex == NULL)
+            continue;  // Not loaded or uploaded yet.
+        if (last_gputex != run_tex && run_len > 0) {
+            if (!backend->DrawSpriteQuadsAtPixels(
+                    backend, win, backend_winfo, run_tex,
+                    _internal_spew3d_spritequads, run_len))
+                result = 0;
+            run_len = 0;
+        }
+        run_tex = last_gputex;
+        _internal_spew3d_texture_SpriteQuad(
+            entry, last_w, last_h, uv_offset, uv_scale,
+            &_internal_spew3d_spritequads[run_len]
+        );
+        run_len++;
+    }
+    if (run_len > 0 && !backend->DrawSpriteQuadsAtPixels(
+            backend, win, backend_winfo, run_tex,
+            _internal_spew3d_spritequads, run_len))
+        result = 0;
+    _spew3d_spritebatch_RecycleEntries(entries, alloc);
+    return result;
+}
+
 S3DEXP s3d_texture_t spew3d_texture_FromFile(
         const char *path, int vfsflags
         ) {
@@ -788,7 +1996,6 @@ S3DEXP s3d_texture_t spew3d_texture_NewWritable(
     assert(!tinfo->correspondstofile);
     assert(tinfo->idstring != NULL);
     if (!tinfo->loaded) {
-        assert(tex == _internal_spew3d_texlist_count - 1);
         extrainfo->width = w;
         extrainfo->height = h;
         int64_t pixelcount = ((int64_t)w) * ((int64_t)h);
@@ -796,17 +2003,20 @@ S3DEXP s3d_texture_t spew3d_texture_NewWritable(
         extrainfo->pixels = malloc(4 * pixelcount);
         if (!extrainfo->pixels) {
             int uregcount = (
-                _unregister_texid_from_hashmap(tinfo->idstring, 0)
-            );
+                _internal_spew3d_texlist_HashmapRemove_nolock(
+                    tinfo->idstring, 0
+                ));
             assert(uregcount == 1);
+            _internal_spew3d_TextureLRUUnlink_nolock(extrainfo);
             free(tinfo->_internal);
-            free(tinfo->idstring);
-            free(tinfo->diskpath);
-            _internal_spew3d_texlist_count--;
+            _internal_spew3d_texlist_FreeSlot_nolock(tinfo);
             mutex_Release(_texlist_mutex);
             return 0;
         }
         memset(extrainfo->pixels, 0, 4 * pixelcount);
+        _internal_spew3d_texture_cpu_bytes += (
+            (uint64_t)w * (uint64_t)h * 4
+        );
         tinfo->loaded = 1;
     }
     mutex_Release(_texlist_mutex);
@@ -814,7 +2024,18 @@ S3DEXP s3d_texture_t spew3d_texture_NewWritable(
 }
 
 S3DEXP void spew3d_texture_Destroy(s3d_texture_t tid) {
+    #if !defined(SPEW3D_OPTION_DISABLE_TEXTURE_ATLAS)
+    mutex_Lock(_texatlas_mutex);
+    #endif
     mutex_Lock(_texlist_mutex);
+    #if !defined(SPEW3D_OPTION_DISABLE_TEXTURE_ATLAS)
+    // Give back its atlas space right away, since the destroy
+    // request below can't take the atlas lock anymore:
+    if (_internal_spew3d_texture_IsValid_nolock(tid) &&
+            spew3d_extrainfo(tid) != NULL)
+        _spew3d_texture_AtlasRemoveItem_nolock(spew3d_extrainfo(tid));
+    mutex_Release(_texatlas_mutex);
+    #endif
     s3d_event e = {0};
     e.kind = S3DEV_INTERNAL_CMD_TEXDELETE;
     e.texdelete.tid = tid;
@@ -825,7 +2046,6 @@ S3DEXP void spew3d_texture_Destroy(s3d_texture_t tid) {
 S3DHID int _spew3d_texture_ProcessTexDestroyReq(s3d_event *ev) {
     assert(mutex_IsLocked(_texlist_mutex));
     s3d_texture_t tid = ev->texdelete.tid;
-    assert(tid >= 0 && tid <= _internal_spew3d_texlist_count);
     if (tid == 0) {
         return 1;
     }
@@ -837,45 +2057,21 @@ S3DHID int _spew3d_texture_ProcessTexDestroyReq(s3d_event *ev) {
         return 1;
     }
     int uregcount = (
-        _unregister_texid_from_hashmap(tinfo->idstring, 0)
-    );
+        _internal_spew3d_texlist_HashmapRemove_nolock(
+            tinfo->idstring, 0
+        ));
     assert(uregcount == 1);
     spew3d_texture_extrainfo *extrainfo = (
         spew3d_extrainfo(tid)
     );
     if (extrainfo) {
         assert(extrainfo->loadingjob == NULL);
-        free(extrainfo->pixels);
-        s3d_backend_windowing *backend = extrainfo->gpubackend;
-        s3d_backend_windowing_wininfo *backend_winfo = (
-            extrainfo->gpubackend_backend_winfo
-        );
-        s3d_window *win = extrainfo->gpubackend_window;
-        backend = spew3d_window_GetBackend(
-            win, &backend_winfo
-        );
-        if (extrainfo->gputexture_alpha) {
-            backend->DestroyGPUTexture(
-                backend, win, backend_winfo,
-                extrainfo->gputexture_alpha
-            );
-            extrainfo->gputexture_alpha = NULL;
-        }
-        if (extrainfo->gputexture_noalpha) {
-            backend->DestroyGPUTexture(
-                backend, win, backend_winfo,
-                extrainfo->gputexture_noalpha
-            );
-            extrainfo->gputexture_noalpha = NULL;
-        }
+        _internal_spew3d_TextureDropPixels_nolock(extrainfo);
+        _internal_spew3d_TextureDropGPU_nolock(extrainfo);
+        _internal_spew3d_TextureLRUUnlink_nolock(extrainfo);
         free(extrainfo);
     }
-    free(tinfo->idstring);
-    free(tinfo->diskpath);
-    tinfo->idstring = NULL;
-    tinfo->diskpath = NULL;
-    tinfo->_internal = NULL;
-    tinfo->loaded = 0;
+    _internal_spew3d_texlist_FreeSlot_nolock(tinfo);
     return 1;
 }
 
@@ -921,6 +2117,18 @@ S3DEXP int spew3d_texture_InternalMainThreadProcessEvent(
             mutex_Release(_texlist_mutex);
         }
         return 1;
+    } else if (e->kind == S3DEV_INTERNAL_CMD_SPRITEBATCHDRAW) {
+        if (!_spew3d_texture_ProcessSpriteBatchDrawReq(e)) {
+            #if defined(DEBUG_SPEW3D_TEXTURE)
+            fprintf(stderr,
+                "spew3d_texture.c: debug: "
+                "spew3d_texture_InternalMainThreadProcessEvent(): "
+                "Unexpected _spew3d_texture_ProcessSpriteBatchDrawReq() "
+                "error, might not be rendering everything.\n");
+            #endif
+        }
+        mutex_Release(_texlist_mutex);
+        return 1;
     } else if (e->kind == S3DEV_INTERNAL_CMD_TEXDELETE) {
         if (!_spew3d_texture_ProcessTexDestroyReq(e)) {
             mutex_Release(_texlist_mutex);
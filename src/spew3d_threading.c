@@ -412,6 +412,19 @@ S3DEXP int thread_InMainThread() {
 #endif
 }
 
+S3DEXP int thread_GetCPUCount() {
+#ifdef WINDOWS
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    int count = (int)sysinfo.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (count < 1)
+        return 1;
+    return count;
+}
+
 S3DEXP int mutex_IsLocked(s3d_mutex *m) {
     if (mutex_TryLock(m)) {
         mutex_Release(m);
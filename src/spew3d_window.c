@@ -1128,7 +1128,8 @@ S3DEXP void spew3d_window_FillWithColor(
     e.drawprimitive.red = red;
     e.drawprimitive.green = green;
     e.drawprimitive.blue = blue;
-    _spew3d_event_q_InsertForce(eq, &e);
+    while (!_spew3d_event_InsertDrawCmd(&e))
+        spew3d_time_Sleep(20);
     mutex_Release(_win_id_mutex);
 }
 
@@ -0,0 +1,329 @@
+/* Copyright (c) 2024, ellie/@ell1e & Spew3D Team (see AUTHORS.md).
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+Alternatively, at your option, this file is offered under the Apache 2
+license, see accompanied LICENSE.md.
+*/
+
+#include <assert.h>
+#include <check.h>
+#include <string.h>
+
+#define SPEW3D_OPTION_DISABLE_SDL
+#define SPEW3D_IMPLEMENTATION 1
+#include "spew3d.h"
+
+#include "testmain.h"
+
+static s3d_lvlbox *_test_lvlbox_MakeRoom() {
+    // A 3x3 tiles room with the floor at 0 and the ceiling at 2,
+    // in the corner of an otherwise empty chunk:
+    char s[4096] = "S3DLVLBOX V1\nsave_id 0\noffset 0 0 0\n"
+        "extent 1 1\nchunk 0\n";
+    int x = 0;
+    while (x < 3) {
+        int y = 0;
+        while (y < 3) {
+            char tile[512];
+            snprintf(tile, sizeof(tile),
+                "tile %d 1\nfloor 0 0 0 0 none\n"
+                "ceiling 2 2 2 2 none\n"
+                "wall none none fence 0 0 0 0 0 none\n"
+                "wall none none fence 0 0 0 0 0 none\n"
+                "wall none none fence 0 0 0 0 0 none\n"
+                "wall none none fence 0 0 0 0 0 none\n"
+                "hori_fences 0\n",
+                y * LVLBOX_CHUNK_SIZE + x);
+            strcat(s, tile);
+            y++;
+        }
+        x++;
+    }
+    strcat(s, "endchunk\nend\n");
+    s3d_lvlbox *lvlbox = spew3d_lvlbox_FromString(s, strlen(s));
+    assert(lvlbox != NULL);
+    return lvlbox;
+}
+
+START_TEST (test_lvlbox_collision_groundheights)
+{
+    s3d_lvlbox *lvlbox = _test_lvlbox_MakeRoom();
+    s3d_pos positions[2];
+    memset(positions, 0, sizeof(positions));
+    positions[0].x = 1.5;
+    positions[0].y = 1.5;
+    positions[0].z = 0.5;
+    positions[1].x = 5.5;  // Above an empty tile.
+    positions[1].y = 5.5;
+    positions[1].z = 0.5;
+    s3d_lvlbox_groundinfo info[2];
+    uint32_t found = spew3d_lvlbox_collision_GroundHeights(
+        lvlbox, positions, 2, 0, info
+    );
+    assert(found == 1);
+    assert(info[0].segment_no == 0);
+    assert(S3D_ABS(info[0].floor_z - (0)) <= (0.01));
+    assert(S3D_ABS(info[0].ceiling_z - (2)) <= (0.01));
+    assert(info[1].segment_no == -1);
+    spew3d_lvlbox_Destroy(lvlbox);
+}
+END_TEST
+
+START_TEST (test_lvlbox_collision_raycastbatch)
+{
+    s3d_lvlbox *lvlbox = _test_lvlbox_MakeRoom();
+    s3d_pos origins[3];
+    s3d_pos dirs[3];
+    memset(origins, 0, sizeof(origins));
+    memset(dirs, 0, sizeof(dirs));
+    origins[0].x = 1.5;  // Straight down onto the floor.
+    origins[0].y = 1.5;
+    origins[0].z = 1;
+    dirs[0].z = -1;
+    origins[1] = origins[0];  // Towards the room's side.
+    dirs[1].x = 1;
+    origins[2] = origins[0];  // Along the room, but too short.
+    dirs[2].y = 1;
+    s3d_lvlbox_collisionhit hits[3];
+    uint32_t hit_count = spew3d_lvlbox_collision_RayCastBatch(
+        lvlbox, origins, dirs, 3, 1.2, 0, hits
+    );
+    assert(hit_count == 1);
+    assert(hits[0].hit && hits[0].hit_floor);
+    assert(S3D_ABS(hits[0].distance - (1)) <= (0.01));
+    assert(S3D_ABS(hits[0].pos.z - (0)) <= (0.01));
+    assert(S3D_ABS(hits[0].normal.z - (1)) <= (0.01));
+    assert(!hits[1].hit);
+    assert(!hits[2].hit);
+
+    // The wall is only reached with a longer ray:
+    hit_count = spew3d_lvlbox_collision_RayCastBatch(
+        lvlbox, origins, dirs, 2, 2, 0, hits
+    );
+    assert(hit_count == 2);
+    assert(hits[1].hit && !hits[1].hit_floor &&
+        !hits[1].hit_ceiling);
+    assert(S3D_ABS(hits[1].distance - (1.5)) <= (0.01));
+    assert(S3D_ABS(hits[1].pos.x - (3)) <= (0.01));
+    spew3d_lvlbox_Destroy(lvlbox);
+}
+END_TEST
+
+START_TEST (test_lvlbox_collision_spheresweepbatch)
+{
+    s3d_lvlbox *lvlbox = _test_lvlbox_MakeRoom();
+    s3d_pos starts[2];
+    s3d_pos ends[2];
+    memset(starts, 0, sizeof(starts));
+    memset(ends, 0, sizeof(ends));
+    starts[0].x = 1.5;  // Out of the room through its side.
+    starts[0].y = 1.5;
+    starts[0].z = 0.5;
+    ends[0] = starts[0];
+    ends[0].x = 4.5;
+    starts[1].x = 0.5;  // Diagonally across, staying inside.
+    starts[1].y = 0.5;
+    starts[1].z = 0.5;
+    ends[1] = starts[1];
+    ends[1].x = 2.5;
+    ends[1].y = 2.5;
+    s3d_lvlbox_collisionhit hits[2];
+    uint32_t hit_count = spew3d_lvlbox_collision_SphereSweepBatch(
+        lvlbox, starts, ends, 2, 0.3, 0, hits
+    );
+    assert(hit_count == 1);
+    assert(hits[0].hit);
+    assert(S3D_ABS(hits[0].distance - (0.4)) <= (0.01));
+    assert(S3D_ABS(hits[0].pos.x - (2.7)) <= (0.01));
+    assert(S3D_ABS(hits[0].normal.x - (-1)) <= (0.01));
+    assert(!hits[1].hit);
+    spew3d_lvlbox_Destroy(lvlbox);
+}
+END_TEST
+
+START_TEST (test_lvlbox_roundtrip)
+{
+    s3d_lvlbox *lvlbox = _test_lvlbox_MakeRoom();
+    uint32_t slen = 0;
+    char *s = spew3d_lvlbox_ToString(lvlbox, &slen);
+    assert(s != NULL);
+    s3d_lvlbox *lvlbox2 = spew3d_lvlbox_FromString(s, slen);
+    assert(lvlbox2 != NULL);
+    assert(lvlbox2->chunk_count == lvlbox->chunk_count);
+    assert(lvlbox2->chunk[0].tile[0].occupied);
+    assert(lvlbox2->chunk[0].tile[0].segment_count == 1);
+    assert(S3D_ABS(lvlbox2->chunk[0].tile[0].segment[0].ceiling_z[0] -
+        (2)) <= (0.01));
+    uint32_t slen2 = 0;
+    char *s2 = spew3d_lvlbox_ToString(lvlbox2, &slen2);
+    assert(s2 != NULL);
+    assert(slen2 == slen && memcmp(s, s2, slen) == 0);
+    free(s);
+    free(s2);
+    spew3d_lvlbox_Destroy(lvlbox);
+    spew3d_lvlbox_Destroy(lvlbox2);
+}
+END_TEST
+
+static s3d_lvlbox *_test_lvlbox_LoadFile(const char *path) {
+    struct lvlbox_load_settings *settings = malloc(sizeof(*settings));
+    assert(settings != NULL);
+    memset(settings, 0, sizeof(*settings));
+    return _spew3d_lvlbox_DoMapLoad(
+        path, VFSFLAG_NO_VIRTUALPAK_ACCESS, settings
+    );
+}
+
+static int _test_lvlbox_SaveFile(
+        s3d_lvlbox *lvlbox, const char *path, int incremental
+        ) {
+    struct lvlbox_save_settings *settings = malloc(sizeof(*settings));
+    assert(settings != NULL);
+    settings->lvlbox = lvlbox;
+    settings->incremental = incremental;
+    return (_spew3d_lvlbox_DoMapSave(
+        path, VFSFLAG_NO_VIRTUALPAK_ACCESS, settings
+    ) != NULL);
+}
+
+START_TEST (test_lvlbox_journalreplay)
+{
+    char *folder_path = NULL;
+    char *path = NULL;
+    FILE *f = spew3d_fs_TempFile(0, 0, "s3dtest", ".s3dlvlbox",
+        &folder_path, &path);
+    assert(f != NULL);
+    fclose(f);
+    char *journal_path = _spew3d_lvlbox_JournalPath(path);
+    assert(journal_path != NULL);
+
+    // Save the room in full, then raise the middle tile's floor
+    // and only save that to the journal:
+    s3d_lvlbox *lvlbox = _test_lvlbox_MakeRoom();
+    assert(_test_lvlbox_SaveFile(lvlbox, path, 0));
+    s3d_lvlbox_vertsegment *seg = (
+        &lvlbox->chunk[0].tile[1 * LVLBOX_CHUNK_SIZE + 1].segment[0]
+    );
+    int i = 0;
+    while (i < 4) {
+        seg->floor_z[i] = 0.5;
+        i++;
+    }
+    _spew3d_lvlbox_MarkChunkEdited_nolock(lvlbox, 0);
+    assert(_test_lvlbox_SaveFile(lvlbox, path, 1));
+    int _exists = 0;
+    assert(spew3d_fs_TargetExists(journal_path, &_exists) && _exists);
+
+    s3d_lvlbox *loaded = _test_lvlbox_LoadFile(path);
+    assert(loaded != NULL);
+    seg = &loaded->chunk[0].tile[1 * LVLBOX_CHUNK_SIZE + 1].segment[0];
+    assert(S3D_ABS(seg->floor_z[0] - (0.5)) <= (0.01));
+    assert(_lvlbox_Internal(loaded)->journal_bytes > 0);
+    spew3d_lvlbox_Destroy(loaded);
+
+    // A full save compacts the journal away:
+    assert(_test_lvlbox_SaveFile(lvlbox, path, 0));
+    _exists = 1;
+    assert(spew3d_fs_TargetExists(journal_path, &_exists) && !_exists);
+    loaded = _test_lvlbox_LoadFile(path);
+    assert(loaded != NULL);
+    seg = &loaded->chunk[0].tile[1 * LVLBOX_CHUNK_SIZE + 1].segment[0];
+    assert(S3D_ABS(seg->floor_z[0] - (0.5)) <= (0.01));
+    spew3d_lvlbox_Destroy(loaded);
+
+    spew3d_lvlbox_Destroy(lvlbox);
+    int _err = 0;
+    spew3d_fs_RemoveFile(path, &_err);
+    free(journal_path);
+    free(folder_path);
+    free(path);
+}
+END_TEST
+
+START_TEST (test_lvlbox_journaltorntail)
+{
+    char *folder_path = NULL;
+    char *path = NULL;
+    FILE *f = spew3d_fs_TempFile(0, 0, "s3dtest", ".s3dlvlbox",
+        &folder_path, &path);
+    assert(f != NULL);
+    fclose(f);
+    char *journal_path = _spew3d_lvlbox_JournalPath(path);
+    assert(journal_path != NULL);
+
+    s3d_lvlbox *lvlbox = _test_lvlbox_MakeRoom();
+    assert(_test_lvlbox_SaveFile(lvlbox, path, 0));
+    lvlbox->chunk[0].tile[0].segment[0].ceiling_z[0] = 3;
+    _spew3d_lvlbox_MarkChunkEdited_nolock(lvlbox, 0);
+    assert(_test_lvlbox_SaveFile(lvlbox, path, 1));
+
+    // Simulate a crash in the middle of appending another entry:
+    f = fopen(journal_path, "ab");
+    assert(f != NULL);
+    const char *torn = "entry 1 1\nchunk 0\ntile 0 1\nfloor 1 1";
+    assert(fwrite(torn, 1, strlen(torn), f) == strlen(torn));
+    fclose(f);
+
+    // The committed entry must survive, and the next incremental
+    // save must be a full one since the tail can't be appended to:
+    s3d_lvlbox *loaded = _test_lvlbox_LoadFile(path);
+    assert(loaded != NULL);
+    assert(S3D_ABS(loaded->chunk[0].tile[0].segment[0].ceiling_z[0] -
+        (3)) <= (0.01));
+    assert(S3D_ABS(loaded->chunk[0].tile[0].segment[0].floor_z[0] -
+        (0)) <= (0.01));
+    assert(_lvlbox_Internal(loaded)->journal_bytes ==
+        _lvlbox_Internal(loaded)->journal_base_bytes);
+    spew3d_lvlbox_Destroy(loaded);
+
+    // A journal too large to read must fail the load rather than
+    // return the map without its edits:
+    f = fopen(journal_path, "ab");
+    assert(f != NULL);
+    char filler[4096];
+    memset(filler, ' ', sizeof(filler));
+    int i = 0;
+    while (i < (20 * 1024 * 1024) / (int)sizeof(filler) + 1) {
+        assert(fwrite(filler, 1, sizeof(filler), f) == sizeof(filler));
+        i++;
+    }
+    fclose(f);
+    loaded = _test_lvlbox_LoadFile(path);
+    assert(loaded == NULL);
+
+    spew3d_lvlbox_Destroy(lvlbox);
+    int _err = 0;
+    spew3d_fs_RemoveFile(journal_path, &_err);
+    spew3d_fs_RemoveFile(path, &_err);
+    free(journal_path);
+    free(folder_path);
+    free(path);
+}
+END_TEST
+
+TESTS_MAIN(test_lvlbox_collision_groundheights,
+    test_lvlbox_collision_raycastbatch,
+    test_lvlbox_collision_spheresweepbatch,
+    test_lvlbox_roundtrip,
+    test_lvlbox_journalreplay,
+    test_lvlbox_journaltorntail)
@@ -382,7 +382,364 @@ START_TEST (test_math_angle_3d)
 }
 END_TEST
 
+START_TEST (test_math_matrix_transform)
+{
+    s3d_transform3d_cam_info cinfo = {0};
+    cinfo.cam_pos.x = -3;
+    cinfo.cam_pos.y = 1.5;
+    cinfo.cam_pos.z = 2;
+    cinfo.cam_rotation.hori = 30;
+    cinfo.cam_rotation.verti = -20;
+    cinfo.cam_rotation.roll = 10;
+    cinfo.viewport_pixel_width = 320;
+    cinfo.viewport_pixel_height = 240;
+    spew3d_math3d_split_fovs_from_fov(
+        80.0, 320, 240,
+        &cinfo.cam_horifov, &cinfo.cam_vertifov
+    );
+    s3d_pos model_pos = {0};
+    model_pos.x = 5;
+    model_pos.y = -1;
+    model_pos.z = 0.5;
+    s3d_rotation model_rot = {0};
+    model_rot.hori = -70;
+    model_rot.verti = 15;
+    model_rot.roll = 45;
+
+    s3d_matrix4 modelview;
+    spew3d_math3d_matrix_modelview(
+        &cinfo, &model_pos, &model_rot, &modelview
+    );
+    s3d_pos v = {0};
+    v.x = 1;
+    v.y = -2;
+    v.z = 0.5;
+    s3d_pos expected, expected_unscaled;
+    spew3d_math3d_transform3d(
+        v, &cinfo, model_pos, model_rot,
+        &expected, &expected_unscaled
+    );
+    s3d_pos result, result_unscaled;
+    spew3d_math3d_transform3d_matrix(
+        v, &cinfo, &modelview, &result, &result_unscaled
+    );
+    assert(S3D_ABS(result_unscaled.x - expected_unscaled.x) <= 0.001);
+    assert(S3D_ABS(result_unscaled.y - expected_unscaled.y) <= 0.001);
+    assert(S3D_ABS(result_unscaled.z - expected_unscaled.z) <= 0.001);
+    assert(S3D_ABS(result.y - expected.y) <= 0.01);
+    assert(S3D_ABS(result.z - expected.z) <= 0.01);
+
+    s3d_matrix4 rotmat;
+    spew3d_math3d_matrix_fromrotation(&model_rot, &rotmat);
+    s3d_pos p = v;
+    spew3d_math3d_matrix_apply(&rotmat, &p);
+    spew3d_math3d_rotate(&v, &model_rot);
+    assert(S3D_ABS(p.x - v.x) <= 0.001);
+    assert(S3D_ABS(p.y - v.y) <= 0.001);
+    assert(S3D_ABS(p.z - v.z) <= 0.001);
+}
+END_TEST
+
+START_TEST (test_math_transform_batch)
+{
+    s3d_transform3d_cam_info cinfo = {0};
+    cinfo.cam_pos.x = -1;
+    cinfo.cam_pos.y = 0.5;
+    cinfo.cam_rotation.hori = -15;
+    cinfo.cam_rotation.verti = 5;
+    cinfo.viewport_pixel_width = 640;
+    cinfo.viewport_pixel_height = 480;
+    spew3d_math3d_split_fovs_from_fov(
+        70.0, 640, 480,
+        &cinfo.cam_horifov, &cinfo.cam_vertifov
+    );
+    s3d_pos model_pos = {0};
+    model_pos.x = 4;
+    s3d_rotation model_rot = {0};
+    model_rot.hori = 33;
+    model_rot.roll = -12;
+    s3d_matrix4 modelview;
+    spew3d_math3d_matrix_modelview(
+        &cinfo, &model_pos, &model_rot, &modelview
+    );
+
+    // Use odd counts, so that the scalar leftovers get tested too:
+    #define BATCH_MAX 19
+    double in_x[BATCH_MAX], in_y[BATCH_MAX], in_z[BATCH_MAX];
+    float in_xf[BATCH_MAX], in_yf[BATCH_MAX], in_zf[BATCH_MAX];
+    double out_x[BATCH_MAX], out_y[BATCH_MAX], out_z[BATCH_MAX];
+    double out_ux[BATCH_MAX], out_uy[BATCH_MAX], out_uz[BATCH_MAX];
+    float out_xf[BATCH_MAX], out_yf[BATCH_MAX], out_zf[BATCH_MAX];
+    int count = 0;
+    while (count <= BATCH_MAX) {
+        int i = 0;
+        while (i < count) {
+            in_x[i] = 0.5 + (double)i * 0.25;
+            in_y[i] = -1.0 + (double)((i * 7) % 5) * 0.5;
+            in_z[i] = (double)((i * 3) % 4) * 0.3 - 0.5;
+            in_xf[i] = in_x[i];
+            in_yf[i] = in_y[i];
+            in_zf[i] = in_z[i];
+            i++;
+        }
+        spew3d_math3d_transform_batch_d(
+            &modelview, &cinfo, in_x, in_y, in_z, count,
+            out_x, out_y, out_z, out_ux, out_uy, out_uz
+        );
+        spew3d_math3d_transform_batch_f(
+            &modelview, &cinfo, in_xf, in_yf, in_zf, count,
+            out_xf, out_yf, out_zf, NULL, NULL, NULL
+        );
+        i = 0;
+        while (i < count) {
+            s3d_pos v;
+            v.x = in_x[i];
+            v.y = in_y[i];
+            v.z = in_z[i];
+            s3d_pos expected, expected_unscaled;
+            spew3d_math3d_transform3d_matrix(
+                v, &cinfo, &modelview,
+                &expected, &expected_unscaled
+            );
+            assert(S3D_ABS(out_x[i] - expected.x) <= 0.0001);
+            assert(S3D_ABS(out_y[i] - expected.y) <= 0.0001);
+            assert(S3D_ABS(out_z[i] - expected.z) <= 0.0001);
+            assert(S3D_ABS(out_ux[i] - expected_unscaled.x) <= 0.0001);
+            assert(S3D_ABS(out_uy[i] - expected_unscaled.y) <= 0.0001);
+            assert(S3D_ABS(out_uz[i] - expected_unscaled.z) <= 0.0001);
+            assert(S3D_ABS(out_xf[i] - expected.x) <= 0.01);
+            assert(S3D_ABS(out_yf[i] - expected.y) <= 0.5);
+            assert(S3D_ABS(out_zf[i] - expected.z) <= 0.5);
+            i++;
+        }
+        count++;
+    }
+    #undef BATCH_MAX
+}
+END_TEST
+
+START_TEST (test_math_backface)
+{
+    s3d_transform3d_cam_info cinfo = {0};
+    cinfo.cam_pos.x = 2;
+    cinfo.cam_pos.y = -3;
+    cinfo.cam_pos.z = 1;
+    cinfo.cam_rotation.hori = 120;
+    cinfo.cam_rotation.verti = 10;
+    s3d_pos model_pos = {0};
+    model_pos.x = -1;
+    model_pos.y = 4;
+    s3d_rotation model_rot = {0};
+    model_rot.hori = 25;
+    model_rot.roll = -30;
+    s3d_matrix4 modelview;
+    spew3d_math3d_matrix_modelview(
+        &cinfo, &model_pos, &model_rot, &modelview
+    );
+
+    // The camera in model space must end up at the camera space
+    // origin again:
+    s3d_pos cam_pos;
+    spew3d_math3d_matrix_camerapos(&modelview, &cam_pos);
+    s3d_pos p = cam_pos;
+    spew3d_math3d_matrix_apply(&modelview, &p);
+    assert(S3D_ABS(p.x) <= 0.001);
+    assert(S3D_ABS(p.y) <= 0.001);
+    assert(S3D_ABS(p.z) <= 0.001);
+
+    // The X+ side of a cube, wound like spew3d_geometry_AddCube():
+    s3d_pos v1 = {0};
+    v1.x = 1;
+    v1.y = -1;
+    v1.z = 1;
+    s3d_pos v2 = {0};
+    v2.x = 1;
+    v2.y = 1;
+    v2.z = -1;
+    s3d_pos v3 = {0};
+    v3.x = 1;
+    v3.y = 1;
+    v3.z = 1;
+    s3d_pos normal;
+    spew3d_math3d_polygon_normal(&v1, &v2, &v3, 0, &normal);
+    s3d_pos viewer = {0};
+    viewer.x = 5;
+    viewer.y = 2;
+    assert(!spew3d_math3d_polygon_facesaway(&normal, &v1, &viewer));
+    viewer.x = -5;
+    assert(spew3d_math3d_polygon_facesaway(&normal, &v1, &viewer));
+}
+END_TEST
+
+START_TEST (test_math_geometry_simplify)
+{
+    // A flat 8x8 grid of quads, two polygons each:
+    #define GRID_SIZE 8
+    s3d_geometry *geom = spew3d_geometry_Create();
+    assert(geom != NULL);
+    int result = _internal_spew3d_geometry_AddVertexPolyAlloc(
+        geom, (GRID_SIZE + 1) * (GRID_SIZE + 1),
+        GRID_SIZE * GRID_SIZE * 2
+    );
+    assert(result != 0);
+    geom->vertex_count = (GRID_SIZE + 1) * (GRID_SIZE + 1);
+    geom->polygon_count = GRID_SIZE * GRID_SIZE * 2;
+    int y = 0;
+    while (y <= GRID_SIZE) {
+        int x = 0;
+        while (x <= GRID_SIZE) {
+            s3d_pos *v = &geom->vertex[y * (GRID_SIZE + 1) + x];
+            v->x = x;
+            v->y = y;
+            v->z = 0;
+            x++;
+        }
+        y++;
+    }
+    uint32_t *vindex = geom->polygon_vertexindex;
+    int i = 0;
+    y = 0;
+    while (y < GRID_SIZE) {
+        int x = 0;
+        while (x < GRID_SIZE) {
+            uint32_t topleft = y * (GRID_SIZE + 1) + x;
+            vindex[i * 3 + 0] = topleft;
+            vindex[i * 3 + 1] = topleft + 1;
+            vindex[i * 3 + 2] = topleft + GRID_SIZE + 2;
+            vindex[i * 3 + 3] = topleft;
+            vindex[i * 3 + 4] = topleft + GRID_SIZE + 2;
+            vindex[i * 3 + 5] = topleft + GRID_SIZE + 1;
+            i += 2;
+            x++;
+        }
+        y++;
+    }
+
+    s3d_geometry *simple = spew3d_geometry_Simplify(geom, 16);
+    assert(simple != NULL);
+    assert(simple->polygon_count > 0);
+    assert(simple->polygon_count <= 16);
+    assert(simple->vertex_count < geom->vertex_count);
+
+    // It must still be the same flat square, all facing the same way:
+    s3d_pos expected_normal;
+    spew3d_math3d_polygon_normal(
+        &geom->vertex[vindex[0]], &geom->vertex[vindex[1]],
+        &geom->vertex[vindex[2]], 1, &expected_normal
+    );
+    double area = 0;
+    i = 0;
+    while (i < simple->polygon_count) {
+        s3d_pos *v1 = &simple->vertex[simple->polygon_vertexindex[i * 3]];
+        s3d_pos *v2 = &simple->vertex[
+            simple->polygon_vertexindex[i * 3 + 1]];
+        s3d_pos *v3 = &simple->vertex[
+            simple->polygon_vertexindex[i * 3 + 2]];
+        s3d_pos normal;
+        spew3d_math3d_polygon_normal(v1, v2, v3, 0, &normal);
+        area += spew3d_math3d_len(normal) / 2;
+        assert(S3D_ABS(v1->z) <= 0.001);
+        assert(normal.x * expected_normal.x + normal.y *
+            expected_normal.y + normal.z * expected_normal.z > 0);
+        i++;
+    }
+    assert(S3D_ABS(area - GRID_SIZE * GRID_SIZE) <= 0.01);
+    _spew3d_geometry_ActuallyDestroy(simple);
+    _spew3d_geometry_ActuallyDestroy(geom);
+    #undef GRID_SIZE
+}
+END_TEST
+
+START_TEST (test_math_sphere_outsideview)
+{
+    s3d_transform3d_cam_info cinfo = {0};
+    cinfo.viewport_pixel_width = 640;
+    cinfo.viewport_pixel_height = 480;
+    spew3d_math3d_split_fovs_from_fov(
+        90, 640, 480, &cinfo.cam_horifov, &cinfo.cam_vertifov
+    );
+    s3d_pos center = {0};
+    center.x = 10;
+    assert(!spew3d_math3d_sphere_outsideview(&cinfo, &center, 1));
+    center.x = -2;
+    assert(spew3d_math3d_sphere_outsideview(&cinfo, &center, 1));
+    assert(!spew3d_math3d_sphere_outsideview(&cinfo, &center, 3));
+
+    // Far to the side, but touching the view with a large radius:
+    center.x = 10;
+    center.y = 30;
+    assert(spew3d_math3d_sphere_outsideview(&cinfo, &center, 1));
+    assert(!spew3d_math3d_sphere_outsideview(&cinfo, &center, 20));
+    center.y = 0;
+    center.z = -30;
+    assert(spew3d_math3d_sphere_outsideview(&cinfo, &center, 1));
+    assert(!spew3d_math3d_sphere_outsideview(&cinfo, &center, 20));
+}
+END_TEST
+
+START_TEST (test_math_drawpolygon_tint)
+{
+    s3d_geometry *geometry = spew3d_geometry_Create();
+    assert(geometry != NULL);
+    assert(spew3d_geometry_AddCubeSimple(geometry, 1, 0, 0));
+
+    s3d_transform3d_cam_info cinfo = {0};
+    cinfo.viewport_pixel_width = 640;
+    cinfo.viewport_pixel_height = 480;
+    spew3d_math3d_split_fovs_from_fov(
+        70, 640, 480, &cinfo.cam_horifov, &cinfo.cam_vertifov
+    );
+    s3d_geometryrenderlightinfo rinfo = {0};
+    rinfo.dynlight_mode = DLRD_UNLIT;
+
+    // One cube in front of the camera, tinted orange-ish:
+    s3d_geometryinstance instance = {0};
+    instance.tint.red = 1;
+    instance.tint.green = 0.5;
+    instance.tint.blue = 0.25;
+    instance.tint.alpha = 1;
+    s3d_pos pos = {0};
+    pos.x = 3;
+    s3d_rotation rot = {0};
+    s3d_renderpolygon *polys = NULL;
+    uint32_t poly_fill = 0;
+    uint32_t poly_alloc = 0;
+    assert(spew3d_geometry_TransformInstances(
+        geometry, &pos, &rot, &instance, 1, -1,
+        &cinfo, &rinfo, &polys, &poly_fill, &poly_alloc
+    ));
+    assert(poly_fill > 0);
+
+    // The tint must survive into the compact draw records:
+    s3d_drawpolygon *draws = NULL;
+    uint32_t draw_fill = 0;
+    uint32_t draw_alloc = 0;
+    assert(_spew3d_camera3d_BuildDrawPolygons(
+        polys, poly_fill, &draws, &draw_fill, &draw_alloc
+    ));
+    assert(draw_fill > 0);
+    uint32_t i = 0;
+    while (i < draw_fill) {
+        int k = 0;
+        while (k < 3) {
+            assert(draws[i].vertex[k].red == 255);
+            assert(draws[i].vertex[k].green == 128);
+            assert(draws[i].vertex[k].blue == 64);
+            assert(draws[i].vertex[k].alpha == 255);
+            k++;
+        }
+        i++;
+    }
+    free(draws);
+    free(polys);
+    _spew3d_geometry_ActuallyDestroy(geometry);
+}
+END_TEST
+
 TESTS_MAIN(test_math_rotate_3d, test_math_angle_rotate_2d,
     test_math_angle_3d, test_math_polygon_normal,
-    test_math_rotate_3d_2, test_poly_rotate)
+    test_math_rotate_3d_2, test_poly_rotate,
+    test_math_matrix_transform, test_math_transform_batch,
+    test_math_backface, test_math_geometry_simplify,
+    test_math_sphere_outsideview, test_math_drawpolygon_tint)
 